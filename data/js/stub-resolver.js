@@ -0,0 +1,51 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Permission is hereby granted, free of charge, to any person obtaining a copy
+ *   of this software and associated documentation files (the "Software"), to deal
+ *   in the Software without restriction, including without limitation the rights
+ *   to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ *   copies of the Software, and to permit persons to whom the Software is
+ *   furnished to do so, subject to the following conditions:
+ *
+ *   The above copyright notice and this permission notice shall be included in
+ *   all copies or substantial portions of the Software.
+ */
+
+// A resolver that answers every query right away without any network access,
+// so the time it takes to get results is spent in the script runtime alone.
+//
+// Install it from file in the resolver settings and start Tomahawk with
+// --verbose: every 1000 calls the log shows how long dispatching them kept
+// the GUI thread busy, and each dispatch that took longer than a frame.
+
+var StubResolver = Tomahawk.extend(Tomahawk.Resolver, {
+
+    settings: {
+        name: 'Stub',
+        weight: 1,
+        timeout: 5
+    },
+
+    resolve: function (params) {
+        return [{
+            artist: params.artist,
+            album: params.album,
+            track: params.track,
+            source: this.settings.name,
+            url: 'http://localhost/stub.mp3',
+            extension: 'mp3',
+            mimetype: 'audio/mpeg',
+            bitrate: 128,
+            duration: 180,
+            score: 1.0
+        }];
+    },
+
+    search: function (params) {
+        return [];
+    }
+});
+
+Tomahawk.resolver.instance = StubResolver;
@@ -166,7 +166,8 @@ var TomahawkResolverCapability = {
     Browsable:      1,
     PlaylistSync:   2,
     AccountFactory: 4,
-    UrlLookup:      8
+    UrlLookup:      8,
+    BatchResolve:   16
 };
 
 //Deprecated for 0.9 resolvers. Use Tomahawk.UrlType instead.
@@ -304,6 +305,63 @@ Tomahawk.Resolver = {
         });
     },
 
+    /**
+     * Resolves params.queries, a list of {qid, artist, album, track} or {qid, query}
+     * objects, in a single call. Only used once the resolver reported the
+     * BatchResolve capability.
+     *
+     * Resolvers can implement resolveBatch(params) and return an object mapping each
+     * qid to what resolve() would have returned for it. Otherwise the queries are
+     * resolved one by one.
+     */
+    _adapter_resolveBatch: function (params) {
+        var that = this;
+
+        if (typeof this.resolveBatch === 'function') {
+            return RSVP.Promise.resolve(this.resolveBatch(params)).then(function (results) {
+                var mapped = {};
+                for (var qid in results) {
+                    if (Array.isArray(results[qid])) {
+                        mapped[qid] = {
+                            'tracks': results[qid]
+                        };
+                    } else {
+                        mapped[qid] = results[qid];
+                    }
+                }
+
+                return {
+                    'results': mapped
+                };
+            });
+        }
+
+        var promises = params.queries.map(function (query) {
+            query.type = params.type;
+            var methodName = query.hasOwnProperty('query') ? 'search' : 'resolve';
+            return new RSVP.Promise(function (resolve) {
+                resolve(Tomahawk.PluginManager.invokeSync(null, that.id, methodName, query));
+            }).then(null, function (error) {
+                // a failing query must not take down the rest of the batch
+                Tomahawk.log("resolveBatch: " + methodName + " failed for " + query.qid + ": " + error);
+                return null;
+            });
+        });
+
+        return RSVP.all(promises).then(function (results) {
+            var mapped = {};
+            for (var i = 0; i < results.length; i++) {
+                if (results[i]) {
+                    mapped[params.queries[i].qid] = results[i];
+                }
+            }
+
+            return {
+                'results': mapped
+            };
+        });
+    },
+
     _adapter_testConfig: function (config) {
         return RSVP.Promise.resolve(this.testConfig(config)).then(function (results) {
             results = results || Tomahawk.ConfigTestResultType.Success;
@@ -814,6 +872,27 @@ Tomahawk.NativeScriptJobManager = {
     }
 };
 
+// Tomahawk hands us calls and results through this channel as plain objects,
+// nothing has to be evaluated for them.
+if (window.TomahawkChannel) {
+    TomahawkChannel.invoke.connect(function (calls) {
+        for (var i = 0; i < calls.length; i++) {
+            var call = calls[i];
+            try {
+                Tomahawk.PluginManager.invoke(call.requestId, call.objectId, call.methodName, call.params);
+            } catch (e) {
+                Tomahawk.log("Failed to invoke " + call.methodName + " on ScriptObject " + call.objectId + ": " + e);
+            }
+        }
+    });
+    TomahawkChannel.nativeScriptJobResult.connect(function (requestId, result) {
+        Tomahawk.NativeScriptJobManager.reportNativeScriptJobResult(requestId, result);
+    });
+    TomahawkChannel.nativeScriptJobError.connect(function (requestId, error) {
+        Tomahawk.NativeScriptJobManager.reportNativeScriptJobError(requestId, error);
+    });
+}
+
 Tomahawk.UrlType = {
     Any: 0,
     Playlist: 1,
@@ -1429,6 +1508,7 @@ Tomahawk.Collection = {
             return t.execDeferredStatements();
         }).then(function (results) {
             that._trackCount = results[0].length;
+            that._bumpRevision(id);
             Tomahawk.log("Added " + results[0].length + " tracks to collection '" + id + "'");
             // Add the db ids together with the basic metadata to the fuzzy index list
             var fuzzyIndexList = [];
@@ -1466,6 +1546,7 @@ Tomahawk.Collection = {
                         reject();
                     }, function () {
                         delete that.cachedDbs[id];
+                        that._bumpRevision(id);
                         Tomahawk.deleteFuzzyIndex(id);
                         Tomahawk.log("Wiped collection '" + id + "'");
                         resolve();
@@ -1475,7 +1556,43 @@ Tomahawk.Collection = {
     },
 
     revision: function (params) {
-        return RSVP.resolve();
+        var id = params.id;
+        if (typeof id === 'undefined') {
+            id = this.settings.id;
+        }
+
+        return window.localStorage[id + "_revision"] || "";
+    },
+
+    _bumpRevision: function (id) {
+        window.localStorage[id + "_revision"] = Date.now().toString();
+    },
+
+    /**
+     * Feeds the native mirror of this collection. Returns the tracks added since
+     * params.revision, or the whole listing with reset set if we can't tell.
+     * Our WebSQL store keeps no changelog, so any change means a full listing.
+     * That's why mirroring is off unless a collection sets settings.mirror itself,
+     * which only pays off for listings that rarely change.
+     */
+    changes: function (params) {
+        var revision = this.revision({});
+        if (revision !== "" && revision === params.revision) {
+            return {
+                revision: revision,
+                tracks: [],
+                removed: []
+            };
+        }
+
+        return this.tracks({}).then(function (result) {
+            return {
+                revision: revision,
+                reset: true,
+                tracks: result.tracks,
+                removed: []
+            };
+        });
     },
 
     _fuzzyIndexIdsToTracks: function (resultIds, id) {
@@ -1537,6 +1654,10 @@ Tomahawk.Collection = {
         });
     },
 
+    _adapter_resolveBatch: function (params) {
+        return Tomahawk.Resolver._adapter_resolveBatch.call(this, params);
+    },
+
     resolve: function (params) {
         var resultIds = Tomahawk.resolveFromFuzzyIndex(params.artist, params.album, params.track);
         return this._fuzzyIndexIdsToTracks(resultIds);
@@ -1766,6 +1887,8 @@ Tomahawk.Collection = {
         this.settings.capabilities = [Tomahawk.Collection.BrowseCapability.Artists,
             Tomahawk.Collection.BrowseCapability.Albums,
             Tomahawk.Collection.BrowseCapability.Tracks];
+        this.settings.batchresolve = true;
+        this.settings.revision = this.revision({});
         if (!this.settings.weight && this.resolver && this.resolver.settings.weight) {
             this.settings.weight = this.resolver.settings.weight;
         }
@@ -0,0 +1,46 @@
+-- Script to migate from db version 31 to 32.
+
+-- Aggregate tables, so collection and play statistics don't need to scan
+-- file and playback_log every time they are asked for
+
+CREATE TABLE IF NOT EXISTS collection_stats (
+    source INTEGER PRIMARY KEY,
+    numfiles INTEGER NOT NULL DEFAULT 0,
+    lastmodified INTEGER NOT NULL DEFAULT 0,
+    plays INTEGER NOT NULL DEFAULT 0,
+    secs_played INTEGER NOT NULL DEFAULT 0
+);
+
+CREATE TABLE IF NOT EXISTS track_stats (
+    track INTEGER PRIMARY KEY REFERENCES track(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    plays INTEGER NOT NULL DEFAULT 0,
+    secs_played INTEGER NOT NULL DEFAULT 0
+);
+CREATE INDEX track_stats_plays ON track_stats(plays);
+
+CREATE TABLE IF NOT EXISTS artist_stats (
+    artist INTEGER PRIMARY KEY REFERENCES artist(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    plays INTEGER NOT NULL DEFAULT 0,
+    secs_played INTEGER NOT NULL DEFAULT 0
+);
+CREATE INDEX artist_stats_plays ON artist_stats(plays);
+
+INSERT INTO collection_stats(source, numfiles, lastmodified)
+    SELECT coalesce(source, 0), count(*), coalesce(max(mtime), 0) FROM file GROUP BY source;
+
+INSERT OR IGNORE INTO collection_stats(source)
+    SELECT DISTINCT coalesce(source, 0) FROM playback_log;
+
+UPDATE collection_stats SET
+    plays = (SELECT count(*) FROM playback_log WHERE coalesce(playback_log.source, 0) = collection_stats.source),
+    secs_played = (SELECT coalesce(sum(secs_played), 0) FROM playback_log WHERE coalesce(playback_log.source, 0) = collection_stats.source);
+
+INSERT INTO track_stats(track, plays, secs_played)
+    SELECT track, count(*), sum(secs_played) FROM playback_log
+    WHERE source IS NULL AND track IS NOT NULL GROUP BY track;
+
+INSERT INTO artist_stats(artist, plays, secs_played)
+    SELECT track.artist, count(*), sum(playback_log.secs_played) FROM playback_log, track
+    WHERE playback_log.source IS NULL AND track.id = playback_log.track GROUP BY track.artist;
+
+UPDATE settings SET v = '32' WHERE k == 'schema_version';
@@ -0,0 +1,24 @@
+-- Script to migate from db version 32 to 33.
+
+-- Daily play count rollups, charts and trending are computed from these
+-- instead of aggregating the whole playback_log
+
+CREATE TABLE IF NOT EXISTS playback_daily (
+    day INTEGER NOT NULL,
+    source INTEGER NOT NULL,
+    track INTEGER NOT NULL REFERENCES track(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    artist INTEGER NOT NULL REFERENCES artist(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    plays INTEGER NOT NULL DEFAULT 0,
+    secs_played INTEGER NOT NULL DEFAULT 0,
+    PRIMARY KEY (day, source, track)
+);
+CREATE INDEX playback_daily_track ON playback_daily(track);
+CREATE INDEX playback_daily_artist ON playback_daily(artist);
+
+INSERT INTO playback_daily(day, source, track, artist, plays, secs_played)
+    SELECT playback_log.playtime / 86400, coalesce(playback_log.source, 0), playback_log.track, track.artist, count(*), sum(playback_log.secs_played)
+    FROM playback_log, track
+    WHERE track.id = playback_log.track
+    GROUP BY playback_log.playtime / 86400, playback_log.source, playback_log.track;
+
+UPDATE settings SET v = '33' WHERE k == 'schema_version';
@@ -0,0 +1,21 @@
+-- Script to migate from db version 33 to 34.
+
+-- Loudness moves from track attributes to tables keyed by file and album:
+-- a track id is shared by every file and album it appears on. The old values
+-- can't be told apart, so they are dropped and the files analysed again.
+
+CREATE TABLE IF NOT EXISTS file_loudness (
+    file INTEGER PRIMARY KEY REFERENCES file(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    loudness REAL,
+    peak REAL NOT NULL
+);
+
+CREATE TABLE IF NOT EXISTS album_loudness (
+    album INTEGER PRIMARY KEY REFERENCES album(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    loudness REAL NOT NULL,
+    peak REAL NOT NULL
+);
+
+DELETE FROM track_attributes WHERE k IN ('replaygain_loudness', 'replaygain_peak', 'replaygain_albumloudness', 'replaygain_albumpeak');
+
+UPDATE settings SET v = '34' WHERE k == 'schema_version';
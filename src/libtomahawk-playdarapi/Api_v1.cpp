@@ -30,14 +30,24 @@
 #include "utils/TomahawkUtils.h"
 
 #include "Api_v1_5.h"
+#include "BatchRequestHandler.h"
 #include "Pipeline.h"
 #include "Result.h"
+#include "ResultsResponseHandler.h"
 #include "Source.h"
 #include "StatResponseHandler.h"
+#include "StreamResponseDevice.h"
 #include "UrlHandler.h"
 
 #include <QHash>
 
+// longest time in ms a get_results request may be held back waiting for results
+#define PLAYDARAPI_MAX_WAIT 30000
+// most queries a single batch request may carry
+#define PLAYDARAPI_MAX_BATCH 5000
+// largest batch request body we are willing to buffer, in bytes
+#define PLAYDARAPI_MAX_BODY 2 * 1024 * 1024
+
 using namespace Tomahawk;
 using namespace TomahawkUtils;
 
@@ -183,6 +193,8 @@ Api_v1::api( QxtWebRequestEvent* event, const QString& version, const QString& m
           if ( method == "stat" )        return stat( event );
           if ( method == "resolve" )     return resolve( event );
           if ( method == "get_results" ) return get_results( event );
+          if ( method == "resolve_batch" )     return resolve_batch( event );
+          if ( method == "get_results_batch" ) return get_results_batch( event );
       }
 
       send404( event );
@@ -251,25 +263,112 @@ Api_v1::sid( QxtWebRequestEvent* event, QString unused )
 void
 Api_v1::processSid( QxtWebRequestEvent* event, const Tomahawk::result_ptr rp, const QString url, QSharedPointer< QIODevice > iodev )
 {
-    Q_UNUSED( url );
-
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO;
     if ( !iodev || !rp )
     {
         return send404( event ); // 503?
     }
-    m_ioDevice = iodev;
 
-    QxtWebPageEvent* e = new QxtWebPageEvent( event->sessionID, event->requestID, iodev.data() );
-    e->streaming = iodev->isSequential();
+    // ranges can only be served from devices we can seek in and know the size of
+    qint64 size = rp->size() > 0 ? rp->size() : -1;
+    const bool seekable = !iodev->isSequential();
+    if ( seekable && size < 0 && iodev->size() > 0 )
+        size = iodev->size();
+
+    QString range;
+    for ( QMultiHash< QString, QString >::const_iterator it = event->headers.constBegin(); it != event->headers.constEnd(); ++it )
+    {
+        if ( it.key().toLower() == "range" )
+            range = it.value();
+    }
+
+    qint64 start = 0;
+    qint64 end = size - 1;
+    const bool partial = seekable && size > 0 && !range.isEmpty();
+    if ( partial )
+    {
+        if ( !parseRange( range, size, &start, &end ) )
+        {
+            QxtWebPageEvent* e = new QxtWebPageEvent( event->sessionID, event->requestID, QByteArray() );
+            e->status = 416;
+            e->statusMessage = "Requested Range Not Satisfiable";
+            e->headers.insert( "Content-Range", QString( "bytes */%1" ).arg( size ) );
+            postEvent( e );
+            return;
+        }
+
+        // a BufferIODevice requests the missing blocks from its peer when seeking
+        if ( !iodev->seek( start ) )
+        {
+            tDebug() << Q_FUNC_INFO << "Could not seek to" << start << "in" << url;
+            return send404( event );
+        }
+    }
+
+    // every request gets its own device, so concurrent streams don't interfere
+    const qint64 length = size > 0 ? end - start + 1 : -1;
+    StreamResponseDevice* device = new StreamResponseDevice( iodev, length );
+
+    QxtWebPageEvent* e = new QxtWebPageEvent( event->sessionID, event->requestID, device );
     e->contentType = rp->mimetype().toLatin1();
-    if ( rp->size() > 0 )
-        e->headers.insert( "Content-Length", QString::number( rp->size() ) );
+    if ( seekable )
+        e->headers.insert( "Accept-Ranges", "bytes" );
+    if ( length > 0 )
+    {
+        // the length is known, so send the body as is rather than in chunks
+        e->chunked = false;
+        e->headers.insert( "Content-Length", QString::number( length ) );
+    }
+    if ( partial )
+    {
+        e->status = 206;
+        e->statusMessage = "Partial Content";
+        e->headers.insert( "Content-Range", QString( "bytes %1-%2/%3" ).arg( start ).arg( end ).arg( size ) );
+    }
 
     postEvent( e );
 }
 
 
+bool
+Api_v1::parseRange( const QString& header, qint64 size, qint64* start, qint64* end )
+{
+    // we only support a single range: bytes=<start>-[<end>] or bytes=-<suffix length>
+    const QString spec = header.trimmed();
+    if ( !spec.startsWith( "bytes=" ) || spec.contains( ',' ) )
+        return false;
+
+    const QString from = spec.mid( 6 ).section( '-', 0, 0 ).trimmed();
+    const QString to = spec.mid( 6 ).section( '-', 1 ).trimmed();
+
+    bool ok = true;
+    if ( from.isEmpty() )
+    {
+        const qint64 suffix = to.toLongLong( &ok );
+        if ( !ok || suffix <= 0 )
+            return false;
+
+        *start = qMax( (qint64)0, size - suffix );
+        *end = size - 1;
+        return true;
+    }
+
+    *start = from.toLongLong( &ok );
+    if ( !ok || *start < 0 || *start >= size )
+        return false;
+
+    *end = size - 1;
+    if ( !to.isEmpty() )
+    {
+        *end = qMin( to.toLongLong( &ok ), size - 1 );
+        if ( !ok || *end < *start )
+            return false;
+    }
+
+    return true;
+}
+
+
 void
 Api_v1::send404( QxtWebRequestEvent* event )
 {
@@ -414,11 +513,36 @@ Api_v1::get_results( QxtWebRequestEvent* event )
         return;
     }
 
+    // with wait=<ms> the request is held back until there is something new to
+    // tell, since=<n> being the number of results the client already knows about
+    const int wait = qBound( 0, urlQueryItemValue( event->url, "wait" ).toInt(), PLAYDARAPI_MAX_WAIT );
+    const int since = urlQueryItemValue( event->url, "since" ).toInt();
+    if ( wait > 0 && !ResultsResponseHandler::hasNews( qry, since ) )
+    {
+        new ResultsResponseHandler( this, event, qry, since, wait );
+        return;
+    }
+
+    sendResults( event, qry );
+}
+
+
+void
+Api_v1::sendResults( QxtWebRequestEvent* event, const Tomahawk::query_ptr& qry )
+{
+    sendJSON( resultsToVariant( qry ), event );
+}
+
+
+QVariantMap
+Api_v1::resultsToVariant( const Tomahawk::query_ptr& qry ) const
+{
     QVariantMap r;
     r.insert( "qid", qry->id() );
     r.insert( "poll_interval", 1300 );
     r.insert( "refresh_interval", 1000 );
     r.insert( "poll_limit", 14 );
+    r.insert( "max_wait", PLAYDARAPI_MAX_WAIT );
     r.insert( "solved", qry->playable() );
     r.insert( "query", qry->toVariant() );
 
@@ -430,6 +554,109 @@ Api_v1::get_results( QxtWebRequestEvent* event )
     }
     r.insert( "results", res );
 
+    return r;
+}
+
+
+void
+Api_v1::readBatch( QxtWebRequestEvent* event, const QString& key, void ( Api_v1::*callback )( QxtWebRequestEvent*, const QVariantList&, bool ) )
+{
+    // refuse bodies of unknown or excessive length before buffering any of them
+    if ( event->content.isNull() || event->content->wantAll() || event->content->unreadBytes() > PLAYDARAPI_MAX_BODY )
+    {
+        tDebug( LOGVERBOSE ) << "Rejecting HTTP batch request with an unknown or too large body";
+        if ( !event->content.isNull() )
+            event->content->ignoreRemainingContent();
+
+        return sendJsonError( event, QString( "Expected a request body of up to %1 bytes" ).arg( PLAYDARAPI_MAX_BODY ) );
+    }
+
+    // the body is read as it arrives, the callback answers the request once it's complete
+    new BatchRequestHandler( this, event, key, PLAYDARAPI_MAX_BATCH, PLAYDARAPI_MAX_WAIT, callback );
+}
+
+
+void
+Api_v1::resolve_batch( QxtWebRequestEvent* event )
+{
+    readBatch( event, "queries", &Api_v1::resolveBatch );
+}
+
+
+void
+Api_v1::resolveBatch( QxtWebRequestEvent* event, const QVariantList& list, bool ok )
+{
+    if ( !ok )
+    {
+        tDebug( LOGVERBOSE ) << "Malformed HTTP resolve_batch request";
+        return sendJsonError( event, QString( "Expected a JSON array of up to %1 queries" ).arg( PLAYDARAPI_MAX_BATCH ) );
+    }
+
+    // qids line up with the posted queries, malformed ones get an empty qid
+    QList< query_ptr > queries;
+    QVariantList qids;
+    foreach ( const QVariant& v, list )
+    {
+        const QVariantMap m = v.toMap();
+        const QString artist = m.value( "artist" ).toString();
+        const QString track = m.value( "track" ).toString();
+        if ( artist.trimmed().isEmpty() || track.trimmed().isEmpty() )
+        {
+            qids << QString();
+            continue;
+        }
+
+        QString qid = m.value( "qid" ).toString();
+        if ( qid.isEmpty() )
+            qid = uuid();
+
+        query_ptr qry = Query::get( artist, track, m.value( "album" ).toString(), qid, false );
+        if ( qry.isNull() )
+        {
+            qids << QString();
+            continue;
+        }
+
+        queries << qry;
+        qids << qid;
+    }
+
+    if ( !queries.isEmpty() )
+        Pipeline::instance()->resolve( queries, true, true );
+
+    QVariantMap r;
+    r.insert( "qids", qids );
+    sendJSON( r, event );
+}
+
+
+void
+Api_v1::get_results_batch( QxtWebRequestEvent* event )
+{
+    readBatch( event, "qids", &Api_v1::sendResultsBatch );
+}
+
+
+void
+Api_v1::sendResultsBatch( QxtWebRequestEvent* event, const QVariantList& list, bool ok )
+{
+    if ( !ok )
+    {
+        tDebug( LOGVERBOSE ) << "Malformed HTTP get_results_batch request";
+        return sendJsonError( event, QString( "Expected a JSON array of up to %1 qids" ).arg( PLAYDARAPI_MAX_BATCH ) );
+    }
+
+    // unknown qids are left out, clients match the entries up by their qid
+    QVariantList results;
+    foreach ( const QVariant& v, list )
+    {
+        query_ptr qry = Pipeline::instance()->query( v.toString() );
+        if ( !qry.isNull() )
+            results << resultsToVariant( qry );
+    }
+
+    QVariantMap r;
+    r.insert( "results", results );
     sendJSON( r, event );
 }
 
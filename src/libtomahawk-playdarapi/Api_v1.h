@@ -39,7 +39,9 @@ class Api_v1_5;
 
 namespace Tomahawk
 {
+    class Query;
     class Result;
+    typedef QSharedPointer< Query > query_ptr;
     typedef QSharedPointer< Result > result_ptr;
 }
 
@@ -73,6 +75,11 @@ public slots:
     void staticdata( QxtWebRequestEvent* event, const QString& file );
     void staticdata( QxtWebRequestEvent* event, const QString& path, const QString& file );
     void get_results( QxtWebRequestEvent* event );
+    void sendResults( QxtWebRequestEvent* event, const Tomahawk::query_ptr& query );
+
+    // POST a JSON array of queries or qids to resolve or fetch results for many at once
+    void resolve_batch( QxtWebRequestEvent* event );
+    void get_results_batch( QxtWebRequestEvent* event );
     void sendJSON( const QVariantMap& m, QxtWebRequestEvent* event );
 
     void sendJsonError( QxtWebRequestEvent* event, const QString& message );
@@ -89,9 +96,14 @@ protected:
     void sendPlain404( QxtWebRequestEvent* event, const QString& message, const QString& statusmessage );
 
 private:
+    void readBatch( QxtWebRequestEvent* event, const QString& key, void ( Api_v1::*callback )( QxtWebRequestEvent*, const QVariantList&, bool ) );
+    void resolveBatch( QxtWebRequestEvent* event, const QVariantList& list, bool ok );
+    void sendResultsBatch( QxtWebRequestEvent* event, const QVariantList& list, bool ok );
+    QVariantMap resultsToVariant( const Tomahawk::query_ptr& query ) const;
+
     void processSid( QxtWebRequestEvent* event, const Tomahawk::result_ptr, const QString url, QSharedPointer< QIODevice > );
+    static bool parseRange( const QString& header, qint64 size, qint64* start, qint64* end );
 
-    QSharedPointer< QIODevice > m_ioDevice;
     Api_v1_5* m_api_v1_5;
 };
 
@@ -0,0 +1,113 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BatchRequestHandler.h"
+
+#include "utils/Json.h"
+#include "utils/Logger.h"
+
+#include "Api_v1.h"
+
+BatchRequestHandler::BatchRequestHandler( Api_v1* parent, QxtWebRequestEvent* event, const QString& key, int maxEntries, int timeout, Callback callback )
+    : QObject( parent )
+    , m_parent( parent )
+    , m_storedEvent( event )
+    , m_content( event->content )
+    , m_key( key )
+    , m_maxEntries( maxEntries )
+    , m_callback( callback )
+    , m_done( false )
+{
+    connect( m_content.data(), SIGNAL( readyRead() ), SLOT( read() ) );
+    connect( m_content.data(), SIGNAL( readChannelFinished() ), SLOT( read() ) );
+    connect( m_content.data(), SIGNAL( destroyed() ), SLOT( contentDestroyed() ) );
+
+    m_timer.setSingleShot( true );
+    connect( &m_timer, SIGNAL( timeout() ), SLOT( timeout() ) );
+    m_timer.start( timeout );
+
+    // the start of the body usually arrived along with the headers
+    QMetaObject::invokeMethod( this, "read", Qt::QueuedConnection );
+}
+
+
+void
+BatchRequestHandler::read()
+{
+    if ( m_done || m_content.isNull() )
+        return;
+
+    m_body.append( m_content->readAll() );
+
+    // readChannelFinished() also fires if the client went away mid-body, bytesNeeded() is 0 then too
+    if ( m_content->bytesNeeded() == 0 && m_content->bytesAvailable() == 0 )
+        finish( true );
+}
+
+
+void
+BatchRequestHandler::timeout()
+{
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Timed out reading batch request body";
+    if ( !m_content.isNull() )
+        m_content->ignoreRemainingContent();
+
+    finish( false );
+}
+
+
+void
+BatchRequestHandler::contentDestroyed()
+{
+    // the connection is gone, there is nobody left to answer
+    m_done = true;
+    m_timer.stop();
+    deleteLater();
+}
+
+
+void
+BatchRequestHandler::finish( bool complete )
+{
+    if ( m_done )
+        return;
+
+    m_done = true;
+    m_timer.stop();
+    if ( !m_content.isNull() )
+        disconnect( m_content.data(), 0, this, 0 );
+
+    bool ok = false;
+    QVariantList list;
+    if ( complete )
+    {
+        const QVariant v = TomahawkUtils::parseJson( m_body, &ok );
+
+        // accept a bare array as well as an object wrapping it
+        if ( v.type() == QVariant::List )
+            list = v.toList();
+        else if ( v.type() == QVariant::Map )
+            list = v.toMap().value( m_key ).toList();
+
+        ok = ok && !list.isEmpty() && list.count() <= m_maxEntries;
+    }
+
+    ( m_parent->*m_callback )( m_storedEvent, list, ok );
+
+    deleteLater();
+}
@@ -0,0 +1,69 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef BATCHREQUESTHANDLER_H
+#define BATCHREQUESTHANDLER_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QVariant>
+
+class Api_v1;
+class QxtWebContent;
+class QxtWebRequestEvent;
+
+/**
+ * Collects the body of a batch request as it arrives, without blocking the
+ * main thread, and hands the posted JSON list to the Api_v1 method that
+ * serves the request.
+ *
+ * The caller has to make sure the body has a known and sane length, this only
+ * reads what the client announced.
+ */
+class BatchRequestHandler : public QObject
+{
+    Q_OBJECT
+public:
+    /// Gets the event, the posted list and whether it was a valid batch of up to maxEntries
+    typedef void ( Api_v1::*Callback )( QxtWebRequestEvent* event, const QVariantList& list, bool ok );
+
+    BatchRequestHandler( Api_v1* parent, QxtWebRequestEvent* event, const QString& key, int maxEntries, int timeout, Callback callback );
+
+private slots:
+    void read();
+    void timeout();
+    void contentDestroyed();
+
+private:
+    void finish( bool complete );
+
+    Api_v1* m_parent;
+    QxtWebRequestEvent* m_storedEvent;
+    QPointer< QxtWebContent > m_content;
+    QString m_key;
+    int m_maxEntries;
+    Callback m_callback;
+    QByteArray m_body;
+    bool m_done;
+    QTimer m_timer;
+};
+
+#endif // BATCHREQUESTHANDLER_H
@@ -0,0 +1,81 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ResultsResponseHandler.h"
+
+#include "Api_v1.h"
+#include "Query.h"
+#include "Result.h"
+
+ResultsResponseHandler::ResultsResponseHandler( Api_v1* parent, QxtWebRequestEvent* event, const Tomahawk::query_ptr& query, int since, int wait )
+    : QObject( parent )
+    , m_parent( parent )
+    , m_storedEvent( event )
+    , m_query( query )
+    , m_since( since )
+    , m_done( false )
+{
+    connect( query.data(), SIGNAL( resultsChanged() ), SLOT( check() ) );
+    connect( query.data(), SIGNAL( solvedStateChanged( bool ) ), SLOT( check() ) );
+    connect( query.data(), SIGNAL( resolvingFinished( bool ) ), SLOT( check() ) );
+
+    m_timer.setSingleShot( true );
+    connect( &m_timer, SIGNAL( timeout() ), SLOT( respond() ) );
+    m_timer.start( wait );
+}
+
+
+bool
+ResultsResponseHandler::hasNews( const Tomahawk::query_ptr& query, int since )
+{
+    if ( query->solved() || query->resolvingFinished() )
+        return true;
+
+    int online = 0;
+    foreach ( const Tomahawk::result_ptr& rp, query->results() )
+    {
+        if ( rp->isOnline() )
+            online++;
+    }
+
+    return online > since;
+}
+
+
+void
+ResultsResponseHandler::check()
+{
+    if ( hasNews( m_query, m_since ) )
+        respond();
+}
+
+
+void
+ResultsResponseHandler::respond()
+{
+    if ( m_done )
+        return;
+
+    m_done = true;
+    m_timer.stop();
+    disconnect( m_query.data(), 0, this, 0 );
+
+    m_parent->sendResults( m_storedEvent, m_query );
+
+    deleteLater();
+}
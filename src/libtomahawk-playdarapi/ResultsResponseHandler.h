@@ -0,0 +1,60 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef RESULTSRESPONSEHANDLER_H
+#define RESULTSRESPONSEHANDLER_H
+
+#include "Typedefs.h"
+
+#include <QObject>
+#include <QTimer>
+
+class Api_v1;
+class QxtWebRequestEvent;
+
+/**
+ * Holds back a get_results request until the query found new results, got
+ * solved or finished resolving, or until the request's wait time is up.
+ *
+ * Waiting costs nothing but this object and a timer on the main thread, so
+ * plenty of clients can wait at the same time.
+ */
+class ResultsResponseHandler : public QObject
+{
+    Q_OBJECT
+public:
+    ResultsResponseHandler( Api_v1* parent, QxtWebRequestEvent* event, const Tomahawk::query_ptr& query, int since, int wait );
+
+    /// True if a client that already knows about since results has something new to fetch
+    static bool hasNews( const Tomahawk::query_ptr& query, int since );
+
+private slots:
+    void check();
+    void respond();
+
+private:
+    Api_v1* m_parent;
+    QxtWebRequestEvent* m_storedEvent;
+    Tomahawk::query_ptr m_query;
+    int m_since;
+    bool m_done;
+    QTimer m_timer;
+};
+
+#endif // RESULTSRESPONSEHANDLER_H
@@ -0,0 +1,127 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StreamResponseDevice.h"
+
+#include "utils/Logger.h"
+
+
+StreamResponseDevice::StreamResponseDevice( const QSharedPointer< QIODevice >& source, qint64 length, QObject* parent )
+    : QIODevice( parent )
+    , m_source( source )
+    , m_remaining( length )
+    , m_sourceFinished( false )
+    , m_finishing( false )
+{
+    connect( source.data(), SIGNAL( readyRead() ), SIGNAL( readyRead() ) );
+    connect( source.data(), SIGNAL( readChannelFinished() ), SLOT( onSourceFinished() ) );
+    connect( source.data(), SIGNAL( aboutToClose() ), SLOT( onSourceFinished() ) );
+
+    // no buffering on our side, QxtWeb only reads what bytesAvailable() promised
+    open( QIODevice::ReadOnly | QIODevice::Unbuffered );
+}
+
+
+StreamResponseDevice::~StreamResponseDevice()
+{
+    disconnect( m_source.data(), 0, this, 0 );
+}
+
+
+qint64
+StreamResponseDevice::bytesAvailable() const
+{
+    if ( m_finishing )
+        return 0;
+
+    const qint64 available = m_source->bytesAvailable();
+    if ( m_remaining < 0 )
+        return available;
+
+    return qMin( available, m_remaining );
+}
+
+
+qint64
+StreamResponseDevice::readData( char* data, qint64 maxSize )
+{
+    if ( m_finishing )
+        return -1;
+
+    if ( m_remaining >= 0 )
+        maxSize = qMin( maxSize, m_remaining );
+
+    const qint64 read = m_source->read( data, maxSize );
+    if ( read > 0 && m_remaining >= 0 )
+        m_remaining -= read;
+
+    if ( isDone() )
+    {
+        m_finishing = true;
+        QMetaObject::invokeMethod( this, "finish", Qt::QueuedConnection );
+    }
+
+    return read;
+}
+
+
+qint64
+StreamResponseDevice::writeData( const char* data, qint64 maxSize )
+{
+    Q_UNUSED( data );
+    Q_UNUSED( maxSize );
+
+    return -1;
+}
+
+
+bool
+StreamResponseDevice::isDone() const
+{
+    if ( m_remaining == 0 )
+        return true;
+
+    if ( m_source->bytesAvailable() > 0 )
+        return false;
+
+    // random access devices are done at their end, streams once they said so
+    return m_sourceFinished || ( !m_source->isSequential() && m_source->atEnd() );
+}
+
+
+void
+StreamResponseDevice::onSourceFinished()
+{
+    m_sourceFinished = true;
+
+    if ( !m_finishing && isDone() )
+    {
+        m_finishing = true;
+        QMetaObject::invokeMethod( this, "finish", Qt::QueuedConnection );
+    }
+}
+
+
+void
+StreamResponseDevice::finish()
+{
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Stream response complete";
+
+    // QxtWeb ends the response once its data source is about to close
+    close();
+}
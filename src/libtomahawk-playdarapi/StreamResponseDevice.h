@@ -0,0 +1,63 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+#ifndef STREAMRESPONSEDEVICE_H
+#define STREAMRESPONSEDEVICE_H
+
+#include <QIODevice>
+#include <QSharedPointer>
+
+/**
+ * Hands (a range of) a stream to QxtWeb for a single /sid request.
+ *
+ * QxtWeb deletes the data source of a response once it's done with it, which
+ * must not happen to a device that is still shared with the rest of Tomahawk.
+ * Each request gets one of these instead. It keeps the source alive for as long
+ * as the response needs it and closes itself after the last requested byte, so
+ * QxtWeb knows when a response of a still open stream is complete.
+ */
+class StreamResponseDevice : public QIODevice
+{
+    Q_OBJECT
+public:
+    /// Serves length bytes from the source's current position, or everything if length is negative
+    StreamResponseDevice( const QSharedPointer< QIODevice >& source, qint64 length, QObject* parent = 0 );
+    virtual ~StreamResponseDevice();
+
+    virtual bool isSequential() const { return true; }
+    virtual qint64 bytesAvailable() const;
+
+protected:
+    virtual qint64 readData( char* data, qint64 maxSize );
+    virtual qint64 writeData( const char* data, qint64 maxSize );
+
+private slots:
+    void onSourceFinished();
+    void finish();
+
+private:
+    bool isDone() const;
+
+    QSharedPointer< QIODevice > m_source;
+    qint64 m_remaining;
+    bool m_sourceFinished;
+    bool m_finishing;
+};
+
+#endif // STREAMRESPONSEDEVICE_H
@@ -22,6 +22,7 @@
 #include "database/Database.h"
 #include "database/DatabaseImpl.h"
 #include "database/IdThreadWorker.h"
+#include "utils/CoverCache.h"
 #include "utils/TomahawkUtilsGui.h"
 #include "utils/Logger.h"
 
@@ -279,6 +280,38 @@ Album::purchased() const
 }
 
 
+void
+Album::loadCover() const
+{
+    Q_D( const Album );
+    if ( d->coverLoaded || d->coverLoading || d->name.isEmpty() )
+        return;
+
+    Tomahawk::InfoSystem::InfoStringHash trackInfo;
+    trackInfo["artist"] = d->artist->name();
+    trackInfo["album"] = d->name;
+
+    Tomahawk::InfoSystem::InfoRequestData requestData;
+    requestData.caller = infoid();
+    requestData.type = Tomahawk::InfoSystem::InfoAlbumCoverArt;
+    requestData.input = QVariant::fromValue< Tomahawk::InfoSystem::InfoStringHash >( trackInfo );
+    requestData.customData = QVariantMap();
+    requestData.allSources = true;
+
+    connect( Tomahawk::InfoSystem::InfoSystem::instance(),
+            SIGNAL( info( Tomahawk::InfoSystem::InfoRequestData, QVariant ) ),
+            SLOT( infoSystemInfo( Tomahawk::InfoSystem::InfoRequestData, QVariant ) ) );
+
+    connect( Tomahawk::InfoSystem::InfoSystem::instance(),
+            SIGNAL( finished( QString ) ),
+            SLOT( infoSystemFinished( QString ) ) );
+
+    Tomahawk::InfoSystem::InfoSystem::instance()->getInfo( requestData );
+
+    d->coverLoading = true;
+}
+
+
 QPixmap
 Album::cover( const QSize& size, bool forceLoad ) const
 {
@@ -294,53 +327,21 @@ Album::cover( const QSize& size, bool forceLoad ) const
         if ( !forceLoad )
             return QPixmap();
 
-        Tomahawk::InfoSystem::InfoStringHash trackInfo;
-        trackInfo["artist"] = d->artist->name();
-        trackInfo["album"] = d->name;
-
-        Tomahawk::InfoSystem::InfoRequestData requestData;
-        requestData.caller = infoid();
-        requestData.type = Tomahawk::InfoSystem::InfoAlbumCoverArt;
-        requestData.input = QVariant::fromValue< Tomahawk::InfoSystem::InfoStringHash >( trackInfo );
-        requestData.customData = QVariantMap();
-        requestData.allSources = true;
-
-        connect( Tomahawk::InfoSystem::InfoSystem::instance(),
-                SIGNAL( info( Tomahawk::InfoSystem::InfoRequestData, QVariant ) ),
-                SLOT( infoSystemInfo( Tomahawk::InfoSystem::InfoRequestData, QVariant ) ) );
-
-        connect( Tomahawk::InfoSystem::InfoSystem::instance(),
-                SIGNAL( finished( QString ) ),
-                SLOT( infoSystemFinished( QString ) ) );
-
-        Tomahawk::InfoSystem::InfoSystem::instance()->getInfo( requestData );
-
-        d->coverLoading = true;
+        loadCover();
     }
 
+    // sized covers are what views paint, never decode those on the GUI thread
+    if ( !size.isEmpty() )
+        return CoverCache::instance()->cover( infoid(), d->coverBuffer, size, const_cast< Album* >( this ) );
+
     if ( !d->cover && !d->coverBuffer.isEmpty() )
     {
         QPixmap cover;
         cover.loadFromData( d->coverBuffer );
-        d->coverBuffer.clear();
 
         d->cover = new QPixmap( TomahawkUtils::squareCenterPixmap( cover ) );
     }
 
-    if ( d->cover && !d->cover->isNull() && !size.isEmpty() )
-    {
-        const QString cacheKey = QString( "%1_%2_%3" ).arg( infoid() ).arg( size.width() ).arg( size.height() );
-        QPixmap cover;
-
-        if ( !QPixmapCache::find( cacheKey, &cover ) )
-        {
-            cover = d->cover->scaled( size, Qt::KeepAspectRatio, Qt::SmoothTransformation );
-            QPixmapCache::insert( cacheKey, cover );
-            return cover;
-        }
-        return cover;
-    }
-
     if ( d->cover )
         return *d->cover;
     else
@@ -356,6 +357,14 @@ Album::coverLoaded() const
 }
 
 
+bool
+Album::hasCover() const
+{
+    Q_D( const Album );
+    return !d->coverBuffer.isEmpty() && !CoverCache::instance()->isUndecodable( infoid() );
+}
+
+
 void
 Album::infoSystemInfo( const Tomahawk::InfoSystem::InfoRequestData& requestData, const QVariant& output )
 {
@@ -386,9 +395,13 @@ Album::infoSystemInfo( const Tomahawk::InfoSystem::InfoRequestData& requestData,
     {
         QVariantMap returnedData = output.value< QVariantMap >();
         const QByteArray ba = returnedData["imgbytes"].toByteArray();
-        if ( !ba.isEmpty() )
+        if ( !ba.isEmpty() && ba != d->coverBuffer )
         {
             d->coverBuffer = ba;
+
+            delete d->cover;
+            d->cover = 0;
+            CoverCache::instance()->remove( infoid() );
         }
 
         d->coverLoaded = true;
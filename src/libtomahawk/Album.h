@@ -58,8 +58,13 @@ public:
     QString sortname() const;
 
     artist_ptr artist() const;
+    /// Returns a null pixmap while a sized cover is being decoded, coverChanged() is emitted once it is ready
     QPixmap cover( const QSize& size, bool forceLoad = true ) const;
+    /// Starts fetching the cover without decoding it
+    void loadCover() const;
     bool coverLoaded() const;
+    /// True if image data for the cover has been loaded, which doesn't mean it's decoded yet
+    bool hasCover() const;
     QString purchaseUrl() const;
     bool purchased() const;
 
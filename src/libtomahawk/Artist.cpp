@@ -27,6 +27,7 @@
 #include "database/DatabaseCommand_ArtistStats.h"
 #include "database/DatabaseCommand_TrackStats.h"
 #include "database/IdThreadWorker.h"
+#include "utils/CoverCache.h"
 #include "utils/TomahawkUtilsGui.h"
 #include "utils/Logger.h"
 
@@ -515,9 +516,13 @@ Artist::infoSystemInfo( Tomahawk::InfoSystem::InfoRequestData requestData, QVari
             else if ( output.isValid() )
             {
                 const QByteArray ba = returnedData["imgbytes"].toByteArray();
-                if ( !ba.isEmpty() )
+                if ( !ba.isEmpty() && ba != m_coverBuffer )
                 {
                     m_coverBuffer = ba;
+
+                    delete m_cover;
+                    m_cover = 0;
+                    CoverCache::instance()->remove( infoid() );
                 }
 
                 m_coverLoaded = true;
@@ -585,6 +590,36 @@ Artist::infoSystemFinished( QString target )
 }
 
 
+void
+Artist::loadCover() const
+{
+    if ( m_coverLoaded || m_coverLoading )
+        return;
+
+    Tomahawk::InfoSystem::InfoStringHash trackInfo;
+    trackInfo["artist"] = name();
+
+    Tomahawk::InfoSystem::InfoRequestData requestData;
+    requestData.caller = infoid();
+    requestData.type = Tomahawk::InfoSystem::InfoArtistImages;
+    requestData.input = QVariant::fromValue< Tomahawk::InfoSystem::InfoStringHash >( trackInfo );
+    requestData.customData = QVariantMap();
+
+    connect( Tomahawk::InfoSystem::InfoSystem::instance(),
+            SIGNAL( info( Tomahawk::InfoSystem::InfoRequestData, QVariant ) ),
+            SLOT( infoSystemInfo( Tomahawk::InfoSystem::InfoRequestData, QVariant ) ), Qt::UniqueConnection );
+
+    connect( Tomahawk::InfoSystem::InfoSystem::instance(),
+            SIGNAL( finished( QString ) ),
+            SLOT( infoSystemFinished( QString ) ), Qt::UniqueConnection );
+
+    m_infoJobs++;
+    Tomahawk::InfoSystem::InfoSystem::instance()->getInfo( requestData );
+
+    m_coverLoading = true;
+}
+
+
 QPixmap
 Artist::cover( const QSize& size, bool forceLoad ) const
 {
@@ -593,52 +628,21 @@ Artist::cover( const QSize& size, bool forceLoad ) const
         if ( !forceLoad )
             return QPixmap();
 
-        Tomahawk::InfoSystem::InfoStringHash trackInfo;
-        trackInfo["artist"] = name();
-
-        Tomahawk::InfoSystem::InfoRequestData requestData;
-        requestData.caller = infoid();
-        requestData.type = Tomahawk::InfoSystem::InfoArtistImages;
-        requestData.input = QVariant::fromValue< Tomahawk::InfoSystem::InfoStringHash >( trackInfo );
-        requestData.customData = QVariantMap();
-
-        connect( Tomahawk::InfoSystem::InfoSystem::instance(),
-                SIGNAL( info( Tomahawk::InfoSystem::InfoRequestData, QVariant ) ),
-                SLOT( infoSystemInfo( Tomahawk::InfoSystem::InfoRequestData, QVariant ) ), Qt::UniqueConnection );
-
-        connect( Tomahawk::InfoSystem::InfoSystem::instance(),
-                SIGNAL( finished( QString ) ),
-                SLOT( infoSystemFinished( QString ) ), Qt::UniqueConnection );
-
-        m_infoJobs++;
-        Tomahawk::InfoSystem::InfoSystem::instance()->getInfo( requestData );
-
-        m_coverLoading = true;
+        loadCover();
     }
 
+    // sized covers are what views paint, never decode those on the GUI thread
+    if ( !size.isEmpty() )
+        return CoverCache::instance()->cover( infoid(), m_coverBuffer, size, const_cast< Artist* >( this ) );
+
     if ( !m_cover && !m_coverBuffer.isEmpty() )
     {
         QPixmap cover;
         cover.loadFromData( m_coverBuffer );
-        m_coverBuffer.clear();
 
         m_cover = new QPixmap( TomahawkUtils::squareCenterPixmap( cover ) );
     }
 
-    if ( m_cover && !m_cover->isNull() && !size.isEmpty() )
-    {
-        const QString cacheKey = QString( "%1_%2_%3" ).arg( infoid() ).arg( size.width() ).arg( size.height() );
-        QPixmap cover;
-
-        if ( !QPixmapCache::find( cacheKey, &cover ) )
-        {
-            cover = m_cover->scaled( size, Qt::KeepAspectRatio, Qt::SmoothTransformation );
-            QPixmapCache::insert( cacheKey, cover );
-            return cover;
-        }
-        return cover;
-    }
-
     if ( m_cover )
         return *m_cover;
     else
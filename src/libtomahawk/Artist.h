@@ -65,7 +65,10 @@ public:
 
     QString biography() const;
 
+    /// Returns a null pixmap while a sized cover is being decoded, coverChanged() is emitted once it is ready
     QPixmap cover( const QSize& size, bool forceLoad = true ) const;
+    /// Starts fetching the cover without decoding it
+    void loadCover() const;
     bool coverLoaded() const { return m_coverLoaded; }
 
     Tomahawk::playlistinterface_ptr playlistInterface();
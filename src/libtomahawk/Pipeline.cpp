@@ -37,6 +37,7 @@
 #define CLEANUP_TIMEOUT 5 * 60 * 1000
 #define MINSCORE 0.5
 #define DEFAULT_RESOLVER_TIMEOUT 5000 // 5 seconds
+#define BATCH_WINDOW 50 // collect queries for batching resolvers this many ms
 
 using namespace Tomahawk;
 
@@ -62,6 +63,10 @@ Pipeline::Pipeline( QObject* parent )
 
     d->temporaryQueryTimer.setInterval( CLEANUP_TIMEOUT );
     connect( &d->temporaryQueryTimer, SIGNAL( timeout() ), SLOT( onTemporaryQueryTimer() ) );
+
+    d->batchTimer.setInterval( BATCH_WINDOW );
+    d->batchTimer.setSingleShot( true );
+    connect( &d->batchTimer, SIGNAL( timeout() ), SLOT( flushBatches() ) );
 }
 
 
@@ -142,6 +147,8 @@ Pipeline::removeResolver( Resolver* r )
 
     tDebug() << "Removed resolver:" << r->name();
     d->resolvers.removeAll( r );
+    // queries that were still waiting for this resolver run into their timeout
+    d->batches.remove( r );
     if ( d->running ) {
         // Only notify if Pipeline is still active.
         emit resolverRemoved( r );
@@ -581,7 +588,26 @@ Pipeline::shunt( const query_ptr& q )
 
         incQIDState( q, r );
         q->setCurrentResolver( r );
-        r->resolve( q );
+
+        const unsigned int batchSize = r->maxBatchSize();
+        if ( batchSize > 1 )
+        {
+            bool full;
+            {
+                QMutexLocker lock( &d->mut );
+                QList< query_ptr >& batch = d->batches[ r ];
+                batch << q;
+                full = (unsigned int)batch.count() >= batchSize;
+            }
+
+            if ( full )
+                flushBatch( r );
+            else if ( !d->batchTimer.isActive() )
+                d->batchTimer.start();
+        }
+        else
+            r->resolve( q );
+
         emit resolving( q );
 
         auto timeout = r->timeout();
@@ -605,6 +631,42 @@ Pipeline::shunt( const query_ptr& q )
 }
 
 
+void
+Pipeline::flushBatches()
+{
+    Q_D( Pipeline );
+
+    QList< Resolver* > resolvers;
+    {
+        QMutexLocker lock( &d->mut );
+        resolvers = d->batches.keys();
+    }
+
+    foreach ( Resolver* r, resolvers )
+        flushBatch( r );
+}
+
+
+void
+Pipeline::flushBatch( Resolver* r )
+{
+    Q_D( Pipeline );
+    if ( !d->running )
+        return;
+
+    QList< query_ptr > batch;
+    {
+        QMutexLocker lock( &d->mut );
+        batch = d->batches.take( r );
+        if ( batch.isEmpty() || !d->resolvers.contains( r ) )
+            return;
+    }
+
+    tDebug( LOGVERBOSE ) << "Dispatching batch of" << batch.count() << "queries to resolver" << r->name();
+    r->resolve( batch );
+}
+
+
 Tomahawk::Resolver*
 Pipeline::nextResolver( const Tomahawk::query_ptr& query ) const
 {
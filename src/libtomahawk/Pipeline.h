@@ -99,6 +99,7 @@ private slots:
     void timeoutShunt( const query_ptr& q, Tomahawk::Resolver* r );
     void shunt( const query_ptr& q );
     void shuntNext();
+    void flushBatches();
 
     void onTemporaryQueryTimer();
     void onResultUrlCheckerDone( );
@@ -108,6 +109,7 @@ private:
 
     void addResultsToQuery( const query_ptr& query, const QList< result_ptr >& results );
     Tomahawk::Resolver* nextResolver( const Tomahawk::query_ptr& query ) const;
+    void flushBatch( Tomahawk::Resolver* r );
 
     void checkQIDState( const Tomahawk::query_ptr& query );
     void incQIDState( const Tomahawk::query_ptr& query, Tomahawk::Resolver* );
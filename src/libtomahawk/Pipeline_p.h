@@ -23,6 +23,7 @@
 
 #include "Pipeline.h"
 
+#include <QHash>
 #include <QMutex>
 #include <QTimer>
 
@@ -56,6 +57,10 @@ private:
     // store temporary queries here and clean up after timeout threshold
     QList< query_ptr > queries_temporary;
 
+    // queries waiting to be handed to a batching resolver in one go
+    QHash< Resolver*, QList< query_ptr > > batches;
+    QTimer batchTimer;
+
     int maxConcurrentQueries;
     bool running;
     QTimer temporaryQueryTimer;
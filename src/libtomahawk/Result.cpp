@@ -432,6 +432,24 @@ Result::setModificationTime( unsigned int modtime )
 }
 
 
+void
+Result::setUrl( const QString& url )
+{
+    QMutexLocker cacheLock( &s_mutex );
+    QMutexLocker lock( &m_mutex );
+
+    if ( m_url == url )
+        return;
+
+    if ( s_results.value( m_url ).data() == this )
+        s_results.remove( m_url );
+    if ( !s_results.contains( url ) )
+        s_results.insert( url, m_ownRef );
+
+    m_url = url;
+}
+
+
 void
 Result::setTrack( const track_ptr& track )
 {
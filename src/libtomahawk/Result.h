@@ -132,6 +132,12 @@ public:
     void setSize( unsigned int size );
     void setModificationTime( unsigned int modtime );
 
+    /**
+     * Point this Result at the new url of a file that was moved, the cache
+     * entry follows along so Result::getCached finds it under the new url.
+     */
+    void setUrl( const QString& url );
+
     void setTrack( const track_ptr& track );
 
     unsigned int fileId() const;
@@ -785,6 +785,20 @@ TomahawkSettings::setScannerTime( uint time )
 }
 
 
+uint
+TomahawkSettings::scannerTagReaders() const
+{
+    return value( "scanner/tagreaders", 0 ).toUInt();
+}
+
+
+void
+TomahawkSettings::setScannerTagReaders( uint readers )
+{
+    setValue( "scanner/tagreaders", readers );
+}
+
+
 bool
 TomahawkSettings::watchForChanges() const
 {
@@ -799,6 +813,20 @@ TomahawkSettings::setWatchForChanges( bool watch )
 }
 
 
+bool
+TomahawkSettings::analyzeLoudness() const
+{
+    return value( "scanner/analyzeloudness", false ).toBool();
+}
+
+
+void
+TomahawkSettings::setAnalyzeLoudness( bool analyze )
+{
+    setValue( "scanner/analyzeloudness", analyze );
+}
+
+
 QString
 TomahawkSettings::downloadsPreferredFormat() const
 {
@@ -943,6 +971,20 @@ TomahawkSettings::setMuted( bool muted )
 }
 
 
+TomahawkSettings::VolumeNormalization
+TomahawkSettings::volumeNormalization() const
+{
+    return ( TomahawkSettings::VolumeNormalization ) value( "audio/volumenormalization", TomahawkSettings::NoNormalization ).toInt();
+}
+
+
+void
+TomahawkSettings::setVolumeNormalization( VolumeNormalization mode )
+{
+    setValue( "audio/volumenormalization", mode );
+}
+
+
 QString
 TomahawkSettings::proxyHost() const
 {
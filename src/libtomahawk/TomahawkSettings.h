@@ -56,6 +56,8 @@ public:
     bool hasScannerPaths() const;
     uint scannerTime() const;
     void setScannerTime( uint time );
+    uint scannerTagReaders() const; /// 0 means automatic
+    void setScannerTagReaders( uint readers );
 
     QString downloadsPreferredFormat() const;
     void setDownloadsPreferredFormat( const QString& format );
@@ -74,6 +76,9 @@ public:
     bool watchForChanges() const;
     void setWatchForChanges( bool watch );
 
+    bool analyzeLoudness() const; // false by default
+    void setAnalyzeLoudness( bool analyze );
+
     bool acceptedLegalWarning() const;
     void setAcceptedLegalWarning( bool accept );
 
@@ -110,6 +115,15 @@ public:
     bool muted() const;
     void setMuted( bool muted );
 
+    enum VolumeNormalization
+    {
+        NoNormalization,
+        TrackNormalization,
+        AlbumNormalization
+    };
+    VolumeNormalization volumeNormalization() const;
+    void setVolumeNormalization( VolumeNormalization mode );
+
     /// Playlist stuff
     QByteArray playlistColumnSizes( const QString& playlistid ) const;
     void setPlaylistColumnSizes( const QString& playlistid, const QByteArray& state );
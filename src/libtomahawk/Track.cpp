@@ -668,11 +668,12 @@ Track::composerPtr() const
 QPixmap
 Track::cover( const QSize& size, bool forceLoad ) const
 {
-    albumPtr()->cover( size, forceLoad );
+    const QPixmap cover = albumPtr()->cover( size, forceLoad );
     if ( albumPtr()->coverLoaded() )
     {
-        if ( !albumPtr()->cover( size ).isNull() )
-            return albumPtr()->cover( size );
+        // a null pixmap may just mean the album cover is still being decoded
+        if ( !cover.isNull() || albumPtr()->hasCover() )
+            return cover;
 
         return artistPtr()->cover( size, forceLoad );
     }
@@ -681,6 +682,13 @@ Track::cover( const QSize& size, bool forceLoad ) const
 }
 
 
+void
+Track::loadCover() const
+{
+    albumPtr()->loadCover();
+}
+
+
 bool
 Track::coverLoaded() const
 {
@@ -688,7 +696,7 @@ Track::coverLoaded() const
     if ( d->albumPtr.isNull() )
         return false;
 
-    if ( d->albumPtr->coverLoaded() && !d->albumPtr->cover( QSize( 0, 0 ) ).isNull() )
+    if ( d->albumPtr->coverLoaded() && d->albumPtr->hasCover() )
         return true;
 
     return d->artistPtr->coverLoaded();
@@ -35,6 +35,7 @@ namespace Tomahawk
 {
 
 class DatabaseCommand_LoadInboxEntries;
+class DatabaseImpl;
 class TrackPrivate;
 
 class DLLEXPORT Track : public QObject
@@ -43,6 +44,7 @@ Q_OBJECT
 
 friend class Pipeline;
 friend class DatabaseCommand_LoadInboxEntries; // for setAllSocialActions
+friend class DatabaseImpl; // for setAllSocialActions
 
 public:
     enum DescriptionMode
@@ -89,6 +91,8 @@ public:
     Tomahawk::artist_ptr composerPtr() const;
 
     QPixmap cover( const QSize& size, bool forceLoad = true ) const;
+    /// Starts fetching the cover without decoding it
+    void loadCover() const;
     bool coverLoaded() const;
 
     void setLoved( bool loved, bool postToInfoSystem = true );
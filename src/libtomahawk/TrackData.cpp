@@ -267,6 +267,7 @@ TrackData::setAllSocialActions( const QList< SocialAction >& socialActions )
     {
         QMutexLocker locker( &s_memberMutex );
         m_allSocialActions = socialActions;
+        m_socialActionsLoaded = true;
         parseSocialActions();
     }
 
@@ -76,7 +76,7 @@ public:
 
     void loadAttributes();
     QVariantMap attributes() const { return m_attributes; }
-    void setAttributes( const QVariantMap& map ) { m_attributes = map; updateAttributes(); }
+    void setAttributes( const QVariantMap& map ) { m_attributes = map; m_attributesLoaded = true; updateAttributes(); }
 
     void loadSocialActions( bool force = false );
     QList< Tomahawk::SocialAction > allSocialActions() const;
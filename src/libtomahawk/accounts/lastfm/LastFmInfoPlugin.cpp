@@ -53,6 +53,9 @@ LastFmInfoPlugin::LastFmInfoPlugin( LastFmAccount* account )
 {
     m_supportedGetTypes << InfoAlbumCoverArt << InfoArtistImages << InfoArtistSimilars << InfoArtistSongs << InfoArtistBiography << InfoChart << InfoChartCapabilities << InfoTrackSimilars;
     m_supportedPushTypes << InfoSubmitScrobble << InfoSubmitNowPlaying << InfoLove << InfoUnLove;
+
+    // Last.fm asks clients to stay below five requests per second
+    m_maxRequestsPerSecond = 5;
 }
 
 
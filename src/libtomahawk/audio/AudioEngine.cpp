@@ -24,6 +24,8 @@
 #include "config.h"
 
 #include "audio/Qnr_IoDeviceStream.h"
+#include "database/Database.h"
+#include "database/DatabaseCommand_LoadLoudness.h"
 #include "filemetadata/MusicScanner.h"
 #include "jobview/JobStatusView.h"
 #include "jobview/JobStatusModel.h"
@@ -46,9 +48,12 @@
 
 #include <QDir>
 
+#include <cmath>
+
 using namespace Tomahawk;
 
 #define AUDIO_VOLUME_STEP 5
+#define REPLAYGAIN_REFERENCE_LOUDNESS -18.0
 
 static const uint_fast8_t UNDERRUNTHRESHOLD = 2;
 
@@ -1259,7 +1264,44 @@ AudioEngine::setCurrentTrack( const Tomahawk::result_ptr& result )
         {
             d->playlist->setCurrentIndex( d->playlist->indexOfResult( result ) );
         }
+
+        // loudness was measured on our own files, it doesn't apply to other sources' encodings of a track
+        if ( TomahawkSettings::instance()->volumeNormalization() != TomahawkSettings::NoNormalization &&
+             TomahawkUtils::isLocalResult( result->url() ) )
+        {
+            DatabaseCommand_LoadLoudness* cmd = new DatabaseCommand_LoadLoudness( result->url() );
+            connect( cmd, SIGNAL( loudness( QString, QVariantMap ) ), SLOT( onLoudnessLoaded( QString, QVariantMap ) ) );
+            Database::instance()->enqueue( dbcmd_ptr( cmd ) );
+        }
     }
+
+    d->audioOutput->setReplayGain( 0.0 );
+}
+
+
+void
+AudioEngine::onLoudnessLoaded( const QString& url, const QVariantMap& values )
+{
+    Q_D( AudioEngine );
+
+    const TomahawkSettings::VolumeNormalization mode = TomahawkSettings::instance()->volumeNormalization();
+    if ( mode == TomahawkSettings::NoNormalization || !d->currentTrack || d->currentTrack->url() != url )
+        return;
+
+    const QString prefix = ( mode == TomahawkSettings::AlbumNormalization && values.contains( "albumloudness" ) ) ? "album" : "";
+    if ( !values.contains( prefix + "loudness" ) )
+        return;
+
+    qreal gain = REPLAYGAIN_REFERENCE_LOUDNESS - values.value( prefix + "loudness" ).toDouble();
+    const qreal peak = values.value( prefix + "peak" ).toDouble();
+    if ( peak > 0.0 )
+    {
+        // don't amplify beyond the point where the loudest sample would clip
+        gain = qMin( gain, -20.0 * std::log10( peak ) );
+    }
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Applying gain of" << gain << "dB for" << url;
+    d->audioOutput->setReplayGain( gain );
 }
 
 
@@ -24,6 +24,7 @@
 #include "../Typedefs.h"
 
 #include <QStringList>
+#include <QVariantMap>
 #include <functional>
 
 #include "DllMacro.h"
@@ -197,6 +198,7 @@ private slots:
     void onPositionChanged( float new_position );
 
     void setCurrentTrack( const Tomahawk::result_ptr& result );
+    void onLoudnessLoaded( const QString& url, const QVariantMap& values );
     void onNowPlayingInfoReady( const Tomahawk::InfoSystem::InfoType type );
     void onPlaylistNextTrackAvailable();
 
@@ -41,6 +41,7 @@
 #include <vlc/libvlc_version.h>
 
 #include <algorithm>
+#include <cmath>
 
 AudioOutput* AudioOutput::s_instance = 0;
 
@@ -60,6 +61,7 @@ AudioOutput::AudioOutput( QObject* parent )
     , m_muted( false )
     , m_autoDelete( true )
     , m_volume( 1.0 )
+    , m_replayGain( 0.0 )
     , m_currentTime( 0 )
     , m_totalTime( 0 )
     , m_justSeeked( false )
@@ -548,7 +550,7 @@ AudioOutput::setMuted( bool m )
 
     if ( !m_muted )
     {
-        libvlc_audio_set_volume( m_vlcPlayer, m_volume * 100.0 );
+        libvlc_audio_set_volume( m_vlcPlayer, vlcVolume() );
     }
 }
 
@@ -568,11 +570,37 @@ AudioOutput::setVolume( qreal vol )
     m_volume = vol;
     if ( !m_muted )
     {
-        libvlc_audio_set_volume( m_vlcPlayer, m_volume * 100.0 );
+        libvlc_audio_set_volume( m_vlcPlayer, vlcVolume() );
     }
 }
 
 
+qreal
+AudioOutput::replayGain() const
+{
+    return m_replayGain;
+}
+
+
+void
+AudioOutput::setReplayGain( qreal gain )
+{
+    m_replayGain = gain;
+    if ( !m_muted )
+    {
+        libvlc_audio_set_volume( m_vlcPlayer, vlcVolume() );
+    }
+}
+
+
+int
+AudioOutput::vlcVolume() const
+{
+    // libVLC accepts up to 200%, which leaves us 6dB of headroom for amplification
+    return qBound( 0, (int)( m_volume * std::pow( 10.0, m_replayGain / 20.0 ) * 100.0 ), 200 );
+}
+
+
 void
 AudioOutput::onVlcEvent( const libvlc_event_t* event )
 {
@@ -609,7 +637,8 @@ AudioOutput::onVlcEvent( const libvlc_event_t* event )
             break;
 #if (LIBVLC_VERSION_INT >= LIBVLC_VERSION(2, 2, 2, 0))
         case libvlc_MediaPlayerAudioVolume:
-            m_volume = event->u.media_player_audio_volume.volume;
+            // libVLC reports the effective volume, which includes our normalization gain
+            m_volume = event->u.media_player_audio_volume.volume / std::pow( 10.0, m_replayGain / 20.0 );
             emit volumeChanged( volume() );
             break;
         case libvlc_MediaPlayerMuted:
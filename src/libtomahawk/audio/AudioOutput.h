@@ -63,6 +63,9 @@ public:
     void setMuted( bool m );
     void setVolume( qreal vol );
     qreal volume() const;
+    /// Additional gain in dB applied on top of the volume, used for loudness normalization
+    void setReplayGain( qreal gain );
+    qreal replayGain() const;
     qint64 currentTime() const;
     qint64 totalTime() const;
     void setAutoDelete ( bool ad );
@@ -89,6 +92,7 @@ private:
     void setCurrentTime( qint64 time );
     void setCurrentPosition( float position );
     void setTotalTime( qint64 time );
+    int vlcVolume() const;
 
     void onVlcEvent( const libvlc_event_t* event );
     static void vlcEventCallback( const libvlc_event_t* event, void* opaque );
@@ -103,6 +107,7 @@ private:
     bool m_havePosition;
     bool m_haveTiming;
     qreal m_volume;
+    qreal m_replayGain;
     qint64 m_currentTime;
     qint64 m_totalTime;
     bool m_justSeeked;
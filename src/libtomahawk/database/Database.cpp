@@ -31,6 +31,7 @@
 #include "DatabaseCommand_AddFiles.h"
 #include "DatabaseCommand_CreatePlaylist.h"
 #include "DatabaseCommand_DeleteFiles.h"
+#include "DatabaseCommand_MoveFiles.h"
 #include "DatabaseCommand_DeletePlaylist.h"
 #include "DatabaseCommand_LogPlayback.h"
 #include "DatabaseCommand_RenamePlaylist.h"
@@ -96,6 +97,7 @@ Database::Database( const QString& dbname, QObject* parent )
     // register commands
     registerCommand<DatabaseCommand_AddFiles>();
     registerCommand<DatabaseCommand_DeleteFiles>();
+    registerCommand<DatabaseCommand_MoveFiles>();
     registerCommand<DatabaseCommand_CreatePlaylist>();
     registerCommand<DatabaseCommand_DeletePlaylist>();
     registerCommand<DatabaseCommand_LogPlayback>();
@@ -69,6 +69,7 @@ public:
     unsigned int weight() const override;
     unsigned int timeout() const override;
     void resolve( const Tomahawk::query_ptr& query ) override;
+    using Resolver::resolve;
 
 public slots:
     virtual void addTracks( const QList<QVariant>& newitems );
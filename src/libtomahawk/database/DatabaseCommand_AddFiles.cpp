@@ -40,12 +40,12 @@ QVariantList
 DatabaseCommand_AddFiles::files() const
 {
     QVariantList list;
-    foreach ( const QVariant& v, m_files )
+    list.reserve( m_files.count() );
+    foreach ( const ScannedFile& file, m_files )
     {
         // replace url with the id, we don't leak file paths over the network.
-        QVariantMap m = v.toMap();
-        m.remove( "url" );
-        m.insert( "url", QString::number( m.value( "id" ).toInt() ) );
+        QVariantMap m = file.toVariantMap();
+        m.insert( "url", QString::number( file.id ) );
         list.append( m );
     }
     return list;
@@ -85,77 +85,66 @@ DatabaseCommand_AddFiles::exec( DatabaseImpl* dbi )
     query_trackattr.prepare( "INSERT INTO track_attributes(id, k, v) VALUES (?, ?, ?)" );
 
     int added = 0;
+    int inserted = 0;
+    unsigned int lastmodified = 0;
     QVariant srcid = source()->isLocal() ? QVariant( QVariant::Int ) : source()->id();
     qDebug() << "Adding" << m_files.length() << "files to db for source" << srcid;
 
-    QList<QVariant>::iterator it;
+    QList< ScannedFile >::iterator it;
     for ( it = m_files.begin(); it != m_files.end(); ++it )
     {
-        QVariant& v = *it;
-        QVariantMap m = v.toMap();
+        ScannedFile& file = *it;
 
         int fileid = 0, artistid = 0, albumartistid = 0, albumid = 0, trackid = 0, composerid = 0;
 
-        const QString url         = m.value( "url" ).toString();
-        const int mtime           = m.value( "mtime" ).toInt();
-        const uint size           = m.value( "size" ).toUInt();
-        const QString hash        = m.value( "hash" ).toString();
-        const QString mimetype    = m.value( "mimetype" ).toString();
-        const uint duration       = m.value( "duration" ).toUInt();
-        const uint bitrate        = m.value( "bitrate" ).toUInt();
-        const QString artist      = m.value( "artist" ).toString();
-        const QString albumartist = m.value( "albumartist" ).toString();
-        const QString album       = m.value( "album" ).toString();
-        const QString track       = m.value( "track" ).toString();
-        const uint albumpos       = m.value( "albumpos" ).toUInt();
-        const QString composer    = m.value( "composer" ).toString();
-        const uint discnumber     = m.value( "discnumber" ).toUInt();
-        const int year            = m.value( "year" ).toInt();
-
         query_file.bindValue( 0, srcid );
-        query_file.bindValue( 1, url );
-        query_file.bindValue( 2, size );
-        query_file.bindValue( 3, mtime );
-        query_file.bindValue( 4, hash );
-        query_file.bindValue( 5, mimetype );
-        query_file.bindValue( 6, duration );
-        query_file.bindValue( 7, bitrate );
-        query_file.exec();
+        query_file.bindValue( 1, file.url );
+        query_file.bindValue( 2, file.size );
+        query_file.bindValue( 3, file.mtime );
+        query_file.bindValue( 4, file.hash );
+        query_file.bindValue( 5, file.mimetype );
+        query_file.bindValue( 6, file.duration );
+        query_file.bindValue( 7, file.bitrate );
+        if ( !query_file.exec() )
+            continue;
+
+        // every file row counts towards the collection stats, even without a usable artist or track
+        inserted++;
+        lastmodified = qMax( lastmodified, file.mtime );
 
         if ( added % 1000 == 0 )
             qDebug() << "Inserted" << added;
 
         // get internal IDs for art/alb/trk
         fileid = query_file.lastInsertId().toInt();
-        m.insert( "id", fileid );
-        // this is the qvariant(map) the remote will get
-        v = m;
+        // this is the id the remote will get
+        file.id = fileid;
 
         // add the album artist to the artist database.
-        if ( !albumartist.trimmed().isEmpty() )
-            albumartistid = dbi->artistId( albumartist, true );
-        
-        if ( !artist.trimmed().isEmpty() )
-            artistid = dbi->artistId( artist, true );
+        if ( !file.albumartist.trimmed().isEmpty() )
+            albumartistid = dbi->artistId( file.albumartist, true );
+
+        if ( !file.artist.trimmed().isEmpty() )
+            artistid = dbi->artistId( file.artist, true );
         if ( artistid < 1 )
             continue;
-        trackid = dbi->trackId( artistid, track, true );
+        trackid = dbi->trackId( artistid, file.track, true );
         if ( trackid < 1 )
             continue;
         // If there's an album artist, use it. Otherwise use the track artist
-        albumid = dbi->albumId( albumartistid > 0 ? albumartistid : artistid, album, true );
+        albumid = dbi->albumId( albumartistid > 0 ? albumartistid : artistid, file.album, true );
 
-        if ( !composer.trimmed().isEmpty() )
-            composerid = dbi->artistId( composer, true );
+        if ( !file.composer.trimmed().isEmpty() )
+            composerid = dbi->artistId( file.composer, true );
 
         // Now add the association
         query_filejoin.bindValue( 0, fileid );
         query_filejoin.bindValue( 1, artistid );
         query_filejoin.bindValue( 2, albumid > 0 ? albumid : QVariant( QVariant::Int ) );
         query_filejoin.bindValue( 3, trackid );
-        query_filejoin.bindValue( 4, albumpos );
+        query_filejoin.bindValue( 4, file.albumpos );
         query_filejoin.bindValue( 5, composerid > 0 ? composerid : QVariant( QVariant::Int ) );
-        query_filejoin.bindValue( 6, discnumber );
+        query_filejoin.bindValue( 6, file.discnumber );
         if ( !query_filejoin.exec() )
         {
             qDebug() << "Error inserting into file_join table";
@@ -164,7 +153,7 @@ DatabaseCommand_AddFiles::exec( DatabaseImpl* dbi )
 
         query_trackattr.bindValue( 0, trackid );
         query_trackattr.bindValue( 1, "releaseyear" );
-        query_trackattr.bindValue( 2, year );
+        query_trackattr.bindValue( 2, file.year );
         query_trackattr.exec();
 
         m_ids << fileid;
@@ -172,7 +161,9 @@ DatabaseCommand_AddFiles::exec( DatabaseImpl* dbi )
     }
 
     qDebug() << "Inserted" << added << "tracks to database";
+    if ( inserted > 0 )
+        dbi->updateCollectionStats( source()->isLocal() ? 0 : source()->id(), inserted, lastmodified );
     tDebug() << "Committing" << added << "tracks...";
 
-    emit done( m_files, source()->dbCollection() );
+    emit done( ScannedFile::toVariantList( m_files ), source()->dbCollection() );
 }
@@ -23,6 +23,7 @@
 #include <QVariantMap>
 
 #include "database/DatabaseCommandLoggable.h"
+#include "filemetadata/ScannedFile.h"
 #include "Typedefs.h"
 #include "Query.h"
 
@@ -42,6 +43,12 @@ public:
     {}
 
     explicit DatabaseCommand_AddFiles( const QList<QVariant>& files, const Tomahawk::source_ptr& source, QObject* parent = 0 )
+        : DatabaseCommandLoggable( parent ), m_files( ScannedFile::fromVariantList( files ) )
+    {
+        setSource( source );
+    }
+
+    explicit DatabaseCommand_AddFiles( const QList< Tomahawk::ScannedFile >& files, const Tomahawk::source_ptr& source, QObject* parent = 0 )
         : DatabaseCommandLoggable( parent ), m_files( files )
     {
         setSource( source );
@@ -54,14 +61,14 @@ public:
     virtual void postCommitHook();
 
     QVariantList files() const;
-    void setFiles( const QVariantList& f ) { m_files = f; }
+    void setFiles( const QVariantList& f ) { m_files = ScannedFile::fromVariantList( f ); }
 
 signals:
     void done( const QList<QVariant>&, const Tomahawk::collection_ptr& );
     void notify( const QList<unsigned int>& ids );
 
 private:
-    QVariantList m_files;
+    QList< Tomahawk::ScannedFile > m_files;
     QList<unsigned int> m_ids;
 };
 
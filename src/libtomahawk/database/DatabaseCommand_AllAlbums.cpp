@@ -38,6 +38,8 @@ DatabaseCommand_AllAlbums::DatabaseCommand_AllAlbums( const Tomahawk::collection
   , m_collection( collection.objectCast< DatabaseCollection >() )
   , m_artist( artist )
   , m_amount( 0 )
+  , m_afterId( 0 )
+  , m_paged( false )
   , m_sortOrder( DatabaseCommand_AllAlbums::None )
   , m_sortDescending( false )
 {
@@ -61,15 +63,17 @@ DatabaseCommand_AllAlbums::execForArtist( DatabaseImpl* dbi )
 {
     TomahawkSqlQuery query = dbi->newquery();
     QList<Tomahawk::album_ptr> al;
-    QString orderToken, sourceToken, filterToken, timeToken, tables;
+    QString orderToken, sourceToken, filterToken, timeToken, tables, pageKeyToken;
 
     switch ( m_sortOrder )
     {
         case 0:
+            pageKeyToken = "IFNULL( album.sortname, '' )";
             break;
 
         case ModificationTime:
             orderToken = "file.mtime";
+            pageKeyToken = "MAX( file.mtime )";
             timeToken = QString( "AND file.mtime <= %1" ).arg( QDateTime::currentDateTimeUtc().toTime_t() );
     }
 
@@ -91,28 +95,49 @@ DatabaseCommand_AllAlbums::execForArtist( DatabaseImpl* dbi )
     else
         tables = "file, file_join";
 
-    QString sql = QString(
-        "SELECT DISTINCT album.id, album.name "
+    const QString where = QString(
         "FROM %1 "
         "LEFT OUTER JOIN album ON file_join.album = album.id "
         "WHERE file.id = file_join.file "
         "AND file_join.artist = %2 "
-        "%3 %4 %5 %6 %7 %8"
+        "%3 %4 %5"
         ).arg( tables )
          .arg( m_artist->id() )
          .arg( sourceToken )
          .arg( timeToken )
-         .arg( filterToken )
-         .arg( m_sortOrder > 0 ? QString( "ORDER BY %1" ).arg( orderToken ) : QString() )
-         .arg( m_sortDescending ? "DESC" : QString() )
+         .arg( filterToken );
+
+    int total = -1;
+    if ( m_paged && m_afterId == 0 )
+        total = countAlbums( query, where );
+
+    // albums without a name have no id, they sort first with an id of 0
+    QString order;
+    if ( m_paged )
+        order = pageClause( pageKeyToken, "IFNULL( album.id, 0 )" );
+    else if ( m_sortOrder > 0 )
+        order = QString( "ORDER BY %1 %2" ).arg( orderToken ).arg( m_sortDescending ? "DESC" : QString() );
+
+    QString sql = QString(
+        "SELECT %1 album.id, album.name, %2 "
+        "%3 %4 %5"
+        ).arg( m_paged ? QString() : QString( "DISTINCT" ) )
+         .arg( m_paged ? pageKeyToken : QString( "NULL" ) )
+         .arg( where )
+         .arg( order )
          .arg( m_amount > 0 ? QString( "LIMIT 0, %1" ).arg( m_amount ) : QString() );
 
     query.prepare( sql );
+    bindPage( query );
     query.exec();
 
+    QVariant lastKey;
+    unsigned int lastId = 0;
     while( query.next() )
     {
         unsigned int albumId = query.value( 0 ).toUInt();
+        lastId = albumId;
+        lastKey = query.value( 2 );
         QString albumName = query.value( 1 ).toString();
         if ( query.value( 0 ).isNull() )
         {
@@ -125,6 +150,8 @@ DatabaseCommand_AllAlbums::execForArtist( DatabaseImpl* dbi )
 
     emit albums( al, data() );
     emit albums( al );
+    if ( m_paged )
+        emit pageLoaded( lastKey, lastId, total );
     emit done();
 }
 
@@ -134,38 +161,59 @@ DatabaseCommand_AllAlbums::execForCollection( DatabaseImpl* dbi )
 {
     TomahawkSqlQuery query = dbi->newquery();
     QList<Tomahawk::album_ptr> al;
-    QString orderToken, sourceToken;
+    QString orderToken, sourceToken, pageKeyToken;
 
     switch ( m_sortOrder )
     {
         case 0:
+            pageKeyToken = "album.sortname";
             break;
 
         case ModificationTime:
             orderToken = "file.mtime";
+            pageKeyToken = "MAX( file.mtime )";
     }
 
     if ( !m_collection.isNull() )
         sourceToken = QString( "AND file.source %1 " ).arg( m_collection->source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( m_collection->source()->id() ) );
 
-    QString sql = QString(
-        "SELECT DISTINCT album.id, album.name, album.artist, artist.name "
+    const QString where = QString(
         "FROM file_join, file, album "
         "LEFT OUTER JOIN artist ON album.artist = artist.id "
         "WHERE file.id = file_join.file "
         "AND file_join.album = album.id "
         "%1 "
-        "%2 %3 %4"
-        ).arg( sourceToken )
-         .arg( m_sortOrder > 0 ? QString( "ORDER BY %1" ).arg( orderToken ) : QString() )
-         .arg( m_sortDescending ? "DESC" : QString() )
+        ).arg( sourceToken );
+
+    int total = -1;
+    if ( m_paged && m_afterId == 0 )
+        total = countAlbums( query, where );
+
+    QString order;
+    if ( m_paged )
+        order = pageClause( pageKeyToken, "album.id" );
+    else if ( m_sortOrder > 0 )
+        order = QString( "ORDER BY %1 %2" ).arg( orderToken ).arg( m_sortDescending ? "DESC" : QString() );
+
+    QString sql = QString(
+        "SELECT %1 album.id, album.name, album.artist, artist.name, %2 "
+        "%3 %4 %5"
+        ).arg( m_paged ? QString() : QString( "DISTINCT" ) )
+         .arg( m_paged ? pageKeyToken : QString( "NULL" ) )
+         .arg( where )
+         .arg( order )
          .arg( m_amount > 0 ? QString( "LIMIT 0, %1" ).arg( m_amount ) : QString() );
 
     query.prepare( sql );
+    bindPage( query );
     query.exec();
 
+    QVariant lastKey;
+    unsigned int lastId = 0;
     while( query.next() )
     {
+        lastId = query.value( 0 ).toUInt();
+        lastKey = query.value( 4 );
         Tomahawk::artist_ptr artist = Tomahawk::Artist::get( query.value( 2 ).toUInt(), query.value( 3 ).toString() );
         Tomahawk::album_ptr album = Tomahawk::Album::get( query.value( 0 ).toUInt(), query.value( 1 ).toString(), artist );
 
@@ -174,10 +222,49 @@ DatabaseCommand_AllAlbums::execForCollection( DatabaseImpl* dbi )
 
     emit albums( al, data() );
     emit albums( al );
+    if ( m_paged )
+        emit pageLoaded( lastKey, lastId, total );
     emit done();
 }
 
 
+QString
+DatabaseCommand_AllAlbums::pageClause( const QString& keyToken, const QString& idToken ) const
+{
+    // the key may be an aggregate, so the cursor is compared after grouping
+    const char* cmp = m_sortDescending ? "<" : ">";
+    const char* dir = m_sortDescending ? "DESC" : "ASC";
+
+    QString clause = "GROUP BY album.id ";
+    if ( m_afterId > 0 )
+        clause += QString( "HAVING ( %1 %3 ? OR ( %1 = ? AND %2 %3 ? ) ) " ).arg( keyToken ).arg( idToken ).arg( cmp );
+
+    return clause + QString( "ORDER BY %1 %3, %2 %3" ).arg( keyToken ).arg( idToken ).arg( dir );
+}
+
+
+void
+DatabaseCommand_AllAlbums::bindPage( TomahawkSqlQuery& query ) const
+{
+    if ( !m_paged || m_afterId == 0 )
+        return;
+
+    query.bindValue( 0, m_afterKey );
+    query.bindValue( 1, m_afterKey );
+    query.bindValue( 2, m_afterId );
+}
+
+
+int
+DatabaseCommand_AllAlbums::countAlbums( TomahawkSqlQuery& query, const QString& from )
+{
+    query.prepare( QString( "SELECT COUNT(DISTINCT album.id) %1" ).arg( from ) );
+    query.exec();
+
+    return query.next() ? query.value( 0 ).toInt() : -1;
+}
+
+
 void
 DatabaseCommand_AllAlbums::exec( DatabaseImpl* dbi )
 {
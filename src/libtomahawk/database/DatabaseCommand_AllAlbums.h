@@ -34,6 +34,8 @@
 
 #include "DllMacro.h"
 
+class TomahawkSqlQuery;
+
 namespace Tomahawk
 {
 
@@ -65,6 +67,13 @@ public:
 
     void setArtist( const Tomahawk::artist_ptr& artist );
     void setLimit( unsigned int amount ) { m_amount = amount; }
+    /**
+     * Keyset pagination: fetch at most pageSize albums that come after (afterKey, afterId) when
+     * ordered by the sort order's key and then album id. The key is the album's sortname unless
+     * a sort order is set. Pass an afterId of 0 for the first page, then continue with the
+     * cursor reported by pageLoaded().
+     */
+    void setPage( const QVariant& afterKey, unsigned int afterId, unsigned int pageSize ) { m_afterKey = afterKey; m_afterId = afterId; m_amount = pageSize; m_paged = true; }
     void setSortOrder( DatabaseCommand_AllAlbums::SortOrder order ) { m_sortOrder = order; }
     void setSortDescending( bool descending ) { m_sortDescending = descending; }
     void setFilter( const QString& filter ) { m_filter = filter; }
@@ -73,12 +82,21 @@ signals:
     void albums( const QList<Tomahawk::album_ptr>&, const QVariant& data );
     void albums( const QList<Tomahawk::album_ptr>& );
     void done();
+    /// After a paged request: the cursor to continue after (lastId is 0 for an empty page) and, for the first page only, the total number of albums (-1 otherwise)
+    void pageLoaded( const QVariant& lastKey, unsigned int lastId, int total );
 
 private:
+    QString pageClause( const QString& keyToken, const QString& idToken ) const;
+    void bindPage( TomahawkSqlQuery& query ) const;
+    int countAlbums( TomahawkSqlQuery& query, const QString& from );
+
     QSharedPointer< DatabaseCollection > m_collection;
     Tomahawk::artist_ptr m_artist;
 
     unsigned int m_amount;
+    QVariant m_afterKey;
+    unsigned int m_afterId;
+    bool m_paged;
     DatabaseCommand_AllAlbums::SortOrder m_sortOrder;
     bool m_sortDescending;
     QString m_filter;
@@ -35,6 +35,8 @@ DatabaseCommand_AllArtists::DatabaseCommand_AllArtists( const Tomahawk::collecti
     : DatabaseCommand( parent )
     , m_collection( collection.objectCast< DatabaseCollection >() )
     , m_amount( 0 )
+    , m_afterId( 0 )
+    , m_paged( false )
     , m_sortOrder( DatabaseCommand_AllArtists::None )
     , m_sortDescending( false )
 {
@@ -50,15 +52,17 @@ void
 DatabaseCommand_AllArtists::exec( DatabaseImpl* dbi )
 {
     TomahawkSqlQuery query = dbi->newquery();
-    QString orderToken, sourceToken, filterToken, tables, joins;
+    QString orderToken, sourceToken, filterToken, tables, joins, pageKeyToken;
 
     switch ( m_sortOrder )
     {
         case 0:
+            pageKeyToken = "artist.sortname";
             break;
 
         case ModificationTime:
             orderToken = "file.mtime";
+            pageKeyToken = "MAX( file.mtime )";
     }
 
     if ( !m_collection.isNull() )
@@ -80,32 +84,72 @@ DatabaseCommand_AllArtists::exec( DatabaseImpl* dbi )
     else
         tables = "artist, file, file_join";
 
-    QString sql = QString(
-            "SELECT DISTINCT artist.id, artist.name "
+    const QString where = QString(
             "FROM %1 "
             "%2 "
             "WHERE file.id = file_join.file "
             "AND file_join.artist = artist.id "
-            "%3 %4 %5 %6 %7"
+            "%3 %4"
             ).arg( tables )
              .arg( joins )
              .arg( sourceToken )
-             .arg( filterToken )
-             .arg( m_sortOrder > 0 ? QString( "ORDER BY %1" ).arg( orderToken ) : QString() )
-             .arg( m_sortDescending ? "DESC" : QString() )
+             .arg( filterToken );
+
+    int total = -1;
+    if ( m_paged && m_afterId == 0 )
+    {
+        query.prepare( QString( "SELECT COUNT(DISTINCT artist.id) %1" ).arg( where ) );
+        query.exec();
+        if ( query.next() )
+            total = query.value( 0 ).toInt();
+    }
+
+    // the key may be an aggregate, so the cursor is compared after grouping
+    QString order;
+    if ( m_paged )
+    {
+        const char* cmp = m_sortDescending ? "<" : ">";
+        const char* dir = m_sortDescending ? "DESC" : "ASC";
+        order = "GROUP BY artist.id ";
+        if ( m_afterId > 0 )
+            order += QString( "HAVING ( %1 %2 ? OR ( %1 = ? AND artist.id %2 ? ) ) " ).arg( pageKeyToken ).arg( cmp );
+        order += QString( "ORDER BY %1 %2, artist.id %2" ).arg( pageKeyToken ).arg( dir );
+    }
+    else if ( m_sortOrder > 0 )
+        order = QString( "ORDER BY %1 %2" ).arg( orderToken ).arg( m_sortDescending ? "DESC" : QString() );
+
+    QString sql = QString(
+            "SELECT %1 artist.id, artist.name, %2 "
+            "%3 %4 %5"
+            ).arg( m_paged ? QString() : QString( "DISTINCT" ) )
+             .arg( m_paged ? pageKeyToken : QString( "NULL" ) )
+             .arg( where )
+             .arg( order )
              .arg( m_amount > 0 ? QString( "LIMIT 0, %1" ).arg( m_amount ) : QString() );
 
     query.prepare( sql );
+    if ( m_paged && m_afterId > 0 )
+    {
+        query.bindValue( 0, m_afterKey );
+        query.bindValue( 1, m_afterKey );
+        query.bindValue( 2, m_afterId );
+    }
     query.exec();
 
     QList<Tomahawk::artist_ptr> al;
+    QVariant lastKey;
+    unsigned int lastId = 0;
     while ( query.next() )
     {
+        lastId = query.value( 0 ).toUInt();
+        lastKey = query.value( 2 );
         Tomahawk::artist_ptr artist = Tomahawk::Artist::get( query.value( 0 ).toUInt(), query.value( 1 ).toString() );
         al << artist;
     }
 
     emit artists( al );
+    if ( m_paged )
+        emit pageLoaded( lastKey, lastId, total );
     emit done();
 }
 
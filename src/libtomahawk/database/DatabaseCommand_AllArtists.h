@@ -57,6 +57,13 @@ public:
     void enqueue() Q_DECL_OVERRIDE { Database::instance()->enqueue( Tomahawk::dbcmd_ptr( this ) ); }
 
     void setLimit( unsigned int amount ) { m_amount = amount; }
+    /**
+     * Keyset pagination: fetch at most pageSize artists that come after (afterKey, afterId) when
+     * ordered by the sort order's key and then artist id. The key is the artist's sortname unless
+     * a sort order is set. Pass an afterId of 0 for the first page, then continue with the
+     * cursor reported by pageLoaded().
+     */
+    void setPage( const QVariant& afterKey, unsigned int afterId, unsigned int pageSize ) { m_afterKey = afterKey; m_afterId = afterId; m_amount = pageSize; m_paged = true; }
     void setSortOrder( DatabaseCommand_AllArtists::SortOrder order ) { m_sortOrder = order; }
     void setSortDescending( bool descending ) { m_sortDescending = descending; }
     void setFilter( const QString& filter ) override { m_filter = filter; }
@@ -64,10 +71,15 @@ public:
 signals:
     void artists( const QList<Tomahawk::artist_ptr>& ) override;
     void done();
+    /// After a paged request: the cursor to continue after (lastId is 0 for an empty page) and, for the first page only, the total number of artists (-1 otherwise)
+    void pageLoaded( const QVariant& lastKey, unsigned int lastId, int total );
 
 private:
     QSharedPointer< DatabaseCollection > m_collection;
     unsigned int m_amount;
+    QVariant m_afterKey;
+    unsigned int m_afterId;
+    bool m_paged;
     DatabaseCommand_AllArtists::SortOrder m_sortOrder;
     bool m_sortDescending;
     QString m_filter;
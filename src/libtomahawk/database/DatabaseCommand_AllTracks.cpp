@@ -41,22 +41,27 @@ DatabaseCommand_AllTracks::exec( DatabaseImpl* dbi )
     TomahawkSqlQuery query = dbi->newquery();
     QList<Tomahawk::query_ptr> ql;
 
-    QString m_orderToken, sourceToken;
+    // pages are cut along a single sort key, with the file id breaking ties
+    QString m_orderToken, sourceToken, pageKeyToken;
     switch ( m_sortOrder )
     {
         case 0:
+            pageKeyToken = "artist.sortname";
             break;
 
         case Album:
             m_orderToken = "album.name, file_join.discnumber, file_join.albumpos";
+            pageKeyToken = "IFNULL( album.sortname, '' )";
             break;
 
         case ModificationTime:
             m_orderToken = "file.mtime";
+            pageKeyToken = "file.mtime";
             break;
 
         case AlbumPosition:
             m_orderToken = "file_join.discnumber, file_join.albumpos";
+            pageKeyToken = "IFNULL( file_join.discnumber, 0 ) * 10000 + IFNULL( file_join.albumpos, 0 )";
             break;
     }
 
@@ -75,39 +80,79 @@ DatabaseCommand_AllTracks::exec( DatabaseImpl* dbi )
             albumToken = QString( "AND album.id = %1" ).arg( m_album->id() );
     }
 
-    QString sql = QString(
-            "SELECT file.id, artist.name, album.name, track.name, composer.name, file.size, "             //0
-                   "file.duration, file.bitrate, file.url, file.source, file.mtime, "                     //6
-                   "file.mimetype, file_join.discnumber, file_join.albumpos, track.id, albumArtist.name " //11
+    const QString tables =
             "FROM file, artist, track, file_join "
             "LEFT OUTER JOIN album "
             "ON file_join.album = album.id "
             "LEFT OUTER JOIN artist AS composer "
             "ON file_join.composer = composer.id "
             "LEFT OUTER JOIN artist AS albumArtist "
-            "ON album.artist = albumArtist.id "
+            "ON album.artist = albumArtist.id ";
+
+    const QString where = QString(
             "WHERE file.id = file_join.file "
             "AND file_join.artist = artist.id "
             "AND file_join.track = track.id "
             "%1 "
             "%2 %3 "
-            "%4 %5 %6"
             ).arg( sourceToken )
              .arg( !m_artist ? QString() : QString( "AND artist.id = %1" ).arg( m_artist->id() ) )
-             .arg( !m_album ? QString() : albumToken )
-             .arg( m_sortOrder > 0 ? QString( "ORDER BY %1" ).arg( m_orderToken ) : QString() )
-             .arg( m_sortDescending ? "DESC" : QString() )
+             .arg( !m_album ? QString() : albumToken );
+
+    int total = -1;
+    if ( m_paged && m_afterId == 0 )
+    {
+        query.prepare( QString( "SELECT COUNT(*) %1 %2" ).arg( tables ).arg( where ) );
+        query.exec();
+        if ( query.next() )
+            total = query.value( 0 ).toInt();
+    }
+
+    QString order;
+    if ( m_paged )
+    {
+        const char* cmp = m_sortDescending ? "<" : ">";
+        const char* dir = m_sortDescending ? "DESC" : "ASC";
+        if ( m_afterId > 0 )
+            order = QString( "AND ( %1 %2 ? OR ( %1 = ? AND file.id %2 ? ) ) " ).arg( pageKeyToken ).arg( cmp );
+        order += QString( "ORDER BY %1 %2, file.id %2" ).arg( pageKeyToken ).arg( dir );
+    }
+    else if ( m_sortOrder > 0 )
+        order = QString( "ORDER BY %1 %2" ).arg( m_orderToken ).arg( m_sortDescending ? "DESC" : QString() );
+
+    QString sql = QString(
+            "SELECT file.id, artist.name, album.name, track.name, composer.name, file.size, "             //0
+                   "file.duration, file.bitrate, file.url, file.source, file.mtime, "                     //6
+                   "file.mimetype, file_join.discnumber, file_join.albumpos, track.id, albumArtist.name, " //11
+                   "%1 "                                                                                  //16
+            "%2 %3 %4 %5"
+            ).arg( pageKeyToken.isEmpty() ? QString( "NULL" ) : pageKeyToken )
+             .arg( tables )
+             .arg( where )
+             .arg( order )
              .arg( m_amount > 0 ? QString( "LIMIT 0, %1" ).arg( m_amount ) : QString() );
 
     query.prepare( sql );
+    if ( m_paged && m_afterId > 0 )
+    {
+        query.bindValue( 0, m_afterKey );
+        query.bindValue( 1, m_afterKey );
+        query.bindValue( 2, m_afterId );
+    }
     query.exec();
 
     // Small cache to keep already created source objects.
     // This saves some mutex locking.
     std::unordered_map<uint, Tomahawk::source_ptr> sourceCache;
+    // album and artist views show the release year, their attributes get loaded at once
+    QHash< unsigned int, Tomahawk::track_ptr > attributeTracks;
 
+    QVariant lastKey;
+    unsigned int lastId = 0;
     while( query.next() )
     {
+        lastId = query.value( 0 ).toUInt();
+        lastKey = query.value( 16 );
         const QString artist = query.value( 1 ).toString();
         const QString album = query.value( 2 ).toString();
         const QString track = query.value( 3 ).toString();
@@ -151,7 +196,7 @@ DatabaseCommand_AllTracks::exec( DatabaseImpl* dbi )
             continue;
 
         if ( m_album || m_artist )
-            t->loadAttributes();
+            attributeTracks.insert( trackId, t );
 
         Tomahawk::result_ptr result = Tomahawk::Result::get( url, t );
         if ( !result )
@@ -166,8 +211,12 @@ DatabaseCommand_AllTracks::exec( DatabaseImpl* dbi )
         ql << Tomahawk::Query::getFixed( t, result );
     }
 
+    dbi->loadTrackAttributes( attributeTracks );
+
     emit tracks( ql, data() );
     emit tracks( ql );
+    if ( m_paged )
+        emit pageLoaded( lastKey, lastId, total );
     emit done( m_collection );
 }
 
@@ -54,6 +54,8 @@ public:
         , m_artist( nullptr )
         , m_album( nullptr )
         , m_amount( 0 )
+        , m_afterId( 0 )
+        , m_paged( false )
         , m_sortOrder( DatabaseCommand_AllTracks::None )
         , m_sortDescending( false )
     {}
@@ -69,6 +71,13 @@ public:
     void setAlbum( const Tomahawk::album_ptr& album ) { m_album = album; }
 
     void setLimit( unsigned int amount ) { m_amount = amount; }
+    /**
+     * Keyset pagination: fetch at most pageSize tracks that come after (afterKey, afterId) when
+     * ordered by the sort order's key and then file id. The key is the artist's sortname unless
+     * a sort order is set. Pass an afterId of 0 for the first page, then continue with the
+     * cursor reported by pageLoaded().
+     */
+    void setPage( const QVariant& afterKey, unsigned int afterId, unsigned int pageSize ) { m_afterKey = afterKey; m_afterId = afterId; m_amount = pageSize; m_paged = true; }
     void setSortOrder( DatabaseCommand_AllTracks::SortOrder order ) { m_sortOrder = order; }
     void setSortDescending( bool descending ) { m_sortDescending = descending; }
 
@@ -76,6 +85,8 @@ signals:
     void tracks( const QList<Tomahawk::query_ptr>&, const QVariant& data );
     void tracks( const QList<Tomahawk::query_ptr>& ) override;
     void done( const Tomahawk::collection_ptr& );
+    /// After a paged request: the cursor to continue after (lastId is 0 for an empty page) and, for the first page only, the total number of tracks (-1 otherwise)
+    void pageLoaded( const QVariant& lastKey, unsigned int lastId, int total );
 
 private:
     QSharedPointer< DatabaseCollection > m_collection;
@@ -84,6 +95,9 @@ private:
     Tomahawk::album_ptr m_album;
 
     unsigned int m_amount;
+    QVariant m_afterKey;
+    unsigned int m_afterId;
+    bool m_paged;
     DatabaseCommand_AllTracks::SortOrder m_sortOrder;
     bool m_sortDescending;
 };
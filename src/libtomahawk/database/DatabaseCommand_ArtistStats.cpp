@@ -46,30 +46,23 @@ DatabaseCommand_ArtistStats::exec( DatabaseImpl* dbi )
 {
     TomahawkSqlQuery query = dbi->newquery();
 
-    query.prepare( "SELECT COUNT(*) AS counter, artist.id "
-                   "FROM playback_log, track, artist "
-                   "WHERE playback_log.source IS NULL AND track.id = playback_log.track AND artist.id = track.artist "
-                   "GROUP BY track.artist "
-                   "ORDER BY counter DESC" );
-    query.exec();
-
     unsigned int plays = 0;
     unsigned int chartPos = 0;
     unsigned int chartCount = 0;
-    const unsigned int artistId = m_artist->id();
 
-    QHash< QString, unsigned int > charts;
-    while ( query.next() )
-    {
-        if ( query.value( 0 ).toUInt() < 2 )
-            break;
+    // artists need at least two plays to make it into the charts
+    query.exec( "SELECT COUNT(*) FROM artist_stats WHERE plays >= 2" );
+    if ( query.next() )
+        chartCount = query.value( 0 ).toUInt();
 
-        chartCount++;
-        if ( chartPos == 0 && query.value( 1 ).toUInt() == artistId )
-        {
-            chartPos = chartCount;
-            plays = query.value( 0 ).toUInt();
-        }
+    query.prepare( "SELECT plays, (SELECT COUNT(*) FROM artist_stats AS other WHERE other.plays > artist_stats.plays) "
+                   "FROM artist_stats WHERE artist = ?" );
+    query.addBindValue( m_artist->id() );
+    query.exec();
+    if ( query.next() && query.value( 0 ).toUInt() >= 2 )
+    {
+        plays = query.value( 0 ).toUInt();
+        chartPos = query.value( 1 ).toUInt() + 1;
     }
 
     if ( chartPos == 0 )
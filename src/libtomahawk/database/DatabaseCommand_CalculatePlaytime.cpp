@@ -92,13 +92,17 @@ DatabaseCommand_CalculatePlaytime::exec( DatabaseImpl *dbi )
 
     QString sql;
 
+    // the daily rollups only know whole days, the day we start from isn't part of the span
+    const uint fromDay = d->from.toTime_t() / 86400;
+    const uint toDay = d->to.toTime_t() / 86400;
+
     if ( d->plEntryIds.isEmpty() )
     {
         sql = QString(
                     " SELECT SUM(pl.secs_played) "
-                    " FROM playback_log pl "
-                    " WHERE track in ( %1 ) AND playtime >= %2 AND playtime <= %3 "
-                    ).arg( d->trackIds.join(", ") ).arg( d->from.toTime_t() ).arg( d->to.toTime_t() );
+                    " FROM playback_daily pl "
+                    " WHERE track in ( %1 ) AND day > %2 AND day <= %3 "
+                    ).arg( d->trackIds.join(", ") ).arg( fromDay ).arg( toDay );
     }
     else
     {
@@ -113,13 +117,13 @@ DatabaseCommand_CalculatePlaytime::exec( DatabaseImpl *dbi )
                     " FROM playlist_item pi "
                     " JOIN track t ON pi.trackname = t.name "
                     " JOIN artist a ON a.name = pi.artistname AND t.artist = a.id "
-                    " JOIN playback_log pl ON pl.track = t.id "
+                    " JOIN playback_daily pl ON pl.track = t.id "
                     " WHERE pi.guid IN (%1) "
-                    " AND pl.playtime >= %2 AND pl.playtime <= %3 "
+                    " AND pl.day > %2 AND pl.day <= %3 "
                     )
                 .arg( d->plEntryIds.join(", ") )
-                .arg( d->from.toTime_t() )
-                .arg( d->to.toTime_t() );
+                .arg( fromDay )
+                .arg( toDay );
 
     }
 
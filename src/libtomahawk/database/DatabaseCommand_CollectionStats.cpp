@@ -37,19 +37,26 @@ DatabaseCommand_CollectionStats::exec( DatabaseImpl* dbi )
     Q_ASSERT( source()->isLocal() || source()->id() >= 1 );
     TomahawkSqlQuery query = dbi->newquery();
 
+    // collection_stats is kept up to date by AddFiles, DeleteFiles and LogPlayback
+    const QString stats( "coalesce((SELECT %1 FROM collection_stats WHERE source = %2), 0)" );
+    const unsigned int srcid = source()->isLocal() ? 0 : source()->id();
+
     QVariantMap m;
     if ( source()->isLocal() )
     {
-        query.exec( "SELECT count(*), max(mtime), (SELECT guid FROM oplog WHERE source IS NULL ORDER BY id DESC LIMIT 1) "
-                    "FROM file "
-                    "WHERE source IS NULL" );
+        query.exec( QString( "SELECT %1, %2, (SELECT guid FROM oplog WHERE source IS NULL ORDER BY id DESC LIMIT 1), %3, %4" )
+                    .arg( stats.arg( "numfiles" ).arg( srcid ) )
+                    .arg( stats.arg( "lastmodified" ).arg( srcid ) )
+                    .arg( stats.arg( "plays" ).arg( srcid ) )
+                    .arg( stats.arg( "secs_played" ).arg( srcid ) ) );
     }
     else
     {
-        query.prepare( "SELECT count(*), max(mtime), (SELECT lastop FROM source WHERE id = ?) "
-                       "FROM file "
-                       "WHERE source = ?" );
-        query.addBindValue( source()->id() );
+        query.prepare( QString( "SELECT %1, %2, (SELECT lastop FROM source WHERE id = ?), %3, %4" )
+                       .arg( stats.arg( "numfiles" ).arg( srcid ) )
+                       .arg( stats.arg( "lastmodified" ).arg( srcid ) )
+                       .arg( stats.arg( "plays" ).arg( srcid ) )
+                       .arg( stats.arg( "secs_played" ).arg( srcid ) ) );
         query.addBindValue( source()->id() );
         query.exec();
     }
@@ -59,6 +66,8 @@ DatabaseCommand_CollectionStats::exec( DatabaseImpl* dbi )
         m.insert( "numfiles", query.value( 0 ).toInt() );
         m.insert( "lastmodified", query.value( 1 ).toInt() );
         m.insert( "lastop", query.value( 2 ).toString() );
+        m.insert( "plays", query.value( 3 ).toInt() );
+        m.insert( "secsplayed", query.value( 4 ).toUInt() );
     }
 
     emit done( m );
@@ -65,6 +65,7 @@ DatabaseCommand_DeleteFiles::exec( DatabaseImpl* dbi )
 
     int srcid = source()->isLocal() ? 0 : source()->id();
     TomahawkSqlQuery delquery = dbi->newquery();
+    int deleted = 0;
 
     if ( m_deleteAll )
     {
@@ -104,7 +105,8 @@ DatabaseCommand_DeleteFiles::exec( DatabaseImpl* dbi )
     {
         delquery.prepare( QString( "DELETE FROM file WHERE source %1" )
                     .arg( source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( source()->id() ) ) );
-        delquery.exec();
+        if ( delquery.exec() )
+            deleted = delquery.numRowsAffected();
     }
     else if ( !m_ids.isEmpty() )
     {
@@ -132,9 +134,13 @@ DatabaseCommand_DeleteFiles::exec( DatabaseImpl* dbi )
         delquery.prepare( QString( "DELETE FROM file WHERE source %1 AND id IN ( %2 )" )
                              .arg( source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( source()->id() ) )
                              .arg( idstring ) );
-        delquery.exec();
+        if ( delquery.exec() )
+            deleted = delquery.numRowsAffected();
     }
 
+    if ( deleted > 0 )
+        dbi->updateCollectionStats( srcid, -deleted, 0 );
+
     if ( !m_idList.isEmpty() )
         source()->updateIndexWhenSynced();
 
@@ -42,35 +42,40 @@ DatabaseCommand_FileMtimes::execSelect( DatabaseImpl* dbi )
     qDebug() << Q_FUNC_INFO;
     //FIXME: If ever needed for a non-local source this will have to be fixed/updated
     QMap< QString, QMap< unsigned int, unsigned int > > mtimes;
+    QMap< unsigned int, QString > hashes;
     TomahawkSqlQuery query = dbi->newquery();
     if( m_prefix.isEmpty() && m_prefixes.isEmpty() )
     {
         QString limit( m_checkonly ? QString( "LIMIT 1" ) : QString() );
-        query.exec( QString( "SELECT url, id, mtime FROM file WHERE source IS NULL %1" ).arg( limit ) );
+        query.exec( QString( "SELECT url, id, mtime, md5 FROM file WHERE source IS NULL %1" ).arg( limit ) );
         while( query.next() )
         {
             QMap< unsigned int, unsigned int > map;
             map.insert( query.value( 1 ).toUInt(), query.value( 2 ).toUInt() );
             mtimes.insert( query.value( 0 ).toString(), map );
+
+            if ( !query.value( 3 ).toString().isEmpty() )
+                hashes.insert( query.value( 1 ).toUInt(), query.value( 3 ).toString() );
         }
     }
     else if( m_prefixes.isEmpty() )
-        execSelectPath( dbi, m_prefix, mtimes );
+        execSelectPath( dbi, m_prefix, mtimes, hashes );
     else
     {
         if( !m_prefix.isEmpty() )
-            execSelectPath( dbi, m_prefix, mtimes );
+            execSelectPath( dbi, m_prefix, mtimes, hashes );
         foreach( QString path, m_prefixes )
-            execSelectPath( dbi, path, mtimes );
+            execSelectPath( dbi, path, mtimes, hashes );
     }
+    emit fileHashes( hashes );
     emit done( mtimes );
 }
 
 void
-DatabaseCommand_FileMtimes::execSelectPath( DatabaseImpl *dbi, const QDir& path, QMap<QString, QMap< unsigned int, unsigned int > > &mtimes )
+DatabaseCommand_FileMtimes::execSelectPath( DatabaseImpl *dbi, const QDir& path, QMap<QString, QMap< unsigned int, unsigned int > > &mtimes, QMap< unsigned int, QString >& hashes )
 {
     TomahawkSqlQuery query = dbi->newquery();
-    query.prepare( QString( "SELECT url, id, mtime "
+    query.prepare( QString( "SELECT url, id, mtime, md5 "
                             "FROM file "
                             "WHERE source IS NULL "
                             "AND url LIKE :prefix" ) );
@@ -83,6 +88,9 @@ DatabaseCommand_FileMtimes::execSelectPath( DatabaseImpl *dbi, const QDir& path,
         QMap< unsigned int, unsigned int > map;
         map.insert( query.value( 1 ).toUInt(), query.value( 2 ).toUInt() );
         mtimes.insert( query.value( 0 ).toString(), map );
+
+        if ( !query.value( 3 ).toString().isEmpty() )
+            hashes.insert( query.value( 1 ).toUInt(), query.value( 3 ).toString() );
     }
 }
 
@@ -57,12 +57,14 @@ public:
     virtual QString commandname() const { return "filemtimes"; }
 
 signals:
+    /// content fingerprints of the files by id, emitted right before done()
+    void fileHashes( const QMap< unsigned int, QString >& );
     void done( const QMap< QString, QMap< unsigned int, unsigned int > >& );
 
 public slots:
 
 private:
-    void execSelectPath( DatabaseImpl *dbi, const QDir& path, QMap< QString, QMap< unsigned int, unsigned int > > &mtimes );
+    void execSelectPath( DatabaseImpl *dbi, const QDir& path, QMap< QString, QMap< unsigned int, unsigned int > > &mtimes, QMap< unsigned int, QString >& hashes );
     void execSelect( DatabaseImpl* dbi );
     QString m_prefix;
     QStringList m_prefixes;
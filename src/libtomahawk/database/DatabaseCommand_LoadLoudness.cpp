@@ -0,0 +1,54 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DatabaseCommand_LoadLoudness.h"
+
+#include "DatabaseImpl.h"
+#include "TomahawkSqlQuery.h"
+
+namespace Tomahawk
+{
+
+void
+DatabaseCommand_LoadLoudness::exec( DatabaseImpl* dbi )
+{
+    TomahawkSqlQuery query = dbi->newquery();
+    query.prepare( "SELECT file_loudness.loudness, file_loudness.peak, album_loudness.loudness, album_loudness.peak "
+                   "FROM file "
+                   "JOIN file_loudness ON file_loudness.file = file.id "
+                   "LEFT JOIN file_join ON file_join.file = file.id "
+                   "LEFT JOIN album_loudness ON album_loudness.album = file_join.album "
+                   "WHERE file.source IS NULL AND file.url = ?" );
+    query.bindValue( 0, m_url );
+    query.exec();
+
+    QVariantMap values;
+    if ( query.next() )
+    {
+        static const char* keys[] = { "loudness", "peak", "albumloudness", "albumpeak" };
+        for ( int i = 0; i < 4; i++ )
+        {
+            if ( !query.value( i ).isNull() )
+                values[ keys[ i ] ] = query.value( i ).toDouble();
+        }
+    }
+
+    emit loudness( m_url, values );
+}
+
+}
@@ -0,0 +1,61 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASECOMMAND_LOADLOUDNESS_H
+#define DATABASECOMMAND_LOADLOUDNESS_H
+
+#include <QVariantMap>
+
+#include "DatabaseCommand.h"
+
+#include "DllMacro.h"
+
+namespace Tomahawk
+{
+
+/**
+ * \class DatabaseCommand_LoadLoudness
+ * \brief Loads the loudness the scanner measured for a local file.
+ *
+ * Emits loudness() with the keys "loudness" and "peak" for the file and
+ * "albumloudness" and "albumpeak" for the album it is on. Keys without a
+ * measurement are left out.
+ */
+class DLLEXPORT DatabaseCommand_LoadLoudness : public DatabaseCommand
+{
+Q_OBJECT
+
+public:
+    explicit DatabaseCommand_LoadLoudness( const QString& url, QObject* parent = 0 )
+        : DatabaseCommand( parent ), m_url( url )
+    {}
+
+    virtual void exec( DatabaseImpl* );
+    virtual bool doesMutates() const { return false; }
+    virtual QString commandname() const { return "loadloudness"; }
+
+signals:
+    void loudness( const QString& url, const QVariantMap& values );
+
+private:
+    QString m_url;
+};
+
+}
+
+#endif // DATABASECOMMAND_LOADLOUDNESS_H
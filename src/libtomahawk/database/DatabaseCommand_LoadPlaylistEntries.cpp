@@ -67,11 +67,16 @@ DatabaseCommand_LoadPlaylistEntries::generateEntries( DatabaseImpl* dbi )
 
             TomahawkSqlQuery query = dbi->newquery();
             QString sql = QString( "SELECT guid, trackname, artistname, albumname, annotation, "
-                                "duration, addedon, addedby, result_hint "
+                                "duration, addedon, addedby, result_hint, "
+                                "(SELECT track.id FROM track, artist WHERE artist.name = playlist_item.artistname "
+                                "AND track.artist = artist.id AND track.name = playlist_item.trackname) "
                                 "FROM playlist_item "
                                 "WHERE guid IN %1" ).arg( inclause );
 
             query.exec( sql );
+
+            // tracks we already know get their attributes and social actions in one go
+            QHash< unsigned int, track_ptr > tracks;
             while ( query.next() )
             {
                 plentry_ptr e( new PlaylistEntry );
@@ -94,7 +99,13 @@ DatabaseCommand_LoadPlaylistEntries::generateEntries( DatabaseImpl* dbi )
                 e->setQuery( q );
 
                 m_entrymap.insert( e->guid(), e );
+
+                if ( query.value( 9 ).toUInt() > 0 )
+                    tracks.insert( query.value( 9 ).toUInt(), q->queryTrack() );
             }
+
+            dbi->loadTrackAttributes( tracks );
+            dbi->loadSocialActions( tracks );
         }
 
         prevrev = query_entries.value( 4 ).toString();
@@ -92,7 +92,8 @@ DatabaseCommand_LogPlayback::exec( DatabaseImpl* dbi )
 
     if ( pt > 0 && source()->isLocal() )
     {
-        query.prepare( QString( "SELECT * FROM playback_log WHERE source %1 AND playtime = %2" ).arg( srcid.isNull() ? "IS NULL" : srcid.toString() ).arg( m_playtime ) );
+        query.prepare( "SELECT id FROM playback_log WHERE source IS NULL AND playtime = ?" );
+        query.addBindValue( m_playtime );
         query.exec();
         if ( query.next() )
         {
@@ -119,7 +120,8 @@ DatabaseCommand_LogPlayback::exec( DatabaseImpl* dbi )
     query.bindValue( 2, m_playtime );
     query.bindValue( 3, m_secsPlayed );
 
-    query.exec();
+    if ( query.exec() )
+        dbi->updatePlayStats( source()->isLocal() ? 0 : source()->id(), artid, trkid, m_playtime, m_secsPlayed );
 }
 
 
@@ -0,0 +1,122 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DatabaseCommand_MoveFiles.h"
+
+#include "database/DatabaseImpl.h"
+#include "network/Servent.h"
+#include "utils/Logger.h"
+
+#include "Result.h"
+#include "Source.h"
+
+using namespace Tomahawk;
+
+
+// remove file paths when making oplog/for network transmission
+QVariantList
+DatabaseCommand_MoveFiles::files() const
+{
+    QVariantList list;
+    list.reserve( m_files.count() );
+    foreach ( const QVariant& v, m_files )
+    {
+        QVariantMap m = v.toMap();
+        m.remove( "url" );
+        list.append( m );
+    }
+    return list;
+}
+
+
+void
+DatabaseCommand_MoveFiles::postCommitHook()
+{
+    // the tracks themselves did not change, so there's no need to bother the
+    // collection, but results handed out earlier still carry the old file
+    foreach ( const QVariant& v, m_files )
+    {
+        const QVariantMap m = v.toMap();
+
+        QString url;
+        if ( source()->isLocal() )
+            url = m_oldUrls.value( m.value( "id" ).toUInt() );
+        else
+            url = QString( "servent://%1\t%2" ).arg( source()->nodeId() ).arg( m.value( "id" ).toString() );
+
+        result_ptr result = Result::getCached( url );
+        if ( !result )
+            continue;
+
+        if ( source()->isLocal() )
+            result->setUrl( m.value( "url" ).toString() );
+        result->setModificationTime( m.value( "mtime" ).toUInt() );
+        result->setSize( m.value( "size" ).toUInt() );
+        emit result->updated();
+    }
+
+    if ( source()->isLocal() )
+        Servent::instance()->triggerDBSync();
+}
+
+
+void
+DatabaseCommand_MoveFiles::exec( DatabaseImpl* dbi )
+{
+    Q_ASSERT( !source().isNull() );
+
+    TomahawkSqlQuery urlQuery = dbi->newquery();
+    urlQuery.prepare( "SELECT url FROM file WHERE id = ? AND source IS NULL" );
+
+    TomahawkSqlQuery query = dbi->newquery();
+    if ( source()->isLocal() )
+        query.prepare( "UPDATE file SET url = ?, mtime = ?, size = ? WHERE id = ? AND source IS NULL" );
+    else
+        query.prepare( "UPDATE file SET mtime = ?, size = ? WHERE url = ? AND source = ?" );
+
+    int moved = 0;
+    foreach ( const QVariant& v, m_files )
+    {
+        const QVariantMap m = v.toMap();
+
+        if ( source()->isLocal() )
+        {
+            urlQuery.bindValue( 0, m.value( "id" ) );
+            if ( urlQuery.exec() && urlQuery.next() )
+                m_oldUrls.insert( m.value( "id" ).toUInt(), urlQuery.value( 0 ).toString() );
+
+            query.bindValue( 0, m.value( "url" ) );
+            query.bindValue( 1, m.value( "mtime" ) );
+            query.bindValue( 2, m.value( "size" ) );
+            query.bindValue( 3, m.value( "id" ) );
+        }
+        else
+        {
+            // remote files are stored with their id as url
+            query.bindValue( 0, m.value( "mtime" ) );
+            query.bindValue( 1, m.value( "size" ) );
+            query.bindValue( 2, m.value( "id" ).toString() );
+            query.bindValue( 3, source()->id() );
+        }
+
+        if ( query.exec() )
+            moved++;
+    }
+
+    tDebug() << Q_FUNC_INFO << "Moved" << moved << "files for source" << source()->id();
+}
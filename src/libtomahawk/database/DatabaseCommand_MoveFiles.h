@@ -0,0 +1,74 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASECOMMAND_MOVEFILES_H
+#define DATABASECOMMAND_MOVEFILES_H
+
+#include <QHash>
+#include <QObject>
+#include <QVariantMap>
+
+#include "database/DatabaseCommandLoggable.h"
+#include "Typedefs.h"
+
+#include "DllMacro.h"
+
+namespace Tomahawk
+{
+
+/**
+ * Updates files that were moved or renamed in place, keeping their id.
+ *
+ * Every entry is a map with the file id, its new url, mtime and size. Since
+ * peers only know our files by their id, the url never goes over the network
+ * and their copy of our collection stays untouched apart from mtime and size.
+ */
+class DLLEXPORT DatabaseCommand_MoveFiles : public DatabaseCommandLoggable
+{
+Q_OBJECT
+Q_PROPERTY( QVariantList files READ files WRITE setFiles )
+
+public:
+    explicit DatabaseCommand_MoveFiles( QObject* parent = 0 )
+        : DatabaseCommandLoggable( parent )
+    {}
+
+    explicit DatabaseCommand_MoveFiles( const QVariantList& files, const Tomahawk::source_ptr& source, QObject* parent = 0 )
+        : DatabaseCommandLoggable( parent ), m_files( files )
+    {
+        setSource( source );
+    }
+
+    virtual QString commandname() const { return "movefiles"; }
+
+    virtual void exec( DatabaseImpl* );
+    virtual bool doesMutates() const { return true; }
+    virtual void postCommitHook();
+
+    QVariantList files() const;
+    void setFiles( const QVariantList& f ) { m_files = f; }
+
+private:
+    QVariantList m_files;
+    // local file id -> url before the move, to find cached results
+    QHash< unsigned int, QString > m_oldUrls;
+};
+
+}
+
+#endif // DATABASECOMMAND_MOVEFILES_H
@@ -51,13 +51,12 @@ DatabaseCommand_PlaybackCharts::exec( DatabaseImpl* dbi )
     QString sourceToken;
 
     if ( source() )
-        sourceToken = QString( "AND playback_log.source %1" ).arg( source()->isLocal() ? "IS NULL" : QString( "= %1" ).arg( source()->id() ) );
+        sourceToken = QString( "AND playback_daily.source = %1" ).arg( source()->isLocal() ? 0 : source()->id() );
 
     QString sql = QString(
-            "SELECT artist.id, artist.name, COUNT(*) AS counter "
-            "FROM playback_log, artist, track "
-            "WHERE playback_log.track = track.id "
-            "AND artist.id = track.artist "
+            "SELECT artist.id, artist.name, SUM(plays) AS counter "
+            "FROM playback_daily, artist "
+            "WHERE artist.id = playback_daily.artist "
             "%1 "
             "GROUP BY artist.id "
             "ORDER BY counter DESC "
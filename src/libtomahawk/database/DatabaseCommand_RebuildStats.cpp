@@ -0,0 +1,82 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "DatabaseCommand_RebuildStats.h"
+
+#include "DatabaseImpl.h"
+#include "utils/Logger.h"
+
+using namespace Tomahawk;
+
+
+void
+DatabaseCommand_RebuildStats::exec( DatabaseImpl* dbi )
+{
+    if ( !m_force && isConsistent( dbi ) )
+    {
+        emit done( false );
+        return;
+    }
+
+    tLog() << Q_FUNC_INFO << "Rebuilding collection and playback stats";
+    dbi->rebuildStats();
+
+    emit done( true );
+}
+
+
+bool
+DatabaseCommand_RebuildStats::isConsistent( DatabaseImpl* dbi ) const
+{
+    TomahawkSqlQuery query = dbi->newquery();
+
+    // file counts per source
+    query.exec( "SELECT count(*) FROM "
+                "(SELECT coalesce(source, 0) AS src, count(*) AS numfiles FROM file GROUP BY source) AS counted "
+                "LEFT JOIN collection_stats ON collection_stats.source = counted.src "
+                "WHERE collection_stats.numfiles IS NULL OR collection_stats.numfiles != counted.numfiles" );
+    if ( !query.next() || query.value( 0 ).toInt() > 0 )
+        return false;
+
+    query.exec( "SELECT count(*) FROM collection_stats WHERE numfiles > 0 AND source NOT IN "
+                "(SELECT DISTINCT coalesce(source, 0) FROM file)" );
+    if ( !query.next() || query.value( 0 ).toInt() > 0 )
+        return false;
+
+    // our own plays have to add up in all three tables
+    query.exec( "SELECT (SELECT count(*) FROM playback_log WHERE source IS NULL), "
+                "coalesce((SELECT plays FROM collection_stats WHERE source = 0), 0), "
+                "(SELECT coalesce(sum(plays), 0) FROM track_stats), "
+                "(SELECT coalesce(sum(plays), 0) FROM artist_stats)" );
+    if ( !query.next() )
+        return false;
+
+    const int plays = query.value( 0 ).toInt();
+    if ( query.value( 1 ).toInt() != plays || query.value( 2 ).toInt() != plays || query.value( 3 ).toInt() != plays )
+    {
+        tDebug() << Q_FUNC_INFO << "Play counts out of sync:" << plays << query.value( 1 ).toInt()
+                 << query.value( 2 ).toInt() << query.value( 3 ).toInt();
+        return false;
+    }
+
+    query.exec( "SELECT (SELECT count(*) FROM playback_log, track WHERE track.id = playback_log.track), "
+                "(SELECT coalesce(sum(plays), 0) FROM playback_daily)" );
+    if ( !query.next() || query.value( 0 ).toInt() != query.value( 1 ).toInt() )
+        return false;
+
+    return true;
+}
@@ -0,0 +1,62 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DATABASECOMMAND_REBUILDSTATS_H
+#define DATABASECOMMAND_REBUILDSTATS_H
+
+#include "DatabaseCommand.h"
+
+#include "DllMacro.h"
+
+// Not loggable, the stats tables are derived from our own database only.
+
+namespace Tomahawk
+{
+
+/**
+ * \class DatabaseCommand_RebuildStats
+ * \brief Checks the collection_stats, track_stats, artist_stats and playback_daily aggregates against
+ * file and playback_log and recomputes them if they drifted apart.
+ *
+ * With force set the aggregates get rebuilt without checking them first.
+ */
+class DLLEXPORT DatabaseCommand_RebuildStats : public DatabaseCommand
+{
+Q_OBJECT
+
+public:
+    explicit DatabaseCommand_RebuildStats( bool force = false, QObject* parent = 0 )
+        : DatabaseCommand( parent ), m_force( force )
+    {}
+
+    virtual void exec( DatabaseImpl* );
+    virtual bool doesMutates() const { return true; }
+    virtual bool localOnly() const { return true; }
+    virtual QString commandname() const { return "rebuildstats"; }
+
+signals:
+    void done( bool rebuilt );
+
+private:
+    bool isConsistent( DatabaseImpl* dbi ) const;
+
+    bool m_force;
+};
+
+}
+
+#endif // DATABASECOMMAND_REBUILDSTATS_H
@@ -27,6 +27,9 @@
 #include "SourceList.h"
 #include "Track.h"
 
+// candidate tracks looked up with one statement
+#define RESOLVE_TRACK_BATCH 512
+
 using namespace Tomahawk;
 
 
@@ -91,83 +94,7 @@ DatabaseCommand_Resolve::resolve( DatabaseImpl* lib )
     }
 
     // STEP 2
-    TomahawkSqlQuery files_query = lib->newquery();
-
-    QStringList trksl;
-    for ( int k = 0; k < tracks.count(); k++ )
-        trksl.append( QString::number( tracks.at( k ).first ) );
-
-    QString trksToken = QString( "file_join.track IN (%1)" ).arg( trksl.join( "," ) );
-
-    QString sql = QString( "SELECT "
-                            "url, mtime, size, md5, mimetype, duration, bitrate, "  //0
-                            "file_join.artist, file_join.album, file_join.track, "  //7
-                            "file_join.composer, file_join.discnumber, "            //10
-                            "artist.name as artname, "                              //12
-                            "album.name as albname, "                               //13
-                            "track.name as trkname, "                               //14
-                            "composer.name as cmpname, "                            //15
-                            "file.source, "                                         //16
-                            "file_join.albumpos, "                                  //17
-                            "artist.id as artid, "                                  //18
-                            "album.id as albid, "                                   //19
-                            "composer.id as cmpid, "                                //20
-                            "albumArtist.id as albumartistid, "                     //21
-                            "albumArtist.name as albumartistname "                  //22
-                            "FROM file, file_join, artist, track "
-                            "LEFT JOIN album ON album.id = file_join.album "
-                            "LEFT JOIN artist AS composer ON composer.id = file_join.composer "
-                            "LEFT JOIN artist AS albumArtist ON albumArtist.id = album.artist "
-                            "WHERE "
-                            "artist.id = file_join.artist AND "
-                            "track.id = file_join.track AND "
-                            "file.id = file_join.file AND "
-                            "(%1)" )
-         .arg( trksToken );
-
-    files_query.prepare( sql );
-    files_query.exec();
-
-    while ( files_query.next() )
-    {
-        QString url = files_query.value( 0 ).toString();
-        source_ptr s = SourceList::instance()->get( files_query.value( 16 ).toUInt() );
-        if ( !s )
-        {
-            tDebug() << "Could not find source" << files_query.value( 16 ).toUInt();
-            continue;
-        }
-        if ( !s->isLocal() )
-            url = QString( "servent://%1\t%2" ).arg( s->nodeId() ).arg( url );
-
-        Tomahawk::result_ptr result = Tomahawk::Result::getCached( url );
-        if ( result )
-        {
-            tDebug( LOGVERBOSE ) << "Result already cached:" << result->toString();
-            res << result;
-            continue;
-        }
-
-        track_ptr track = Track::get( files_query.value( 9 ).toUInt(), files_query.value( 12 ).toString(), files_query.value( 14 ).toString(),
-                                      files_query.value( 13 ).toString(), files_query.value( 22 ).toString(), files_query.value( 5 ).toUInt(),
-                                      files_query.value( 15 ).toString(), files_query.value( 17 ).toUInt(), files_query.value( 11 ).toUInt() );
-        if ( !track )
-            continue;
-        track->loadAttributes();
-
-        result = Result::get( url, track );
-        if ( !result )
-            continue;
-
-        result->setModificationTime( files_query.value( 1 ).toUInt() );
-        result->setSize( files_query.value( 2 ).toUInt() );
-        result->setMimetype( files_query.value( 4 ).toString() );
-        result->setBitrate( files_query.value( 6 ).toUInt() );
-        result->setRID( uuid() );
-        result->setResolvedByCollection( s->dbCollection() );
-
-        res << result;
-    }
+    res = resultsForTracks( lib, tracks );
 
     emit results( m_query->id(), res );
 }
@@ -210,77 +137,105 @@ DatabaseCommand_Resolve::fullTextResolve( DatabaseImpl* lib )
     }
 
     // STEP 2
-    TomahawkSqlQuery files_query = lib->newquery();
-
-    QStringList trksl;
-    for ( int k = 0; k < trackPairs.count(); k++ )
-        trksl.append( QString::number( trackPairs.at( k ).first ) );
-
-    QString trksToken = QString( "file_join.track IN (%1)" ).arg( trksl.join( "," ) );
-    QString sql = QString( "SELECT "
-                            "url, mtime, size, md5, mimetype, duration, bitrate, "  //0
-                            "file_join.artist, file_join.album, file_join.track, "  //7
-                            "file_join.composer, file_join.discnumber, "            //10
-                            "artist.name as artname, "                              //12
-                            "album.name as albname, "                               //13
-                            "track.name as trkname, "                               //14
-                            "composer.name as cmpname, "                            //15
-                            "file.source, "                                         //16
-                            "file_join.albumpos, "                                  //17
-                            "artist.id as artid, "                                  //18
-                            "album.id as albid, "                                   //19
-                            "composer.id as cmpid, "                                //20
-                            "albumArtist.id as albumartistid, "                     //21
-                            "albumArtist.name as albumartistname "                  //22
-                            "FROM file, file_join, artist, track "
-                            "LEFT JOIN album ON album.id = file_join.album "
-                            "LEFT JOIN artist AS composer ON composer.id = file_join.composer "
-                            "LEFT JOIN artist AS albumArtist ON albumArtist.id = album.artist "
-                            "WHERE "
-                            "artist.id = file_join.artist AND "
-                            "track.id = file_join.track AND "
-                            "file.id = file_join.file AND "
-                            "%1" )
-                        .arg( !trksl.isEmpty() ? trksToken : QString( "0" ) );
-
-    files_query.prepare( sql );
-    files_query.exec();
-
-    while ( files_query.next() )
+    res = resultsForTracks( lib, trackPairs );
+
+    emit results( m_query->id(), res );
+}
+
+
+QList< Tomahawk::result_ptr >
+DatabaseCommand_Resolve::resultsForTracks( DatabaseImpl* lib, const QList< QPair<int, float> >& candidates )
+{
+    QList< unsigned int > ids;
+    for ( int k = 0; k < candidates.count(); k++ )
     {
-        QString url = files_query.value( 0 ).toString();
-        source_ptr s = SourceList::instance()->get( files_query.value( 16 ).toUInt() );
-        if ( !s )
-        {
-            tDebug() << "Could not find source" << files_query.value( 16 ).toUInt();
-            continue;
-        }
-        if ( !s->isLocal() )
-            url = QString( "servent://%1\t%2" ).arg( s->nodeId() ).arg( url );
+        if ( !ids.contains( candidates.at( k ).first ) )
+            ids << candidates.at( k ).first;
+    }
 
-        Tomahawk::result_ptr result = Tomahawk::Result::getCached( url );
-        if ( result )
+    QHash< unsigned int, QList< Tomahawk::result_ptr > > resultsPerTrack;
+    QHash< unsigned int, track_ptr > tracks;
+    for ( int i = 0; i < ids.count(); i += RESOLVE_TRACK_BATCH )
+    {
+        const QList< unsigned int > batch = ids.mid( i, RESOLVE_TRACK_BATCH );
+
+        // the IN list is padded to a few sizes, so its statements get cached as well
+        TomahawkSqlQuery files_query = lib->newquery();
+        files_query.prepare( QString( "SELECT "
+                                      "url, mtime, size, md5, mimetype, duration, bitrate, "  //0
+                                      "file_join.artist, file_join.album, file_join.track, "  //7
+                                      "file_join.composer, file_join.discnumber, "            //10
+                                      "artist.name as artname, "                              //12
+                                      "album.name as albname, "                               //13
+                                      "track.name as trkname, "                               //14
+                                      "composer.name as cmpname, "                            //15
+                                      "file.source, "                                         //16
+                                      "file_join.albumpos, "                                  //17
+                                      "artist.id as artid, "                                  //18
+                                      "album.id as albid, "                                   //19
+                                      "composer.id as cmpid, "                                //20
+                                      "albumArtist.id as albumartistid, "                     //21
+                                      "albumArtist.name as albumartistname "                  //22
+                                      "FROM file, file_join, artist, track "
+                                      "LEFT JOIN album ON album.id = file_join.album "
+                                      "LEFT JOIN artist AS composer ON composer.id = file_join.composer "
+                                      "LEFT JOIN artist AS albumArtist ON albumArtist.id = album.artist "
+                                      "WHERE "
+                                      "artist.id = file_join.artist AND "
+                                      "track.id = file_join.track AND "
+                                      "file.id = file_join.file AND "
+                                      "file_join.track IN ( %1 )" ).arg( DatabaseImpl::idPlaceholders( batch.count() ) ) );
+        DatabaseImpl::bindIds( files_query, batch );
+        files_query.exec();
+
+        while ( files_query.next() )
         {
-            tDebug( LOGVERBOSE ) << "Result already cached:" << result->toString();
-            res << result;
-            continue;
+            QString url = files_query.value( 0 ).toString();
+            source_ptr s = SourceList::instance()->get( files_query.value( 16 ).toUInt() );
+            if ( !s )
+            {
+                tDebug() << "Could not find source" << files_query.value( 16 ).toUInt();
+                continue;
+            }
+            if ( !s->isLocal() )
+                url = QString( "servent://%1\t%2" ).arg( s->nodeId() ).arg( url );
+
+            Tomahawk::result_ptr result = Tomahawk::Result::getCached( url );
+            if ( result )
+            {
+                tDebug( LOGVERBOSE ) << "Result already cached:" << result->toString();
+                resultsPerTrack[ files_query.value( 9 ).toUInt() ] << result;
+                continue;
+            }
+
+            track_ptr track = Track::get( files_query.value( 9 ).toUInt(), files_query.value( 12 ).toString(), files_query.value( 14 ).toString(),
+                                          files_query.value( 13 ).toString(), files_query.value( 22 ).toString(), files_query.value( 5 ).toUInt(),
+                                          files_query.value( 15 ).toString(), files_query.value( 17 ).toUInt(), files_query.value( 11 ).toUInt() );
+            if ( !track )
+                continue;
+            tracks.insert( track->trackId(), track );
+
+            result = Result::get( url, track );
+            if ( !result )
+                continue;
+
+            result->setModificationTime( files_query.value( 1 ).toUInt() );
+            result->setSize( files_query.value( 2 ).toUInt() );
+            result->setMimetype( files_query.value( 4 ).toString() );
+            result->setBitrate( files_query.value( 6 ).toUInt() );
+            result->setRID( uuid() );
+            result->setResolvedByCollection( s->dbCollection() );
+
+            resultsPerTrack[ files_query.value( 9 ).toUInt() ] << result;
         }
+    }
 
-        track_ptr track = Track::get( files_query.value( 9 ).toUInt(), files_query.value( 12 ).toString(), files_query.value( 14 ).toString(),
-                                      files_query.value( 13 ).toString(), files_query.value( 22 ).toString(), files_query.value( 5 ).toUInt(),
-                                      files_query.value( 15 ).toString(), files_query.value( 17 ).toUInt(), files_query.value( 11 ).toUInt() );
-        track->loadAttributes();
-
-        result = Result::get( url, track );
-        result->setModificationTime( files_query.value( 1 ).toUInt() );
-        result->setSize( files_query.value( 2 ).toUInt() );
-        result->setMimetype( files_query.value( 4 ).toString() );
-        result->setBitrate( files_query.value( 6 ).toUInt() );
-        result->setRID( uuid() );
-        result->setResolvedByCollection( s->dbCollection() );
+    // the IN list doesn't keep the order of the candidates, which are sorted by score
+    QList<Tomahawk::result_ptr> res;
+    foreach ( unsigned int id, ids )
+        res << resultsPerTrack.value( id );
 
-        res << result;
-    }
+    lib->loadTrackAttributes( tracks );
 
-    emit results( m_query->id(), res );
+    return res;
 }
@@ -54,6 +54,7 @@ private:
 
     void fullTextResolve( DatabaseImpl* lib );
     void resolve( DatabaseImpl* lib );
+    QList< Tomahawk::result_ptr > resultsForTracks( DatabaseImpl* lib, const QList< QPair<int, float> >& candidates );
 
     Tomahawk::query_ptr m_query;
 };
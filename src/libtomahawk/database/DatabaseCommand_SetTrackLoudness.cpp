@@ -0,0 +1,109 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DatabaseCommand_SetTrackLoudness.h"
+
+#include "DatabaseImpl.h"
+#include "TomahawkSqlQuery.h"
+#include "utils/Logger.h"
+
+#include <QSet>
+
+#include <cmath>
+
+namespace Tomahawk
+{
+
+void
+DatabaseCommand_SetTrackLoudness::exec( DatabaseImpl* dbi )
+{
+    TomahawkSqlQuery filequery = dbi->newquery();
+    TomahawkSqlQuery insertquery = dbi->newquery();
+    TomahawkSqlQuery albumquery = dbi->newquery();
+
+    filequery.prepare( "SELECT file.id, file_join.album FROM file "
+                       "LEFT JOIN file_join ON file_join.file = file.id "
+                       "WHERE file.source IS NULL AND file.url = ?" );
+    insertquery.prepare( "INSERT OR REPLACE INTO file_loudness ( file, loudness, peak ) VALUES( ?, ?, ? )" );
+    albumquery.prepare( "INSERT OR REPLACE INTO album_loudness ( album, loudness, peak ) VALUES( ?, ?, ? )" );
+
+    QSet< int > albums;
+    int stored = 0;
+    foreach ( const QVariant& v, m_tracks )
+    {
+        const QVariantMap m = v.toMap();
+
+        filequery.bindValue( 0, m.value( "url" ) );
+        filequery.exec();
+        if ( !filequery.next() )
+        {
+            tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Analysed file isn't in the collection anymore:" << m.value( "url" );
+            continue;
+        }
+
+        if ( !filequery.value( 1 ).isNull() )
+            albums << filequery.value( 1 ).toInt();
+
+        insertquery.bindValue( 0, filequery.value( 0 ) );
+        insertquery.bindValue( 1, m.contains( "loudness" ) ? m.value( "loudness" ) : QVariant( QVariant::Double ) );
+        insertquery.bindValue( 2, m.value( "peak", 0.0 ) );
+        insertquery.exec();
+
+        stored++;
+    }
+
+    foreach ( int album, albums )
+        updateAlbum( dbi, albumquery, album );
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Stored loudness for" << stored << "of" << m_tracks.count() << "files on" << albums.count() << "albums";
+}
+
+
+void
+DatabaseCommand_SetTrackLoudness::updateAlbum( DatabaseImpl* dbi, TomahawkSqlQuery& albumquery, int album )
+{
+    TomahawkSqlQuery query = dbi->newquery();
+    query.prepare( "SELECT file.duration, file_loudness.loudness, file_loudness.peak "
+                   "FROM file, file_join, file_loudness "
+                   "WHERE file.id = file_join.file AND file_loudness.file = file.id "
+                   "AND file.source IS NULL AND file_loudness.loudness IS NOT NULL AND file_join.album = ?" );
+    query.bindValue( 0, album );
+    query.exec();
+
+    // the mean energy of all files, weighted by duration, comes close to measuring the album as a whole
+    int files = 0;
+    double energy = 0.0, duration = 0.0, peak = 0.0;
+    while ( query.next() )
+    {
+        const double weight = qMax( 1, query.value( 0 ).toInt() );
+        energy += weight * std::pow( 10.0, query.value( 1 ).toDouble() / 10.0 );
+        duration += weight;
+        peak = qMax( peak, query.value( 2 ).toDouble() );
+        files++;
+    }
+
+    if ( !files )
+        return;
+
+    albumquery.bindValue( 0, album );
+    albumquery.bindValue( 1, 10.0 * std::log10( energy / duration ) );
+    albumquery.bindValue( 2, peak );
+    albumquery.exec();
+}
+
+}
@@ -0,0 +1,69 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DATABASECOMMAND_SETTRACKLOUDNESS_H
+#define DATABASECOMMAND_SETTRACKLOUDNESS_H
+
+#include <QVariantMap>
+
+#include "DatabaseCommand.h"
+#include "TomahawkSqlQuery.h"
+
+#include "DllMacro.h"
+
+// Not loggable, loudness values are derived from our local files only.
+
+namespace Tomahawk
+{
+
+/**
+ * \class DatabaseCommand_SetTrackLoudness
+ * \brief Stores the results of the scanner's loudness analysis.
+ *
+ * Takes a list of maps with the keys "url", "loudness" and "peak". Loudness is in
+ * LUFS, peaks are linear sample peaks. A file that couldn't be decoded comes
+ * without a loudness.
+ *
+ * Values are stored per file, as the same track may exist in several files and
+ * on several albums. Album loudness and peak are derived from all analysed local
+ * files of the albums involved, so they stay right when an album is analysed bit
+ * by bit.
+ */
+class DLLEXPORT DatabaseCommand_SetTrackLoudness : public DatabaseCommand
+{
+Q_OBJECT
+
+public:
+    explicit DatabaseCommand_SetTrackLoudness( const QVariantList& tracks, QObject* parent = 0 )
+        : DatabaseCommand( parent ), m_tracks( tracks )
+    {}
+
+    virtual void exec( DatabaseImpl* );
+    virtual bool doesMutates() const { return true; }
+    virtual bool localOnly() const { return true; }
+    virtual QString commandname() const { return "settrackloudness"; }
+
+private:
+    void updateAlbum( DatabaseImpl* dbi, TomahawkSqlQuery& albumquery, int album );
+
+    QVariantList m_tracks;
+};
+
+}
+
+#endif // DATABASECOMMAND_SETTRACKLOUDNESS_H
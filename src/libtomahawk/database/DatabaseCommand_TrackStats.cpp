@@ -57,29 +57,20 @@ DatabaseCommand_TrackStats::exec( DatabaseImpl* dbi )
         if ( m_track->trackId() == 0 )
             return;
 
-        query.prepare( "SELECT COUNT(*) AS counter, track.id "
-                       "FROM playback_log, track "
-                       "WHERE playback_log.source IS NULL AND track.id = playback_log.track "
-                       "GROUP BY track.id "
-                       "ORDER BY counter DESC" );
-        query.exec();
-
         unsigned int chartPos = 0;
         unsigned int chartCount = 0;
-        const unsigned int trackId = m_track->trackId();
-
-        QHash< QString, unsigned int > charts;
-        while ( query.next() )
-        {
-            if ( query.value( 0 ).toUInt() < 2 )
-                break;
-
-            chartCount++;
-            if ( chartPos == 0 && query.value( 1 ).toUInt() == trackId )
-            {
-                chartPos = chartCount;
-            }
-        }
+
+        // tracks need at least two plays to make it into the charts
+        query.exec( "SELECT COUNT(*) FROM track_stats WHERE plays >= 2" );
+        if ( query.next() )
+            chartCount = query.value( 0 ).toUInt();
+
+        query.prepare( "SELECT plays, (SELECT COUNT(*) FROM track_stats AS other WHERE other.plays > track_stats.plays) "
+                       "FROM track_stats WHERE track = ?" );
+        query.addBindValue( m_track->trackId() );
+        query.exec();
+        if ( query.next() && query.value( 0 ).toUInt() >= 2 )
+            chartPos = query.value( 1 ).toUInt() + 1;
 
         if ( chartPos == 0 )
             chartPos = chartCount;
@@ -48,9 +48,10 @@ DatabaseCommand_TrendingArtists::exec( DatabaseImpl* dbi )
         limit = QString( "LIMIT 0, %1" ).arg( d->amount );
     }
 
-    QDateTime now = QDateTime::currentDateTime();
-    QDateTime _1WeekAgo = now.addDays( -7 );
-    QDateTime _2WeeksAgo = now.addDays( -14 );
+    // weeks are made of whole (UTC) days, the rollups don't know anything finer
+    const uint today = QDateTime::currentDateTimeUtc().toTime_t() / 86400;
+    const uint _1WeekAgo = today - 7;
+    const uint _2WeeksAgo = today - 14;
 
     uint peersLastWeek = 1; // Use a default of 1 to be able to do certain mathematical computations without Div-by-0 Errors.
     {
@@ -59,10 +60,10 @@ DatabaseCommand_TrendingArtists::exec( DatabaseImpl* dbi )
 
         QString peersLastWeekSql = QString(
                     " SELECT COUNT(DISTINCT source ) "
-                    " FROM playback_log "
-                    " WHERE playback_log.source IS NOT NULL " // exclude self
-                    " AND playback_log.playtime >= %1 "
-                    ).arg( _1WeekAgo.toTime_t() );
+                    " FROM playback_daily "
+                    " WHERE playback_daily.source > 0 " // exclude self
+                    " AND playback_daily.day > %1 "
+                    ).arg( _1WeekAgo );
         TomahawkSqlQuery query = dbi->newquery();
         query.prepare( peersLastWeekSql );
         query.exec();
@@ -74,16 +75,15 @@ DatabaseCommand_TrendingArtists::exec( DatabaseImpl* dbi )
 
 
     QString timespanSql = QString(
-                " SELECT COUNT(*) as counter, track.artist as artistid "
-                " FROM playback_log "
-                " JOIN track ON track.id = playback_log.track "
-                " WHERE playback_log.source IS NOT NULL " // exclude self
-                " AND playback_log.playtime >= %1 AND playback_log.playtime <= %2 "
-                " GROUP BY track.artist "
+                " SELECT SUM(plays) as counter, artist as artistid "
+                " FROM playback_daily "
+                " WHERE playback_daily.source > 0 " // exclude self
+                " AND playback_daily.day > %1 AND playback_daily.day <= %2 "
+                " GROUP BY playback_daily.artist "
                 " HAVING counter > 0 "
                 );
-    QString lastWeekSql = timespanSql.arg( _1WeekAgo.toTime_t() ).arg( now.toTime_t() );
-    QString _1BeforeLastWeekSql = timespanSql.arg( _2WeeksAgo.toTime_t() ).arg( _1WeekAgo.toTime_t() );
+    QString lastWeekSql = timespanSql.arg( _1WeekAgo ).arg( today );
+    QString _1BeforeLastWeekSql = timespanSql.arg( _2WeeksAgo ).arg( _1WeekAgo );
     QString formula = QString(
                 " (  lastweek.counter /  weekbefore.counter ) "
                 " * "
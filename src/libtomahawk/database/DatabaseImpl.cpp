@@ -48,9 +48,15 @@
 */
 #include "Schema.sql.h"
 
-#define CURRENT_SCHEMA_VERSION 31
+// number of track ids looked up per statement when loading track data in batches
+#define DATABASEIMPL_TRACK_BATCH 512
+// prepared statements kept around per connection
+#define DATABASEIMPL_STATEMENT_CACHE 128
+
+#define CURRENT_SCHEMA_VERSION 34
 
 Tomahawk::DatabaseImpl::DatabaseImpl( const QString& dbname )
+    : m_statements( DATABASEIMPL_STATEMENT_CACHE )
 {
     QTime t;
     t.start();
@@ -101,6 +107,7 @@ Tomahawk::DatabaseImpl::DatabaseImpl( const QString& dbname )
 
 
 Tomahawk::DatabaseImpl::DatabaseImpl( const QString& dbname, bool internal )
+    : m_statements( DATABASEIMPL_STATEMENT_CACHE )
 {
     Q_UNUSED( internal );
     openDatabase( dbname, false );
@@ -123,6 +130,10 @@ Tomahawk::DatabaseImpl::init()
 Tomahawk::DatabaseImpl::~DatabaseImpl()
 {
     tDebug() << "Shutting down database connection.";
+    tDebug( LOGVERBOSE ) << "Prepared" << m_statements.prepared() << "statements, reused" << m_statements.reused();
+
+    // finalize the cached statements while the connection is still around
+    m_statements.clear();
 
 /*
 #ifdef TOMAHAWK_QUERY_ANALYZE
@@ -144,7 +155,7 @@ TomahawkSqlQuery
 Tomahawk::DatabaseImpl::newquery()
 {
     QMutexLocker lock( &m_mutex );
-    return TomahawkSqlQuery( m_db );
+    return TomahawkSqlQuery( m_db, &m_statements );
 }
 
 
@@ -283,22 +294,214 @@ Tomahawk::DatabaseImpl::cleanSql( const QString& sql )
 }
 
 
+void
+Tomahawk::DatabaseImpl::updateCollectionStats( unsigned int sourceId, int fileDelta, unsigned int mtime )
+{
+    TomahawkSqlQuery query = newquery();
+    query.prepare( "INSERT OR IGNORE INTO collection_stats(source) VALUES (?)" );
+    query.addBindValue( sourceId );
+    query.exec();
+
+    query.prepare( "UPDATE collection_stats SET numfiles = max( 0, numfiles + ? ), lastmodified = max( lastmodified, ? ) WHERE source = ?" );
+    query.addBindValue( fileDelta );
+    query.addBindValue( mtime );
+    query.addBindValue( sourceId );
+    query.exec();
+}
+
+
+void
+Tomahawk::DatabaseImpl::updatePlayStats( unsigned int sourceId, int artistId, int trackId, unsigned int playtime, unsigned int secsPlayed )
+{
+    TomahawkSqlQuery query = newquery();
+    query.prepare( "INSERT OR IGNORE INTO collection_stats(source) VALUES (?)" );
+    query.addBindValue( sourceId );
+    query.exec();
+
+    query.prepare( "UPDATE collection_stats SET plays = plays + 1, secs_played = secs_played + ? WHERE source = ?" );
+    query.addBindValue( secsPlayed );
+    query.addBindValue( sourceId );
+    query.exec();
+
+    // daily rollups, days are counted in UTC since the epoch
+    query.prepare( "INSERT OR IGNORE INTO playback_daily(day, source, track, artist) VALUES (?, ?, ?, ?)" );
+    query.addBindValue( playtime / 86400 );
+    query.addBindValue( sourceId );
+    query.addBindValue( trackId );
+    query.addBindValue( artistId );
+    query.exec();
+
+    query.prepare( "UPDATE playback_daily SET plays = plays + 1, secs_played = secs_played + ? WHERE day = ? AND source = ? AND track = ?" );
+    query.addBindValue( secsPlayed );
+    query.addBindValue( playtime / 86400 );
+    query.addBindValue( sourceId );
+    query.addBindValue( trackId );
+    query.exec();
+
+    // the per track and artist charts only count our own plays
+    if ( sourceId > 0 )
+        return;
+
+    query.prepare( "INSERT OR IGNORE INTO track_stats(track) VALUES (?)" );
+    query.addBindValue( trackId );
+    query.exec();
+
+    query.prepare( "UPDATE track_stats SET plays = plays + 1, secs_played = secs_played + ? WHERE track = ?" );
+    query.addBindValue( secsPlayed );
+    query.addBindValue( trackId );
+    query.exec();
+
+    query.prepare( "INSERT OR IGNORE INTO artist_stats(artist) VALUES (?)" );
+    query.addBindValue( artistId );
+    query.exec();
+
+    query.prepare( "UPDATE artist_stats SET plays = plays + 1, secs_played = secs_played + ? WHERE artist = ?" );
+    query.addBindValue( secsPlayed );
+    query.addBindValue( artistId );
+    query.exec();
+}
+
+
+void
+Tomahawk::DatabaseImpl::rebuildStats()
+{
+    TomahawkSqlQuery query = newquery();
+    query.exec( "DELETE FROM collection_stats" );
+    query.exec( "DELETE FROM track_stats" );
+    query.exec( "DELETE FROM artist_stats" );
+    query.exec( "DELETE FROM playback_daily" );
+
+    query.exec( "INSERT INTO collection_stats(source, numfiles, lastmodified) "
+                "SELECT coalesce(source, 0), count(*), coalesce(max(mtime), 0) FROM file GROUP BY source" );
+    query.exec( "INSERT OR IGNORE INTO collection_stats(source) "
+                "SELECT DISTINCT coalesce(source, 0) FROM playback_log" );
+    query.exec( "UPDATE collection_stats SET "
+                "plays = (SELECT count(*) FROM playback_log WHERE coalesce(playback_log.source, 0) = collection_stats.source), "
+                "secs_played = (SELECT coalesce(sum(secs_played), 0) FROM playback_log WHERE coalesce(playback_log.source, 0) = collection_stats.source)" );
+
+    query.exec( "INSERT INTO track_stats(track, plays, secs_played) "
+                "SELECT track, count(*), sum(secs_played) FROM playback_log "
+                "WHERE source IS NULL AND track IS NOT NULL GROUP BY track" );
+    query.exec( "INSERT INTO artist_stats(artist, plays, secs_played) "
+                "SELECT track.artist, count(*), sum(playback_log.secs_played) FROM playback_log, track "
+                "WHERE playback_log.source IS NULL AND track.id = playback_log.track GROUP BY track.artist" );
+
+    query.exec( "INSERT INTO playback_daily(day, source, track, artist, plays, secs_played) "
+                "SELECT playback_log.playtime / 86400, coalesce(playback_log.source, 0), playback_log.track, track.artist, "
+                "count(*), sum(playback_log.secs_played) FROM playback_log, track "
+                "WHERE track.id = playback_log.track "
+                "GROUP BY playback_log.playtime / 86400, playback_log.source, playback_log.track" );
+}
+
+
+QString
+Tomahawk::DatabaseImpl::idPlaceholders( int count )
+{
+    // round up to a power of two, so there are only a few different statements to cache
+    int size = 8;
+    while ( size < count )
+        size *= 2;
+
+    QStringList placeholders;
+    for ( int i = 0; i < size; i++ )
+        placeholders << "?";
+
+    return placeholders.join( ", " );
+}
+
+
+void
+Tomahawk::DatabaseImpl::bindIds( TomahawkSqlQuery& query, const QList< unsigned int >& ids )
+{
+    int size = 8;
+    while ( size < ids.count() )
+        size *= 2;
+
+    // the unused placeholders get an id that doesn't exist
+    for ( int i = 0; i < size; i++ )
+        query.addBindValue( i < ids.count() ? ids.at( i ) : 0 );
+}
+
+
+void
+Tomahawk::DatabaseImpl::loadTrackAttributes( const QHash< unsigned int, Tomahawk::track_ptr >& tracks )
+{
+    const QList< unsigned int > ids = tracks.keys();
+    for ( int i = 0; i < ids.count(); i += DATABASEIMPL_TRACK_BATCH )
+    {
+        const QList< unsigned int > batch = ids.mid( i, DATABASEIMPL_TRACK_BATCH );
+        QHash< unsigned int, QVariantMap > attributes;
+        foreach ( unsigned int id, batch )
+            attributes.insert( id, QVariantMap() );
+
+        TomahawkSqlQuery query = newquery();
+        query.prepare( QString( "SELECT id, k, v FROM track_attributes WHERE id IN ( %1 )" ).arg( idPlaceholders( batch.count() ) ) );
+        bindIds( query, batch );
+        query.exec();
+        while ( query.next() )
+            attributes[ query.value( 0 ).toUInt() ][ query.value( 1 ).toString() ] = query.value( 2 ).toString();
+
+        // tracks without any attributes count as loaded too
+        QHash< unsigned int, QVariantMap >::const_iterator it = attributes.constBegin();
+        for ( ; it != attributes.constEnd(); ++it )
+            tracks.value( it.key() )->setAttributes( it.value() );
+    }
+}
+
+
+void
+Tomahawk::DatabaseImpl::loadSocialActions( const QHash< unsigned int, Tomahawk::track_ptr >& tracks )
+{
+    const QList< unsigned int > ids = tracks.keys();
+    for ( int i = 0; i < ids.count(); i += DATABASEIMPL_TRACK_BATCH )
+    {
+        const QList< unsigned int > batch = ids.mid( i, DATABASEIMPL_TRACK_BATCH );
+        QHash< unsigned int, QList< Tomahawk::SocialAction > > actions;
+        foreach ( unsigned int id, batch )
+            actions.insert( id, QList< Tomahawk::SocialAction >() );
+
+        TomahawkSqlQuery query = newquery();
+        query.prepare( QString( "SELECT id, k, v, timestamp, source "
+                                "FROM social_attributes WHERE id IN ( %1 ) "
+                                "ORDER BY timestamp ASC" ).arg( idPlaceholders( batch.count() ) ) );
+        bindIds( query, batch );
+        query.exec();
+        while ( query.next() )
+        {
+            Tomahawk::SocialAction action;
+            action.action    = query.value( 1 );  // action
+            action.value     = query.value( 2 );  // comment
+            action.timestamp = query.value( 3 );  // timestamp
+            action.source    = SourceList::instance()->get( query.value( 4 ).toInt() );  // source
+
+            if ( !action.source.isNull() )
+                actions[ query.value( 0 ).toUInt() ].append( action );
+        }
+
+        QHash< unsigned int, QList< Tomahawk::SocialAction > >::const_iterator it = actions.constBegin();
+        for ( ; it != actions.constEnd(); ++it )
+            tracks.value( it.key() )->setAllSocialActions( it.value() );
+    }
+}
+
+
 Tomahawk::result_ptr
 Tomahawk::DatabaseImpl::file( int fid )
 {
     Tomahawk::result_ptr r;
     TomahawkSqlQuery query = newquery();
-    query.exec( QString( "SELECT url, mtime, size, md5, mimetype, duration, bitrate, "
-                         "file_join.artist, file_join.album, file_join.track, file_join.composer, "
-                         "(SELECT name FROM artist WHERE id = file_join.artist) AS artname, "
-                         "(SELECT name FROM album  WHERE id = file_join.album)  AS albname, "
-                         "(SELECT name FROM track  WHERE id = file_join.track)  AS trkname, "
-                         "(SELECT name FROM artist WHERE id = file_join.composer) AS cmpname, "
-                         "source, "
-                         "(SELECT artist.name FROM artist, album WHERE artist.id = album.artist AND album.id = file_join.album) AS albumartname "
-                         "FROM file, file_join "
-                         "WHERE file.id = file_join.file AND file.id = %1" )
-                .arg( fid ) );
+    query.prepare( "SELECT url, mtime, size, md5, mimetype, duration, bitrate, "
+                   "file_join.artist, file_join.album, file_join.track, file_join.composer, "
+                   "(SELECT name FROM artist WHERE id = file_join.artist) AS artname, "
+                   "(SELECT name FROM album  WHERE id = file_join.album)  AS albname, "
+                   "(SELECT name FROM track  WHERE id = file_join.track)  AS trkname, "
+                   "(SELECT name FROM artist WHERE id = file_join.composer) AS cmpname, "
+                   "source, "
+                   "(SELECT artist.name FROM artist, album WHERE artist.id = album.artist AND album.id = file_join.album) AS albumartname "
+                   "FROM file, file_join "
+                   "WHERE file.id = file_join.file AND file.id = ?" );
+    query.addBindValue( fid );
+    query.exec();
 
     if ( query.next() )
     {
@@ -528,9 +731,10 @@ Tomahawk::DatabaseImpl::getTrackFids( int tid )
     QList< int > ret;
 
     TomahawkSqlQuery query = newquery();
-    query.exec( QString( "SELECT file.id FROM file, file_join "
-                         "WHERE file_join.file=file.id "
-                         "AND file_join.track = %1 ").arg( tid ) );
+    query.prepare( "SELECT file.id FROM file, file_join "
+                   "WHERE file_join.file=file.id "
+                   "AND file_join.track = ?" );
+    query.addBindValue( tid );
     query.exec();
 
     while( query.next() )
@@ -558,7 +762,9 @@ QVariantMap
 Tomahawk::DatabaseImpl::artist( int id )
 {
     TomahawkSqlQuery query = newquery();
-    query.exec( QString( "SELECT id, name, sortname FROM artist WHERE id = %1" ).arg( id ) );
+    query.prepare( "SELECT id, name, sortname FROM artist WHERE id = ?" );
+    query.addBindValue( id );
+    query.exec();
 
     QVariantMap m;
     if( !query.next() )
@@ -575,7 +781,9 @@ QVariantMap
 Tomahawk::DatabaseImpl::track( int id )
 {
     TomahawkSqlQuery query = newquery();
-    query.exec( QString( "SELECT id, artist, name, sortname FROM track WHERE id = %1" ).arg( id ) );
+    query.prepare( "SELECT id, artist, name, sortname FROM track WHERE id = ?" );
+    query.addBindValue( id );
+    query.exec();
 
     QVariantMap m;
     if( !query.next() )
@@ -593,7 +801,9 @@ QVariantMap
 Tomahawk::DatabaseImpl::album( int id )
 {
     TomahawkSqlQuery query = newquery();
-    query.exec( QString( "SELECT id, artist, name, sortname FROM album WHERE id = %1" ).arg( id ) );
+    query.prepare( "SELECT id, artist, name, sortname FROM album WHERE id = ?" );
+    query.addBindValue( id );
+    query.exec();
 
     QVariantMap m;
     if( !query.next() )
@@ -59,6 +59,7 @@ public:
 
     TomahawkSqlQuery newquery();
     QSqlDatabase& database();
+    TomahawkSqlStatementCache* statementCache() { return &m_statements; }
 
     int artistId( const QString& name_orig, bool autoCreate ); //also for composers!
     int trackId( int artistid, const QString& name_orig, bool autoCreate );
@@ -76,6 +77,23 @@ public:
     Tomahawk::result_ptr file( int fid );
     Tomahawk::result_ptr resultFromHint( const Tomahawk::query_ptr& query );
 
+    /**
+     * Keep the collection_stats, track_stats, artist_stats and playback_daily aggregates in sync.
+     * Call these from the command that changes file or playback_log, so they end up
+     * in the same transaction. sourceId is 0 for the local source.
+     */
+    void updateCollectionStats( unsigned int sourceId, int fileDelta, unsigned int mtime );
+    void updatePlayStats( unsigned int sourceId, int artistId, int trackId, unsigned int playtime, unsigned int secsPlayed );
+    /// Recomputes all aggregates from scratch
+    void rebuildStats();
+
+    /**
+     * Fill in the attributes or social actions of many tracks at once, instead of a
+     * separate command per track. tracks maps track ids to a track with that id.
+     */
+    void loadTrackAttributes( const QHash< unsigned int, Tomahawk::track_ptr >& tracks );
+    void loadSocialActions( const QHash< unsigned int, Tomahawk::track_ptr >& tracks );
+
     static bool scorepairSorter( const QPair<int,float>& left, const QPair<int,float>& right )
     {
         return left.second > right.second;
@@ -99,6 +117,8 @@ private:
     void setDatabaseID( const QString& dbid ) { m_dbid = dbid; }
 
     void init();
+    static QString idPlaceholders( int count );
+    static void bindIds( TomahawkSqlQuery& query, const QList< unsigned int >& ids );
     bool openDatabase( const QString& dbname, bool checkSchema = true );
     bool updateSchema( int oldVersion );
     void dumpDatabase();
@@ -112,6 +132,7 @@ private:
 
     QString m_dbid;
     Tomahawk::DatabaseFuzzyIndex* m_fuzzyIndex;
+    TomahawkSqlStatementCache m_statements;
     mutable QMutex m_mutex;
 };
 
@@ -37,6 +37,8 @@ public:
     virtual unsigned int weight() const override{ return m_weight; }
     virtual unsigned int timeout() const override{ return 0; }
 
+    using Resolver::resolve;
+
 public slots:
     virtual void resolve( const Tomahawk::query_ptr& query ) override;
 
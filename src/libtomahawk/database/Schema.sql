@@ -280,6 +280,62 @@ CREATE INDEX playback_log_playtime ON playback_log(playtime);
 
 
 
+-- aggregates kept up to date by AddFiles, DeleteFiles and LogPlayback,
+-- DatabaseCommand_RebuildStats recomputes them from file and playback_log
+
+CREATE TABLE IF NOT EXISTS collection_stats (
+    source INTEGER PRIMARY KEY,             -- 0 for the local collection
+    numfiles INTEGER NOT NULL DEFAULT 0,
+    lastmodified INTEGER NOT NULL DEFAULT 0,
+    plays INTEGER NOT NULL DEFAULT 0,
+    secs_played INTEGER NOT NULL DEFAULT 0
+);
+
+-- local plays only, like the charts built from them
+CREATE TABLE IF NOT EXISTS track_stats (
+    track INTEGER PRIMARY KEY REFERENCES track(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    plays INTEGER NOT NULL DEFAULT 0,
+    secs_played INTEGER NOT NULL DEFAULT 0
+);
+CREATE INDEX track_stats_plays ON track_stats(plays);
+
+CREATE TABLE IF NOT EXISTS artist_stats (
+    artist INTEGER PRIMARY KEY REFERENCES artist(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    plays INTEGER NOT NULL DEFAULT 0,
+    secs_played INTEGER NOT NULL DEFAULT 0
+);
+CREATE INDEX artist_stats_plays ON artist_stats(plays);
+
+-- plays per day (playtime / 86400, UTC), source and track, for charts and trending
+CREATE TABLE IF NOT EXISTS playback_daily (
+    day INTEGER NOT NULL,
+    source INTEGER NOT NULL,                -- 0 for the local source
+    track INTEGER NOT NULL REFERENCES track(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    artist INTEGER NOT NULL REFERENCES artist(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    plays INTEGER NOT NULL DEFAULT 0,
+    secs_played INTEGER NOT NULL DEFAULT 0,
+    PRIMARY KEY (day, source, track)
+);
+CREATE INDEX playback_daily_track ON playback_daily(track);
+CREATE INDEX playback_daily_artist ON playback_daily(artist);
+
+-- loudness of local files and albums as measured by the scanner, in LUFS with
+-- linear sample peaks. files that couldn't be decoded only get a peak.
+
+CREATE TABLE IF NOT EXISTS file_loudness (
+    file INTEGER PRIMARY KEY REFERENCES file(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    loudness REAL,
+    peak REAL NOT NULL
+);
+
+CREATE TABLE IF NOT EXISTS album_loudness (
+    album INTEGER PRIMARY KEY REFERENCES album(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,
+    loudness REAL NOT NULL,
+    peak REAL NOT NULL
+);
+
+
+
 -- auth information for http clients
 
 CREATE TABLE IF NOT EXISTS http_client_auth (
@@ -300,4 +356,4 @@ CREATE TABLE IF NOT EXISTS settings (
     v TEXT NOT NULL DEFAULT ''
 );
 
-INSERT INTO settings(k,v) VALUES('schema_version', '31');
+INSERT INTO settings(k,v) VALUES('schema_version', '34');
@@ -1,5 +1,5 @@
 /*
-    This file was automatically generated from ./Schema.sql on Tue Jul 30 12:51:06 CEST 2013.
+    This file was automatically generated from ./Schema.sql on Sun Oct 18 12:17:08 UTC 2026.
 */
 
 static const char * tomahawk_schema_sql = 
@@ -185,6 +185,46 @@ static const char * tomahawk_schema_sql =
 "CREATE INDEX playback_log_source ON playback_log(source);"
 "CREATE INDEX playback_log_track ON playback_log(track);"
 "CREATE INDEX playback_log_playtime ON playback_log(playtime);"
+"CREATE TABLE IF NOT EXISTS collection_stats ("
+"    source INTEGER PRIMARY KEY,             "
+"    numfiles INTEGER NOT NULL DEFAULT 0,"
+"    lastmodified INTEGER NOT NULL DEFAULT 0,"
+"    plays INTEGER NOT NULL DEFAULT 0,"
+"    secs_played INTEGER NOT NULL DEFAULT 0"
+");"
+"CREATE TABLE IF NOT EXISTS track_stats ("
+"    track INTEGER PRIMARY KEY REFERENCES track(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,"
+"    plays INTEGER NOT NULL DEFAULT 0,"
+"    secs_played INTEGER NOT NULL DEFAULT 0"
+");"
+"CREATE INDEX track_stats_plays ON track_stats(plays);"
+"CREATE TABLE IF NOT EXISTS artist_stats ("
+"    artist INTEGER PRIMARY KEY REFERENCES artist(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,"
+"    plays INTEGER NOT NULL DEFAULT 0,"
+"    secs_played INTEGER NOT NULL DEFAULT 0"
+");"
+"CREATE INDEX artist_stats_plays ON artist_stats(plays);"
+"CREATE TABLE IF NOT EXISTS playback_daily ("
+"    day INTEGER NOT NULL,"
+"    source INTEGER NOT NULL,                "
+"    track INTEGER NOT NULL REFERENCES track(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,"
+"    artist INTEGER NOT NULL REFERENCES artist(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,"
+"    plays INTEGER NOT NULL DEFAULT 0,"
+"    secs_played INTEGER NOT NULL DEFAULT 0,"
+"    PRIMARY KEY (day, source, track)"
+");"
+"CREATE INDEX playback_daily_track ON playback_daily(track);"
+"CREATE INDEX playback_daily_artist ON playback_daily(artist);"
+"CREATE TABLE IF NOT EXISTS file_loudness ("
+"    file INTEGER PRIMARY KEY REFERENCES file(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,"
+"    loudness REAL,"
+"    peak REAL NOT NULL"
+");"
+"CREATE TABLE IF NOT EXISTS album_loudness ("
+"    album INTEGER PRIMARY KEY REFERENCES album(id) ON DELETE CASCADE ON UPDATE CASCADE DEFERRABLE INITIALLY DEFERRED,"
+"    loudness REAL NOT NULL,"
+"    peak REAL NOT NULL"
+");"
 "CREATE TABLE IF NOT EXISTS http_client_auth ("
 "    token TEXT NOT NULL PRIMARY KEY,"
 "    website TEXT NOT NULL,"
@@ -197,7 +237,7 @@ static const char * tomahawk_schema_sql =
 "    k TEXT NOT NULL PRIMARY KEY,"
 "    v TEXT NOT NULL DEFAULT ''"
 ");"
-"INSERT INTO settings(k,v) VALUES('schema_version', '31');"
+"INSERT INTO settings(k,v) VALUES('schema_version', '34');"
     ;
 
 const char * get_tomahawk_sql()
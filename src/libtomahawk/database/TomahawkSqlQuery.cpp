@@ -34,15 +34,125 @@
 #define QUERY_THRESHOLD 60
 
 
+struct TomahawkSqlQuery::CachedStatement
+{
+    CachedStatement( TomahawkSqlStatementCache* c, const QString& s, const QSqlQuery& q )
+        : cache( c ), sql( s ), statement( q )
+    {
+    }
+
+    ~CachedStatement()
+    {
+        if ( cache )
+            cache->give( sql, statement );
+    }
+
+    TomahawkSqlStatementCache* cache;
+    QString sql;
+    QSqlQuery statement;
+};
+
+
+TomahawkSqlStatementCache::TomahawkSqlStatementCache( int capacity )
+    : m_prepared( 0 )
+    , m_reused( 0 )
+{
+    m_statements.setMaxCost( capacity );
+}
+
+
+bool
+TomahawkSqlStatementCache::take( const QString& sql, QSqlQuery& statement )
+{
+    QMutexLocker lock( &m_mutex );
+
+    QSqlQuery* cached = m_statements.take( sql );
+    if ( !cached )
+        return false;
+
+    statement = *cached;
+    delete cached;
+
+    m_reused++;
+    return true;
+}
+
+
+void
+TomahawkSqlStatementCache::give( const QString& sql, QSqlQuery statement )
+{
+    // release the statement's locks and results before anyone else gets it
+    statement.finish();
+
+    QMutexLocker lock( &m_mutex );
+
+    // another query with the same SQL already gave its statement back, one is enough
+    if ( m_statements.contains( sql ) )
+        return;
+
+    m_statements.insert( sql, new QSqlQuery( statement ) );
+}
+
+
+void
+TomahawkSqlStatementCache::clear()
+{
+    QMutexLocker lock( &m_mutex );
+    m_statements.clear();
+}
+
+
+void
+TomahawkSqlStatementCache::setCapacity( int capacity )
+{
+    QMutexLocker lock( &m_mutex );
+    m_statements.setMaxCost( capacity );
+}
+
+
+int
+TomahawkSqlStatementCache::capacity() const
+{
+    QMutexLocker lock( &m_mutex );
+    return m_statements.maxCost();
+}
+
+
+void
+TomahawkSqlStatementCache::countPrepared()
+{
+    QMutexLocker lock( &m_mutex );
+    m_prepared++;
+}
+
+
+quint64
+TomahawkSqlStatementCache::prepared() const
+{
+    QMutexLocker lock( &m_mutex );
+    return m_prepared;
+}
+
+
+quint64
+TomahawkSqlStatementCache::reused() const
+{
+    QMutexLocker lock( &m_mutex );
+    return m_reused;
+}
+
+
 TomahawkSqlQuery::TomahawkSqlQuery()
     : QSqlQuery()
+    , m_cache( 0 )
 {
 }
 
 
-TomahawkSqlQuery::TomahawkSqlQuery( const QSqlDatabase& db )
+TomahawkSqlQuery::TomahawkSqlQuery( const QSqlDatabase& db, TomahawkSqlStatementCache* cache )
     : QSqlQuery( db )
     , m_db( db )
+    , m_cache( cache )
 {
 }
 
@@ -58,6 +168,41 @@ bool
 TomahawkSqlQuery::prepare( const QString& query )
 {
     m_query = query;
+    if ( !m_cache )
+        return QSqlQuery::prepare( query );
+
+    // hands our previous statement back to the cache, unless a copy of us still uses it
+    m_statement.clear();
+
+    QSqlQuery statement;
+    if ( m_cache->take( query, statement ) )
+    {
+        QSqlQuery::operator=( statement );
+    }
+    else
+    {
+        // don't re-prepare the statement we just gave back, start over with a fresh one
+        QSqlQuery::operator=( QSqlQuery( m_db ) );
+        if ( !QSqlQuery::prepare( query ) )
+            return false;
+
+        m_cache->countPrepared();
+    }
+
+    m_statement = QSharedPointer< CachedStatement >( new CachedStatement( m_cache, query, *this ) );
+    return true;
+}
+
+
+bool
+TomahawkSqlQuery::prepareUncached( const QString& query )
+{
+    m_query = query;
+
+    // hands our previous statement back to the cache, unless a copy of us still uses it
+    m_statement.clear();
+    QSqlQuery::operator=( QSqlQuery( m_db ) );
+
     return QSqlQuery::prepare( query );
 }
 
@@ -65,8 +210,10 @@ TomahawkSqlQuery::prepare( const QString& query )
 bool
 TomahawkSqlQuery::exec( const QString& query )
 {
+    // one-off SQL (schema changes, values inlined into the text) would only push
+    // the statements that do get reused out of the cache
 //     bool prepareResult =
-    prepare( query );
+    prepareUncached( query );
 //     tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Query preparation successful?" << ( prepareResult ? "true" : "false" );
     return exec();
 }
@@ -94,7 +241,15 @@ TomahawkSqlQuery::exec()
             tDebug() << Q_FUNC_INFO << "Re-preparing query!";
 
             QMap< QString, QVariant > bv = boundValues();
-            prepare( m_query );
+
+            // a broken statement must not go back into the cache
+            if ( m_statement )
+            {
+                m_statement->cache = 0;
+                prepare( m_query );
+            }
+            else
+                prepareUncached( m_query );
 
             foreach ( const QString& key, bv.keys() )
             {
@@ -21,6 +21,9 @@
 
 // subclass QSqlQuery so that it prints the error msg if a query fails
 
+#include <QCache>
+#include <QMutex>
+#include <QSharedPointer>
 #include <QSqlDriver>
 #include <QSqlQuery>
 
@@ -28,28 +31,70 @@
 
 #include "DllMacro.h"
 
+/**
+ * LRU of the prepared statements of one database connection, keyed by their SQL.
+ *
+ * A statement is taken out of the cache while a TomahawkSqlQuery uses it and
+ * only goes back in once that query is done with it, so two queries never share
+ * a statement. SQL with values inlined into its text will hardly ever be reused,
+ * bind them instead.
+ */
+class DLLEXPORT TomahawkSqlStatementCache
+{
+public:
+    explicit TomahawkSqlStatementCache( int capacity );
+
+    bool take( const QString& sql, QSqlQuery& statement );
+    void give( const QString& sql, QSqlQuery statement );
+    void clear();
+
+    void setCapacity( int capacity );
+    int capacity() const;
+
+    /// Statements compiled by sqlite and statements we could reuse, for benchmarking
+    void countPrepared();
+    quint64 prepared() const;
+    quint64 reused() const;
+
+private:
+    mutable QMutex m_mutex;
+    QCache< QString, QSqlQuery > m_statements;
+    quint64 m_prepared;
+    quint64 m_reused;
+};
+
+
 class DLLEXPORT TomahawkSqlQuery : public QSqlQuery
 {
 
 public:
     TomahawkSqlQuery();
-    TomahawkSqlQuery( const QSqlDatabase& db );
+    TomahawkSqlQuery( const QSqlDatabase& db, TomahawkSqlStatementCache* cache = 0 );
 
     static QString escape( QString identifier );
 
     bool prepare( const QString& query );
+    /// Runs query right away, without taking a statement from the cache or adding one to it
     bool exec( const QString& query );
     bool exec();
 
     bool commitTransaction();
 
 private:
+    struct CachedStatement;
+
+    bool prepareUncached( const QString& query );
+
     bool isBusyError( const QSqlError& error ) const;
 
     void showError();
 
     QSqlDatabase m_db;
     QString m_query;
+
+    TomahawkSqlStatementCache* m_cache;
+    // shared between copies of this query, hands the statement back to the cache once all of them are done with it
+    QSharedPointer< CachedStatement > m_statement;
 };
 
 #endif // TOMAHAWKSQLQUERY_H
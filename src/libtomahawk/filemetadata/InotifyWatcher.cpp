@@ -0,0 +1,391 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "InotifyWatcher.h"
+
+#include "utils/Logger.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <QTimer>
+
+#include <sys/inotify.h>
+#include <errno.h>
+#include <unistd.h>
+
+// a directory needs to be quiet this long before we report its changes
+#define INOTIFY_DEBOUNCE 2000
+// but we don't hold back changes of a busy directory forever
+#define INOTIFY_MAX_DELAY 30000
+// directories we add watches for per event loop iteration
+#define INOTIFY_WALK_CHUNK 50
+
+static const uint32_t s_watchMask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                    IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW;
+
+
+InotifyWatcher::InotifyWatcher( QObject* parent )
+    : QObject( parent )
+    , m_fd( -1 )
+    , m_notifier( 0 )
+    , m_debounce( INOTIFY_DEBOUNCE )
+{
+    m_flushTimer = new QTimer( this );
+    m_flushTimer->setInterval( 500 );
+    connect( m_flushTimer, SIGNAL( timeout() ), SLOT( flushDirectories() ) );
+
+    m_walkTimer = new QTimer( this );
+    m_walkTimer->setInterval( 0 );
+    connect( m_walkTimer, SIGNAL( timeout() ), SLOT( walkDirectories() ) );
+}
+
+
+InotifyWatcher::~InotifyWatcher()
+{
+    stop();
+}
+
+
+bool
+InotifyWatcher::watch( const QStringList& paths )
+{
+    stop();
+
+    m_fd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if ( m_fd < 0 )
+    {
+        tLog() << Q_FUNC_INFO << "Could not initialize inotify:" << strerror( errno );
+        return false;
+    }
+
+    m_notifier = new QSocketNotifier( m_fd, QSocketNotifier::Read, this );
+    connect( m_notifier, SIGNAL( activated( int ) ), SLOT( readEvents() ) );
+    m_flushTimer->start();
+
+    foreach ( const QString& path, paths )
+        addWatches( QDir( path ).canonicalPath(), false );
+
+    return true;
+}
+
+
+void
+InotifyWatcher::stop()
+{
+    m_flushTimer->stop();
+    m_walkTimer->stop();
+    m_pendingDirs.clear();
+
+    // we may be called from within readEvents(), while the notifier is still busy delivering
+    if ( m_notifier )
+    {
+        m_notifier->setEnabled( false );
+        m_notifier->deleteLater();
+        m_notifier = 0;
+    }
+
+    if ( m_fd >= 0 )
+    {
+        // closing the descriptor removes all of its watches
+        ::close( m_fd );
+        m_fd = -1;
+    }
+
+    m_watches.clear();
+    m_watchedDirs.clear();
+    m_pendingMoves.clear();
+    m_changes.clear();
+}
+
+
+void
+InotifyWatcher::giveUp()
+{
+    stop();
+    emit watchLimitReached();
+}
+
+
+void
+InotifyWatcher::addWatches( const QString& path, bool reportFiles, const QString& batch )
+{
+    if ( path.isEmpty() )
+        return;
+
+    PendingDirectory pending;
+    pending.path = path;
+    pending.reportFiles = reportFiles;
+    pending.batch = batch;
+    m_pendingDirs << pending;
+
+    if ( !m_walkTimer->isActive() )
+        m_walkTimer->start();
+}
+
+
+void
+InotifyWatcher::walkDirectories()
+{
+    for ( int i = 0; i < INOTIFY_WALK_CHUNK && !m_pendingDirs.isEmpty(); i++ )
+    {
+        const PendingDirectory pending = m_pendingDirs.takeLast();
+        if ( m_watchedDirs.contains( pending.path ) )
+            continue;
+
+        const int wd = inotify_add_watch( m_fd, QFile::encodeName( pending.path ).constData(), s_watchMask );
+        if ( wd < 0 )
+        {
+            if ( errno == ENOSPC )
+            {
+                tLog() << Q_FUNC_INFO << "Reached the inotify watch limit at" << m_watches.count() << "directories, falling back to periodic scans";
+                giveUp();
+                return;
+            }
+
+            // vanished or unreadable directories are no reason to give up on the rest
+            tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Could not watch" << pending.path << strerror( errno );
+            continue;
+        }
+
+        m_watches.insert( wd, pending.path );
+        m_watchedDirs.insert( pending.path, wd );
+
+        QDir dir( pending.path );
+        if ( pending.reportFiles )
+        {
+            // a directory that just appeared may already contain files we never got events for
+            dir.setFilter( QDir::Files | QDir::Readable | QDir::NoDotAndDotDot );
+            foreach ( const QFileInfo& fi, dir.entryInfoList() )
+                markChanged( pending.batch.isEmpty() ? pending.path : pending.batch, fi.canonicalFilePath() );
+        }
+
+        dir.setFilter( QDir::Dirs | QDir::Readable | QDir::NoDotAndDotDot );
+        foreach ( const QFileInfo& fi, dir.entryInfoList() )
+        {
+            if ( fi.isSymLink() )
+                continue;
+
+            PendingDirectory child = pending;
+            child.path = fi.canonicalFilePath();
+            m_pendingDirs << child;
+        }
+    }
+
+    if ( m_pendingDirs.isEmpty() )
+    {
+        m_walkTimer->stop();
+        tDebug() << Q_FUNC_INFO << "Watching" << m_watches.count() << "directories for changes";
+    }
+}
+
+
+void
+InotifyWatcher::removeWatches( const QString& path )
+{
+    const QString prefix = path + '/';
+    foreach ( const QString& dir, m_watchedDirs.keys() )
+    {
+        if ( dir != path && !dir.startsWith( prefix ) )
+            continue;
+
+        const int wd = m_watchedDirs.take( dir );
+        m_watches.remove( wd );
+        inotify_rm_watch( m_fd, wd );
+    }
+
+    // directories below it we did not get to yet are gone as well
+    for ( int i = m_pendingDirs.count() - 1; i >= 0; i-- )
+    {
+        const QString& pending = m_pendingDirs.at( i ).path;
+        if ( pending == path || pending.startsWith( prefix ) )
+            m_pendingDirs.removeAt( i );
+    }
+}
+
+
+void
+InotifyWatcher::markChanged( const QString& dir, const QString& path )
+{
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+
+    DirectoryChanges& changes = m_changes[ dir ];
+    if ( changes.paths.isEmpty() )
+        changes.firstChange = now;
+    changes.lastChange = now;
+    changes.paths.insert( path );
+}
+
+
+void
+InotifyWatcher::unmarkChanged( const QString& dir, const QString& path )
+{
+    QHash< QString, DirectoryChanges >::iterator it = m_changes.find( dir );
+    if ( it == m_changes.end() )
+        return;
+
+    it->paths.remove( path );
+    if ( it->paths.isEmpty() )
+        m_changes.erase( it );
+}
+
+
+void
+InotifyWatcher::readEvents()
+{
+    char buffer[ 64 * 1024 ] __attribute__ ( ( aligned( __alignof__( struct inotify_event ) ) ) );
+
+    forever
+    {
+        const ssize_t len = ::read( m_fd, buffer, sizeof( buffer ) );
+        if ( len <= 0 )
+            break;
+
+        for ( char* ptr = buffer; ptr < buffer + len; )
+        {
+            const struct inotify_event* event = reinterpret_cast< const struct inotify_event* >( ptr );
+            ptr += sizeof( struct inotify_event ) + event->len;
+
+            if ( event->mask & IN_Q_OVERFLOW )
+            {
+                tLog() << Q_FUNC_INFO << "inotify queue overflowed, changes were lost";
+                m_changes.clear();
+                m_pendingMoves.clear();
+                emit eventsLost();
+                continue;
+            }
+
+            if ( !m_watches.contains( event->wd ) )
+                continue;
+
+            const QString dir = m_watches.value( event->wd );
+            if ( event->mask & ( IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED ) )
+            {
+                // the parent directory's event tells us what happened to the contents
+                if ( event->mask & IN_IGNORED )
+                {
+                    m_watches.remove( event->wd );
+                    m_watchedDirs.remove( dir );
+                }
+                continue;
+            }
+
+            if ( !event->len )
+                continue;
+
+            const QString path = dir + '/' + QFile::decodeName( event->name );
+            const bool isDir = event->mask & IN_ISDIR;
+
+            if ( event->mask & IN_MOVED_FROM )
+            {
+                // wait for the matching IN_MOVED_TO, if it never comes the path left our tree
+                PendingMove move;
+                move.dir = dir;
+                move.path = path;
+                move.time = QDateTime::currentDateTimeUtc();
+                m_pendingMoves.insert( event->cookie, move );
+
+                markChanged( dir, path );
+                if ( isDir )
+                    removeWatches( path );
+                continue;
+            }
+
+            if ( event->mask & IN_MOVED_TO )
+            {
+                if ( m_pendingMoves.contains( event->cookie ) )
+                {
+                    // report the old path together with the new one, so the scanner pairs them up
+                    const PendingMove from = m_pendingMoves.take( event->cookie );
+                    unmarkChanged( from.dir, from.path );
+                    markChanged( dir, from.path );
+                }
+
+                if ( isDir )
+                    addWatches( path, true, dir );
+                else
+                    markChanged( dir, path );
+
+                continue;
+            }
+
+            if ( event->mask & IN_CREATE )
+            {
+                // files get reported once they are closed after writing
+                if ( isDir )
+                    addWatches( path, true );
+                continue;
+            }
+
+            if ( event->mask & IN_DELETE )
+            {
+                if ( isDir )
+                    removeWatches( path );
+                markChanged( dir, path );
+                continue;
+            }
+
+            if ( event->mask & IN_CLOSE_WRITE )
+                markChanged( dir, path );
+        }
+    }
+
+    if ( m_fd >= 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+        tLog() << Q_FUNC_INFO << "Error reading inotify events:" << strerror( errno );
+}
+
+
+void
+InotifyWatcher::flushDirectories()
+{
+    if ( m_changes.isEmpty() )
+        return;
+
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+
+    QStringList paths;
+    QHash< QString, DirectoryChanges >::iterator it = m_changes.begin();
+    while ( it != m_changes.end() )
+    {
+        if ( it->lastChange.msecsTo( now ) < m_debounce && it->firstChange.msecsTo( now ) < INOTIFY_MAX_DELAY )
+        {
+            ++it;
+            continue;
+        }
+
+        paths << it->paths.toList();
+        it = m_changes.erase( it );
+    }
+
+    // renames whose destination we never saw are left as removals
+    QHash< quint32, PendingMove >::iterator move = m_pendingMoves.begin();
+    while ( move != m_pendingMoves.end() )
+    {
+        if ( move->time.msecsTo( now ) >= m_debounce )
+            move = m_pendingMoves.erase( move );
+        else
+            ++move;
+    }
+
+    if ( paths.isEmpty() )
+        return;
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Reporting" << paths.count() << "changed paths";
+    emit filesChanged( paths );
+}
@@ -0,0 +1,128 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INOTIFYWATCHER_H
+#define INOTIFYWATCHER_H
+
+#include "DllMacro.h"
+
+#include <QDateTime>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+class QSocketNotifier;
+class QTimer;
+
+/**
+ * Watches the collection directories through Linux' inotify and reports the
+ * files that changed, so the ScanManager only has to look at those instead of
+ * walking the whole tree.
+ *
+ * Changes are collected per directory and reported once the directory has been
+ * quiet for a while, so a file being copied or an album being tagged results in
+ * a single report. Removed paths are reported as well, the scanner drops them
+ * from the database once it finds they no longer exist.
+ *
+ * Renames within the watched tree are paired up by their cookie, and both their
+ * old and new paths go out in the same report. That way the scanner sees the
+ * file vanish and reappear in one batch and moves it instead of deleting and
+ * re-adding it.
+ *
+ * The directory trees are walked in small chunks from the event loop, so
+ * setting up the watches for a large collection doesn't block the GUI.
+ */
+class DLLEXPORT InotifyWatcher : public QObject
+{
+Q_OBJECT
+
+public:
+    explicit InotifyWatcher( QObject* parent = 0 );
+    virtual ~InotifyWatcher();
+
+    /// Replaces all watches with recursive watches on the given directories. Returns false if inotify is not available.
+    /// The watches are added in the background, watchLimitReached() is emitted if we have to give up on the way.
+    bool watch( const QStringList& paths );
+    void stop();
+
+    /// True while all directories are watched and no events were lost
+    bool isActive() const { return m_fd >= 0; }
+
+    void setDebounceInterval( int msecs ) { m_debounce = msecs; }
+
+signals:
+    /// Files (or vanished directories) that were created, modified, moved or deleted
+    void filesChanged( const QStringList& paths );
+
+    /// We could not watch everything, e.g. because fs.inotify.max_user_watches was hit
+    void watchLimitReached();
+
+    /// The kernel queue overflowed and events were lost, a full rescan is needed
+    void eventsLost();
+
+private slots:
+    void readEvents();
+    void flushDirectories();
+    void walkDirectories();
+
+private:
+    /// Files found in new directories are reported with the changes of batch, or their own directory if it's empty
+    void addWatches( const QString& path, bool reportFiles, const QString& batch = QString() );
+    void removeWatches( const QString& path );
+    void markChanged( const QString& dir, const QString& path );
+    void unmarkChanged( const QString& dir, const QString& path );
+    void giveUp();
+
+    int m_fd;
+    QSocketNotifier* m_notifier;
+    QTimer* m_flushTimer;
+    QTimer* m_walkTimer;
+    int m_debounce;
+
+    // directories we still have to watch and look into
+    struct PendingDirectory
+    {
+        QString path;
+        bool reportFiles;
+        QString batch;
+    };
+    QList< PendingDirectory > m_pendingDirs;
+
+    QHash< int, QString > m_watches;
+    QHash< QString, int > m_watchedDirs;
+
+    // a rename we have not seen the other half of yet, by cookie
+    struct PendingMove
+    {
+        QString dir;
+        QString path;
+        QDateTime time;
+    };
+    QHash< quint32, PendingMove > m_pendingMoves;
+
+    struct DirectoryChanges
+    {
+        QSet< QString > paths;
+        QDateTime firstChange;
+        QDateTime lastChange;
+    };
+    QHash< QString, DirectoryChanges > m_changes;
+};
+
+#endif // INOTIFYWATCHER_H
@@ -0,0 +1,450 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "LoudnessAnalyzer.h"
+
+#include "audio/AudioOutput.h"
+#include "database/Database.h"
+#include "database/DatabaseCommand_SetTrackLoudness.h"
+#include "utils/Logger.h"
+
+#include <QFile>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <vlc/libvlc.h>
+#include <vlc/libvlc_media.h>
+#include <vlc/libvlc_events.h>
+#include <vlc/libvlc_media_player.h>
+
+#include <cmath>
+
+using namespace Tomahawk;
+
+#define LOUDNESS_ANALYSIS_RATE 48000
+#define LOUDNESS_ABSOLUTE_GATE -70.0
+#define LOUDNESS_RELATIVE_GATE -10.0
+// results are written to the database in batches of this many tracks
+#define LOUDNESS_COMMIT_BATCH 50
+
+
+EbuR128Meter::EbuR128Meter()
+{
+    reset( LOUDNESS_ANALYSIS_RATE, 2 );
+}
+
+
+void
+EbuR128Meter::reset( unsigned int rate, unsigned int channels )
+{
+    m_rate = rate;
+    m_channels = qMax( 1u, channels );
+
+    // K-weighting pre-filter (high shelf) and RLB weighting (high pass),
+    // coefficients as specified by BS.1770 re-derived for the given rate.
+    double f0 = 1681.974450955533;
+    double G = 3.999843853973347;
+    double Q = 0.7071752369554196;
+    double K = std::tan( M_PI * f0 / (double)m_rate );
+    const double Vh = std::pow( 10.0, G / 20.0 );
+    const double Vb = std::pow( Vh, 0.4996667741545416 );
+    double a0 = 1.0 + K / Q + K * K;
+
+    m_shelf.b0 = ( Vh + Vb * K / Q + K * K ) / a0;
+    m_shelf.b1 = 2.0 * ( K * K - Vh ) / a0;
+    m_shelf.b2 = ( Vh - Vb * K / Q + K * K ) / a0;
+    m_shelf.a1 = 2.0 * ( K * K - 1.0 ) / a0;
+    m_shelf.a2 = ( 1.0 - K / Q + K * K ) / a0;
+
+    f0 = 38.13547087602444;
+    Q = 0.5003270373238773;
+    K = std::tan( M_PI * f0 / (double)m_rate );
+    a0 = 1.0 + K / Q + K * K;
+
+    m_highpass.b0 = 1.0;
+    m_highpass.b1 = -2.0;
+    m_highpass.b2 = 1.0;
+    m_highpass.a1 = 2.0 * ( K * K - 1.0 ) / a0;
+    m_highpass.a2 = ( 1.0 - K / Q + K * K ) / a0;
+
+    m_state.assign( m_channels * 4, 0.0 );
+
+    m_subBlockFrames = m_rate / 10;
+    m_subBlockPos = 0;
+    m_subBlockEnergy = 0.0;
+    m_subBlockCount = 0;
+    for ( int i = 0; i < 4; i++ )
+        m_lastSubBlocks[ i ] = 0.0;
+
+    m_blocks.clear();
+    m_peak = 0.0;
+}
+
+
+void
+EbuR128Meter::addFrames( const float* samples, unsigned int frames )
+{
+    for ( unsigned int f = 0; f < frames; f++ )
+    {
+        for ( unsigned int c = 0; c < m_channels; c++ )
+        {
+            const double x = samples[ f * m_channels + c ];
+            m_peak = qMax( m_peak, std::fabs( x ) );
+
+            // transposed direct form II, one state pair per stage
+            double* s = &m_state[ c * 4 ];
+            const double y1 = m_shelf.b0 * x + s[0];
+            s[0] = m_shelf.b1 * x - m_shelf.a1 * y1 + s[1];
+            s[1] = m_shelf.b2 * x - m_shelf.a2 * y1;
+
+            const double y2 = m_highpass.b0 * y1 + s[2];
+            s[2] = m_highpass.b1 * y1 - m_highpass.a1 * y2 + s[3];
+            s[3] = m_highpass.b2 * y1 - m_highpass.a2 * y2;
+
+            // channel weights are 1.0 for front channels, 1.41 for surrounds (5.1 layout)
+            const double weight = ( m_channels > 4 && ( c == 4 || c == 5 ) ) ? 1.41 : 1.0;
+            if ( m_channels > 4 && c == 3 )
+                continue; // LFE is not taken into account
+
+            m_subBlockEnergy += weight * y2 * y2;
+        }
+
+        if ( ++m_subBlockPos < m_subBlockFrames )
+            continue;
+
+        // a 100ms step is complete, each gating block spans the last four steps
+        m_lastSubBlocks[ m_subBlockCount % 4 ] = m_subBlockEnergy / (double)m_subBlockFrames;
+        m_subBlockCount++;
+        m_subBlockPos = 0;
+        m_subBlockEnergy = 0.0;
+
+        if ( m_subBlockCount >= 4 )
+        {
+            m_blocks.push_back( ( m_lastSubBlocks[0] + m_lastSubBlocks[1] +
+                                  m_lastSubBlocks[2] + m_lastSubBlocks[3] ) / 4.0 );
+        }
+    }
+}
+
+
+double
+EbuR128Meter::gatedLoudness( const std::vector< double >& blocks )
+{
+    const double absoluteThreshold = std::pow( 10.0, ( LOUDNESS_ABSOLUTE_GATE + 0.691 ) / 10.0 );
+
+    double sum = 0.0;
+    unsigned int count = 0;
+    for ( std::vector< double >::const_iterator it = blocks.begin(); it != blocks.end(); ++it )
+    {
+        if ( *it > absoluteThreshold )
+        {
+            sum += *it;
+            count++;
+        }
+    }
+    if ( !count )
+        return -HUGE_VAL;
+
+    const double relativeThreshold = ( sum / count ) * std::pow( 10.0, LOUDNESS_RELATIVE_GATE / 10.0 );
+
+    sum = 0.0;
+    count = 0;
+    for ( std::vector< double >::const_iterator it = blocks.begin(); it != blocks.end(); ++it )
+    {
+        if ( *it > absoluteThreshold && *it > relativeThreshold )
+        {
+            sum += *it;
+            count++;
+        }
+    }
+    if ( !count )
+        return -HUGE_VAL;
+
+    return -0.691 + 10.0 * std::log10( sum / count );
+}
+
+
+double
+EbuR128Meter::integratedLoudness() const
+{
+    return gatedLoudness( m_blocks );
+}
+
+
+namespace
+{
+
+/**
+ * Decodes a single file through libVLC's stream output and feeds the PCM into
+ * a meter. The smem module hands us the decoded audio as fast as the decoder
+ * produces it instead of syncing it to the playback clock.
+ */
+class LoudnessJob : public QRunnable
+{
+public:
+    LoudnessJob( LoudnessAnalyzer* analyzer, const QSharedPointer< QAtomicInt >& cancelled, const QVariantMap& track )
+        : m_analyzer( analyzer )
+        , m_cancelled( cancelled )
+        , m_track( track )
+        , m_meter( new EbuR128Meter )
+        , m_decoderThread( 0 )
+        , m_initialized( false )
+        , m_done( false )
+    {
+    }
+
+    void run()
+    {
+        if ( !m_cancelled->load() )
+            decode();
+
+        if ( m_cancelled->load() )
+            return;
+
+        QMetaObject::invokeMethod( m_analyzer, "onTrackAnalyzed", Qt::QueuedConnection,
+                                   Q_ARG( QSharedPointer< QAtomicInt >, m_cancelled ),
+                                   Q_ARG( QVariantMap, m_track ),
+                                   Q_ARG( QSharedPointer< EbuR128Meter >, m_meter ) );
+    }
+
+private:
+    void decode()
+    {
+        if ( !AudioOutput::instance() || !AudioOutput::instance()->vlcInstance() )
+        {
+            tLog() << Q_FUNC_INFO << "No libVLC instance available, can't analyse loudness";
+            return;
+        }
+
+        QString path = m_track.value( "url" ).toString();
+        if ( path.startsWith( "file://" ) )
+            path = path.mid( 7 );
+
+        libvlc_media_t* media = libvlc_media_new_path( AudioOutput::instance()->vlcInstance(), QFile::encodeName( path ).constData() );
+        if ( !media )
+            return;
+
+        const QString sout = QString( ":sout=#transcode{acodec=fl32,samplerate=%1}:smem{"
+                                      "audio-prerender-callback=%2,audio-postrender-callback=%3,audio-data=%4,time-sync=false}" )
+                                .arg( LOUDNESS_ANALYSIS_RATE )
+                                .arg( (uintptr_t)&LoudnessJob::prerenderCallback )
+                                .arg( (uintptr_t)&LoudnessJob::postrenderCallback )
+                                .arg( (uintptr_t)this );
+        libvlc_media_add_option_flag( media, sout.toLatin1().constData(), libvlc_media_option_trusted );
+        libvlc_media_add_option( media, ":no-sout-video" );
+        libvlc_media_add_option( media, ":sout-keep" );
+
+        libvlc_media_player_t* player = libvlc_media_player_new_from_media( media );
+        libvlc_media_release( media );
+
+        libvlc_event_manager_t* manager = libvlc_media_player_event_manager( player );
+        libvlc_event_attach( manager, libvlc_MediaPlayerEndReached, &LoudnessJob::eventCallback, this );
+        libvlc_event_attach( manager, libvlc_MediaPlayerEncounteredError, &LoudnessJob::eventCallback, this );
+
+        libvlc_media_player_play( player );
+        {
+            QMutexLocker locker( &m_mutex );
+            while ( !m_done && !m_cancelled->load() )
+                m_waitCondition.wait( &m_mutex, 250 );
+        }
+
+        libvlc_event_detach( manager, libvlc_MediaPlayerEndReached, &LoudnessJob::eventCallback, this );
+        libvlc_event_detach( manager, libvlc_MediaPlayerEncounteredError, &LoudnessJob::eventCallback, this );
+        libvlc_media_player_stop( player );
+        libvlc_media_player_release( player );
+    }
+
+    static void prerenderCallback( void* data, uint8_t** buffer, size_t size )
+    {
+        LoudnessJob* job = static_cast< LoudnessJob* >( data );
+
+        // the pool thread only waits, the decoding happens on libVLC's threads
+        if ( job->m_decoderThread != QThread::currentThreadId() )
+        {
+            job->m_decoderThread = QThread::currentThreadId();
+            QThread::currentThread()->setPriority( QThread::IdlePriority );
+        }
+
+        if ( job->m_buffer.size() < size )
+            job->m_buffer.resize( size );
+
+        *buffer = job->m_buffer.data();
+    }
+
+    static void postrenderCallback( void* data, uint8_t* buffer, unsigned int channels, unsigned int rate,
+                                    unsigned int samples, unsigned int bitsPerSample, size_t size, int64_t pts )
+    {
+        Q_UNUSED( size );
+        Q_UNUSED( pts );
+
+        LoudnessJob* job = static_cast< LoudnessJob* >( data );
+        if ( job->m_cancelled->load() || bitsPerSample != 32 )
+            return;
+
+        if ( !job->m_initialized )
+        {
+            job->m_meter->reset( rate, channels );
+            job->m_initialized = true;
+        }
+
+        job->m_meter->addFrames( reinterpret_cast< const float* >( buffer ), samples );
+    }
+
+    static void eventCallback( const libvlc_event_t* event, void* data )
+    {
+        Q_UNUSED( event );
+
+        LoudnessJob* job = static_cast< LoudnessJob* >( data );
+        QMutexLocker locker( &job->m_mutex );
+        job->m_done = true;
+        job->m_waitCondition.wakeAll();
+    }
+
+    LoudnessAnalyzer* m_analyzer;
+    QSharedPointer< QAtomicInt > m_cancelled;
+    QVariantMap m_track;
+    QSharedPointer< EbuR128Meter > m_meter;
+    std::vector< uint8_t > m_buffer;
+    Qt::HANDLE m_decoderThread;
+    bool m_initialized;
+
+    QMutex m_mutex;
+    QWaitCondition m_waitCondition;
+    bool m_done;
+};
+
+}
+
+
+LoudnessAnalyzer::LoudnessAnalyzer( QObject* parent )
+    : QObject( parent )
+    , m_cancelled( new QAtomicInt( 0 ) )
+    , m_pending( 0 )
+{
+    qRegisterMetaType< QSharedPointer< EbuR128Meter > >( "QSharedPointer< EbuR128Meter >" );
+    qRegisterMetaType< QSharedPointer< QAtomicInt > >( "QSharedPointer< QAtomicInt >" );
+
+    // decoding is CPU bound, but we don't want to steal all of it from playback and the UI
+    m_pool.setMaxThreadCount( qMax( 1, QThread::idealThreadCount() / 2 ) );
+}
+
+
+LoudnessAnalyzer::~LoudnessAnalyzer()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+
+bool
+LoudnessAnalyzer::isRunning() const
+{
+    return m_pending > 0;
+}
+
+
+void
+LoudnessAnalyzer::analyze( const QVariantList& files )
+{
+    if ( QThread::currentThread() != thread() )
+    {
+        QMetaObject::invokeMethod( this, "analyze", Qt::QueuedConnection, Q_ARG( QVariantList, files ) );
+        return;
+    }
+
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Queueing" << files.count() << "files for loudness analysis";
+
+    foreach ( const QVariant& v, files )
+    {
+        const QVariantMap m = v.toMap();
+        const QString url = m.value( "url" ).toString();
+        // the library catch-up and the scanner may hand us the same file
+        if ( !url.startsWith( "file://" ) || m_queued.contains( url ) )
+            continue;
+
+        m_queued.insert( url );
+        m_pending++;
+
+        LoudnessJob* job = new LoudnessJob( this, m_cancelled, m );
+        job->setAutoDelete( true );
+        m_pool.start( job );
+    }
+
+    emit progress( m_pending );
+}
+
+
+void
+LoudnessAnalyzer::cancel()
+{
+    if ( !m_pending )
+        return;
+
+    tDebug() << Q_FUNC_INFO << "Cancelling loudness analysis of" << m_pending << "files";
+
+    // jobs that are already running check this flag, queued ones never start decoding
+    m_cancelled->store( 1 );
+    m_cancelled = QSharedPointer< QAtomicInt >( new QAtomicInt( 0 ) );
+    m_results.clear();
+    m_queued.clear();
+    m_pending = 0;
+
+    emit finished();
+}
+
+
+void
+LoudnessAnalyzer::onTrackAnalyzed( const QSharedPointer< QAtomicInt >& cancelled, const QVariantMap& track, const QSharedPointer< EbuR128Meter >& meter )
+{
+    if ( cancelled != m_cancelled )
+        return; // cancelled in the meantime
+
+    m_pending--;
+    m_queued.remove( track.value( "url" ).toString() );
+
+    QVariantMap m;
+    m[ "url" ] = track.value( "url" );
+    m[ "peak" ] = meter->samplePeak();
+
+    const double loudness = meter->integratedLoudness();
+    if ( meter->isValid() && !std::isinf( loudness ) )
+        m[ "loudness" ] = loudness;
+    else
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Could not decode any audio from:" << track.value( "url" ).toString();
+
+    // undecodable files are stored without a loudness, so they don't get queued over and over
+    m_results << m;
+    if ( m_results.count() >= LOUDNESS_COMMIT_BATCH || !m_pending )
+        commit();
+
+    emit progress( m_pending );
+    if ( !m_pending )
+        emit finished();
+}
+
+
+void
+LoudnessAnalyzer::commit()
+{
+    if ( !m_results.isEmpty() && Database::instance() )
+        Database::instance()->enqueue( dbcmd_ptr( new DatabaseCommand_SetTrackLoudness( m_results ) ) );
+
+    m_results.clear();
+}
@@ -0,0 +1,122 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOUDNESSANALYZER_H
+#define LOUDNESSANALYZER_H
+
+#include "DllMacro.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QVariantMap>
+
+#include <vector>
+
+/**
+ * Measures integrated loudness and sample peak of interleaved float PCM
+ * as described by ITU-R BS.1770 / EBU R128: K-weighting, 400ms blocks with
+ * 75% overlap, an absolute gate at -70 LUFS and a relative gate at -10 LU.
+ */
+class DLLEXPORT EbuR128Meter
+{
+public:
+    EbuR128Meter();
+
+    void reset( unsigned int rate, unsigned int channels );
+    void addFrames( const float* samples, unsigned int frames );
+
+    /// Integrated loudness in LUFS, or -HUGE_VAL if nothing but silence was measured
+    double integratedLoudness() const;
+    /// Linear sample peak
+    double samplePeak() const { return m_peak; }
+    bool isValid() const { return !m_blocks.empty(); }
+
+private:
+    struct Biquad
+    {
+        double b0, b1, b2, a1, a2;
+    };
+
+    static double gatedLoudness( const std::vector< double >& blocks );
+
+    unsigned int m_rate;
+    unsigned int m_channels;
+    Biquad m_shelf;
+    Biquad m_highpass;
+    // two filter stages with two state values each, per channel
+    std::vector< double > m_state;
+
+    unsigned int m_subBlockFrames;
+    unsigned int m_subBlockPos;
+    double m_subBlockEnergy;
+    double m_lastSubBlocks[ 4 ];
+    unsigned int m_subBlockCount;
+
+    std::vector< double > m_blocks;
+    double m_peak;
+};
+
+
+/**
+ * Decodes local audio files through libVLC at idle priority, a few at a time,
+ * and computes their loudness.
+ *
+ * Results are stored per file, where DatabaseCommand_SetTrackLoudness derives
+ * the album values from every analysed file of the album, and picked up by the
+ * AudioEngine for volume normalization.
+ */
+class DLLEXPORT LoudnessAnalyzer : public QObject
+{
+Q_OBJECT
+
+public:
+    explicit LoudnessAnalyzer( QObject* parent = 0 );
+    virtual ~LoudnessAnalyzer();
+
+    bool isRunning() const;
+
+public slots:
+    /// Takes the tag maps the MusicScanner produced for new or modified files
+    void analyze( const QVariantList& files );
+    void cancel();
+
+signals:
+    void progress( unsigned int remaining );
+    void finished();
+
+private slots:
+    void onTrackAnalyzed( const QSharedPointer< QAtomicInt >& cancelled, const QVariantMap& track, const QSharedPointer< EbuR128Meter >& meter );
+
+private:
+    void commit();
+
+    QThreadPool m_pool;
+    QSharedPointer< QAtomicInt > m_cancelled;
+    QVariantList m_results;
+    QSet< QString > m_queued;
+    unsigned int m_pending;
+};
+
+Q_DECLARE_METATYPE( QSharedPointer< EbuR128Meter > )
+Q_DECLARE_METATYPE( QSharedPointer< QAtomicInt > )
+
+#endif // LOUDNESSANALYZER_H
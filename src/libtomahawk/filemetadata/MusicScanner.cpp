@@ -25,6 +25,7 @@
 #include "database/DatabaseCommand_CollectionStats.h"
 #include "database/DatabaseCommand_AddFiles.h"
 #include "database/DatabaseCommand_DeleteFiles.h"
+#include "database/DatabaseCommand_MoveFiles.h"
 #include "taghandlers/tag.h"
 #include "utils/Logger.h"
 #include "utils/TomahawkUtils.h"
@@ -35,8 +36,45 @@
 
 #include "config.h"
 
+#include <QCryptographicHash>
+#include <QFile>
+#include <QRunnable>
+
+// files listed by the DirLister that may wait for a tag reader at once
+#define MUSICSCANNER_MAX_QUEUED_FILES 512
+
 using namespace Tomahawk;
 
+namespace
+{
+
+class TagReaderJob : public QRunnable
+{
+public:
+    TagReaderJob( MusicScanner* scanner, quint64 sequence, const QFileInfo& fi )
+        : m_scanner( scanner )
+        , m_sequence( sequence )
+        , m_fileInfo( fi )
+    {
+    }
+
+    void run()
+    {
+        const ScannedFile file = MusicScanner::readScannedFile( m_fileInfo );
+        QMetaObject::invokeMethod( m_scanner, "onFileRead", Qt::QueuedConnection,
+                                   Q_ARG( quint64, m_sequence ),
+                                   Q_ARG( Tomahawk::ScannedFile, file ),
+                                   Q_ARG( QString, m_fileInfo.canonicalFilePath() ) );
+    }
+
+private:
+    MusicScanner* m_scanner;
+    quint64 m_sequence;
+    QFileInfo m_fileInfo;
+};
+
+}
+
 void
 DirLister::go()
 {
@@ -84,7 +122,25 @@ DirLister::scanDir( QDir dir, int depth )
     dir.setSorting( QDir::Name );
     filteredEntries = dir.entryInfoList();
     foreach ( const QFileInfo& di, filteredEntries )
+    {
+        // wait until the scanner caught up, but don't get stuck when we're asked to stop
+        while ( !m_queueSpace->tryAcquire( 1, 100 ) )
+        {
+            if ( isDeleting() )
+                break;
+        }
+
+        if ( isDeleting() )
+        {
+            m_opcount--;
+            if ( m_opcount == 0 )
+                emit finished();
+
+            return;
+        }
+
         emit fileToScan( di );
+    }
 
     dir.setFilter( QDir::Dirs | QDir::Readable | QDir::NoDotAndDotDot );
     filteredEntries = dir.entryInfoList();
@@ -106,6 +162,8 @@ DirLister::scanDir( QDir dir, int depth )
 
 DirListerThreadController::DirListerThreadController( QObject *parent )
     : QThread( parent )
+    , m_queueSpace( 0 )
+    , m_aborted( false )
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO;
 }
@@ -117,10 +175,26 @@ DirListerThreadController::~DirListerThreadController()
 }
 
 
+void
+DirListerThreadController::abort()
+{
+    QMutexLocker locker( &m_mutex );
+    m_aborted = true;
+
+    if ( !m_dirLister.isNull() )
+        m_dirLister.data()->setIsDeleting();
+}
+
+
 void
 DirListerThreadController::run()
 {
-    m_dirLister = QPointer< DirLister >( new DirLister( m_paths ) );
+    {
+        QMutexLocker locker( &m_mutex );
+        m_dirLister = QPointer< DirLister >( new DirLister( m_paths, m_queueSpace ) );
+        if ( m_aborted )
+            m_dirLister.data()->setIsDeleting();
+    }
     connect( m_dirLister.data(), SIGNAL( fileToScan( QFileInfo ) ),
              parent(), SLOT( scanFile( QFileInfo ) ), Qt::QueuedConnection );
 
@@ -131,6 +205,8 @@ DirListerThreadController::run()
     QMetaObject::invokeMethod( m_dirLister.data(), "go", Qt::QueuedConnection );
 
     exec();
+
+    QMutexLocker locker( &m_mutex );
     if ( !m_dirLister.isNull() )
         delete m_dirLister.data();
 }
@@ -141,12 +217,22 @@ MusicScanner::MusicScanner( MusicScanner::ScanMode scanMode, const QStringList&
     , m_scanMode( scanMode )
     , m_paths( paths )
     , m_scanned( 0 )
+    , m_skipped( 0 )
     , m_dryRun( false )
     , m_verbose( false )
     , m_cmdQueue( 0 )
     , m_batchsize( bs )
+    , m_readsInFlight( 0 )
+    , m_nextSequence( 0 )
+    , m_nextToCommit( 0 )
+    , m_listingFinished( false )
+    , m_queueSpace( MUSICSCANNER_MAX_QUEUED_FILES )
     , m_dirListerThreadController( 0 )
 {
+    qRegisterMetaType< Tomahawk::ScannedFile >( "Tomahawk::ScannedFile" );
+    qRegisterMetaType< QMap< unsigned int, QString > >( "QMap< unsigned int, QString >" );
+
+    setTagReaderThreads( qMax( 4, QThread::idealThreadCount() ) );
 }
 
 
@@ -154,8 +240,15 @@ MusicScanner::~MusicScanner()
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO;
 
+    // results still queued for us get discarded along with this object
+    m_pendingReads.clear();
+    m_tagReaderPool.waitForDone();
+
     if ( m_dirListerThreadController )
     {
+        // a DirLister waiting for queue space would never get it now, have it stop listing
+        m_dirListerThreadController->abort();
+        m_queueSpace.release( MUSICSCANNER_MAX_QUEUED_FILES );
         m_dirListerThreadController->quit();
         m_dirListerThreadController->wait( 60000 );
 
@@ -193,6 +286,38 @@ MusicScanner::verbose()
 }
 
 
+void
+MusicScanner::setTagReaderThreads( int threads )
+{
+    m_tagReaderThreads = qMax( 1, threads );
+    m_maxPendingReads = m_tagReaderThreads;
+    m_tagReaderPool.setMaxThreadCount( m_tagReaderThreads );
+}
+
+
+int
+MusicScanner::tagReaderThreads() const
+{
+    return m_tagReaderThreads;
+}
+
+
+void
+MusicScanner::setMaxPendingReads( int reads )
+{
+    // reads beyond the thread count would only wait in the pool's queue
+    m_maxPendingReads = qBound( 1, reads, m_tagReaderThreads );
+    m_tagReaderPool.setMaxThreadCount( m_maxPendingReads );
+}
+
+
+int
+MusicScanner::maxPendingReads() const
+{
+    return m_maxPendingReads;
+}
+
+
 void
 MusicScanner::startScan()
 {
@@ -207,6 +332,8 @@ MusicScanner::startScan()
     //bear in mind that simply passing in the top-level of a defined collection means it will not return items that need
     //to be removed that aren't in that root any longer -- might have to do the filtering in setMTimes based on strings
     DatabaseCommand_FileMtimes *cmd = new DatabaseCommand_FileMtimes();
+    connect( cmd, SIGNAL( fileHashes( QMap< unsigned int, QString > ) ),
+                    SLOT( setFileHashes( QMap< unsigned int, QString > ) ) );
     connect( cmd, SIGNAL( done( QMap< QString, QMap< unsigned int, unsigned int > > ) ),
                     SLOT( setFileMtimes( QMap< QString, QMap< unsigned int, unsigned int > > ) ) );
 
@@ -224,13 +351,20 @@ MusicScanner::setFileMtimes( const QMap< QString, QMap< unsigned int, unsigned i
 }
 
 
+void
+MusicScanner::setFileHashes( const QMap< unsigned int, QString >& hashes )
+{
+    m_fileHashes = hashes;
+}
+
+
 void
 MusicScanner::scan()
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Num saved file mtimes from last scan:" << m_filemtimes.size();
 
-    connect( this, SIGNAL( batchReady( QVariantList, QVariantList ) ),
-                     SLOT( commitBatch( QVariantList, QVariantList ) ), Qt::DirectConnection );
+    connect( this, SIGNAL( batchReady( QList<Tomahawk::ScannedFile>, QVariantList ) ),
+                     SLOT( commitBatch( QList<Tomahawk::ScannedFile>, QVariantList ) ), Qt::DirectConnection );
 
     if ( m_scanMode == MusicScanner::FileScan )
     {
@@ -240,6 +374,7 @@ MusicScanner::scan()
 
     m_dirListerThreadController = new DirListerThreadController( this );
     m_dirListerThreadController->setPaths( m_paths );
+    m_dirListerThreadController->setQueueSpace( &m_queueSpace );
     m_dirListerThreadController->start( QThread::IdlePriority );
 }
 
@@ -253,14 +388,54 @@ MusicScanner::scanFilePaths()
         QFileInfo fi( path );
         if ( fi.exists() && fi.isReadable() )
             scanFile( fi );
+        else if ( !fi.exists() )
+            removeMissingPath( path );
     }
 
     QMetaObject::invokeMethod( this, "postOps", Qt::QueuedConnection );
 }
 
 
+void
+MusicScanner::removeMissingPath( const QString& path )
+{
+    // the path may have been a single file or a whole directory that got removed or moved away
+    const QString url = "file://" + path;
+    const QString prefix = url + '/';
+
+    QMap< QString, QMap< unsigned int, unsigned int > >::iterator it = m_filemtimes.find( url );
+    if ( it != m_filemtimes.end() )
+    {
+        if ( !it.value().keys().isEmpty() )
+            m_filesToDelete << it.value().keys().first();
+
+        m_filemtimes.erase( it );
+    }
+
+    it = m_filemtimes.lowerBound( prefix );
+    while ( it != m_filemtimes.end() && it.key().startsWith( prefix ) )
+    {
+        if ( !it.value().keys().isEmpty() )
+            m_filesToDelete << it.value().keys().first();
+
+        it = m_filemtimes.erase( it );
+    }
+}
+
+
 void
 MusicScanner::postOps()
+{
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Listing finished, waiting for" << m_readsInFlight + m_pendingReads.count() << "tag reads";
+
+    m_listingFinished = true;
+    if ( !m_readsInFlight && m_pendingReads.isEmpty() )
+        finishScan();
+}
+
+
+void
+MusicScanner::finishScan()
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO;
 
@@ -291,6 +466,7 @@ MusicScanner::postOps()
     }
 
     m_processedFiles.clear();
+    m_listingFinished = false;
 
     if ( !m_cmdQueue )
         cleanup();
@@ -315,8 +491,19 @@ MusicScanner::cleanup()
 
 
 void
-MusicScanner::commitBatch( const QVariantList& tracks, const QVariantList& deletethese )
+MusicScanner::commitBatch( const QList<Tomahawk::ScannedFile>& newTracks, const QVariantList& deleted )
 {
+    QList< ScannedFile > tracks = newTracks;
+    QVariantList deletethese = deleted;
+
+    // files that reappeared elsewhere keep their id instead of being deleted and re-added
+    const QVariantList moves = pairMovedFiles( tracks, deletethese );
+    if ( !moves.isEmpty() )
+    {
+        tDebug( LOGINFO ) << Q_FUNC_INFO << "moving" << moves.length() << "tracks";
+        executeCommand( dbcmd_ptr( new DatabaseCommand_MoveFiles( moves, SourceList::instance()->getLocal() ) ) );
+    }
+
     if ( !deletethese.isEmpty() )
     {
         tDebug( LOGINFO ) << Q_FUNC_INFO << "deleting" << deletethese.length() << "tracks";
@@ -327,10 +514,69 @@ MusicScanner::commitBatch( const QVariantList& tracks, const QVariantList& delet
     {
         tDebug( LOGINFO ) << Q_FUNC_INFO << "adding" << tracks.length() << "tracks";
         executeCommand( dbcmd_ptr( new DatabaseCommand_AddFiles( tracks, SourceList::instance()->getLocal() ) ) );
+        emit filesAdded( ScannedFile::toVariantList( tracks ) );
     }
 }
 
 
+QVariantList
+MusicScanner::pairMovedFiles( QList< ScannedFile >& tracks, QVariantList& deletethese ) const
+{
+    QVariantList moves;
+    if ( tracks.isEmpty() || deletethese.isEmpty() || m_fileHashes.isEmpty() )
+        return moves;
+
+    QMultiHash< QString, int > deletedByHash;
+    for ( int i = 0; i < deletethese.count(); i++ )
+    {
+        const QString hash = m_fileHashes.value( deletethese.at( i ).toUInt() );
+        if ( !hash.isEmpty() )
+            deletedByHash.insert( hash, i );
+    }
+
+    if ( deletedByHash.isEmpty() )
+        return moves;
+
+    QSet< int > pairedDeletions;
+    QList< ScannedFile >::iterator it = tracks.begin();
+    while ( it != tracks.end() )
+    {
+        QMultiHash< QString, int >::iterator match = deletedByHash.find( it->hash );
+        if ( it->hash.isEmpty() || match == deletedByHash.end() )
+        {
+            ++it;
+            continue;
+        }
+
+        const int index = match.value();
+        deletedByHash.erase( match );
+        pairedDeletions << index;
+
+        QVariantMap m;
+        m.insert( "id", deletethese.at( index ).toUInt() );
+        m.insert( "url", it->url );
+        m.insert( "mtime", it->mtime );
+        m.insert( "size", it->size );
+        moves << m;
+
+        if ( m_verbose )
+            tDebug( LOGINFO ) << Q_FUNC_INFO << "Moved file:" << deletethese.at( index ).toUInt() << "->" << it->url;
+
+        it = tracks.erase( it );
+    }
+
+    QVariantList remaining;
+    for ( int i = 0; i < deletethese.count(); i++ )
+    {
+        if ( !pairedDeletions.contains( i ) )
+            remaining << deletethese.at( i );
+    }
+    deletethese = remaining;
+
+    return moves;
+}
+
+
 void
 MusicScanner::executeCommand( dbcmd_ptr cmd )
 {
@@ -356,7 +602,10 @@ MusicScanner::scanFile( const QFileInfo& fi )
 {
     // Don't process a single file twice, this might happen if you add a subfolder of another collection folder to your collection
     if ( m_processedFiles.contains( fi.canonicalFilePath() ) )
+    {
+        releaseListedFile();
         return;
+    }
     else
         m_processedFiles << fi.canonicalFilePath();
 
@@ -367,6 +616,7 @@ MusicScanner::scanFile( const QFileInfo& fi )
                 fi.lastModified().toUTC().toTime_t() == m_filemtimes.value( "file://" + fi.canonicalFilePath() ).values().first() )
         {
             m_filemtimes.remove( "file://" + fi.canonicalFilePath() );
+            releaseListedFile();
             return;
         }
 
@@ -375,28 +625,87 @@ MusicScanner::scanFile( const QFileInfo& fi )
         m_filemtimes.remove( "file://" + fi.canonicalFilePath() );
     }
 
-    QVariant m = readFile( fi );
-    if ( m.toMap().isEmpty() )
-        return;
+    m_pendingReads.enqueue( qMakePair( m_nextSequence++, fi ) );
+    dispatchReads();
+}
 
-    m_scannedfiles << m;
-    if ( m_batchsize != 0 && (quint32)m_scannedfiles.length() >= m_batchsize )
+
+void
+MusicScanner::dispatchReads()
+{
+    while ( m_readsInFlight < m_maxPendingReads && !m_pendingReads.isEmpty() )
     {
-        emit batchReady( m_scannedfiles, m_filesToDelete );
-        m_scannedfiles.clear();
-        m_filesToDelete.clear();
+        const QPair< quint64, QFileInfo > read = m_pendingReads.dequeue();
+        releaseListedFile();
+
+        TagReaderJob* job = new TagReaderJob( this, read.first, read.second );
+        job->setAutoDelete( true );
+        m_readsInFlight++;
+        m_tagReaderPool.start( job );
+    }
+}
+
+
+void
+MusicScanner::releaseListedFile()
+{
+    // files of a FileScan are handed to us directly, without taking queue space
+    if ( m_scanMode == MusicScanner::DirScan )
+        m_queueSpace.release();
+}
+
+
+void
+MusicScanner::onFileRead( quint64 sequence, const Tomahawk::ScannedFile& file, const QString& path )
+{
+    m_readsInFlight--;
+    m_readResults.insert( sequence, qMakePair( file, path ) );
+
+    // hand results on in the order we found the files, so batches stay deterministic
+    while ( !m_readResults.isEmpty() && m_readResults.constBegin().key() == m_nextToCommit )
+    {
+        const QPair< ScannedFile, QString > result = m_readResults.take( m_nextToCommit );
+        m_nextToCommit++;
+
+        accountFile( result.first, result.second );
+        if ( !result.first.isValid() )
+            continue;
+
+        m_scannedfiles << result.first;
+        if ( m_batchsize != 0 && (quint32)m_scannedfiles.length() >= m_batchsize )
+        {
+            emit batchReady( m_scannedfiles, m_filesToDelete );
+            m_scannedfiles.clear();
+            m_filesToDelete.clear();
+        }
     }
+
+    dispatchReads();
+
+    if ( m_listingFinished && !m_readsInFlight && m_pendingReads.isEmpty() )
+        finishScan();
 }
 
 
 QVariant
 MusicScanner::readTags( const QFileInfo& fi )
+{
+    const ScannedFile file = readScannedFile( fi );
+    if ( !file.isValid() )
+        return QVariantMap();
+
+    return file.toVariantMap();
+}
+
+
+ScannedFile
+MusicScanner::readScannedFile( const QFileInfo& fi )
 {
     tLog( LOGVERBOSE ) << Q_FUNC_INFO << "Parsing tags for file:" << fi.absoluteFilePath();
 
     const QString suffix = fi.suffix().toLower();
     if ( !TomahawkUtils::supportedExtensions().contains( suffix ) )
-        return QVariantMap(); // invalid extension
+        return ScannedFile(); // invalid extension
 
     #ifdef Q_OS_WIN
         const wchar_t* encodedName = fi.canonicalFilePath().toStdWString().c_str();
@@ -407,13 +716,13 @@ MusicScanner::readTags( const QFileInfo& fi )
 
     TagLib::FileRef f( encodedName );
     if ( f.isNull() || !f.tag() )
-        return QVariantMap();
+        return ScannedFile();
 
     int bitrate = 0;
     int duration = 0;
     QSharedPointer<Tag> tag( Tag::fromFile( f ) );
     if ( !tag )
-        return QVariantMap();
+        return ScannedFile();
 
     if ( f.audioProperties() )
     {
@@ -426,54 +735,77 @@ MusicScanner::readTags( const QFileInfo& fi )
     const QString album  = tag->album().trimmed();
     const QString track  = tag->title().trimmed();
     if ( artist.isEmpty() || track.isEmpty() )
-        return QVariantMap();
+        return ScannedFile();
 
     const QString mimetype = TomahawkUtils::extensionToMimetype( suffix );
     const QString url( "file://%1" );
 
-    QVariantMap m;
-    m["url"]          = url.arg( fi.canonicalFilePath() );
-    m["mtime"]        = fi.lastModified().toUTC().toTime_t();
-    m["size"]         = (unsigned int)fi.size();
-    m["mimetype"]     = mimetype;
-    m["duration"]     = duration;
-    m["bitrate"]      = bitrate;
-    m["artist"]       = artist;
-    m["album"]        = album;
-    m["track"]        = track;
-    m["albumpos"]     = tag->track();
-    m["year"]         = tag->year();
-    m["albumartist"]  = tag->albumArtist();
-    m["composer"]     = tag->composer();
-    m["discnumber"]   = tag->discNumber();
-    m["hash"]         = ""; // TODO
-
-    return m;
+    ScannedFile file;
+    file.url          = url.arg( fi.canonicalFilePath() );
+    file.mtime        = fi.lastModified().toUTC().toTime_t();
+    file.size         = (unsigned int)fi.size();
+    file.mimetype     = mimetype;
+    file.duration     = duration;
+    file.bitrate      = bitrate;
+    file.artist       = artist;
+    file.album        = album;
+    file.track        = track;
+    file.albumpos     = tag->track();
+    file.year         = tag->year();
+    file.albumartist  = tag->albumArtist();
+    file.composer     = tag->composer();
+    file.discnumber   = tag->discNumber();
+    file.hash         = fingerprint( fi );
+
+    return file;
 }
 
 
-QVariant
-MusicScanner::readFile( const QFileInfo& fi )
+QString
+MusicScanner::fingerprint( const QFileInfo& fi )
 {
-    const QVariant m = readTags( fi );
+    const qint64 chunkSize = 64 * 1024;
+
+    QFile file( fi.canonicalFilePath() );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return QString();
+
+    const qint64 size = file.size();
+    QCryptographicHash hash( QCryptographicHash::Md5 );
+    hash.addData( QByteArray::number( size ) );
+    hash.addData( file.read( chunkSize ) );
+
+    if ( size > chunkSize )
+    {
+        // small files were read completely already, don't hash the same bytes twice
+        const qint64 tail = qMin( chunkSize, size - chunkSize );
+        if ( !file.seek( size - tail ) )
+            return QString();
 
+        hash.addData( file.read( tail ) );
+    }
+
+    return QString::fromLatin1( hash.result().toHex() );
+}
+
+
+void
+MusicScanner::accountFile( const ScannedFile& file, const QString& path )
+{
     if ( m_scanned )
         if ( m_scanned % 3 == 0 )
             emit progress( m_scanned );
 
     if ( m_scanned % 100 == 0 || m_verbose )
-        tDebug( LOGINFO ) << Q_FUNC_INFO << "Scanning file:" << m_scanned << fi.canonicalFilePath();
+        tDebug( LOGINFO ) << Q_FUNC_INFO << "Scanning file:" << m_scanned << path;
 
-    if ( m.toMap().isEmpty() )
+    if ( !file.isValid() )
     {
-        m_skippedFiles << fi.canonicalFilePath();
+        m_skippedFiles << path;
         m_skipped++;
     }
     else
     {
         m_scanned++;
     }
-
-    return m;
 }
-
@@ -22,6 +22,7 @@
 
 #include "database/Database.h"
 #include "database/DatabaseCommand.h"
+#include "ScannedFile.h"
 #include "TomahawkSettings.h"
 
 /* taglib */
@@ -33,9 +34,13 @@
 #include <QFileInfo>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QPair>
 #include <QPointer>
+#include <QQueue>
 #include <QString>
 #include <QThread>
+#include <QSemaphore>
+#include <QThreadPool>
 #include <QTimer>
 #include <QVariantMap>
 
@@ -48,8 +53,8 @@ Q_OBJECT
 
 public:
 
-    DirLister( const QStringList& dirs )
-        : QObject(), m_dirs( dirs ), m_opcount( 0 ), m_deleting( false )
+    DirLister( const QStringList& dirs, QSemaphore* queueSpace )
+        : QObject(), m_dirs( dirs ), m_queueSpace( queueSpace ), m_opcount( 0 ), m_deleting( false )
     {
         qDebug() << Q_FUNC_INFO;
     }
@@ -73,6 +78,8 @@ private slots:
 private:
     QStringList m_dirs;
     QSet< QString > m_processedDirs;
+    // one slot per file the scanner may have queued, we wait for a free one before listing more
+    QSemaphore* m_queueSpace;
 
     uint m_opcount;
     QMutex m_deletingMutex;
@@ -88,11 +95,18 @@ public:
     virtual ~DirListerThreadController();
 
     void setPaths( const QStringList& paths ) { m_paths = paths; }
+    void setQueueSpace( QSemaphore* queueSpace ) { m_queueSpace = queueSpace; }
     void run();
 
+    /// Makes the DirLister stop listing, even while it waits for queue space
+    void abort();
+
 private:
     QPointer< DirLister > m_dirLister;
     QStringList m_paths;
+    QSemaphore* m_queueSpace;
+    QMutex m_mutex;
+    bool m_aborted;
 };
 
 class DLLEXPORT MusicScanner : public QObject
@@ -104,6 +118,14 @@ public:
     enum ScanType { None, Full, Normal, File };
 
     static QVariant readTags( const QFileInfo& fi );
+    static Tomahawk::ScannedFile readScannedFile( const QFileInfo& fi );
+
+    /**
+     * Cheap content fingerprint of a file: its size plus the first and last 64 KiB.
+     *
+     * Used to recognize files that were moved or renamed, without reading them completely.
+     */
+    static QString fingerprint( const QFileInfo& fi );
 
     MusicScanner( MusicScanner::ScanMode scanMode, const QStringList& paths, quint32 bs = 0 );
     ~MusicScanner();
@@ -124,28 +146,60 @@ public:
     void setVerbose( bool _verbose );
     bool verbose();
 
+    /**
+     * Number of threads reading tags in parallel.
+     *
+     * Tag reading is mostly waiting for I/O, so on network shares this should be well
+     * above the number of CPU cores.
+     */
+    void setTagReaderThreads( int threads );
+    int tagReaderThreads() const;
+
+    /**
+     * Maximum number of files being read at the same time (I/O depth).
+     *
+     * Every read occupies a tag reader thread, so only as many threads as this are
+     * started. Defaults to the number of tag reader threads.
+     */
+    void setMaxPendingReads( int reads );
+    int maxPendingReads() const;
+
+    unsigned int scannedFiles() const { return m_scanned; }
+    unsigned int skippedFiles() const { return m_skipped; }
+
 signals:
     //void fileScanned( QVariantMap );
     void finished();
-    void batchReady( const QVariantList&, const QVariantList& );
+    void batchReady( const QList<Tomahawk::ScannedFile>&, const QVariantList& );
     void progress( unsigned int files );
+    // tag maps of new or modified files that have been handed to the database
+    void filesAdded( const QVariantList& files );
 
 private:
-    QVariant readFile( const QFileInfo& fi );
+    void accountFile( const Tomahawk::ScannedFile& file, const QString& path );
     void executeCommand( Tomahawk::dbcmd_ptr cmd );
 
 private slots:
     void postOps();
     void scanFile( const QFileInfo& fi );
+    void onFileRead( quint64 sequence, const Tomahawk::ScannedFile& file, const QString& path );
     void setFileMtimes( const QMap< QString, QMap< unsigned int, unsigned int > >& m );
+    void setFileHashes( const QMap< unsigned int, QString >& hashes );
     void startScan();
     void scan();
     void cleanup();
-    void commitBatch( const QVariantList& tracks, const QVariantList& deletethese );
+    void commitBatch( const QList<Tomahawk::ScannedFile>& tracks, const QVariantList& deletethese );
     void commandFinished();
 
 private:
     void scanFilePaths();
+    void removeMissingPath( const QString& path );
+    /// Only files deleted and added within the same batch are paired, a move
+    /// that straddles two batches ends up as a delete and an add.
+    QVariantList pairMovedFiles( QList< Tomahawk::ScannedFile >& tracks, QVariantList& deletethese ) const;
+    void dispatchReads();
+    void releaseListedFile();
+    void finishScan();
 
     MusicScanner::ScanMode m_scanMode;
     QStringList m_paths;
@@ -156,14 +210,28 @@ private:
 
     QList<QString> m_skippedFiles;
     QMap<QString, QMap< unsigned int, unsigned int > > m_filemtimes;
+    QMap< unsigned int, QString > m_fileHashes;
 
     unsigned int m_cmdQueue;
 
     QSet< QString > m_processedFiles;
-    QVariantList m_scannedfiles;
+    QList< Tomahawk::ScannedFile > m_scannedfiles;
     QVariantList m_filesToDelete;
     quint32 m_batchsize;
 
+    // tags are read out of order by the pool, but committed in the order files were found
+    QThreadPool m_tagReaderPool;
+    int m_tagReaderThreads;
+    int m_maxPendingReads;
+    int m_readsInFlight;
+    QQueue< QPair< quint64, QFileInfo > > m_pendingReads;
+    QMap< quint64, QPair< Tomahawk::ScannedFile, QString > > m_readResults;
+    quint64 m_nextSequence;
+    quint64 m_nextToCommit;
+    bool m_listingFinished;
+    // bounds the files listed but not handed to the pool yet, so the DirLister can't run away from us
+    QSemaphore m_queueSpace;
+
     DirListerThreadController* m_dirListerThreadController;
 };
 
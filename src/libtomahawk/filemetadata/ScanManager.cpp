@@ -22,9 +22,15 @@
 #include "database/Database.h"
 #include "database/DatabaseCommand_FileMTimes.h"
 #include "database/DatabaseCommand_DeleteFiles.h"
+#include "database/DatabaseCommand_GenericSelect.h"
+#include "database/DatabaseCommand_RebuildStats.h"
 #include "utils/Logger.h"
 #include "utils/TomahawkUtils.h"
 
+#include "LoudnessAnalyzer.h"
+#ifdef Q_OS_LINUX
+    #include "InotifyWatcher.h"
+#endif
 #include "MusicScanner.h"
 #include "PlaylistEntry.h"
 #include "SourceList.h"
@@ -56,9 +62,12 @@ MusicScannerThreadController::run()
 {
     m_musicScanner = QPointer< MusicScanner >( new MusicScanner( m_mode, m_paths, m_bs ) );
     m_musicScanner->setVerbose( qApp->arguments().contains( "--verbose" ) );
+    if ( TomahawkSettings::instance()->scannerTagReaders() > 0 )
+        m_musicScanner->setTagReaderThreads( TomahawkSettings::instance()->scannerTagReaders() );
 
     connect( m_musicScanner.data(), SIGNAL( finished() ), parent(), SLOT( scannerFinished() ), Qt::QueuedConnection );
     connect( m_musicScanner.data(), SIGNAL( progress( unsigned int ) ), parent(), SIGNAL( progress( unsigned int ) ), Qt::QueuedConnection );
+    connect( m_musicScanner.data(), SIGNAL( filesAdded( QVariantList ) ), parent(), SLOT( onFilesAdded( QVariantList ) ), Qt::QueuedConnection );
     QMetaObject::invokeMethod( m_musicScanner.data(), "startScan", Qt::QueuedConnection );
 
     exec();
@@ -84,10 +93,14 @@ ScanManager::ScanManager( QObject* parent )
     , m_currScannerPaths()
     , m_cachedScannerDirs()
     , m_queuedScanType( MusicScanner::None )
+    , m_watcher( 0 )
     , m_updateGUI( true )
+    , m_analyzeLoudness( false )
 {
     s_instance = this;
 
+    m_loudnessAnalyzer = new LoudnessAnalyzer( this );
+
     m_scanTimer = new QTimer( this );
     m_scanTimer->setSingleShot( false );
     m_scanTimer->setInterval( TomahawkSettings::instance()->scannerTime() * 1000 );
@@ -98,6 +111,8 @@ ScanManager::~ScanManager()
 {
     qDebug() << Q_FUNC_INFO;
 
+    m_loudnessAnalyzer->cancel();
+
     if ( m_musicScannerThreadController )
     {
         m_musicScannerThreadController->quit();
@@ -121,8 +136,111 @@ ScanManager::init()
         m_cachedScannerDirs = TomahawkSettings::instance()->scannerPaths();
         m_scanTimer->start();
         if ( TomahawkSettings::instance()->watchForChanges() )
+        {
+            // start watching first, so we don't miss anything changing during the startup scan
+            updateWatcher();
             QTimer::singleShot( 1000, this, SLOT( runStartupScan() ) );
+        }
+    }
+
+    updateLoudnessAnalysis();
+}
+
+
+void
+ScanManager::updateLoudnessAnalysis()
+{
+    const bool analyze = TomahawkSettings::instance()->analyzeLoudness();
+    if ( analyze == m_analyzeLoudness )
+        return;
+
+    m_analyzeLoudness = analyze;
+    if ( !analyze )
+    {
+        m_loudnessAnalyzer->cancel();
+        return;
+    }
+
+    // new files get analysed as the scanner adds them, this catches up on the rest of the library
+    DatabaseCommand_GenericSelect* cmd = new DatabaseCommand_GenericSelect(
+        "SELECT file.url FROM file "
+        "WHERE file.source IS NULL AND NOT EXISTS ( SELECT 1 FROM file_loudness WHERE file_loudness.file = file.id )",
+        DatabaseCommand_GenericSelect::Track, true );
+    connect( cmd, SIGNAL( rawData( QList< QStringList > ) ), SLOT( onUnanalysedFiles( QList< QStringList > ) ) );
+    Database::instance()->enqueue( dbcmd_ptr( cmd ) );
+}
+
+
+void
+ScanManager::onUnanalysedFiles( const QList< QStringList >& rows )
+{
+    if ( !m_analyzeLoudness )
+        return;
+
+    QVariantList files;
+    foreach ( const QStringList& row, rows )
+    {
+        QVariantMap m;
+        m[ "url" ] = row.value( 0 );
+        files << m;
     }
+
+    tDebug() << Q_FUNC_INFO << "Queueing" << files.count() << "files of the library for loudness analysis";
+    m_loudnessAnalyzer->analyze( files );
+}
+
+
+void
+ScanManager::updateWatcher()
+{
+#ifdef Q_OS_LINUX
+    if ( !TomahawkSettings::instance()->watchForChanges() || !TomahawkSettings::instance()->hasScannerPaths() )
+    {
+        if ( m_watcher )
+            m_watcher->stop();
+        return;
+    }
+
+    if ( !m_watcher )
+    {
+        m_watcher = new InotifyWatcher( this );
+        connect( m_watcher, SIGNAL( filesChanged( QStringList ) ), SLOT( onWatchedFilesChanged( QStringList ) ) );
+        connect( m_watcher, SIGNAL( watchLimitReached() ), SLOT( onWatchLimitReached() ) );
+        connect( m_watcher, SIGNAL( eventsLost() ), SLOT( runNormalScan() ) );
+    }
+
+    m_watcher->watch( TomahawkSettings::instance()->scannerPaths() );
+#endif
+}
+
+
+bool
+ScanManager::isWatching() const
+{
+#ifdef Q_OS_LINUX
+    return m_watcher && m_watcher->isActive();
+#else
+    return false;
+#endif
+}
+
+
+void
+ScanManager::onWatchedFilesChanged( const QStringList& paths )
+{
+    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << paths.count();
+
+    runFileScan( paths );
+}
+
+
+void
+ScanManager::onWatchLimitReached()
+{
+    tLog() << Q_FUNC_INFO << "Can't watch the whole collection for changes, falling back to scanning it periodically";
+
+    // we might have missed changes while setting up the watches
+    runNormalScan();
 }
 
 
@@ -132,14 +250,21 @@ ScanManager::onSettingsChanged()
     if ( !TomahawkSettings::instance()->watchForChanges() && m_scanTimer->isActive() )
         m_scanTimer->stop();
 
+    updateLoudnessAnalysis();
+
     m_scanTimer->setInterval( TomahawkSettings::instance()->scannerTime() * 1000 );
 
     if ( TomahawkSettings::instance()->hasScannerPaths() &&
         m_cachedScannerDirs != TomahawkSettings::instance()->scannerPaths() )
     {
         m_cachedScannerDirs = TomahawkSettings::instance()->scannerPaths();
+        updateWatcher();
         runNormalScan();
     }
+    else if ( TomahawkSettings::instance()->watchForChanges() != isWatching() )
+    {
+        updateWatcher();
+    }
 
     if ( TomahawkSettings::instance()->watchForChanges() && !m_scanTimer->isActive() )
         m_scanTimer->start();
@@ -161,6 +286,11 @@ void
 ScanManager::scanTimerTimeout()
 {
     tLog( LOGVERBOSE ) << Q_FUNC_INFO;
+
+    // the watcher already told us about everything that changed
+    if ( isWatching() )
+        return;
+
     if ( !TomahawkSettings::instance()->watchForChanges() ||
          !Database::instance() ||
          ( Database::instance() && !Database::instance()->isReady() ) )
@@ -208,9 +338,15 @@ ScanManager::runNormalScan( bool manualFull )
 
     if ( manualFull )
     {
+        // every file gets re-added and thus re-analysed
+        m_loudnessAnalyzer->cancel();
+
         DatabaseCommand_DeleteFiles *cmd = new DatabaseCommand_DeleteFiles( SourceList::instance()->getLocal() );
         connect( cmd, SIGNAL( finished() ), SLOT( filesDeleted() ) );
         Database::instance()->enqueue( dbcmd_ptr( cmd ) );
+
+        // a full rescan is a good moment to make sure the aggregate stats didn't drift
+        Database::instance()->enqueue( dbcmd_ptr( new DatabaseCommand_RebuildStats() ) );
         return;
     }
 
@@ -224,12 +360,6 @@ ScanManager::runNormalScan( bool manualFull )
 void
 ScanManager::runFileScan( const QStringList& paths, bool updateGUI )
 {
-    if ( !Database::instance() || ( Database::instance() && !Database::instance()->isReady() ) )
-    {
-        tLog() << Q_FUNC_INFO << "Error... Database is not ready, but should be";
-        return;
-    }
-
     if ( QThread::currentThread() != ScanManager::instance()->thread() )
     {
         QMetaObject::invokeMethod( this, "runFileScan", Qt::QueuedConnection, Q_ARG( QStringList, paths ) );
@@ -241,6 +371,15 @@ ScanManager::runFileScan( const QStringList& paths, bool updateGUI )
     foreach( const QString& path, paths )
         m_currScannerPaths.insert( path );
 
+    if ( !Database::instance() || !Database::instance()->isReady() )
+    {
+        // hold on to the changed paths and scan them once the database is up
+        tLog() << Q_FUNC_INFO << "Database is not ready yet, queueing file scan of" << m_currScannerPaths.count() << "paths";
+        if ( Database::instance() )
+            connect( Database::instance(), SIGNAL( ready() ), SLOT( runQueuedFileScan() ), Qt::UniqueConnection );
+        return;
+    }
+
     if ( m_musicScannerThreadController ) //still running if these are not zero
     {
         if ( m_queuedScanType == MusicScanner::None )
@@ -258,6 +397,16 @@ ScanManager::runFileScan( const QStringList& paths, bool updateGUI )
 }
 
 
+void
+ScanManager::runQueuedFileScan()
+{
+    disconnect( Database::instance(), SIGNAL( ready() ), this, SLOT( runQueuedFileScan() ) );
+
+    if ( !m_currScannerPaths.isEmpty() )
+        runFileScan();
+}
+
+
 void
 ScanManager::fileMtimesCheck( const QMap< QString, QMap< unsigned int, unsigned int > >& mtimes )
 {
@@ -283,6 +432,16 @@ ScanManager::filesDeleted()
 }
 
 
+void
+ScanManager::onFilesAdded( const QVariantList& files )
+{
+    if ( !TomahawkSettings::instance()->analyzeLoudness() )
+        return;
+
+    m_loudnessAnalyzer->analyze( files );
+}
+
+
 void
 ScanManager::runScan()
 {
@@ -322,7 +481,7 @@ ScanManager::scannerFinished()
             QMetaObject::invokeMethod( this, "runNormalScan", Qt::QueuedConnection, Q_ARG( bool, m_queuedScanType == MusicScanner::Full ) );
             break;
         case MusicScanner::File:
-            QMetaObject::invokeMethod( this, "", Qt::QueuedConnection, Q_ARG( QStringList, QStringList() ) );
+            QMetaObject::invokeMethod( this, "runFileScan", Qt::QueuedConnection, Q_ARG( QStringList, QStringList() ) );
             break;
         default:
             break;
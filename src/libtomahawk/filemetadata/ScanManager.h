@@ -33,6 +33,8 @@
 #include <QSet>
 #include <QThread>
 
+class InotifyWatcher;
+class LoudnessAnalyzer;
 class QFileSystemWatcher;
 class QTimer;
 
@@ -80,6 +82,7 @@ public slots:
 
 private slots:
     void runStartupScan();
+    void runQueuedFileScan();
     void runScan();
 
     void scannerFinished();
@@ -89,8 +92,17 @@ private slots:
 
     void fileMtimesCheck( const QMap< QString, QMap< unsigned int, unsigned int > >& mtimes );
     void filesDeleted();
+    void onFilesAdded( const QVariantList& files );
+    void onUnanalysedFiles( const QList< QStringList >& rows );
+
+    void onWatchedFilesChanged( const QStringList& paths );
+    void onWatchLimitReached();
 
 private:
+    void updateWatcher();
+    void updateLoudnessAnalysis();
+    bool isWatching() const;
+
     static ScanManager* s_instance;
 
     MusicScanner::ScanMode m_currScanMode;
@@ -101,7 +113,12 @@ private:
     QTimer* m_scanTimer;
     MusicScanner::ScanType m_queuedScanType;
 
+    LoudnessAnalyzer* m_loudnessAnalyzer;
+    // only available on Linux, we fall back to periodic scans everywhere else
+    InotifyWatcher* m_watcher;
+
     bool m_updateGUI;
+    bool m_analyzeLoudness;
 };
 
 #endif
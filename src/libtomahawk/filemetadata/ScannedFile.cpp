@@ -0,0 +1,98 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ScannedFile.h"
+
+namespace Tomahawk
+{
+
+QVariantMap
+ScannedFile::toVariantMap() const
+{
+    QVariantMap m;
+    if ( id > 0 )
+        m["id"]       = id;
+    m["url"]          = url;
+    m["mtime"]        = mtime;
+    m["size"]         = size;
+    m["mimetype"]     = mimetype;
+    m["duration"]     = duration;
+    m["bitrate"]      = bitrate;
+    m["artist"]       = artist;
+    m["album"]        = album;
+    m["track"]        = track;
+    m["albumpos"]     = albumpos;
+    m["year"]         = year;
+    m["albumartist"]  = albumartist;
+    m["composer"]     = composer;
+    m["discnumber"]   = discnumber;
+    m["hash"]         = hash;
+
+    return m;
+}
+
+
+ScannedFile
+ScannedFile::fromVariantMap( const QVariantMap& m )
+{
+    ScannedFile f;
+    f.id          = m.value( "id" ).toInt();
+    f.url         = m.value( "url" ).toString();
+    f.mtime       = m.value( "mtime" ).toUInt();
+    f.size        = m.value( "size" ).toUInt();
+    f.hash        = m.value( "hash" ).toString();
+    f.mimetype    = m.value( "mimetype" ).toString();
+    f.duration    = m.value( "duration" ).toUInt();
+    f.bitrate     = m.value( "bitrate" ).toUInt();
+    f.artist      = m.value( "artist" ).toString();
+    f.albumartist = m.value( "albumartist" ).toString();
+    f.album       = m.value( "album" ).toString();
+    f.track       = m.value( "track" ).toString();
+    f.albumpos    = m.value( "albumpos" ).toUInt();
+    f.composer    = m.value( "composer" ).toString();
+    f.discnumber  = m.value( "discnumber" ).toUInt();
+    f.year        = m.value( "year" ).toInt();
+
+    return f;
+}
+
+
+QVariantList
+ScannedFile::toVariantList( const QList< ScannedFile >& files )
+{
+    QVariantList list;
+    list.reserve( files.count() );
+    foreach ( const ScannedFile& f, files )
+        list << f.toVariantMap();
+
+    return list;
+}
+
+
+QList< ScannedFile >
+ScannedFile::fromVariantList( const QVariantList& list )
+{
+    QList< ScannedFile > files;
+    files.reserve( list.count() );
+    foreach ( const QVariant& v, list )
+        files << fromVariantMap( v.toMap() );
+
+    return files;
+}
+
+}
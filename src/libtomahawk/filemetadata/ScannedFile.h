@@ -0,0 +1,74 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCANNEDFILE_H
+#define SCANNEDFILE_H
+
+#include "DllMacro.h"
+
+#include <QList>
+#include <QMetaType>
+#include <QString>
+#include <QVariantMap>
+
+namespace Tomahawk
+{
+
+/**
+ * Metadata of a single file as read by the MusicScanner and stored by
+ * DatabaseCommand_AddFiles. The QVariantMap representation is only used
+ * where the data crosses the network or gets serialized into the oplog.
+ */
+struct DLLEXPORT ScannedFile
+{
+    ScannedFile()
+        : id( 0 ), mtime( 0 ), size( 0 ), duration( 0 ), bitrate( 0 )
+        , albumpos( 0 ), discnumber( 0 ), year( 0 )
+    {}
+
+    bool isValid() const { return !url.isEmpty(); }
+
+    QVariantMap toVariantMap() const;
+    static ScannedFile fromVariantMap( const QVariantMap& m );
+
+    static QVariantList toVariantList( const QList< ScannedFile >& files );
+    static QList< ScannedFile > fromVariantList( const QVariantList& list );
+
+    int id;
+    QString url;
+    uint mtime;
+    uint size;
+    QString hash;
+    QString mimetype;
+    uint duration;
+    uint bitrate;
+    QString artist;
+    QString albumartist;
+    QString album;
+    QString track;
+    QString composer;
+    uint albumpos;
+    uint discnumber;
+    int year;
+};
+
+}
+
+Q_DECLARE_METATYPE( Tomahawk::ScannedFile )
+
+#endif // SCANNEDFILE_H
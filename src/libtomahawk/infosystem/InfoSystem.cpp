@@ -65,6 +65,7 @@ InfoRequestData::init( const QString& callr, const InfoType typ, const QVariant&
 
 InfoPlugin::InfoPlugin()
     : QObject()
+    , m_maxRequestsPerSecond( 0 )
 {
 }
 
@@ -74,6 +75,15 @@ InfoPlugin::~InfoPlugin()
 }
 
 
+void
+InfoPlugin::notInCacheBatch( const QList< QPair< Tomahawk::InfoSystem::InfoStringHash, Tomahawk::InfoSystem::InfoRequestData > >& requests )
+{
+    typedef QPair< InfoStringHash, InfoRequestData > Request;
+    foreach ( const Request& request, requests )
+        notInCacheSlot( request.first, request.second );
+}
+
+
 void
 InfoPlugin::setFriendlyName( const QString& friendlyName )
 {
@@ -164,6 +174,9 @@ InfoSystem::init()
     connect( cache, SIGNAL( info( Tomahawk::InfoSystem::InfoRequestData, QVariant ) ),
              worker, SLOT( infoSlot( Tomahawk::InfoSystem::InfoRequestData, QVariant ) ), Qt::UniqueConnection );
 
+    connect( cache, SIGNAL( notInCache( QObject*, Tomahawk::InfoSystem::InfoStringHash, Tomahawk::InfoSystem::InfoRequestData ) ),
+             worker, SLOT( notInCacheSlot( QObject*, Tomahawk::InfoSystem::InfoStringHash, Tomahawk::InfoSystem::InfoRequestData ) ), Qt::UniqueConnection );
+
     connect( worker, SIGNAL( info( Tomahawk::InfoSystem::InfoRequestData, QVariant ) ),
              this,       SIGNAL( info( Tomahawk::InfoSystem::InfoRequestData, QVariant ) ), Qt::UniqueConnection );
 
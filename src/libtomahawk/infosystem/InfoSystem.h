@@ -28,6 +28,7 @@
 #include <QCryptographicHash>
 #include <QMap>
 #include <QObject>
+#include <QPair>
 #include <QPointer>
 #include <QSet>
 #include <QStringList>
@@ -114,6 +115,19 @@ public:
     QSet< InfoType > supportedGetTypes() const { return m_supportedGetTypes; }
     QSet< InfoType > supportedPushTypes() const { return m_supportedPushTypes; }
 
+    /**
+     * @brief Maximum number of requests per second the InfoSystemWorker lets this plugin fetch, 0 for no limit.
+     * Only requests the cache can't answer count, they are queued up before notInCacheSlot() is called so the
+     * plugin stays within the limits of its upstream service.
+     **/
+    int maxRequestsPerSecond() const { return m_maxRequestsPerSecond; }
+
+    /**
+     * @brief Types for which queued cache misses are handed over together through notInCacheBatch().
+     * Only list types here if the upstream service can answer several lookups with a single call.
+     **/
+    QSet< InfoType > batchedGetTypes() const { return m_batchedGetTypes; }
+
 signals:
     void getCachedInfo( Tomahawk::InfoSystem::InfoStringHash criteria, qint64 newMaxAge, Tomahawk::InfoSystem::InfoRequestData requestData );
     void info( Tomahawk::InfoSystem::InfoRequestData requestData, QVariant output );
@@ -130,6 +144,15 @@ protected slots:
     virtual void init() = 0;
 
     virtual void getInfo( Tomahawk::InfoSystem::InfoRequestData requestData ) = 0;
+
+    /**
+     * @brief Called with several queued cache misses of one of the batchedGetTypes() at once.
+     * The default implementation calls notInCacheSlot() for each of them.
+     *
+     * @return void
+     **/
+    virtual void notInCacheBatch( const QList< QPair< Tomahawk::InfoSystem::InfoStringHash, Tomahawk::InfoSystem::InfoRequestData > >& requests );
+
     virtual void pushInfo( Tomahawk::InfoSystem::InfoPushData pushData ) = 0;
     virtual void notInCacheSlot( Tomahawk::InfoSystem::InfoStringHash criteria, Tomahawk::InfoSystem::InfoRequestData requestData ) = 0;
 
@@ -138,9 +161,12 @@ protected:
     QString m_friendlyName;
     QSet< InfoType > m_supportedGetTypes;
     QSet< InfoType > m_supportedPushTypes;
+    QSet< InfoType > m_batchedGetTypes;
+    int m_maxRequestsPerSecond;
 
 private:
     friend class InfoSystem;
+    friend class InfoSystemWorker;
 };
 
 
@@ -25,27 +25,45 @@
 #include "utils/Logger.h"
 #include "Source.h"
 
+#include <QDataStream>
 #include <QDir>
 #include <QSettings>
+#include <QSqlError>
+#include <QSqlQuery>
 #include <QCryptographicHash>
 
+// the store is trimmed down to this size, least recently used entries go first
+#define INFOSYSTEMCACHE_MAX_SIZE 256 * 1024 * 1024
+// the last version of the cache that kept one INI file per entry
+#define INFOSYSTEMCACHE_FILE_VERSION 4
+
 namespace Tomahawk
 {
 
 namespace InfoSystem
 {
 
-const int InfoSystemCache::s_infosystemCacheVersion = 4;
+const int InfoSystemCache::s_infosystemCacheVersion = 5;
 
 InfoSystemCache::InfoSystemCache( QObject* parent )
     : QObject( parent )
     , m_cacheBaseDir( TomahawkSettings::instance()->storageCacheLocation() + "/InfoSystemCache/" )
+    , m_totalSize( 0 )
+    , m_maxSize( INFOSYSTEMCACHE_MAX_SIZE )
 {
     tDebug() << Q_FUNC_INFO;
 
-    if ( TomahawkSettings::instance()->infoSystemCacheVersion() < s_infosystemCacheVersion )
+    const int version = (int)TomahawkSettings::instance()->infoSystemCacheVersion();
+    if ( version < INFOSYSTEMCACHE_FILE_VERSION )
     {
         TomahawkUtils::removeDirectory( m_cacheBaseDir );
+    }
+
+    if ( openStore() && version < s_infosystemCacheVersion )
+    {
+        if ( version == INFOSYSTEMCACHE_FILE_VERSION )
+            migrateFileCache();
+
         TomahawkSettings::instance()->setInfoSystemCacheVersion( s_infosystemCacheVersion );
     }
 
@@ -59,188 +77,320 @@ InfoSystemCache::InfoSystemCache( QObject* parent )
 InfoSystemCache::~InfoSystemCache()
 {
     tDebug() << Q_FUNC_INFO;
+
+    const QString connName = m_db.connectionName();
+    m_db.close();
+    m_db = QSqlDatabase();
+
+    if ( !connName.isEmpty() )
+        QSqlDatabase::removeDatabase( connName );
+}
+
+
+bool
+InfoSystemCache::openStore()
+{
+    if ( !QDir().mkpath( m_cacheBaseDir ) )
+    {
+        tLog() << "Failed to create cache dir! Bailing...";
+        return false;
+    }
+
+    m_db = QSqlDatabase::addDatabase( "QSQLITE", "infosystemcache" );
+    m_db.setDatabaseName( m_cacheBaseDir + "cache.db" );
+    if ( !m_db.open() )
+    {
+        tLog() << Q_FUNC_INFO << "Failed to open infosystem cache:" << m_db.lastError().text();
+        return false;
+    }
+
+    QSqlQuery query( m_db );
+    // losing the most recent entries on a crash is fine for a cache
+    query.exec( "PRAGMA synchronous = OFF" );
+    query.exec( "PRAGMA journal_mode = WAL" );
+
+    query.exec( "CREATE TABLE IF NOT EXISTS cache ( "
+                "type INTEGER NOT NULL, "
+                "hash TEXT NOT NULL, "
+                "expires INTEGER NOT NULL, "
+                "accessed INTEGER NOT NULL, "
+                "size INTEGER NOT NULL, "
+                "data BLOB NOT NULL, "
+                "PRIMARY KEY ( type, hash ) )" );
+    query.exec( "CREATE INDEX IF NOT EXISTS cache_expires ON cache( expires )" );
+    query.exec( "CREATE INDEX IF NOT EXISTS cache_accessed ON cache( accessed )" );
+
+    query.exec( "SELECT SUM( size ) FROM cache" );
+    if ( query.next() )
+        m_totalSize = query.value( 0 ).toLongLong();
+
+    tDebug() << Q_FUNC_INFO << "Infosystem cache holds" << m_totalSize / 1024 << "KB";
+    return true;
 }
 
 
 void
-InfoSystemCache::pruneTimerFired()
+InfoSystemCache::migrateFileCache()
 {
-    qDebug() << Q_FUNC_INFO << "Pruning infosystemcache";
-    qlonglong currentMSecsSinceEpoch = QDateTime::currentMSecsSinceEpoch();
+    tLog() << Q_FUNC_INFO << "Migrating infosystem cache files to" << m_db.databaseName();
+    const qlonglong currentMSecsSinceEpoch = QDateTime::currentMSecsSinceEpoch();
 
+    int migrated = 0;
+    m_db.transaction();
     for ( int i = InfoNoInfo; i <= InfoLastInfo; i++ )
     {
-        InfoType type = (InfoType)(i);
-        QHash< QString, QString > fileLocationHash = m_fileLocationCache[type];
-        const QString cacheDirName = m_cacheBaseDir + QString::number( (int)type );
-        QFileInfoList fileList = QDir( cacheDirName ).entryInfoList( QDir::Files | QDir::NoDotAndDotDot );
-        foreach ( QFileInfo file, fileList )
+        const QString cacheDirName = m_cacheBaseDir + QString::number( i );
+        const QFileInfoList fileList = QDir( cacheDirName ).entryInfoList( QDir::Files | QDir::NoDotAndDotDot );
+        foreach ( const QFileInfo& file, fileList )
         {
-            QString baseName = file.baseName();
-            if ( file.suffix().toLongLong() < currentMSecsSinceEpoch )
-            {
-                if ( !QFile::remove( file.canonicalFilePath() ) )
-                    tLog() << "Failed to remove stale cache file" << file.canonicalFilePath();
-                else
-                    qDebug() << "Removed stale cache file" << file.canonicalFilePath();
-            }
-            if ( fileLocationHash.contains( baseName ) )
-                fileLocationHash.remove( baseName );
+            // files were named <criteria md5>.<expiry in msecs since epoch>
+            const qlonglong expires = file.suffix().toLongLong();
+            if ( expires < currentMSecsSinceEpoch )
+                continue;
+
+            QSettings cachedSettings( file.absoluteFilePath(), QSettings::IniFormat );
+            storeEntry( (InfoType)i, file.baseName(), expires, serialize( cachedSettings.value( "data" ) ) );
+            migrated++;
         }
-        m_fileLocationCache[type] = fileLocationHash;
+
+        TomahawkUtils::removeDirectory( cacheDirName );
     }
+    m_db.commit();
+
+    tLog() << Q_FUNC_INFO << "Migrated" << migrated << "cache entries";
+    evict();
 }
 
 
 void
-InfoSystemCache::getCachedInfoSlot( Tomahawk::InfoSystem::InfoStringHash criteria, qint64 newMaxAge, Tomahawk::InfoSystem::InfoRequestData requestData )
+InfoSystemCache::pruneTimerFired()
 {
-    QObject* sendingObj = sender();
-    const QString criteriaHashVal = criteriaMd5( criteria );
-    const QString criteriaHashValWithType = criteriaMd5( criteria, requestData.type );
-    QHash< QString, QString > fileLocationHash = m_fileLocationCache[ requestData.type ];
-    if ( !fileLocationHash.contains( criteriaHashVal ) )
-    {
-        if ( !fileLocationHash.isEmpty() )
-        {
-            //We already know of some values, so no need to re-read the directory again as it's already happened
-            //qDebug() << Q_FUNC_INFO << "notInCache -- filelocationhash empty";
-            notInCache( sendingObj, criteria, requestData );
-            return;
-        }
+    qDebug() << Q_FUNC_INFO << "Pruning infosystemcache";
+    if ( !m_db.isOpen() )
+        return;
 
-        const QString cacheDir = m_cacheBaseDir + QString::number( (int)requestData.type );
-        QDir dir( cacheDir );
-        if ( !dir.exists() )
-        {
-            //Dir doesn't exist so clearly not in cache
-            //qDebug() << Q_FUNC_INFO << "notInCache -- dir doesn't exist";
-            notInCache( sendingObj, criteria, requestData );
-            return;
-        }
+    const qlonglong currentMSecsSinceEpoch = QDateTime::currentMSecsSinceEpoch();
 
-        QFileInfoList fileList = dir.entryInfoList( QDir::Files | QDir::NoDotAndDotDot );
-        foreach ( QFileInfo file, fileList )
-        {
-            QString baseName = file.baseName();
-            fileLocationHash[ baseName ] = file.canonicalFilePath();
-        }
+    QSqlQuery query( m_db );
+    query.prepare( "SELECT type, hash, size FROM cache WHERE expires < ?" );
+    query.addBindValue( currentMSecsSinceEpoch );
+    query.exec();
 
-        //Store what we've loaded up
-        m_fileLocationCache[ requestData.type ] = fileLocationHash;
-        if ( !fileLocationHash.contains( criteriaHashVal ) )
-        {
-            //Still didn't find it? It's really not in the cache then
-            //qDebug() << Q_FUNC_INFO << "notInCache -- filelocationhash doesn't contain criteria val";
-            notInCache( sendingObj, criteria, requestData );
-            return;
-        }
+    int removed = 0;
+    while ( query.next() )
+    {
+        m_dataCache.remove( memoryCacheKey( (InfoType)query.value( 0 ).toInt(), query.value( 1 ).toString() ) );
+        m_totalSize -= query.value( 2 ).toLongLong();
+        removed++;
     }
 
-    QFileInfo file( fileLocationHash[ criteriaHashVal ] );
-    qlonglong currMaxAge = file.suffix().toLongLong();
+    if ( !removed )
+        return;
 
-    if ( currMaxAge < QDateTime::currentMSecsSinceEpoch() )
-    {
-        if ( !QFile::remove( file.canonicalFilePath() ) )
-            tLog() << "Failed to remove stale cache file" << file.canonicalFilePath();
-        else
-            qDebug() << "Removed stale cache file" << file.canonicalFilePath();
+    query.prepare( "DELETE FROM cache WHERE expires < ?" );
+    query.addBindValue( currentMSecsSinceEpoch );
+    query.exec();
+
+    qDebug() << Q_FUNC_INFO << "Removed" << removed << "stale cache entries";
+}
 
-        fileLocationHash.remove( criteriaHashVal );
-        m_fileLocationCache[ requestData.type ] = fileLocationHash;
-        m_dataCache.remove( criteriaHashValWithType );
 
-        qDebug() << Q_FUNC_INFO << "notInCache -- file was stale";
-        notInCache( sendingObj, criteria, requestData );
+void
+InfoSystemCache::getCachedInfoSlot( Tomahawk::InfoSystem::InfoStringHash criteria, qint64 newMaxAge, Tomahawk::InfoSystem::InfoRequestData requestData )
+{
+    QObject* sendingObj = sender();
+    if ( !m_db.isOpen() )
+    {
+        emit notInCache( sendingObj, criteria, requestData );
         return;
     }
-    else if ( newMaxAge > 0 )
+
+    const QString criteriaHashVal = criteriaMd5( criteria );
+    const qlonglong currentMSecsSinceEpoch = QDateTime::currentMSecsSinceEpoch();
+    const bool inMemory = m_dataCache.contains( memoryCacheKey( requestData.type, criteriaHashVal ) );
+
+    QSqlQuery query( m_db );
+    query.prepare( inMemory ? "SELECT expires FROM cache WHERE type = ? AND hash = ?"
+                            : "SELECT expires, data FROM cache WHERE type = ? AND hash = ?" );
+    query.addBindValue( (int)requestData.type );
+    query.addBindValue( criteriaHashVal );
+    query.exec();
+
+    if ( !query.next() )
     {
-        const QString newFilePath = QString( file.dir().canonicalPath() + '/' + criteriaHashVal + '.' + QString::number( QDateTime::currentMSecsSinceEpoch() + newMaxAge ) );
+        emit notInCache( sendingObj, criteria, requestData );
+        return;
+    }
 
-        if ( !QFile::rename( file.canonicalFilePath(), newFilePath ) )
-        {
-            qDebug() << Q_FUNC_INFO << "notInCache -- failed to move old cache file to new location";
-            notInCache( sendingObj, criteria, requestData );
-            return;
-        }
+    if ( query.value( 0 ).toLongLong() < currentMSecsSinceEpoch )
+    {
+        removeEntry( requestData.type, criteriaHashVal );
 
-        fileLocationHash[ criteriaHashVal ] = newFilePath;
-        m_fileLocationCache[ requestData.type ] = fileLocationHash;
+        qDebug() << Q_FUNC_INFO << "notInCache -- entry was stale";
+        emit notInCache( sendingObj, criteria, requestData );
+        return;
     }
 
-    if ( !m_dataCache.contains( criteriaHashValWithType ) )
+    QVariant output;
+    if ( inMemory )
+    {
+        output = *m_dataCache.object( memoryCacheKey( requestData.type, criteriaHashVal ) );
+    }
+    else
     {
-        QSettings cachedSettings( fileLocationHash[ criteriaHashVal ], QSettings::IniFormat );
-        QVariant output = cachedSettings.value( "data" );
-        m_dataCache.insert( criteriaHashValWithType, new QVariant( output ) );
+        output = deserialize( query.value( 1 ).toByteArray() );
+        m_dataCache.insert( memoryCacheKey( requestData.type, criteriaHashVal ), new QVariant( output ) );
+    }
 
-        emit info( requestData, output );
+    // remember the access for LRU eviction and extend the entry's life if asked to
+    QSqlQuery update( m_db );
+    if ( newMaxAge > 0 )
+    {
+        update.prepare( "UPDATE cache SET accessed = ?, expires = ? WHERE type = ? AND hash = ?" );
+        update.addBindValue( currentMSecsSinceEpoch );
+        update.addBindValue( currentMSecsSinceEpoch + newMaxAge );
     }
     else
     {
-        emit info( requestData, QVariant( *( m_dataCache[ criteriaHashValWithType ] ) ) );
+        update.prepare( "UPDATE cache SET accessed = ? WHERE type = ? AND hash = ?" );
+        update.addBindValue( currentMSecsSinceEpoch );
     }
+    update.addBindValue( (int)requestData.type );
+    update.addBindValue( criteriaHashVal );
+    update.exec();
+
+    emit info( requestData, output );
 }
 
 
 void
-InfoSystemCache::notInCache( QObject *receiver, Tomahawk::InfoSystem::InfoStringHash criteria, Tomahawk::InfoSystem::InfoRequestData requestData )
+InfoSystemCache::updateCacheSlot( Tomahawk::InfoSystem::InfoStringHash criteria, qint64 maxAge, Tomahawk::InfoSystem::InfoType type, QVariant output )
 {
-    QMetaObject::invokeMethod( receiver, "notInCacheSlot", Q_ARG( Tomahawk::InfoSystem::InfoStringHash, criteria ), Q_ARG( Tomahawk::InfoSystem::InfoRequestData, requestData ) );
+    if ( !m_db.isOpen() )
+        return;
+
+    const QString criteriaHashVal = criteriaMd5( criteria );
+
+    storeEntry( type, criteriaHashVal, QDateTime::currentMSecsSinceEpoch() + maxAge, serialize( output ) );
+    m_dataCache.insert( memoryCacheKey( type, criteriaHashVal ), new QVariant( output ) );
+
+    if ( m_totalSize > m_maxSize )
+        evict();
 }
 
 
 void
-InfoSystemCache::updateCacheSlot( Tomahawk::InfoSystem::InfoStringHash criteria, qint64 maxAge, Tomahawk::InfoSystem::InfoType type, QVariant output )
+InfoSystemCache::storeEntry( Tomahawk::InfoSystem::InfoType type, const QString& hash, qint64 expires, const QByteArray& data )
 {
-    const QString criteriaHashVal = criteriaMd5( criteria );
-    const QString criteriaHashValWithType = criteriaMd5( criteria, type );
-    const QString cacheDir = m_cacheBaseDir + QString::number( (int)type );
-    const QString settingsFilePath( cacheDir + '/' + criteriaHashVal + '.' + QString::number( QDateTime::currentMSecsSinceEpoch() + maxAge ) );
-
-    QHash< QString, QString > fileLocationHash = m_fileLocationCache[ type ];
-    if ( fileLocationHash.contains( criteriaHashVal ) )
+    QSqlQuery query( m_db );
+    query.prepare( "SELECT size FROM cache WHERE type = ? AND hash = ?" );
+    query.addBindValue( (int)type );
+    query.addBindValue( hash );
+    query.exec();
+    if ( query.next() )
+        m_totalSize -= query.value( 0 ).toLongLong();
+
+    query.prepare( "INSERT OR REPLACE INTO cache( type, hash, expires, accessed, size, data ) VALUES ( ?, ?, ?, ?, ?, ? )" );
+    query.addBindValue( (int)type );
+    query.addBindValue( hash );
+    query.addBindValue( expires );
+    query.addBindValue( QDateTime::currentMSecsSinceEpoch() );
+    query.addBindValue( data.size() );
+    query.addBindValue( data );
+    if ( !query.exec() )
     {
-        if ( !QFile::rename( fileLocationHash[ criteriaHashVal ], settingsFilePath ) )
-        {
-            tLog() << "Failed to move old cache file to new location!";
-            return;
-        }
-        fileLocationHash[ criteriaHashVal ] = settingsFilePath;
-        m_fileLocationCache[ type ] = fileLocationHash;
+        tLog() << Q_FUNC_INFO << "Failed to store cache entry:" << query.lastError().text();
+        return;
+    }
+
+    m_totalSize += data.size();
+}
+
 
-        QSettings cachedSettings( fileLocationHash[ criteriaHashVal ], QSettings::IniFormat );
-        cachedSettings.setValue( "data", output );
+void
+InfoSystemCache::removeEntry( Tomahawk::InfoSystem::InfoType type, const QString& hash )
+{
+    QSqlQuery query( m_db );
+    query.prepare( "SELECT size FROM cache WHERE type = ? AND hash = ?" );
+    query.addBindValue( (int)type );
+    query.addBindValue( hash );
+    query.exec();
+    if ( query.next() )
+        m_totalSize -= query.value( 0 ).toLongLong();
+
+    query.prepare( "DELETE FROM cache WHERE type = ? AND hash = ?" );
+    query.addBindValue( (int)type );
+    query.addBindValue( hash );
+    query.exec();
+
+    m_dataCache.remove( memoryCacheKey( type, hash ) );
+}
 
-        m_dataCache.insert( criteriaHashValWithType, new QVariant( output ) );
 
+void
+InfoSystemCache::evict()
+{
+    // trim to 90% of the limit, so we don't have to evict again on the next insert
+    const qint64 target = m_maxSize / 10 * 9;
+    if ( m_totalSize <= target )
         return;
-    }
 
-    QDir dir( cacheDir );
-    if( !dir.exists( cacheDir ) )
+    qint64 accessedBefore = 0;
+    int evicted = 0;
+
+    QSqlQuery query( m_db );
+    query.exec( "SELECT type, hash, size, accessed FROM cache ORDER BY accessed ASC" );
+    while ( m_totalSize > target && query.next() )
     {
-        qDebug() << "Creating cache directory" << cacheDir;
-        if( !dir.mkpath( cacheDir ) )
-        {
-            tLog() << "Failed to create cache dir! Bailing...";
-            return;
-        }
+        m_dataCache.remove( memoryCacheKey( (InfoType)query.value( 0 ).toInt(), query.value( 1 ).toString() ) );
+        m_totalSize -= query.value( 2 ).toLongLong();
+        accessedBefore = query.value( 3 ).toLongLong();
+        evicted++;
     }
+    query.finish();
 
-    QSettings cachedSettings( settingsFilePath, QSettings::IniFormat );
-    QStringList keys = criteria.keys();
-    cachedSettings.beginGroup( "criteria" );
-    for( int i = 0; i < criteria.size(); i++ )
-        cachedSettings.setValue( keys.at( i ), criteria[keys.at( i )] );
-    cachedSettings.endGroup();
-    cachedSettings.setValue( "data", output );
-
-    fileLocationHash[criteriaHashVal] = settingsFilePath;
-    m_fileLocationCache[type] = fileLocationHash;
-    m_dataCache.insert( criteriaHashValWithType, new QVariant( output ) );
+    QSqlQuery del( m_db );
+    del.prepare( "DELETE FROM cache WHERE accessed <= ?" );
+    del.addBindValue( accessedBefore );
+    del.exec();
+
+    // entries sharing the last access time went too
+    del.exec( "SELECT SUM( size ) FROM cache" );
+    if ( del.next() )
+        m_totalSize = del.value( 0 ).toLongLong();
+
+    tDebug() << Q_FUNC_INFO << "Evicted" << evicted << "cache entries, now holding" << m_totalSize / 1024 << "KB";
+}
+
+
+QByteArray
+InfoSystemCache::serialize( const QVariant& output )
+{
+    QByteArray data;
+    QDataStream stream( &data, QIODevice::WriteOnly );
+    stream.setVersion( QDataStream::Qt_4_8 );
+    stream << output;
+
+    return data;
+}
+
+
+QVariant
+InfoSystemCache::deserialize( const QByteArray& data )
+{
+    QVariant output;
+    QDataStream stream( data );
+    stream.setVersion( QDataStream::Qt_4_8 );
+    stream >> output;
+
+    return output;
+}
+
+
+QString
+InfoSystemCache::memoryCacheKey( Tomahawk::InfoSystem::InfoType type, const QString& hash )
+{
+    return QString::number( (int)type ) + '/' + hash;
 }
 
 
@@ -23,6 +23,7 @@
 #include <QCache>
 #include <QDateTime>
 #include <QObject>
+#include <QSqlDatabase>
 #include <QtDebug>
 #include <QTimer>
 
@@ -34,6 +35,14 @@ namespace Tomahawk
 namespace InfoSystem
 {
 
+/**
+ * Persistent cache for InfoSystem results.
+ *
+ * All entries live in a single SQLite file, keyed by info type and the hash of
+ * the request criteria. Expired entries are pruned through an index on their
+ * expiry time, and once the store grows beyond its size limit the least
+ * recently used entries get evicted.
+ */
 class DLLEXPORT InfoSystemCache : public QObject
 {
 Q_OBJECT
@@ -45,6 +54,8 @@ public:
 
 signals:
     void info( Tomahawk::InfoSystem::InfoRequestData requestData, QVariant output );
+    /// receiver is the plugin that asked, the InfoSystemWorker decides when it gets to fetch the data
+    void notInCache( QObject* receiver, Tomahawk::InfoSystem::InfoStringHash criteria, Tomahawk::InfoSystem::InfoRequestData requestData );
 
 public slots:
     void getCachedInfoSlot( Tomahawk::InfoSystem::InfoStringHash criteria, qint64 newMaxAge, Tomahawk::InfoSystem::InfoRequestData requestData );
@@ -61,11 +72,23 @@ private:
      */
     static const int s_infosystemCacheVersion;
 
-    void notInCache( QObject *receiver, Tomahawk::InfoSystem::InfoStringHash criteria, Tomahawk::InfoSystem::InfoRequestData requestData );
     const QString criteriaMd5( const Tomahawk::InfoSystem::InfoStringHash &criteria, Tomahawk::InfoSystem::InfoType type = Tomahawk::InfoSystem::InfoNoInfo ) const;
 
+    bool openStore();
+    /// Imports the entries of the old one-file-per-entry cache
+    void migrateFileCache();
+    void storeEntry( Tomahawk::InfoSystem::InfoType type, const QString& hash, qint64 expires, const QByteArray& data );
+    void removeEntry( Tomahawk::InfoSystem::InfoType type, const QString& hash );
+    void evict();
+
+    static QByteArray serialize( const QVariant& output );
+    static QVariant deserialize( const QByteArray& data );
+    static QString memoryCacheKey( Tomahawk::InfoSystem::InfoType type, const QString& hash );
+
     QString m_cacheBaseDir;
-    QHash< InfoType, QHash< QString, QString > > m_fileLocationCache;
+    QSqlDatabase m_db;
+    qint64 m_totalSize;
+    qint64 m_maxSize;
     QTimer m_pruneTimer;
     QCache< QString, QVariant > m_dataCache;
 };
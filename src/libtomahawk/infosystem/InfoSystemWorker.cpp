@@ -37,6 +37,9 @@
 #include <QNetworkConfiguration>
 #include <QNetworkProxy>
 
+// upper bound for the number of requests handed to a plugin in one notInCacheBatch() call
+#define INFOSYSTEM_MAX_BATCH_SIZE 50
+
 namespace Tomahawk
 {
 
@@ -49,16 +52,17 @@ InfoSystemWorker::InfoSystemWorker()
 {
     tDebug() << Q_FUNC_INFO;
 
-    m_checkTimeoutsTimer.setInterval( 1000 );
-    m_checkTimeoutsTimer.setSingleShot( false );
+    // armed for the next deadline only, see scheduleTimeoutCheck()
+    m_checkTimeoutsTimer.setSingleShot( true );
     connect( &m_checkTimeoutsTimer, SIGNAL( timeout() ), SLOT( checkTimeoutsTimerFired() ) );
-    m_checkTimeoutsTimer.start();
 }
 
 
 InfoSystemWorker::~InfoSystemWorker()
 {
     tDebug() << Q_FUNC_INFO;
+
+    qDeleteAll( m_pluginQueues );
 }
 
 
@@ -155,6 +159,17 @@ InfoSystemWorker::removeInfoPlugin( Tomahawk::InfoSystem::InfoPluginPtr plugin )
 
     m_plugins.removeOne( plugin );
     deregisterInfoTypes( plugin, plugin.data()->supportedGetTypes(), plugin.data()->supportedPushTypes() );
+
+    // nobody is going to answer what's still queued up for this plugin
+    PluginQueue* queue = m_pluginQueues.take( plugin.data() );
+    if ( queue )
+    {
+        delete queue->timer;
+        while ( !queue->requests.isEmpty() )
+            infoSlot( queue->requests.dequeue().second, QVariant() );
+
+        delete queue;
+    }
 }
 
 
@@ -234,6 +249,31 @@ InfoSystemWorker::getInfo( Tomahawk::InfoSystem::InfoRequestData requestData )
     if ( !requestData.allSources )
         providers = QList< InfoPluginPtr >( providers.mid( 0, 1 ) );
 
+    const QString key = requestKey( requestData );
+    if ( !key.isEmpty() && m_requestGroups.contains( key ) )
+    {
+        // the same thing was asked for already, wait for its answers instead of asking the plugins again
+        RequestGroup& group = m_requestGroups[ key ];
+        group.waiters << requestData;
+
+        typedef QPair< InfoRequestData, QVariant > Answer;
+        foreach ( const Answer& answer, group.answers )
+        {
+            InfoRequestData data = answer.first;
+            data.requestId = requestData.requestId;
+            data.caller = requestData.caller;
+            data.customData = requestData.customData;
+            emit info( data, answer.second );
+        }
+
+        m_dataTracker[ requestData.caller ][ requestData.type ] = m_dataTracker[ requestData.caller ][ requestData.type ] + group.unanswered;
+        return;
+    }
+
+    // the original request is always the first one in a group
+    if ( !key.isEmpty() )
+        m_requestGroups[ key ].waiters << requestData;
+
     bool foundOne = false;
     foreach ( InfoPluginPtr ptr, providers )
     {
@@ -254,10 +294,13 @@ InfoSystemWorker::getInfo( Tomahawk::InfoSystem::InfoRequestData requestData )
 
         quint64 requestId = requestData.internalId;
         m_requestSatisfiedMap[ requestId ] = false;
-        if ( requestData.timeoutMillis != 0 )
+        startTimeout( requestData );
+
+        if ( !key.isEmpty() )
         {
-            qint64 currMs = QDateTime::currentMSecsSinceEpoch();
-            m_timeRequestMapper.insert( currMs + requestData.timeoutMillis, requestId );
+            RequestGroup& group = m_requestGroups[ key ];
+            group.unanswered++;
+            m_requestGroupKeys[ requestId ] = key;
         }
     //    qDebug() << "Assigning request with requestId" << requestId << "and type" << requestData.type;
         m_dataTracker[ requestData.caller ][ requestData.type ] = m_dataTracker[ requestData.caller ][ requestData.type ] + 1;
@@ -270,11 +313,13 @@ InfoSystemWorker::getInfo( Tomahawk::InfoSystem::InfoRequestData requestData )
         data->customData = requestData.customData;
         m_savedRequestMap[ requestId ] = data;
 
+        // looking things up in the cache is cheap, only fetching what's missing is rate limited
         QMetaObject::invokeMethod( ptr.data(), "getInfo", Qt::QueuedConnection, Q_ARG( Tomahawk::InfoSystem::InfoRequestData, requestData ) );
     }
 
     if ( !foundOne )
     {
+        m_requestGroups.remove( key );
         emit info( requestData, QVariant() );
         checkFinished( requestData );
     }
@@ -320,6 +365,168 @@ InfoSystemWorker::infoSlot( Tomahawk::InfoSystem::InfoRequestData requestData, Q
     delete m_savedRequestMap[ requestId ];
     m_savedRequestMap.remove( requestId );
     checkFinished( requestData );
+
+    answerWaiters( requestId, requestData, output );
+}
+
+
+void
+InfoSystemWorker::answerWaiters( quint64 requestId, const Tomahawk::InfoSystem::InfoRequestData& requestData, const QVariant& output )
+{
+    if ( !m_requestGroupKeys.contains( requestId ) )
+        return;
+
+    const QString key = m_requestGroupKeys.take( requestId );
+    RequestGroup& group = m_requestGroups[ key ];
+    group.unanswered--;
+
+    // the first waiter is the request that went to the plugins, it has been answered already
+    for ( int i = 1; i < group.waiters.count(); i++ )
+    {
+        const InfoRequestData& waiter = group.waiters.at( i );
+
+        InfoRequestData data = requestData;
+        data.requestId = waiter.requestId;
+        data.caller = waiter.caller;
+        data.customData = waiter.customData;
+        emit info( data, output );
+
+        m_dataTracker[ data.caller ][ data.type ] = m_dataTracker[ data.caller ][ data.type ] - 1;
+        checkFinished( data );
+    }
+
+    if ( group.unanswered > 0 )
+        group.answers << qMakePair( requestData, output );
+    else
+        m_requestGroups.remove( key );
+}
+
+
+QString
+InfoSystemWorker::requestKey( const Tomahawk::InfoSystem::InfoRequestData& requestData )
+{
+    if ( !requestData.input.canConvert< Tomahawk::InfoSystem::InfoStringHash >() )
+        return QString();
+
+    const InfoStringHash criteria = requestData.input.value< Tomahawk::InfoSystem::InfoStringHash >();
+    QStringList keys = criteria.keys();
+    keys.sort();
+
+    QString key = QString( "%1|%2" ).arg( (int)requestData.type ).arg( requestData.allSources ? 1 : 0 );
+    foreach ( const QString& k, keys )
+        key += '|' + k + '=' + criteria.value( k );
+
+    return key;
+}
+
+
+void
+InfoSystemWorker::notInCacheSlot( QObject* receiver, Tomahawk::InfoSystem::InfoStringHash criteria, Tomahawk::InfoSystem::InfoRequestData requestData )
+{
+    // the plugin may have been removed while the cache was looking
+    InfoPluginPtr plugin;
+    foreach ( const InfoPluginPtr& ptr, m_plugins )
+    {
+        if ( ptr.data() == receiver )
+        {
+            plugin = ptr;
+            break;
+        }
+    }
+    if ( plugin.isNull() )
+        return;
+
+    if ( plugin->maxRequestsPerSecond() <= 0 )
+    {
+        QMetaObject::invokeMethod( plugin.data(), "notInCacheSlot", Qt::QueuedConnection,
+                                   Q_ARG( Tomahawk::InfoSystem::InfoStringHash, criteria ), Q_ARG( Tomahawk::InfoSystem::InfoRequestData, requestData ) );
+        return;
+    }
+
+    PluginQueue* queue = m_pluginQueues.value( plugin.data() );
+    if ( !queue )
+    {
+        queue = new PluginQueue;
+        queue->plugin = plugin;
+        queue->timer = new QTimer( this );
+        queue->timer->setInterval( qMax( 1, 1000 / plugin->maxRequestsPerSecond() ) );
+        connect( queue->timer, SIGNAL( timeout() ), SLOT( pluginQueueTimerFired() ) );
+
+        m_pluginQueues.insert( plugin.data(), queue );
+    }
+
+    // waiting for a slot doesn't count against the request's timeout, it starts over once the plugin gets it
+    stopTimeout( requestData.internalId );
+    queue->requests.enqueue( qMakePair( criteria, requestData ) );
+
+    // an idle plugin gets the request right away, otherwise it has to wait for its next slot
+    if ( !queue->timer->isActive() )
+    {
+        drainPluginQueue( plugin.data() );
+        queue->timer->start();
+    }
+}
+
+
+void
+InfoSystemWorker::pluginQueueTimerFired()
+{
+    QHash< InfoPlugin*, PluginQueue* >::const_iterator it = m_pluginQueues.constBegin();
+    for ( ; it != m_pluginQueues.constEnd(); ++it )
+    {
+        if ( it.value()->timer == sender() )
+        {
+            drainPluginQueue( it.key() );
+            return;
+        }
+    }
+}
+
+
+void
+InfoSystemWorker::drainPluginQueue( InfoPlugin* plugin )
+{
+    PluginQueue* queue = m_pluginQueues.value( plugin );
+    if ( !queue )
+        return;
+
+    // requests that got answered in the meantime don't need a slot
+    while ( !queue->requests.isEmpty() && m_requestSatisfiedMap.value( queue->requests.head().second.internalId, true ) )
+        queue->requests.dequeue();
+
+    if ( queue->requests.isEmpty() )
+    {
+        queue->timer->stop();
+        return;
+    }
+
+    const QPair< InfoStringHash, InfoRequestData > request = queue->requests.dequeue();
+    startTimeout( request.second );
+    if ( !plugin->batchedGetTypes().contains( request.second.type ) )
+    {
+        QMetaObject::invokeMethod( plugin, "notInCacheSlot", Qt::QueuedConnection,
+                                   Q_ARG( Tomahawk::InfoSystem::InfoStringHash, request.first ), Q_ARG( Tomahawk::InfoSystem::InfoRequestData, request.second ) );
+        return;
+    }
+
+    // one call for everything of the same type that piled up
+    QList< QPair< InfoStringHash, InfoRequestData > > batch;
+    batch << request;
+
+    QQueue< QPair< InfoStringHash, InfoRequestData > >::iterator it = queue->requests.begin();
+    while ( it != queue->requests.end() && batch.count() < INFOSYSTEM_MAX_BATCH_SIZE )
+    {
+        if ( it->second.type == request.second.type && !m_requestSatisfiedMap.value( it->second.internalId, true ) )
+        {
+            startTimeout( it->second );
+            batch << *it;
+            it = queue->requests.erase( it );
+        }
+        else
+            ++it;
+    }
+
+    plugin->notInCacheBatch( batch );
 }
 
 
@@ -339,56 +546,85 @@ InfoSystemWorker::checkFinished( const Tomahawk::InfoSystem::InfoRequestData &re
 }
 
 
+void
+InfoSystemWorker::startTimeout( const Tomahawk::InfoSystem::InfoRequestData& requestData )
+{
+    if ( requestData.timeoutMillis == 0 )
+        return;
+
+    m_timeRequestMapper.insert( QDateTime::currentMSecsSinceEpoch() + requestData.timeoutMillis, requestData.internalId );
+    scheduleTimeoutCheck();
+}
+
+
+void
+InfoSystemWorker::stopTimeout( quint64 requestId )
+{
+    QMultiMap< qint64, quint64 >::iterator it = m_timeRequestMapper.begin();
+    while ( it != m_timeRequestMapper.end() )
+    {
+        if ( it.value() == requestId )
+            it = m_timeRequestMapper.erase( it );
+        else
+            ++it;
+    }
+
+    scheduleTimeoutCheck();
+}
+
+
+void
+InfoSystemWorker::scheduleTimeoutCheck()
+{
+    if ( m_timeRequestMapper.isEmpty() )
+    {
+        m_checkTimeoutsTimer.stop();
+        return;
+    }
+
+    const qint64 next = m_timeRequestMapper.constBegin().key() - QDateTime::currentMSecsSinceEpoch();
+    m_checkTimeoutsTimer.start( (int)qBound( Q_INT64_C(0), next + 1, Q_INT64_C(3600000) ) );
+}
+
+
 void
 InfoSystemWorker::checkTimeoutsTimerFired()
 {
     qint64 currTime = QDateTime::currentMSecsSinceEpoch();
-    Q_FOREACH( qint64 time, m_timeRequestMapper.keys() )
+
+    // the map is sorted by deadline, so we can stop at the first one that's still in the future
+    while ( !m_timeRequestMapper.isEmpty() && m_timeRequestMapper.constBegin().key() < currTime )
     {
-        Q_FOREACH( quint64 requestId, m_timeRequestMapper.values( time ) )
-        {
-            if ( time < currTime )
-            {
-                if ( m_requestSatisfiedMap[ requestId ] )
-                {
-//                    qDebug() << Q_FUNC_INFO << "Removing mapping of" << requestId << "which expired at time" << time << "and was already satisfied";
-                    m_timeRequestMapper.remove( time, requestId );
-                    if ( !m_timeRequestMapper.count( time ) )
-                        m_timeRequestMapper.remove( time );
-                    continue;
-                }
-
-                //doh, timed out
-//                qDebug() << Q_FUNC_INFO << "Doh, timed out for requestId" << requestId;
-                InfoRequestData *savedData = m_savedRequestMap[ requestId ];
-
-                InfoRequestData returnData;
-                returnData.caller = savedData->caller;
-                returnData.type = savedData->type;
-                returnData.input = savedData->input;
-                returnData.customData = savedData->customData;
-                emit info( returnData, QVariant() );
-
-                delete savedData;
-                m_savedRequestMap.remove( requestId );
-
-                m_dataTracker[ returnData.caller ][ returnData.type ] = m_dataTracker[ returnData.caller ][ returnData.type ] - 1;
-//                qDebug() << "Current count in dataTracker for target" << returnData.caller << "is" << m_dataTracker[ returnData.caller ][ returnData.type ];
-
-                m_requestSatisfiedMap[ requestId ] = true;
-                m_timeRequestMapper.remove( time, requestId );
-                if ( !m_timeRequestMapper.count( time ) )
-                    m_timeRequestMapper.remove( time );
-
-                checkFinished( returnData );
-            }
-            else
-            {
-                //we've caught up, the remaining requets still have time to work
-                return;
-            }
-        }
+        const quint64 requestId = m_timeRequestMapper.constBegin().value();
+        m_timeRequestMapper.erase( m_timeRequestMapper.begin() );
+
+        if ( m_requestSatisfiedMap[ requestId ] )
+            continue;
+
+        //doh, timed out
+//        qDebug() << Q_FUNC_INFO << "Doh, timed out for requestId" << requestId;
+        InfoRequestData *savedData = m_savedRequestMap[ requestId ];
+
+        InfoRequestData returnData;
+        returnData.caller = savedData->caller;
+        returnData.type = savedData->type;
+        returnData.input = savedData->input;
+        returnData.customData = savedData->customData;
+        emit info( returnData, QVariant() );
+
+        delete savedData;
+        m_savedRequestMap.remove( requestId );
+
+        m_dataTracker[ returnData.caller ][ returnData.type ] = m_dataTracker[ returnData.caller ][ returnData.type ] - 1;
+//        qDebug() << "Current count in dataTracker for target" << returnData.caller << "is" << m_dataTracker[ returnData.caller ][ returnData.type ];
+
+        m_requestSatisfiedMap[ requestId ] = true;
+        checkFinished( returnData );
+
+        answerWaiters( requestId, returnData, QVariant() );
     }
+
+    scheduleTimeoutCheck();
 }
 
 
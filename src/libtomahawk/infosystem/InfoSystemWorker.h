@@ -28,6 +28,7 @@
 #include <QtCore/QMap>
 #include <QtCore/QSet>
 #include <QtCore/QList>
+#include <QtCore/QQueue>
 #include <QtCore/QVariant>
 #include <QtCore/QTimer>
 
@@ -65,6 +66,8 @@ public slots:
     void pushInfo( Tomahawk::InfoSystem::InfoPushData pushData );
     
     void infoSlot( Tomahawk::InfoSystem::InfoRequestData requestData, QVariant output );
+    /// The cache did not have what plugin asked for, so the plugin has to fetch it
+    void notInCacheSlot( QObject* plugin, Tomahawk::InfoSystem::InfoStringHash criteria, Tomahawk::InfoSystem::InfoRequestData requestData );
 
     void addInfoPlugin( Tomahawk::InfoSystem::InfoPluginPtr plugin );
     void removeInfoPlugin( Tomahawk::InfoSystem::InfoPluginPtr plugin );
@@ -72,6 +75,7 @@ public slots:
 
 private slots:
     void checkTimeoutsTimerFired();
+    void pluginQueueTimerFired();
 
 private:
     void registerInfoTypes( const InfoPluginPtr &plugin, const QSet< InfoType > &getTypes, const QSet< InfoType > &pushTypes );
@@ -80,6 +84,15 @@ private:
     void checkFinished( const Tomahawk::InfoSystem::InfoRequestData &target );
     QList< InfoPluginPtr > determineOrderedMatches( const InfoType type ) const;
 
+    void drainPluginQueue( InfoPlugin* plugin );
+    void startTimeout( const Tomahawk::InfoSystem::InfoRequestData& requestData );
+    void stopTimeout( quint64 requestId );
+    void scheduleTimeoutCheck();
+
+    /// Identical requests that are in flight at the same time share the same key
+    static QString requestKey( const Tomahawk::InfoSystem::InfoRequestData& requestData );
+    void answerWaiters( quint64 requestId, const Tomahawk::InfoSystem::InfoRequestData& requestData, const QVariant& output );
+
     QHash< QString, QHash< InfoType, int > > m_dataTracker;
     QMultiMap< qint64, quint64 > m_timeRequestMapper;
     QHash< uint, bool > m_requestSatisfiedMap;
@@ -96,6 +109,27 @@ private:
 
     QTimer m_checkTimeoutsTimer;
 
+    // cache misses waiting for a plugin with a rate limit to fetch them
+    struct PluginQueue
+    {
+        InfoPluginPtr plugin;
+        QQueue< QPair< InfoStringHash, InfoRequestData > > requests;
+        QTimer* timer;
+    };
+    QHash< InfoPlugin*, PluginQueue* > m_pluginQueues;
+
+    // callers that asked for something already in flight, they get a copy of each answer
+    struct RequestGroup
+    {
+        RequestGroup() : unanswered( 0 ) {}
+
+        int unanswered;
+        QList< InfoRequestData > waiters;
+        QList< QPair< InfoRequestData, QVariant > > answers;
+    };
+    QHash< QString, RequestGroup > m_requestGroups;
+    QHash< quint64, QString > m_requestGroupKeys;
+
     quint64 m_shortLinksWaiting;
 };
 
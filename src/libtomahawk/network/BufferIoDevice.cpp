@@ -114,16 +114,16 @@ BufferIODevice::isSequential() const
 
 
 void
-BufferIODevice::addData( int block, const QByteArray& ba )
+BufferIODevice::addData( int block, const MsgBuffer& data )
 {
     Q_D( BufferIODevice );
     {
         QMutexLocker lock( &d->mut );
 
         while ( d->buffer.count() <= block )
-            d->buffer << QByteArray();
+            d->buffer << MsgBuffer();
 
-        d->buffer.replace( block, ba );
+        d->buffer.replace( block, data );
     }
 
     // If this was the last block of the transfer, check if we need to fill up gaps
@@ -135,8 +135,8 @@ BufferIODevice::addData( int block, const QByteArray& ba )
         }
     }
 
-    d->received += ba.count();
-    emit bytesWritten( ba.count() );
+    d->received += data.length();
+    emit bytesWritten( data.length() );
     emit readyRead();
 }
 
@@ -159,14 +159,11 @@ BufferIODevice::readData( char* data, qint64 maxSize )
     if ( atEnd() )
         return 0;
 
-    QByteArray ba;
-    ba.append( getData( d->pos, maxSize ) );
-    d->pos += ba.count();
+    const qint64 read = getData( data, d->pos, maxSize );
+    d->pos += read;
 
-//    qDebug() << Q_FUNC_INFO << maxSize << ba.count() << 2;
-    memcpy( data, ba.data(), ba.count() );
-
-    return ba.count();
+//    qDebug() << Q_FUNC_INFO << maxSize << read << 2;
+    return read;
 }
 
 
@@ -260,9 +257,9 @@ BufferIODevice::nextEmptyBlock() const
     Q_D( const BufferIODevice );
 
     int i = 0;
-    foreach( const QByteArray& ba, d->buffer )
+    foreach( const MsgBuffer& data, d->buffer )
     {
-        if ( ba.isEmpty() )
+        if ( data.isEmpty() )
             return i;
 
         i++;
@@ -300,17 +297,18 @@ BufferIODevice::isBlockEmpty( int block ) const
 }
 
 
-QByteArray
-BufferIODevice::getData( qint64 pos, qint64 size )
+qint64
+BufferIODevice::getData( char* data, qint64 pos, qint64 size )
 {
     Q_D( BufferIODevice );
 //    qDebug() << Q_FUNC_INFO << pos << size << 1;
-    QByteArray ba;
+    qint64 copied = 0;
     int block = blockForPos( pos );
     int offset = offsetForPos( pos );
 
+    // copy straight from the blocks into the reader's buffer
     QMutexLocker lock( &d->mut );
-    while( ba.count() < size )
+    while( copied < size )
     {
         if ( block > maxBlocks() )
             break;
@@ -318,9 +316,16 @@ BufferIODevice::getData( qint64 pos, qint64 size )
         if ( isBlockEmpty( block ) )
             break;
 
-        ba.append( d->buffer.at( block++ ).mid( offset ) );
+        const MsgBuffer& buffer = d->buffer.at( block++ );
+        const qint64 len = qMin( size - copied, (qint64)( buffer.length() - offset ) );
+        if ( len <= 0 )
+            break;
+
+        memcpy( data + copied, buffer.constData() + offset, len );
+        copied += len;
+        offset = 0;
     }
 
 //    qDebug() << Q_FUNC_INFO << pos << size << 2;
-    return ba.left( size );
+    return copied;
 }
@@ -20,11 +20,14 @@
 #ifndef BUFFERIODEVICE_H
 #define BUFFERIODEVICE_H
 
+#include "DllMacro.h"
+#include "MsgBuffer.h"
+
 #include <QIODevice>
 
 class BufferIODevicePrivate;
 
-class BufferIODevice : public QIODevice
+class DLLEXPORT BufferIODevice : public QIODevice
 {
 Q_OBJECT
 
@@ -43,7 +46,7 @@ public:
     virtual bool atEnd() const;
     virtual qint64 pos() const;
 
-    void addData( int block, const QByteArray& ba );
+    void addData( int block, const MsgBuffer& data );
     void clear();
 
     OpenMode openMode() const;
@@ -68,7 +71,7 @@ protected:
 private:
     int blockForPos( qint64 pos ) const;
     int offsetForPos( qint64 pos ) const;
-    QByteArray getData( qint64 pos, qint64 size );
+    qint64 getData( char* data, qint64 pos, qint64 size );
 
     Q_DECLARE_PRIVATE( BufferIODevice )
     BufferIODevicePrivate* d_ptr;
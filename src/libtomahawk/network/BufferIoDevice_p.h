@@ -39,7 +39,8 @@ public:
     Q_DECLARE_PUBLIC ( BufferIODevice )
 
 private:
-    QList<QByteArray> buffer;
+    // blocks are slices of the msgs they arrived in
+    QList<MsgBuffer> buffer;
     mutable QMutex mut;
     unsigned int size;
     unsigned int received;
@@ -36,6 +36,11 @@
 
 #define PROTOVER "4" // must match remote peer, or we can't talk.
 
+// flush queued outgoing msgs right away once this many bytes are waiting
+#define CONNECTION_WRITE_BUFFER 64 * 1024
+// max number of msgs we read per wakeup, so a busy peer can't starve the event loop
+#define CONNECTION_READ_BUDGET 512
+
 
 Connection::Connection( Servent* parent )
     : QObject()
@@ -206,6 +211,11 @@ Connection::actualShutdown()
 
     if ( !d->sock.isNull() && d->sock->isOpen() )
     {
+        // hand over whatever is still buffered, disconnectFromHost waits for it
+        if ( !d->writeBuffer.isEmpty() && d->sock->isWritable() )
+            d->sock->write( d->writeBuffer );
+        d->writeBuffer.clear();
+
         d->sock->disconnectFromHost();
     }
 
@@ -542,40 +552,47 @@ Connection::readyRead()
 //    qDebug() << "readyRead, bytesavail:" << m_sock->bytesAvailable();
     Q_D( Connection );
 
-    if ( d->msg.isNull() )
+    // drain every complete msg we already have, up to our budget
+    for ( int i = 0; i < CONNECTION_READ_BUDGET; i++ )
     {
-        if ( d->sock->bytesAvailable() < Msg::headerSize() )
+        if ( d->sock.isNull() || d->actually_shutting_down )
             return;
 
-        char msgheader[ Msg::headerSize() ];
-        if ( d->sock->read( (char*) &msgheader, Msg::headerSize() ) != Msg::headerSize() )
+        if ( d->msg.isNull() )
         {
-            tDebug() << "Failed reading msg header";
-            this->markAsFailed();
-            return;
+            if ( d->sock->bytesAvailable() < Msg::headerSize() )
+                return;
+
+            char msgheader[ Msg::headerSize() ];
+            if ( d->sock->read( (char*) &msgheader, Msg::headerSize() ) != Msg::headerSize() )
+            {
+                tDebug() << "Failed reading msg header";
+                this->markAsFailed();
+                return;
+            }
+
+            d->msg = Msg::begin( (char*) &msgheader );
+            d->rx_bytes += Msg::headerSize();
         }
 
-        d->msg = Msg::begin( (char*) &msgheader );
-        d->rx_bytes += Msg::headerSize();
-    }
+        if ( d->sock->bytesAvailable() < d->msg->length() )
+            return;
 
-    if ( d->sock->bytesAvailable() < d->msg->length() )
-        return;
+        QByteArray ba = d->sock->read( d->msg->length() );
+        if ( ba.length() != (qint32)d->msg->length() )
+        {
+            tDebug() << "Failed to read full msg payload";
+            this->markAsFailed();
+            return;
+        }
+        d->msg->fill( ba );
+        d->rx_bytes += ba.length();
 
-    QByteArray ba = d->sock->read( d->msg->length() );
-    if ( ba.length() != (qint32)d->msg->length() )
-    {
-        tDebug() << "Failed to read full msg payload";
-        this->markAsFailed();
-        return;
+        handleReadMsg(); // process m_msg and clear() it
     }
-    d->msg->fill( ba );
-    d->rx_bytes += ba.length();
-
-    handleReadMsg(); // process m_msg and clear() it
 
-    // since there is no explicit threading, use the event loop to schedule this:
-    if ( d->sock->bytesAvailable() )
+    // budget used up, since there is no explicit threading use the event loop to schedule the rest:
+    if ( !d->sock.isNull() && d->sock->bytesAvailable() )
     {
         QTimer::singleShot( 0, this, SLOT( readyRead() ) );
     }
@@ -666,9 +683,45 @@ Connection::sendMsg_now( msg_ptr msg )
         return;
     }
 
-    if ( !msg->write( d->sock.data() ) )
+    // msgs tend to come out of the processor in bursts, frame them into one buffer
+    // and write them with a single call once the burst is over
+    msg->appendTo( d->writeBuffer );
+
+    if ( d->writeBuffer.length() >= CONNECTION_WRITE_BUFFER )
+    {
+        flushWriteBuffer();
+    }
+    else if ( !d->flushScheduled )
+    {
+        d->flushScheduled = true;
+        QMetaObject::invokeMethod( this, "flushWriteBuffer", Qt::QueuedConnection );
+    }
+}
+
+
+void
+Connection::flushWriteBuffer()
+{
+    Q_D( Connection );
+    d->flushScheduled = false;
+
+    if ( d->writeBuffer.isEmpty() || d->actually_shutting_down )
+        return;
+
+    if ( d->sock.isNull() || !d->sock->isOpen() || !d->sock->isWritable() )
+    {
+        tDebug() << "***** Socket problem, whilst in flushWriteBuffer(). Cleaning up. *****";
+        d->writeBuffer.clear();
+        shutdown( false );
+        return;
+    }
+
+    const QByteArray buffer = d->writeBuffer;
+    d->writeBuffer.clear();
+
+    if ( d->sock->write( buffer ) != buffer.length() )
     {
-        //qDebug() << "Error writing to socket in sendMsg() *************";
+        //qDebug() << "Error writing to socket in flushWriteBuffer() *************";
         shutdown( false );
         return;
     }
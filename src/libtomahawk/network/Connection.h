@@ -129,6 +129,7 @@ public slots:
 private slots:
     void handleIncomingQueueEmpty();
     void sendMsg_now( msg_ptr );
+    void flushWriteBuffer();
     void socketDisconnected();
     void socketDisconnectedError( QAbstractSocket::SocketError );
     void readyRead();
@@ -45,6 +45,7 @@ public:
         , tx_bytes( 0 )
         , tx_bytes_requested( 0 )
         , rx_bytes( 0 )
+        , flushScheduled( false )
         , id( "Connection()" )
         , peerport( 0 )
         , statstimer( 0 )
@@ -72,6 +73,11 @@ private:
     qint64 tx_bytes;
     qint64 tx_bytes_requested;
     qint64 rx_bytes;
+
+    // framed outgoing msgs, written to the socket in one go
+    QByteArray writeBuffer;
+    bool flushScheduled;
+
     QString id;
     QString name;
     QString nodeid;
@@ -71,12 +71,24 @@ bool
 Msg::write( QIODevice * device )
 {
     Q_D( Msg );
+    QByteArray frame;
+    frame.reserve( headerSize() + d->length );
+    appendTo( frame );
+
+    return device->write( frame ) == frame.length();
+}
+
+
+void
+Msg::appendTo( QByteArray& buffer ) const
+{
+    Q_D( const Msg );
     quint32 size  = qToBigEndian( d->length );
     quint8  flags = d->flags;
-    if( device->write( (const char*) &size,  sizeof(quint32) ) != sizeof(quint32) ) return false;
-    if( device->write( (const char*) &flags, sizeof(quint8) )  != sizeof(quint8)  ) return false;
-    if( device->write( (const char*) d->payload.data(), d->length ) != d->length ) return false;
-    return true;
+
+    buffer.append( (const char*) &size, sizeof(quint32) );
+    buffer.append( (const char*) &flags, sizeof(quint8) );
+    buffer.append( d->payload.constData(), d->length );
 }
 
 
@@ -114,6 +126,15 @@ Msg::payload() const
 }
 
 
+MsgBuffer
+Msg::buffer() const
+{
+    Q_D( const Msg );
+    Q_ASSERT( d->incomplete == false );
+    return MsgBuffer( d->payload );
+}
+
+
 QVariant&
 Msg::json()
 {
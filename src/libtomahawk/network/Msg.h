@@ -32,6 +32,8 @@
 #define MSG_H
 
 #include "Typedefs.h"
+#include "DllMacro.h"
+#include "MsgBuffer.h"
 
 #include <QSharedPointer>
 
@@ -39,7 +41,7 @@ class MsgPrivate;
 class QByteArray;
 class QIODevice;
 
-class Msg
+class DLLEXPORT Msg
 {
     friend class MsgProcessor;
 
@@ -78,6 +80,11 @@ public:
      */
     bool write( QIODevice * device );
 
+    /**
+     * appends the framed msg to buffer, so many msgs can go out in one write
+     */
+    void appendTo( QByteArray& buffer ) const;
+
     // len(4) + flags(1)
     static quint8 headerSize();
 
@@ -87,6 +94,11 @@ public:
 
     const QByteArray& payload() const;
 
+    /**
+     * the payload as a buffer that can be sliced without copying it
+     */
+    MsgBuffer buffer() const;
+
     QVariant& json();
 
     char flags() const;
@@ -0,0 +1,85 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MSGBUFFER_H
+#define MSGBUFFER_H
+
+#include <QByteArray>
+
+#include <string.h>
+
+/**
+ * A range of bytes within a QByteArray. The data stays implicitly shared with
+ * the array it was sliced from, so stripping a header off a msg payload or
+ * passing a block of audio data on never copies it.
+ */
+class MsgBuffer
+{
+public:
+    MsgBuffer()
+        : m_offset( 0 )
+        , m_length( 0 )
+    {
+    }
+
+    MsgBuffer( const QByteArray& data )
+        : m_data( data )
+        , m_offset( 0 )
+        , m_length( data.length() )
+    {
+    }
+
+    /// length bytes starting at pos, or everything from pos on if length is negative
+    MsgBuffer mid( int pos, int length = -1 ) const
+    {
+        MsgBuffer slice;
+        pos = qBound( 0, pos, m_length );
+        slice.m_data = m_data;
+        slice.m_offset = m_offset + pos;
+        slice.m_length = ( length < 0 || pos + length > m_length ) ? m_length - pos : length;
+        return slice;
+    }
+
+    bool startsWith( const char* prefix ) const
+    {
+        const int len = qstrlen( prefix );
+        return len <= m_length && memcmp( constData(), prefix, len ) == 0;
+    }
+
+    bool isEmpty() const { return m_length == 0; }
+    int length() const { return m_length; }
+    const char* constData() const { return m_data.constData() + m_offset; }
+
+    /// Only copies the bytes if we don't span the whole array anyway
+    QByteArray toByteArray() const
+    {
+        if ( m_offset == 0 && m_length == m_data.length() )
+            return m_data;
+
+        return QByteArray( constData(), m_length );
+    }
+
+private:
+    QByteArray m_data;
+    int m_offset;
+    int m_length;
+};
+
+Q_DECLARE_TYPEINFO( MsgBuffer, Q_MOVABLE_TYPE );
+
+#endif // MSGBUFFER_H
@@ -29,6 +29,10 @@
 #include <QFutureWatcher>
 #include <qtconcurrentrun.h>
 
+// zlib level for msgs above the threshold, dbsync msgs are compressed on the
+// hot path of every sync, so we trade a few percent of size for speed here
+#define MSGPROCESSOR_COMPRESSION_LEVEL 1
+
 MsgProcessor::MsgProcessor( quint32 mode, quint32 t ) :
     QObject(), m_mode( mode ), m_threshold( t ), m_totmsgsize( 0 )
 {
@@ -135,7 +139,7 @@ MsgProcessor::process( msg_ptr msg, quint32 mode, quint32 threshold )
         && msg->length() > threshold )
     {
 //        qDebug() << "MsgProcessor::COMPRESSING";
-        msg->d_func()->payload = qCompress( msg->payload(), 9 );
+        msg->d_func()->payload = qCompress( msg->payload(), MSGPROCESSOR_COMPRESSION_LEVEL );
         msg->d_func()->length  = msg->d_func()->payload.length();
         msg->d_func()->flags |= Msg::COMPRESSED;
     }
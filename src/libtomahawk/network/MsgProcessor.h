@@ -31,11 +31,12 @@
 #define MSGPROCESSOR_H
 
 #include "Typedefs.h"
+#include "DllMacro.h"
 #include "Msg.h" // Needed because we have msg_ptr in a slot
 
 #include <QObject>
 
-class MsgProcessor : public QObject
+class DLLEXPORT MsgProcessor : public QObject
 {
 Q_OBJECT
 public:
@@ -241,8 +241,10 @@ StreamConnection::handleMsg( msg_ptr msg )
     }
     else if ( msg->payload().startsWith( "data" ) )
     {
-        m_badded += msg->payload().length() - 4;
-        ( (BufferIODevice*)m_iodev.data() )->addData( m_curBlock++, msg->payload().mid( 4 ) );
+        // strip the header by offset, the block keeps sharing the msg's payload
+        const MsgBuffer data = msg->buffer().mid( 4 );
+        m_badded += data.length();
+        ( (BufferIODevice*)m_iodev.data() )->addData( m_curBlock++, data );
     }
 
     //qDebug() << Q_FUNC_INFO << "flags" << (int) msg->flags()
@@ -274,8 +276,11 @@ StreamConnection::sendSome()
 {
     Q_ASSERT( m_type == StreamConnection::SENDING );
 
-    QByteArray ba = "data";
-    ba.append( m_readdev->read( BufferIODevice::blockSize() ) );
+    // read the block right behind the header instead of appending a copy of it
+    QByteArray ba( 4 + BufferIODevice::blockSize(), Qt::Uninitialized );
+    memcpy( ba.data(), "data", 4 );
+    const qint64 read = m_readdev->read( ba.data() + 4, BufferIODevice::blockSize() );
+    ba.resize( 4 + qMax( Q_INT64_C( 0 ), read ) );
     m_bsent += ba.length() - 4;
 
     if ( m_readdev->atEnd() )
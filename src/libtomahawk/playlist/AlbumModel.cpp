@@ -140,7 +140,7 @@ AlbumModel::addAlbums( const QList<Tomahawk::album_ptr>& albums )
         PlayableItem* albumitem = new PlayableItem( album, rootItem() );
         albumitem->index = createIndex( rootItem()->children.count() - 1, 0, albumitem );
 
-        connect( albumitem, SIGNAL( dataChanged() ), SLOT( onDataChanged() ) );
+        subscribe( albumitem );
     }
 
     emit endInsertRows();
@@ -185,7 +185,7 @@ AlbumModel::addArtists( const QList<Tomahawk::artist_ptr>& artists )
         PlayableItem* albumitem = new PlayableItem( artist, rootItem() );
         albumitem->index = createIndex( rootItem()->children.count() - 1, 0, albumitem );
 
-        connect( albumitem, SIGNAL( dataChanged() ), SLOT( onDataChanged() ) );
+        subscribe( albumitem );
     }
 
     emit endInsertRows();
@@ -213,7 +213,7 @@ AlbumModel::addQueries( const QList<Tomahawk::query_ptr>& queries )
         PlayableItem* albumitem = new PlayableItem( query, rootItem() );
         albumitem->index = createIndex( rootItem()->children.count() - 1, 0, albumitem );
 
-        connect( albumitem, SIGNAL( dataChanged() ), SLOT( onDataChanged() ) );
+        subscribe( albumitem );
     }
 
     emit endInsertRows();
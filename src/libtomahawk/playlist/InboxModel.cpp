@@ -139,7 +139,7 @@ InboxModel::insertEntries( const QList< Tomahawk::plentry_ptr >& entries, int /*
 
                 PlayableItem* item = new PlayableItem( sa.source, rootItem() );
                 item->index = createIndex( rootItem()->children.count() - 1, 0, item );
-                connect( item, SIGNAL( dataChanged() ), SLOT( onDataChanged() ) );
+                subscribe( item );
 
                 emit endInsertRows();
                 parent = item->index;
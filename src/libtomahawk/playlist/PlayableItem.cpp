@@ -18,6 +18,8 @@
 
 #include "PlayableItem.h"
 
+#include "PlayableModel.h"
+
 #include "utils/Logger.h"
 #include "utils/TomahawkUtils.h"
 
@@ -39,6 +41,10 @@ PlayableItem::~PlayableItem()
     for ( int i = children.count() - 1; i >= 0; i-- )
         delete children.at( i );
 
+    PlayableModel* m = model();
+    if ( m )
+        m->unsubscribe( this );
+
     if ( m_parent && index.isValid() )
     {
         m_parent->children.removeAt( index.row() );
@@ -47,49 +53,38 @@ PlayableItem::~PlayableItem()
 
 
 PlayableItem::PlayableItem( PlayableItem* parent )
-    : QObject( parent )
-    , m_parent( parent )
+    : m_parent( parent )
 {
     init();
 }
 
 
 PlayableItem::PlayableItem( const Tomahawk::album_ptr& album, PlayableItem* parent, int row )
-    : QObject( parent )
-    , m_album( album )
+    : m_album( album )
     , m_parent( parent )
 {
     init( row );
-
-    connect( album.data(), SIGNAL( updated() ), SIGNAL( dataChanged() ) );
 }
 
 
 PlayableItem::PlayableItem( const Tomahawk::artist_ptr& artist, PlayableItem* parent, int row )
-    : QObject( parent )
-    , m_artist( artist )
+    : m_artist( artist )
     , m_parent( parent )
 {
     init( row );
-
-    connect( artist.data(), SIGNAL( updated() ), SIGNAL( dataChanged() ) );
 }
 
 
 PlayableItem::PlayableItem( const Tomahawk::result_ptr& result, PlayableItem* parent, int row )
-    : QObject( parent )
-    , m_result( result )
+    : m_result( result )
     , m_parent( parent )
 {
     init( row );
-
-    connect( result.data(), SIGNAL( updated() ), SIGNAL( dataChanged() ) );
 }
 
 
 PlayableItem::PlayableItem( const Tomahawk::query_ptr& query, PlayableItem* parent, int row )
-    : QObject( parent )
-    , m_query( query )
+    : m_query( query )
     , m_parent( parent )
 {
     init( row );
@@ -97,8 +92,7 @@ PlayableItem::PlayableItem( const Tomahawk::query_ptr& query, PlayableItem* pare
 
 
 PlayableItem::PlayableItem( const Tomahawk::plentry_ptr& entry, PlayableItem* parent, int row )
-    : QObject( parent )
-    , m_entry( entry )
+    : m_entry( entry )
     , m_query( entry->query() )
     , m_parent( parent )
 {
@@ -107,8 +101,7 @@ PlayableItem::PlayableItem( const Tomahawk::plentry_ptr& entry, PlayableItem* pa
 
 
 PlayableItem::PlayableItem( const Tomahawk::source_ptr& source, PlayableItem* parent, int row )
-    : QObject( parent )
-    , m_source( source )
+    : m_source( source )
     , m_parent( parent )
 {
     init( row );
@@ -118,24 +111,6 @@ PlayableItem::PlayableItem( const Tomahawk::source_ptr& source, PlayableItem* pa
 void
 PlayableItem::init( int row )
 {
-    track_ptr track;
-    if ( m_query )
-    {
-        connect( m_query.data(), SIGNAL( resultsChanged() ), SLOT( onResultsChanged() ) );
-        track = m_query->track();
-    }
-    else if ( m_result )
-    {
-        track = m_result->track();
-    }
-
-    if ( track )
-    {
-        connect( track.data(), SIGNAL( socialActionsLoaded() ), SIGNAL( dataChanged() ) );
-        connect( track.data(), SIGNAL( attributesLoaded() ), SIGNAL( dataChanged() ) );
-        connect( track.data(), SIGNAL( updated() ), SIGNAL( dataChanged() ) );
-    }
-
     if ( m_parent )
     {
         if ( row < 0 )
@@ -150,23 +125,38 @@ PlayableItem::init( int row )
 
     if ( m_query )
     {
-        onResultsChanged();
+        updateResult();
     }
 }
 
 
 void
-PlayableItem::onResultsChanged()
+PlayableItem::updateResult()
 {
     if ( m_query && !m_query->results().isEmpty() )
-    {
         m_result = m_query->results().first();
-        connect( m_result.data(), SIGNAL( updated() ), SIGNAL( dataChanged() ), Qt::UniqueConnection );
-    }
     else
         m_result = result_ptr();
+}
+
 
-    emit dataChanged();
+PlayableModel*
+PlayableItem::model() const
+{
+    const PlayableItem* item = this;
+    while ( item->m_parent )
+        item = item->m_parent;
+
+    return item->m_model;
+}
+
+
+void
+PlayableItem::requestRepaint()
+{
+    PlayableModel* m = model();
+    if ( m )
+        m->itemChanged( this );
 }
 
 
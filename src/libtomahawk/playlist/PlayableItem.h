@@ -28,10 +28,15 @@
 #include "Typedefs.h"
 #include "DllMacro.h"
 
-class DLLEXPORT PlayableItem : public QObject
-{
-Q_OBJECT
+class PlayableModel;
 
+/**
+ * A row of a PlayableModel. Rows are plain objects, the model subscribes to
+ * the artists, albums, queries and results they show and repaints the affected
+ * rows in batches.
+ */
+class DLLEXPORT PlayableItem
+{
 public:
     ~PlayableItem();
 
@@ -54,13 +59,17 @@ public:
     void setPlaybackLog( const Tomahawk::PlaybackLog& log );
 
     PlayableItem* parent() const { return m_parent; }
-    void forceUpdate() { emit dataChanged(); }
+    void forceUpdate() { requestRepaint(); }
+
+    /// The model this item belongs to, only known once it is part of a model's tree
+    PlayableModel* model() const;
+    void setModel( PlayableModel* model ) { m_model = model; }
 
     bool isPlaying() const { return m_isPlaying; }
-    void setIsPlaying( bool b ) { m_isPlaying = b; emit dataChanged(); }
+    void setIsPlaying( bool b ) { m_isPlaying = b; requestRepaint(); }
     bool fetchingMore() const { return m_fetchingMore; }
     void setFetchingMore( bool b ) { m_fetchingMore = b; }
-    void requestRepaint() { emit dataChanged(); }
+    void requestRepaint();
 
     QString name() const;
     QString artistName() const;
@@ -70,14 +79,9 @@ public:
 
     QPersistentModelIndex index;
 
-signals:
-    void dataChanged();
-
-private slots:
-    void onResultsChanged();
-
 private:
     void init( int row = -1 );
+    void updateResult();
 
     Tomahawk::artist_ptr m_artist;
     Tomahawk::album_ptr m_album;
@@ -87,10 +91,13 @@ private:
     Tomahawk::source_ptr m_source;
 
     PlayableItem* m_parent;
+    PlayableModel* m_model = 0;
     bool m_fetchingMore = false;
     bool m_isPlaying = false;
 
     Tomahawk::PlaybackLog m_playbackLog;
+
+    friend class PlayableModel;
 };
 
 #endif // PLAYABLEITEM_H
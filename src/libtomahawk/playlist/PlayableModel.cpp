@@ -21,6 +21,9 @@
 #include "PlayableModel_p.h"
 
 #include "audio/AudioEngine.h"
+#include "database/DatabaseCommand_AllAlbums.h"
+#include "database/DatabaseCommand_AllArtists.h"
+#include "database/DatabaseCommand_AllTracks.h"
 #include "utils/TomahawkUtils.h"
 #include "utils/Logger.h"
 
@@ -31,12 +34,16 @@
 #include "PlayableProxyModel.h"
 #include "Result.h"
 #include "Source.h"
+#include "Track.h"
 #include "Typedefs.h"
 
 #include <QDateTime>
 #include <QMimeData>
 #include <QTreeView>
 
+// rows fetched per page when paging through a database collection
+#define PLAYABLEMODEL_PAGE_SIZE 500
+
 using namespace Tomahawk;
 
 
@@ -44,6 +51,8 @@ void
 PlayableModel::init()
 {
     Q_D( PlayableModel );
+    d->rootItem->setModel( this );
+
     connect( AudioEngine::instance(), SIGNAL( started( Tomahawk::result_ptr ) ), SLOT( onPlaybackStarted( Tomahawk::result_ptr ) ), Qt::DirectConnection );
     connect( AudioEngine::instance(), SIGNAL( stopped() ), SLOT( onPlaybackStopped() ), Qt::DirectConnection );
 
@@ -74,6 +83,9 @@ PlayableModel::~PlayableModel()
 {
     Q_D( PlayableModel );
     tDebug() << Q_FUNC_INFO;
+
+    // no need to unsubscribe every single item
+    d->rootItem->setModel( 0 );
     delete d->rootItem;
 }
 
@@ -640,14 +652,23 @@ PlayableModel::clear()
     Q_D( PlayableModel );
     setCurrentIndex( QModelIndex() );
 
+    d->pagedCollection.clear();
+    d->pagedType = NotPaged;
+    d->pageRequest = 0;
+    d->morePages = false;
+
     if ( rowCount( QModelIndex() ) )
     {
         finishLoading();
 
         emit beginResetModel();
+        d->rootItem->setModel( 0 );
         delete d->rootItem;
         d->rootItem = 0;
+        d->subscribers.clear();
+        d->changedItems.clear();
         d->rootItem = new PlayableItem( 0 );
+        d->rootItem->setModel( this );
         emit endResetModel();
     }
 }
@@ -696,22 +717,6 @@ PlayableModel::insertInternal( const QList< T >& items, int row, const QList< To
         PlayableItem* plitem = new PlayableItem( item, pItem, row + i );
         plitem->index = createIndex( row + i, 0, plitem );
 
-        if ( plitem->query() )
-        {
-            if ( !plitem->query()->playable() )
-            {
-                connect( plitem->query().data(), SIGNAL( playableStateChanged( bool ) ),
-                         SLOT( onQueryBecamePlayable( bool ) ),
-                         Qt::UniqueConnection );
-            }
-            if ( !plitem->query()->resolvingFinished() )
-            {
-                connect( plitem->query().data(), SIGNAL( resolvingFinished( bool ) ),
-                         SLOT( onQueryResolved( bool ) ),
-                         Qt::UniqueConnection );
-            }
-        }
-
         if ( logs.count() > i )
             plitem->setPlaybackLog( logs.at( i ) );
 
@@ -720,7 +725,7 @@ PlayableModel::insertInternal( const QList< T >& items, int row, const QList< To
 /*        if ( item->id() == currentItemUuid() )
             setCurrentItem( plitem->index );*/
 
-        connect( plitem, SIGNAL( dataChanged() ), SLOT( onDataChanged() ) );
+        subscribe( plitem );
     }
 
     emit endInsertRows();
@@ -931,11 +936,180 @@ PlayableModel::scoreText( float score ) const
 
 
 void
-PlayableModel::onDataChanged()
+PlayableModel::subscribe( PlayableItem* item )
+{
+    if ( item->artist() && addSubscriber( item->artist().data(), item ) )
+        connect( item->artist().data(), SIGNAL( updated() ), SLOT( onItemSourceChanged() ), Qt::UniqueConnection );
+
+    if ( item->album() && addSubscriber( item->album().data(), item ) )
+        connect( item->album().data(), SIGNAL( updated() ), SLOT( onItemSourceChanged() ), Qt::UniqueConnection );
+
+    if ( item->m_result && addSubscriber( item->m_result.data(), item ) )
+        connect( item->m_result.data(), SIGNAL( updated() ), SLOT( onItemSourceChanged() ), Qt::UniqueConnection );
+
+    track_ptr track;
+    if ( item->query() )
+        track = item->query()->track();
+    else if ( item->m_result )
+        track = item->m_result->track();
+
+    if ( track && addSubscriber( track.data(), item ) )
+    {
+        connect( track.data(), SIGNAL( socialActionsLoaded() ), SLOT( onItemSourceChanged() ), Qt::UniqueConnection );
+        connect( track.data(), SIGNAL( attributesLoaded() ), SLOT( onItemSourceChanged() ), Qt::UniqueConnection );
+        connect( track.data(), SIGNAL( updated() ), SLOT( onItemSourceChanged() ), Qt::UniqueConnection );
+    }
+
+    const query_ptr& query = item->query();
+    if ( query && addSubscriber( query.data(), item ) )
+    {
+        connect( query.data(), SIGNAL( resultsChanged() ), SLOT( onQueryResultsChanged() ), Qt::UniqueConnection );
+
+        if ( !query->playable() )
+        {
+            connect( query.data(), SIGNAL( playableStateChanged( bool ) ),
+                     SLOT( onQueryBecamePlayable( bool ) ),
+                     Qt::UniqueConnection );
+        }
+        if ( !query->resolvingFinished() )
+        {
+            connect( query.data(), SIGNAL( resolvingFinished( bool ) ),
+                     SLOT( onQueryResolved( bool ) ),
+                     Qt::UniqueConnection );
+        }
+    }
+}
+
+
+void
+PlayableModel::unsubscribe( PlayableItem* item )
+{
+    Q_D( PlayableModel );
+
+    removeSubscriber( item->artist().data(), item );
+    removeSubscriber( item->album().data(), item );
+    removeSubscriber( item->m_result.data(), item );
+
+    if ( item->query() )
+    {
+        removeSubscriber( item->query()->track().data(), item );
+        removeSubscriber( item->query().data(), item );
+    }
+    else if ( item->m_result )
+        removeSubscriber( item->m_result->track().data(), item );
+
+    d->changedItems.remove( item );
+}
+
+
+bool
+PlayableModel::addSubscriber( QObject* object, PlayableItem* item )
+{
+    Q_D( PlayableModel );
+
+    QList< PlayableItem* >& items = d->subscribers[ object ];
+    items << item;
+
+    // connections are only made for the first item showing object
+    return items.count() == 1;
+}
+
+
+void
+PlayableModel::removeSubscriber( QObject* object, PlayableItem* item )
+{
+    Q_D( PlayableModel );
+    if ( !object )
+        return;
+
+    QHash< QObject*, QList< PlayableItem* > >::iterator it = d->subscribers.find( object );
+    if ( it == d->subscribers.end() )
+        return;
+
+    it->removeOne( item );
+
+    // the connections stay around, they are cheap and reused if object shows up again
+    if ( it->isEmpty() )
+        d->subscribers.erase( it );
+}
+
+
+void
+PlayableModel::itemChanged( PlayableItem* item )
+{
+    Q_D( PlayableModel );
+
+    d->changedItems.insert( item );
+    if ( !d->dataChangedScheduled )
+    {
+        d->dataChangedScheduled = true;
+        QMetaObject::invokeMethod( this, "flushDataChanged", Qt::QueuedConnection );
+    }
+}
+
+
+void
+PlayableModel::onItemSourceChanged()
+{
+    Q_D( PlayableModel );
+
+    foreach ( PlayableItem* item, d->subscribers.value( sender() ) )
+        itemChanged( item );
+}
+
+
+void
+PlayableModel::onQueryResultsChanged()
+{
+    Q_D( PlayableModel );
+
+    const QList< PlayableItem* > items = d->subscribers.value( sender() );
+    foreach ( PlayableItem* item, items )
+    {
+        removeSubscriber( item->m_result.data(), item );
+        item->updateResult();
+
+        if ( item->m_result && addSubscriber( item->m_result.data(), item ) )
+            connect( item->m_result.data(), SIGNAL( updated() ), SLOT( onItemSourceChanged() ), Qt::UniqueConnection );
+
+        itemChanged( item );
+    }
+}
+
+
+void
+PlayableModel::flushDataChanged()
 {
-    PlayableItem* p = (PlayableItem*)sender();
-    if ( p && p->index.isValid() )
-        emit dataChanged( p->index, p->index.sibling( p->index.row(), columnCount() - 1 ) );
+    Q_D( PlayableModel );
+    d->dataChangedScheduled = false;
+
+    QHash< PlayableItem*, QList< int > > rows;
+    foreach ( PlayableItem* item, d->changedItems )
+    {
+        if ( item->index.isValid() )
+            rows[ item->parent() ] << item->index.row();
+    }
+    d->changedItems.clear();
+
+    // one dataChanged() for each run of adjacent rows
+    QHash< PlayableItem*, QList< int > >::iterator it = rows.begin();
+    for ( ; it != rows.end(); ++it )
+    {
+        QList< int >& changed = it.value();
+        qSort( changed );
+
+        const QModelIndex parent = it.key() == d->rootItem ? QModelIndex() : QModelIndex( it.key()->index );
+        int first = changed.first();
+        for ( int i = 1; i <= changed.count(); i++ )
+        {
+            if ( i < changed.count() && changed.at( i ) == changed.at( i - 1 ) + 1 )
+                continue;
+
+            emit dataChanged( index( first, 0, parent ), index( changed.at( i - 1 ), columnCount() - 1, parent ) );
+            if ( i < changed.count() )
+                first = changed.at( i );
+        }
+    }
 }
 
 
@@ -1110,6 +1284,9 @@ PlayableModel::insertAlbums( const QList< Tomahawk::album_ptr >& albums, int row
 void
 PlayableModel::insertAlbums( const Tomahawk::collection_ptr& collection, int /* row */ )
 {
+    if ( startPaging( collection, PagedAlbums ) )
+        return;
+
     Tomahawk::AlbumsRequest* req = collection->requestAlbums( Tomahawk::artist_ptr() );
     connect( dynamic_cast< QObject* >( req ), SIGNAL( albums( QList< Tomahawk::album_ptr > ) ),
              this, SLOT( appendAlbums( QList< Tomahawk::album_ptr > ) ), Qt::UniqueConnection );
@@ -1127,6 +1304,9 @@ PlayableModel::insertQueries( const QList< Tomahawk::query_ptr >& queries, int r
 void
 PlayableModel::insertTracks( const Tomahawk::collection_ptr& collection, int /* row */ )
 {
+    if ( startPaging( collection, PagedTracks ) )
+        return;
+
     Tomahawk::TracksRequest* req = collection->requestTracks( Tomahawk::album_ptr() );
     connect( dynamic_cast< QObject* >( req ), SIGNAL( tracks( QList< Tomahawk::query_ptr > ) ),
              this, SLOT( appendQueries( QList< Tomahawk::query_ptr > ) ), Qt::UniqueConnection );
@@ -1136,6 +1316,152 @@ PlayableModel::insertTracks( const Tomahawk::collection_ptr& collection, int /*
 }
 
 
+bool
+PlayableModel::startPaging( const Tomahawk::collection_ptr& collection, PagedType type )
+{
+    Q_D( PlayableModel );
+    if ( collection.objectCast< DatabaseCollection >().isNull() )
+        return false;
+
+    d->pagedCollection = collection;
+    d->pagedType = type;
+    d->pageCursorKey = QVariant();
+    d->pageCursorId = 0;
+    d->pageTotal = -1;
+    d->morePages = true;
+    d->fetchAllPages = false;
+
+    requestPage();
+    return true;
+}
+
+
+void
+PlayableModel::requestPage()
+{
+    Q_D( PlayableModel );
+    d->pageRequest = 0;
+
+    DatabaseCommand* cmd = 0;
+    switch ( d->pagedType )
+    {
+        case PagedTracks:
+        {
+            DatabaseCommand_AllTracks* tracks = dynamic_cast< DatabaseCommand_AllTracks* >( d->pagedCollection->requestTracks( album_ptr() ) );
+            if ( tracks )
+            {
+                tracks->setPage( d->pageCursorKey, d->pageCursorId, PLAYABLEMODEL_PAGE_SIZE );
+                connect( tracks, SIGNAL( tracks( QList< Tomahawk::query_ptr > ) ), SLOT( appendQueries( QList< Tomahawk::query_ptr > ) ) );
+            }
+            cmd = tracks;
+            break;
+        }
+
+        case PagedAlbums:
+        {
+            DatabaseCommand_AllAlbums* albums = dynamic_cast< DatabaseCommand_AllAlbums* >( d->pagedCollection->requestAlbums( artist_ptr() ) );
+            if ( albums )
+            {
+                albums->setPage( d->pageCursorKey, d->pageCursorId, PLAYABLEMODEL_PAGE_SIZE );
+                connect( albums, SIGNAL( albums( QList< Tomahawk::album_ptr > ) ), SLOT( appendAlbums( QList< Tomahawk::album_ptr > ) ) );
+            }
+            cmd = albums;
+            break;
+        }
+
+        case PagedArtists:
+        {
+            DatabaseCommand_AllArtists* artists = dynamic_cast< DatabaseCommand_AllArtists* >( d->pagedCollection->requestArtists() );
+            if ( artists )
+            {
+                artists->setPage( d->pageCursorKey, d->pageCursorId, PLAYABLEMODEL_PAGE_SIZE );
+                connect( artists, SIGNAL( artists( QList< Tomahawk::artist_ptr > ) ), SLOT( appendArtists( QList< Tomahawk::artist_ptr > ) ) );
+            }
+            cmd = artists;
+            break;
+        }
+
+        case NotPaged:
+            break;
+    }
+
+    if ( !cmd )
+    {
+        d->morePages = false;
+        finishLoading();
+        return;
+    }
+
+    d->pageRequest = cmd;
+    connect( cmd, SIGNAL( pageLoaded( QVariant, unsigned int, int ) ), SLOT( onPageLoaded( QVariant, unsigned int, int ) ) );
+    Database::instance()->enqueue( Tomahawk::dbcmd_ptr( cmd ) );
+}
+
+
+void
+PlayableModel::onPageLoaded( const QVariant& lastKey, unsigned int lastId, int total )
+{
+    Q_D( PlayableModel );
+    if ( sender() != d->pageRequest )
+        return;
+
+    d->pageRequest = 0;
+    if ( total >= 0 )
+        d->pageTotal = total;
+
+    // the total is only an estimate once the collection changes, so stop at an empty page too
+    d->morePages = lastId > 0 && ( d->pageTotal < 0 || rowCount( QModelIndex() ) < d->pageTotal );
+    if ( lastId > 0 )
+    {
+        d->pageCursorKey = lastKey;
+        d->pageCursorId = lastId;
+    }
+
+    if ( d->fetchAllPages && d->morePages )
+    {
+        requestPage();
+        return;
+    }
+
+    finishLoading();
+}
+
+
+bool
+PlayableModel::canFetchMore( const QModelIndex& parent ) const
+{
+    Q_D( const PlayableModel );
+    return !parent.isValid() && d->morePages && d->pageRequest.isNull();
+}
+
+
+void
+PlayableModel::fetchMore( const QModelIndex& parent )
+{
+    if ( !canFetchMore( parent ) )
+        return;
+
+    startLoading();
+    requestPage();
+}
+
+
+void
+PlayableModel::loadAllPages()
+{
+    Q_D( PlayableModel );
+    if ( !d->morePages )
+        return;
+
+    d->fetchAllPages = true;
+    if ( d->pageRequest.isNull() )
+    {
+        startLoading();
+        requestPage();
+    }
+}
+
+
 void
 PlayableModel::setTitle( const QString& title )
 {
@@ -1212,6 +1538,7 @@ PlayableModel::itemCount() const
 void
 PlayableModel::onQueryBecamePlayable( bool playable )
 {
+    Q_D( PlayableModel );
     Q_UNUSED( playable );
 
     Tomahawk::Query* q = qobject_cast< Query* >( sender() );
@@ -1221,9 +1548,7 @@ PlayableModel::onQueryBecamePlayable( bool playable )
         return;
     }
 
-    Tomahawk::query_ptr query = q->weakRef().toStrongRef();
-    PlayableItem* item = itemFromQuery( query );
-    if ( item )
+    foreach ( PlayableItem* item, d->subscribers.value( q ) )
     {
         emit indexPlayable( item->index );
     }
@@ -1233,6 +1558,7 @@ PlayableModel::onQueryBecamePlayable( bool playable )
 void
 PlayableModel::onQueryResolved( bool hasResults )
 {
+    Q_D( PlayableModel );
     Q_UNUSED( hasResults );
 
     Tomahawk::Query* q = qobject_cast< Query* >( sender() );
@@ -1242,9 +1568,7 @@ PlayableModel::onQueryResolved( bool hasResults )
         return;
     }
 
-    Tomahawk::query_ptr query = q->weakRef().toStrongRef();
-    PlayableItem* item = itemFromQuery( query );
-    if ( item )
+    foreach ( PlayableItem* item, d->subscribers.value( q ) )
     {
         emit indexResolved( item->index );
     }
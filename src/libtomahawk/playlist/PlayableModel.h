@@ -77,6 +77,15 @@ public:
         IsPlayingRole
     };
 
+    /// What a database collection is being paged through for, see startPaging()
+    enum PagedType
+    {
+        NotPaged = 0,
+        PagedTracks,
+        PagedAlbums,
+        PagedArtists
+    };
+
     explicit PlayableModel( QObject* parent = 0, bool loading = true );
     virtual ~PlayableModel();
 
@@ -197,8 +206,25 @@ protected:
     PlayableItem* rootItem() const;
     QModelIndex createIndex( int row, int column, PlayableItem* item = 0 ) const;
 
+    /// Repaints item whenever what it shows changes. Call this for every item added to the model.
+    void subscribe( PlayableItem* item );
+
+    /**
+     * Loads the tracks, albums or artists of a database collection page by page as
+     * the view scrolls, instead of all at once. Returns false for other collections.
+     */
+    bool startPaging( const Tomahawk::collection_ptr& collection, PagedType type );
+
+    bool canFetchMore( const QModelIndex& parent ) const;
+    void fetchMore( const QModelIndex& parent );
+
+    /// Keeps requesting pages until the whole collection is loaded, e.g. so a filter sees every row
+    void loadAllPages();
+
 private slots:
-    void onDataChanged();
+    void onItemSourceChanged();
+    void onQueryResultsChanged();
+    void flushDataChanged();
 
     void onQueryBecamePlayable( bool playable );
     void onQueryResolved( bool hasResults );
@@ -206,8 +232,17 @@ private slots:
     void onPlaybackStarted( const Tomahawk::result_ptr result );
     void onPlaybackStopped();
 
+    void onPageLoaded( const QVariant& lastKey, unsigned int lastId, int total );
+
 private:
     void init();
+    void requestPage();
+
+    void unsubscribe( PlayableItem* item );
+    bool addSubscriber( QObject* object, PlayableItem* item );
+    void removeSubscriber( QObject* object, PlayableItem* item );
+    void itemChanged( PlayableItem* item );
+
     template <typename T>
     void insertInternal( const QList< T >& items, int row, const QList< Tomahawk::PlaybackLog >& logs = QList< Tomahawk::PlaybackLog >(), const QModelIndex& parent = QModelIndex() );
 
@@ -215,6 +250,7 @@ private:
     Qt::Alignment columnAlignment( int column ) const;
 
     Q_DECLARE_PRIVATE( PlayableModel )
+    friend class PlayableItem;
 };
 
 #endif // PLAYABLEMODEL_H
@@ -27,7 +27,10 @@
 
 #include "PlayableItem.h"
 
+#include <QHash>
 #include <QPixmap>
+#include <QPointer>
+#include <QSet>
 #include <QStringList>
 
 class PlayableModelPrivate
@@ -39,6 +42,12 @@ public:
         , readOnly( true )
         , loading( _loading )
         , areAllColumnsEditable( false )
+        , dataChangedScheduled( false )
+        , pagedType( PlayableModel::NotPaged )
+        , pageCursorId( 0 )
+        , pageTotal( -1 )
+        , morePages( false )
+        , fetchAllPages( false )
     {
     }
 
@@ -60,6 +69,23 @@ private:
 
     bool loading;
     bool areAllColumnsEditable;
+
+    // rows showing an artist, album, query, result or track, keyed by that object
+    QHash< QObject*, QList< PlayableItem* > > subscribers;
+
+    // rows that need a repaint at the end of this event loop iteration
+    QSet< PlayableItem* > changedItems;
+    bool dataChangedScheduled;
+
+    // keyset paging through a database collection, see fetchMore()
+    Tomahawk::collection_ptr pagedCollection;
+    PlayableModel::PagedType pagedType;
+    QPointer< QObject > pageRequest;
+    QVariant pageCursorKey;
+    unsigned int pageCursorId;
+    int pageTotal;
+    bool morePages;
+    bool fetchAllPages;
 };
 
 #endif // PLAYABLEMODEL_P_H
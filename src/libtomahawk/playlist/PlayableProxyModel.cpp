@@ -31,6 +31,41 @@
 
 #include <QTreeView>
 
+// strings without a rank are compared directly until there are this many of them
+#define SORTKEYS_MIN_UNRANKED 256
+
+
+static bool
+localeAwareLessThan( const QString& s1, const QString& s2 )
+{
+    return QString::localeAwareCompare( s1, s2 ) < 0;
+}
+
+
+/// Ranks compare like their strings, a string without a rank (-1) is compared as is
+static inline int
+compareSortKeys( int rank1, int rank2, const QString& s1, const QString& s2 )
+{
+    if ( rank1 >= 0 && rank2 >= 0 )
+        return rank1 - rank2;
+
+    return QString::localeAwareCompare( s1, s2 );
+}
+
+
+static void
+rankStrings( const QSet< QString >& strings, QHash< QString, int >& ranks )
+{
+    QStringList sorted = strings.toList();
+    qSort( sorted.begin(), sorted.end(), localeAwareLessThan );
+
+    ranks.clear();
+    ranks.reserve( sorted.count() );
+    for ( int i = 0; i < sorted.count(); i++ )
+        ranks.insert( sorted.at( i ), i );
+}
+
+
 PlayableProxyModel::PlayableProxyModel( QObject* parent )
     : QSortFilterProxyModel( parent )
     , m_model( 0 )
@@ -39,6 +74,8 @@ PlayableProxyModel::PlayableProxyModel( QObject* parent )
     , m_hideDupeItems( false )
     , m_maxVisibleItems( -1 )
     , m_style( Detailed )
+    , m_sortKeysValid( false )
+    , m_sortKeysGeneration( 0 )
 {
     m_playlistInterface = Tomahawk::playlistinterface_ptr( new Tomahawk::PlayableProxyModelPlaylistInterface( this ) );
 
@@ -125,11 +162,30 @@ PlayableProxyModel::setSourcePlayableModel( PlayableModel* sourceModel )
         disconnect( m_model, SIGNAL( currentIndexChanged( QModelIndex, QModelIndex ) ), this, SLOT( onCurrentIndexChanged( QModelIndex, QModelIndex ) ) );
         disconnect( m_model, SIGNAL( expandRequest( QPersistentModelIndex ) ), this, SLOT( expandRequested( QPersistentModelIndex ) ) );
         disconnect( m_model, SIGNAL( selectRequest( QPersistentModelIndex ) ), this, SLOT( selectRequested( QPersistentModelIndex ) ) );
+
+        disconnect( m_model, SIGNAL( dataChanged( QModelIndex, QModelIndex ) ), this, SLOT( onSourceDataChanged( QModelIndex, QModelIndex ) ) );
+        disconnect( m_model, SIGNAL( rowsAboutToBeRemoved( QModelIndex, int, int ) ), this, SLOT( onSourceRowsAboutToBeRemoved( QModelIndex, int, int ) ) );
+        disconnect( m_model, SIGNAL( rowsInserted( QModelIndex, int, int ) ), this, SLOT( onSourceLayoutChanged() ) );
+        disconnect( m_model, SIGNAL( rowsRemoved( QModelIndex, int, int ) ), this, SLOT( onSourceLayoutChanged() ) );
+        disconnect( m_model, SIGNAL( rowsMoved( QModelIndex, int, int, QModelIndex, int ) ), this, SLOT( onSourceLayoutChanged() ) );
+        disconnect( m_model, SIGNAL( layoutChanged() ), this, SLOT( onSourceLayoutChanged() ) );
+        disconnect( m_model, SIGNAL( modelReset() ), this, SLOT( onSourceModelReset() ) );
     }
 
+    clearCaches();
+
     m_model = sourceModel;
     if ( m_model )
     {
+        // these have to run before QSortFilterProxyModel's own handlers re-filter anything
+        connect( m_model, SIGNAL( dataChanged( QModelIndex, QModelIndex ) ), SLOT( onSourceDataChanged( QModelIndex, QModelIndex ) ) );
+        connect( m_model, SIGNAL( rowsAboutToBeRemoved( QModelIndex, int, int ) ), SLOT( onSourceRowsAboutToBeRemoved( QModelIndex, int, int ) ) );
+        connect( m_model, SIGNAL( rowsInserted( QModelIndex, int, int ) ), SLOT( onSourceLayoutChanged() ) );
+        connect( m_model, SIGNAL( rowsRemoved( QModelIndex, int, int ) ), SLOT( onSourceLayoutChanged() ) );
+        connect( m_model, SIGNAL( rowsMoved( QModelIndex, int, int, QModelIndex, int ) ), SLOT( onSourceLayoutChanged() ) );
+        connect( m_model, SIGNAL( layoutChanged() ), SLOT( onSourceLayoutChanged() ) );
+        connect( m_model, SIGNAL( modelReset() ), SLOT( onSourceModelReset() ) );
+
         connect( m_model, SIGNAL( loadingStarted() ), SIGNAL( loadingStarted() ) );
         connect( m_model, SIGNAL( loadingFinished() ), SIGNAL( loadingFinished() ) );
         connect( m_model, SIGNAL( itemCountChanged( unsigned int ) ), SIGNAL( itemCountChanged( unsigned int ) ) );
@@ -175,17 +231,29 @@ PlayableProxyModel::dupeFilterAcceptsRow( int sourceRow, PlayableItem* pi, const
     if ( !m_hideDupeItems )
         return true;
 
-    for ( int i = 0; i < sourceRow; i++ )
+    const QString key = dupeKey( pi );
+    if ( key.isEmpty() )
+        return true;
+
+    PlayableItem* parentItem = itemFromIndex( sourceParent );
+    if ( !m_dupeIndex.contains( parentItem ) )
     {
-        PlayableItem* di = itemFromIndex( sourceModel()->index( i, 0, sourceParent ) );
-        if ( !di )
-            continue;
+        QHash< QString, QList< int > >& index = m_dupeIndex[ parentItem ];
+        for ( int i = 0; i < parentItem->children.count(); i++ )
+        {
+            const QString k = dupeKey( parentItem->children.at( i ) );
+            if ( !k.isEmpty() )
+                index[ k ] << i;
+        }
+    }
 
-        bool b = ( pi->query() && pi->query()->equals( di->query() ) ) ||
-                 ( pi->album() && pi->album() == di->album() ) ||
-                 ( pi->artist() && pi->artist()->name() == di->artist()->name() );
+    // only the first visible one of a bunch of dupes is shown
+    foreach ( int i, m_dupeIndex.value( parentItem ).value( key ) )
+    {
+        if ( i >= sourceRow )
+            break;
 
-        if ( b && filterAcceptsRowInternal( i, di, sourceParent, memo ) )
+        if ( filterAcceptsRowInternal( i, parentItem->children.at( i ), sourceParent, memo ) )
             return false;
     }
 
@@ -193,6 +261,23 @@ PlayableProxyModel::dupeFilterAcceptsRow( int sourceRow, PlayableItem* pi, const
 }
 
 
+QString
+PlayableProxyModel::dupeKey( PlayableItem* item )
+{
+    if ( item->query() )
+    {
+        const Tomahawk::track_ptr& track = item->query()->queryTrack();
+        return QString( "q\t%1\t%2\t%3" ).arg( track->artist() ).arg( track->album() ).arg( track->track() );
+    }
+    if ( item->album() )
+        return QString( "al\t%1" ).arg( (quintptr)item->album().data() );
+    if ( item->artist() )
+        return QString( "ar\t%1" ).arg( item->artist()->name() );
+
+    return QString();
+}
+
+
 bool
 PlayableProxyModel::visibilityFilterAcceptsRow( int sourceRow, const QModelIndex& sourceParent, PlayableProxyModelFilterMemo& memo ) const
 {
@@ -234,66 +319,116 @@ PlayableProxyModel::nameFilterAcceptsRow( int sourceRow, PlayableItem* pi, const
     }
 
     const Tomahawk::query_ptr& query = pi->query();
-    if ( query )
+    if ( query && !m_showOfflineResults )
     {
         Tomahawk::result_ptr r;
         if ( query->numResults() )
             r = query->results().first();
 
-        if ( !m_showOfflineResults && ( r.isNull() || !r->isOnline() ) )
+        if ( r.isNull() || !r->isOnline() )
             return false;
+    }
+
+    if ( !query && !pi->album() && !pi->artist() )
+        return true;
 
-        const QRegExp regexp = filterRegExp();
-        if ( regexp.isEmpty() )
-            return true;
+    return textFilterAcceptsRow( pi );
+}
+
+
+bool
+PlayableProxyModel::textFilterAcceptsRow( PlayableItem* item ) const
+{
+    updateFilterTokens();
+    if ( m_filterTokens.isEmpty() )
+        return true;
+    if ( m_textRejected.contains( item ) )
+        return false;
 
-        QStringList sl = regexp.pattern().split( " ", QString::SkipEmptyParts );
-        foreach( const QString& s, sl )
+    const QString key = searchKey( item );
+    foreach ( const QString& token, m_filterTokens )
+    {
+        if ( !key.contains( token ) )
         {
-            const Tomahawk::track_ptr& track = query->track();
-            if ( !track->artist().contains( s, Qt::CaseInsensitive ) &&
-                 !track->album().contains( s, Qt::CaseInsensitive ) &&
-                 !track->track().contains( s, Qt::CaseInsensitive ) )
-            {
-                return false;
-            }
+            m_textRejected.insert( item );
+            return false;
         }
     }
 
-    const Tomahawk::album_ptr& al = pi->album();
-    if ( al )
-    {
-        QStringList sl = filterRegExp().pattern().split( " ", QString::SkipEmptyParts );
+    return true;
+}
+
+
+void
+PlayableProxyModel::updateFilterTokens() const
+{
+    const QString pattern = filterRegExp().pattern();
+    if ( pattern == m_filterPattern )
+        return;
+
+    QStringList tokens;
+    foreach ( const QString& s, pattern.split( " ", QString::SkipEmptyParts ) )
+        tokens << s.toCaseFolded();
 
-        foreach( const QString& s, sl )
+    // When every old token is part of a new one the filter only got narrower,
+    // e.g. "radio" -> "radioh". Rows it rejected before can't match now either.
+    bool narrower = true;
+    foreach ( const QString& oldToken, m_filterTokens )
+    {
+        bool covered = false;
+        foreach ( const QString& token, tokens )
         {
-            if ( !al->name().contains( s, Qt::CaseInsensitive ) &&
-                 !al->artist()->name().contains( s, Qt::CaseInsensitive ) )
+            if ( token.contains( oldToken ) )
             {
-                return false;
+                covered = true;
+                break;
             }
         }
 
-        return true;
+        if ( !covered )
+        {
+            narrower = false;
+            break;
+        }
     }
 
-    const Tomahawk::artist_ptr& ar = pi->artist();
-    if ( ar )
-    {
-        QStringList sl = filterRegExp().pattern().split( " ", QString::SkipEmptyParts );
+    if ( !narrower )
+        m_textRejected.clear();
 
-        foreach( const QString& s, sl )
-        {
-            if ( !ar->name().contains( s, Qt::CaseInsensitive ) )
-            {
-                return false;
-            }
-        }
+    m_filterPattern = pattern;
+    m_filterTokens = tokens;
+}
 
-        return true;
+
+QString
+PlayableProxyModel::searchKey( PlayableItem* item ) const
+{
+    QHash< PlayableItem*, QString >::const_iterator it = m_searchKeys.constFind( item );
+    if ( it != m_searchKeys.constEnd() )
+        return it.value();
+
+    // the separator keeps tokens from matching across two fields
+    const QChar separator( 0x1f );
+
+    QString key;
+    if ( item->query() )
+    {
+        const Tomahawk::track_ptr& track = item->query()->track();
+        key = track->artist() + separator + track->album() + separator + track->track();
+    }
+    else if ( item->album() )
+    {
+        key = item->album()->name() + separator + item->album()->artist()->name();
+    }
+    else if ( item->artist() )
+    {
+        key = item->artist()->name();
     }
 
-    return true;
+    key = key.toCaseFolded();
+    m_searchKeys.insert( item, key );
+
+    return key;
 }
 
 
@@ -370,17 +505,96 @@ PlayableProxyModel::setMaxVisibleItems( int items )
 }
 
 
+PlayableProxyModel::SortKeys
+PlayableProxyModel::sortKeys( PlayableItem* item ) const
+{
+    if ( !m_sortKeysValid )
+        rankSortKeys();
+
+    QHash< PlayableItem*, SortKeys >::const_iterator it = m_sortKeys.constFind( item );
+    if ( it != m_sortKeys.constEnd() )
+        return it.value();
+
+    // a row we haven't seen yet, or one whose track changed, may bring strings without a rank
+    const Tomahawk::track_ptr& track = item->query()->track();
+    SortKeys keys;
+    keys.artist = sortRank( m_artistRanks, track->artistSortname() );
+    keys.composer = sortRank( m_composerRanks, track->composerSortname() );
+    keys.album = sortRank( m_albumRanks, track->albumSortname() );
+    keys.track = sortRank( m_trackRanks, track->track() );
+
+    // only rank again once the unranked strings could make up half of the
+    // model, so rows being added one by one don't re-rank it every time
+    const int ranked = m_artistRanks.count() + m_composerRanks.count() + m_albumRanks.count() + m_trackRanks.count();
+    if ( m_unranked.count() >= qMax( SORTKEYS_MIN_UNRANKED, ranked ) )
+    {
+        rankSortKeys();
+        return sortKeys( item );
+    }
+
+    m_sortKeys.insert( item, keys );
+    return keys;
+}
+
+
+int
+PlayableProxyModel::sortRank( const QHash< QString, int >& ranks, const QString& s ) const
+{
+    QHash< QString, int >::const_iterator it = ranks.constFind( s );
+    if ( it != ranks.constEnd() )
+        return it.value();
+
+    m_unranked << s;
+    return -1;
+}
+
+
+void
+PlayableProxyModel::rankSortKeys() const
+{
+    m_sortKeys.clear();
+    m_unranked.clear();
+    m_sortKeysValid = true;
+    m_sortKeysGeneration++;
+
+    if ( !m_model )
+        return;
+
+    QSet< QString > artists, composers, albums, tracks;
+
+    QList< PlayableItem* > pending;
+    pending << m_model->itemFromIndex( QModelIndex() );
+    while ( !pending.isEmpty() )
+    {
+        PlayableItem* item = pending.takeLast();
+        pending << item->children;
+
+        if ( !item->query() )
+            continue;
+
+        const Tomahawk::track_ptr& track = item->query()->track();
+        artists << track->artistSortname();
+        composers << track->composerSortname();
+        albums << track->albumSortname();
+        tracks << track->track();
+    }
+
+    rankStrings( artists, m_artistRanks );
+    rankStrings( composers, m_composerRanks );
+    rankStrings( albums, m_albumRanks );
+    rankStrings( tracks, m_trackRanks );
+}
+
+
 bool
-PlayableProxyModel::lessThan( int column, const Tomahawk::query_ptr& q1, const Tomahawk::query_ptr& q2 ) const
+PlayableProxyModel::lessThan( int column, const Tomahawk::query_ptr& q1, const Tomahawk::query_ptr& q2, const SortKeys& k1, const SortKeys& k2 ) const
 {
     // Attention: This function may be called very often!
     // So be aware of its performance.
     const Tomahawk::track_ptr& t1 = q1->track();
     const Tomahawk::track_ptr& t2 = q2->track();
-    const QString& artist1 = t1->artistSortname();
-    const QString& artist2 = t2->artistSortname();
-    const QString& album1 = t1->albumSortname();
-    const QString& album2 = t2->albumSortname();
+    const int artist = compareSortKeys( k1.artist, k2.artist, t1->artistSortname(), t2->artistSortname() );
+    const int album = compareSortKeys( k1.album, k2.album, t1->albumSortname(), t2->albumSortname() );
     const unsigned int albumpos1 = t1->albumpos();
     const unsigned int albumpos2 = t2->albumpos();
     const unsigned int discnumber1 = t1->discnumber();
@@ -390,9 +604,9 @@ PlayableProxyModel::lessThan( int column, const Tomahawk::query_ptr& q1, const T
 
     if ( column == PlayableModel::Artist ) // sort by artist
     {
-        if ( artist1 == artist2 )
+        if ( artist == 0 )
         {
-            if ( album1 == album2 )
+            if ( album == 0 )
             {
                 if ( discnumber1 == discnumber2 )
                 {
@@ -405,20 +619,19 @@ PlayableProxyModel::lessThan( int column, const Tomahawk::query_ptr& q1, const T
                 return discnumber1 < discnumber2;
             }
 
-            return QString::localeAwareCompare( album1, album2 ) < 0;
+            return album < 0;
         }
 
-        return QString::localeAwareCompare( artist1, artist2 ) < 0;
+        return artist < 0;
     }
 
     // Sort by Composer
-    const QString& composer1 = t1->composerSortname();
-    const QString& composer2 = t2->composerSortname();
     if ( column == PlayableModel::Composer )
     {
-        if ( composer1 == composer2 )
+        const int composer = compareSortKeys( k1.composer, k2.composer, t1->composerSortname(), t2->composerSortname() );
+        if ( composer == 0 )
         {
-            if ( album1 == album2 )
+            if ( album == 0 )
             {
                 if ( discnumber1 == discnumber2 )
                 {
@@ -431,16 +644,16 @@ PlayableProxyModel::lessThan( int column, const Tomahawk::query_ptr& q1, const T
                 return discnumber1 < discnumber2;
             }
 
-            return QString::localeAwareCompare( album1, album2 ) < 0;
+            return album < 0;
         }
 
-        return QString::localeAwareCompare( composer1, composer2 ) < 0;
+        return composer < 0;
     }
 
     // Sort by Album
     if ( column == PlayableModel::Album ) // sort by album
     {
-        if ( album1 == album2 )
+        if ( album == 0 )
         {
             if ( discnumber1 == discnumber2 )
             {
@@ -453,7 +666,7 @@ PlayableProxyModel::lessThan( int column, const Tomahawk::query_ptr& q1, const T
             return discnumber1 < discnumber2;
         }
 
-        return QString::localeAwareCompare( album1, album2 ) < 0;
+        return album < 0;
     }
 
     // Lazy load these variables, they are not used before.
@@ -551,12 +764,11 @@ PlayableProxyModel::lessThan( int column, const Tomahawk::query_ptr& q1, const T
         }
     }
 
-    const QString& lefts = t1->track();
-    const QString& rights = t2->track();
-    if ( lefts == rights )
+    const int track = compareSortKeys( k1.track, k2.track, t1->track(), t2->track() );
+    if ( track == 0 )
         return id1 < id2;
 
-    return QString::localeAwareCompare( lefts, rights ) < 0;
+    return track < 0;
 }
 
 
@@ -585,13 +797,21 @@ PlayableProxyModel::lessThan( const QModelIndex& left, const QModelIndex& right
 
     if ( p1->query() && p2->query() )
     {
+        const uint generation = m_sortKeysGeneration;
+        SortKeys k1 = sortKeys( p1 );
+        const SortKeys k2 = sortKeys( p2 );
+
+        // ranks are only comparable when both come from the same ranking
+        if ( generation != m_sortKeysGeneration )
+            k1 = sortKeys( p1 );
+
         if ( !m_headerStyle.contains( m_style ) || left.column() >= m_headerStyle[ m_style ].count() )
         {
-            return lessThan( left.column(), p1->query(), p2->query() );
+            return lessThan( left.column(), p1->query(), p2->query(), k1, k2 );
         }
 
         PlayableModel::Columns col = m_headerStyle[ m_style ].at( left.column() );
-        return lessThan( col, p1->query(), p2->query() );
+        return lessThan( col, p1->query(), p2->query(), k1, k2 );
     }
     if ( p1->album() && p2->album() )
     {
@@ -686,15 +906,15 @@ PlayableProxyModel::updateDetailedInfo( const QModelIndex& index )
 
     if ( item->album() )
     {
-        item->album()->cover( QSize( 0, 0 ) );
+        item->album()->loadCover();
     }
     else if ( item->artist() )
     {
-        item->artist()->cover( QSize( 0, 0 ) );
+        item->artist()->loadCover();
     }
     else if ( item->query() )
     {
-        item->query()->track()->cover( QSize( 0, 0 ) );
+        item->query()->track()->loadCover();
 
 /*        if ( style() == PlayableProxyModel::Fancy )
         {
@@ -709,6 +929,10 @@ PlayableProxyModel::setFilter( const QString& pattern )
 {
     if ( pattern != filterRegExp().pattern() )
     {
+        // rows of pages that aren't loaded yet could match as well
+        if ( !pattern.isEmpty() && sourceModel() )
+            sourceModel()->loadAllPages();
+
         setFilterRegExp( pattern );
         emit filterChanged( pattern );
     }
@@ -730,6 +954,81 @@ PlayableProxyModel::setCurrentIndex( const QModelIndex& index )
 }
 
 
+void
+PlayableProxyModel::forgetItem( PlayableItem* item )
+{
+    m_searchKeys.remove( item );
+    m_sortKeys.remove( item );
+    m_textRejected.remove( item );
+    m_dupeIndex.remove( item );
+}
+
+
+void
+PlayableProxyModel::clearCaches()
+{
+    m_searchKeys.clear();
+    m_sortKeys.clear();
+    m_sortKeysValid = false;
+    m_textRejected.clear();
+    m_dupeIndex.clear();
+}
+
+
+void
+PlayableProxyModel::onSourceDataChanged( const QModelIndex& topLeft, const QModelIndex& bottomRight )
+{
+    const QModelIndex parent = topLeft.parent();
+    for ( int i = topLeft.row(); i <= bottomRight.row(); i++ )
+    {
+        PlayableItem* item = itemFromIndex( m_model->index( i, 0, parent ) );
+        if ( item )
+            forgetItem( item );
+    }
+
+    if ( m_hideDupeItems )
+        m_dupeIndex.remove( itemFromIndex( parent ) );
+}
+
+
+void
+PlayableProxyModel::onSourceRowsAboutToBeRemoved( const QModelIndex& parent, int start, int end )
+{
+    QList< PlayableItem* > pending;
+    for ( int i = start; i <= end; i++ )
+    {
+        PlayableItem* item = itemFromIndex( m_model->index( i, 0, parent ) );
+        if ( item )
+            pending << item;
+    }
+
+    // removed items may be deleted, their addresses reused
+    while ( !pending.isEmpty() )
+    {
+        PlayableItem* item = pending.takeLast();
+        pending << item->children;
+        forgetItem( item );
+    }
+
+    m_dupeIndex.remove( itemFromIndex( parent ) );
+}
+
+
+void
+PlayableProxyModel::onSourceLayoutChanged()
+{
+    // row numbers changed
+    m_dupeIndex.clear();
+}
+
+
+void
+PlayableProxyModel::onSourceModelReset()
+{
+    clearCaches();
+}
+
+
 void
 PlayableProxyModel::onIndexPlayable( const QModelIndex& index )
 {
@@ -20,7 +20,10 @@
 #ifndef TRACKPROXYMODEL_H
 #define TRACKPROXYMODEL_H
 
+#include <QHash>
+#include <QSet>
 #include <QSortFilterProxyModel>
+#include <QStringList>
 
 #include "PlaylistInterface.h"
 #include "playlist/PlayableModel.h"
@@ -125,6 +128,11 @@ protected:
     Tomahawk::playlistinterface_ptr m_playlistInterface;
 
 private slots:
+    void onSourceDataChanged( const QModelIndex& topLeft, const QModelIndex& bottomRight );
+    void onSourceRowsAboutToBeRemoved( const QModelIndex& parent, int start, int end );
+    void onSourceLayoutChanged();
+    void onSourceModelReset();
+
     void onIndexPlayable( const QModelIndex& index );
     void onIndexResolved( const QModelIndex& index );
 
@@ -138,11 +146,52 @@ private:
     bool dupeFilterAcceptsRow( int sourceRow, PlayableItem* pi, const QModelIndex& sourceParent, PlayableProxyModelFilterMemo& memo ) const;
     bool visibilityFilterAcceptsRow( int sourceRow, const QModelIndex& sourceParent, PlayableProxyModelFilterMemo& memo ) const;
 
-    bool lessThan( int column, const Tomahawk::query_ptr& left, const Tomahawk::query_ptr& right ) const;
+    // Sort keys are the ranks of a row's strings among all strings of the model,
+    // so comparing two rows never has to do a locale aware string comparison.
+    struct SortKeys
+    {
+        int artist;
+        int composer;
+        int album;
+        int track;
+    };
+    SortKeys sortKeys( PlayableItem* item ) const;
+    int sortRank( const QHash< QString, int >& ranks, const QString& s ) const;
+    void rankSortKeys() const;
+
+    bool lessThan( int column, const Tomahawk::query_ptr& left, const Tomahawk::query_ptr& right, const SortKeys& leftKeys, const SortKeys& rightKeys ) const;
     bool lessThan( const Tomahawk::album_ptr& album1, const Tomahawk::album_ptr& album2 ) const;
 
+    /// Case folded text the filter is matched against
+    QString searchKey( PlayableItem* item ) const;
+    bool textFilterAcceptsRow( PlayableItem* item ) const;
+    void updateFilterTokens() const;
+
+    static QString dupeKey( PlayableItem* item );
+    void forgetItem( PlayableItem* item );
+    void clearCaches();
+
     QPointer<PlayableModel> m_model;
 
+    mutable QHash< PlayableItem*, SortKeys > m_sortKeys;
+    mutable QHash< QString, int > m_artistRanks;
+    mutable QHash< QString, int > m_composerRanks;
+    mutable QHash< QString, int > m_albumRanks;
+    mutable QHash< QString, int > m_trackRanks;
+    // strings seen since the last ranking that don't have a rank yet
+    mutable QSet< QString > m_unranked;
+    mutable bool m_sortKeysValid;
+    mutable uint m_sortKeysGeneration;
+
+    mutable QHash< PlayableItem*, QString > m_searchKeys;
+    mutable QString m_filterPattern;
+    mutable QStringList m_filterTokens;
+    // rows the current filter text rejected, they stay rejected while the filter only gets narrower
+    mutable QSet< PlayableItem* > m_textRejected;
+
+    // rows with the same dupe key below a parent, in ascending order
+    mutable QHash< PlayableItem*, QHash< QString, QList< int > > > m_dupeIndex;
+
     bool m_showOfflineResults;
     bool m_hideEmptyParents;
     bool m_hideDupeItems;
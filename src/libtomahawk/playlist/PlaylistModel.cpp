@@ -315,7 +315,7 @@ PlaylistModel::insertEntries( const QList< Tomahawk::plentry_ptr >& entries, int
                      SLOT( trackResolved( bool ) ) );
         }
 
-        connect( plitem, SIGNAL( dataChanged() ), SLOT( onDataChanged() ) );
+        subscribe( plitem );
     }
 
     if ( !d->waitingForResolved.isEmpty() )
@@ -111,7 +111,7 @@ RecentlyPlayedModel::onSourceAdded( const Tomahawk::source_ptr& source )
 
     PlayableItem* item = new PlayableItem( source, rootItem() );
     item->index = createIndex( rootItem()->children.count() - 1, 0, item );
-    connect( item, SIGNAL( dataChanged() ), SLOT( onDataChanged() ) );
+    subscribe( item );
 
     emit endInsertRows();
 }
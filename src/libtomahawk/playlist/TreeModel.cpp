@@ -82,15 +82,19 @@ TreeModel::getCover( const QModelIndex& index )
     PlayableItem* item = itemFromIndex( index );
 
     if ( !item->artist().isNull() && !item->artist()->coverLoaded() )
-        item->artist()->cover( QSize( 0, 0 ) );
+        item->artist()->loadCover();
     else if ( !item->album().isNull() && !item->album()->coverLoaded() )
-        item->album()->cover( QSize( 0, 0 ) );
+        item->album()->loadCover();
 }
 
 
 bool
 TreeModel::canFetchMore( const QModelIndex& parent ) const
 {
+    // more artists of a paged collection
+    if ( !parent.isValid() )
+        return PlayableModel::canFetchMore( parent );
+
     PlayableItem* parentItem = itemFromIndex( parent );
 
     if ( parentItem->fetchingMore() )
@@ -112,6 +116,9 @@ TreeModel::canFetchMore( const QModelIndex& parent ) const
 void
 TreeModel::fetchMore( const QModelIndex& parent )
 {
+    if ( !parent.isValid() )
+        return PlayableModel::fetchMore( parent );
+
     PlayableItem* parentItem = itemFromIndex( parent );
     if ( !parentItem || parentItem->fetchingMore() )
         return;
@@ -198,7 +205,7 @@ TreeModel::addAlbums( const QModelIndex& parent, const QList<Tomahawk::album_ptr
     {
         PlayableItem* albumitem = new PlayableItem( album, parentItem );
         albumitem->index = createIndex( parentItem->children.count() - 1, 0, albumitem );
-        connect( albumitem, SIGNAL( dataChanged() ), SLOT( onDataChanged() ) );
+        subscribe( albumitem );
 
         getCover( albumitem->index );
     }
@@ -230,10 +237,13 @@ TreeModel::addCollection( const collection_ptr& collection )
 
     m_collection = collection;
 
-    Tomahawk::ArtistsRequest* req = m_collection->requestArtists();
-    connect( dynamic_cast< QObject* >( req ), SIGNAL( artists( QList< Tomahawk::artist_ptr > ) ),
-             this, SLOT( onArtistsAdded( QList< Tomahawk::artist_ptr > ) ), Qt::UniqueConnection );
-    req->enqueue();
+    if ( !startPaging( collection, PagedArtists ) )
+    {
+        Tomahawk::ArtistsRequest* req = m_collection->requestArtists();
+        connect( dynamic_cast< QObject* >( req ), SIGNAL( artists( QList< Tomahawk::artist_ptr > ) ),
+                 this, SLOT( onArtistsAdded( QList< Tomahawk::artist_ptr > ) ), Qt::UniqueConnection );
+        req->enqueue();
+    }
 
     setIcon( collection->bigIcon() );
     setTitle( collection->prettyName() );
@@ -265,6 +275,14 @@ TreeModel::addCollection( const collection_ptr& collection )
 //}
 
 
+void
+TreeModel::appendArtists( const QList< Tomahawk::artist_ptr >& artists )
+{
+    // artists are the top level items of the tree
+    onArtistsAdded( artists );
+}
+
+
 void
 TreeModel::onArtistsAdded( const QList<Tomahawk::artist_ptr>& artists )
 {
@@ -284,7 +302,7 @@ TreeModel::onArtistsAdded( const QList<Tomahawk::artist_ptr>& artists )
     {
         PlayableItem* artistitem = new PlayableItem( artist, rootItem() );
         artistitem->index = createIndex( rootItem()->children.count() - 1, 0, artistitem );
-        connect( artistitem, SIGNAL( dataChanged() ), SLOT( onDataChanged() ) );
+        subscribe( artistitem );
     }
 
     emit endInsertRows();
@@ -315,7 +333,7 @@ TreeModel::onTracksAdded( const QList<Tomahawk::query_ptr>& tracks, const QModel
         PlayableItem* item = new PlayableItem( query, parentItem );
         item->index = createIndex( parentItem->children.count() - 1, 0, item );
 
-        connect( item, SIGNAL( dataChanged() ), SLOT( onDataChanged() ) );
+        subscribe( item );
     }
 
     emit endInsertRows();
@@ -68,6 +68,7 @@ public:
     virtual QModelIndex indexFromQuery( const Tomahawk::query_ptr& query ) const;
 
 public slots:
+    void appendArtists( const QList< Tomahawk::artist_ptr >& artists );
     void addAlbums( const QModelIndex& parent, const QList<Tomahawk::album_ptr>& albums );
     void addTracks( const Tomahawk::album_ptr& album, const QModelIndex& parent );
 
@@ -105,6 +105,10 @@ TreeProxyModel::setFilter( const QString& pattern )
 
     m_filter = pattern;
 
+    // artists of pages that aren't loaded yet could match as well
+    if ( !m_filter.isEmpty() && m_model )
+        m_model->loadAllPages();
+
     beginResetModel();
     m_albumsFilter.clear();
     endResetModel();
@@ -61,7 +61,8 @@ public:
         Browsable = 0x1,        // can be represented in one or more collection tree views
         PlaylistSync = 0x2,     // can sync playlists
         AccountFactory = 0x4,   // can configure multiple accounts at the same time
-        UrlLookup = 0x8         // can be queried for information on an Url
+        UrlLookup = 0x8,        // can be queried for information on an Url
+        BatchResolve = 0x10     // can resolve a list of queries in a single call
     };
     Q_DECLARE_FLAGS( Capabilities, Capability )
     Q_FLAGS( Capabilities )
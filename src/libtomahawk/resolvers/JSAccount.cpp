@@ -25,16 +25,26 @@
 #include "ScriptObject.h"
 #include "JSResolver.h"
 
+#include <QElapsedTimer>
 #include <QWebFrame>
 #include <QFile>
 #include <QThread>
 
+// dispatching calls that takes longer than a frame shows up as a stutter
+#define JSACCOUNT_JANK_THRESHOLD 16
+
 using namespace Tomahawk;
 
 JSAccount::JSAccount( const QString& name )
     : ScriptAccount( name )
     , m_engine( new ScriptEngine( this ) )
+    , m_channel( new ScriptChannel( this ) )
+    , m_flushScheduled( false )
+    , m_dispatchedCalls( 0 )
+    , m_dispatchMsecs( 0 )
+    , m_maxDispatchMsecs( 0 )
 {
+    m_engine->mainFrame()->addToJavaScriptWindowObject( "TomahawkChannel", m_channel );
 }
 
 
@@ -75,8 +85,8 @@ JSAccount::showDebugger()
 }
 
 
-QString
-JSAccount::serializeQVariantMap( const QVariantMap& map )
+QVariantMap
+JSAccount::stripUnserializable( const QVariantMap& map )
 {
     QVariantMap localMap = map;
 
@@ -91,7 +101,14 @@ JSAccount::serializeQVariantMap( const QVariantMap& map )
         }
     }
 
-    QByteArray serialized = TomahawkUtils::toJson( localMap );
+    return localMap;
+}
+
+
+QString
+JSAccount::serializeQVariantMap( const QVariantMap& map )
+{
+    QByteArray serialized = TomahawkUtils::toJson( stripUnserializable( map ) );
 
     return QString( "JSON.parse('%1')" ).arg( JSAccount::escape( QString::fromUtf8( serialized ) ) );
 }
@@ -139,22 +156,57 @@ JSAccount::loadScripts( const QStringList& paths )
 void
 JSAccount::startJob( ScriptJob* scriptJob )
 {
-    QString eval = QString(
-        "Tomahawk.PluginManager.invoke("
-        "'%1'," // requestId
-        "'%2'," // objectId
-        "'%3'," // methodName
-        "%4"    // arguments
-        ");"
-    ).arg( scriptJob->id() )
-    .arg( scriptJob->scriptObject()->id() )
-    .arg( scriptJob->methodName() )
-    .arg( serializeQVariantMap( scriptJob->arguments() ) );
+    QVariantMap call;
+    call[ "requestId" ] = scriptJob->id();
+    call[ "objectId" ] = scriptJob->scriptObject()->id();
+    call[ "methodName" ] = scriptJob->methodName();
+    call[ "params" ] = stripUnserializable( scriptJob->arguments() );
 
-    // Remove when new scripting api turned out to work reliably
-    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << eval;
+    QMutexLocker locker( &m_pendingCallsMutex );
+    m_pendingCalls << call;
+
+    if ( !m_flushScheduled )
+    {
+        m_flushScheduled = true;
+        QMetaObject::invokeMethod( this, "flushScriptCalls", Qt::QueuedConnection );
+    }
+}
+
+
+void
+JSAccount::flushScriptCalls()
+{
+    QVariantList calls;
+    {
+        QMutexLocker locker( &m_pendingCallsMutex );
+        calls = m_pendingCalls;
+        m_pendingCalls.clear();
+        m_flushScheduled = false;
+    }
 
-    evaluateJavaScript( eval );
+    if ( calls.isEmpty() )
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    m_channel->dispatch( calls );
+
+    const qint64 elapsed = timer.elapsed();
+    m_dispatchedCalls += calls.count();
+    m_dispatchMsecs += elapsed;
+    m_maxDispatchMsecs = qMax( m_maxDispatchMsecs, elapsed );
+
+    if ( elapsed > JSACCOUNT_JANK_THRESHOLD )
+    {
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << name() << "Dispatching" << calls.count() << "script calls blocked for" << elapsed << "ms";
+    }
+
+    if ( m_dispatchedCalls / 1000 != ( m_dispatchedCalls - calls.count() ) / 1000 )
+    {
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << name() << "Dispatched" << m_dispatchedCalls << "script calls in" << m_dispatchMsecs
+                             << "ms, longest block:" << m_maxDispatchMsecs << "ms";
+    }
 }
 
 
@@ -178,39 +230,23 @@ JSAccount::syncInvoke( const scriptobject_ptr& scriptObject, const QString& meth
     return evaluateJavaScriptWithResult( eval );
 }
 
+
 void
 JSAccount::reportNativeScriptJobResult( int resultId, const QVariantMap& result )
 {
-    QString eval = QString(
-        "Tomahawk.NativeScriptJobManager.reportNativeScriptJobResult("
-        "%1," // requestId
-        "%2"    // results
-        ");"
-    ).arg( resultId )
-    .arg( serializeQVariantMap( result ) );
-
-    // Remove when new scripting api turned out to work reliably
-    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << eval;
-
-    evaluateJavaScript( eval );
+    // the channel lives on the WebKit thread, its slots must not be called from anywhere else
+    QMetaObject::invokeMethod( m_channel, "reportResult", Qt::AutoConnection,
+                               Q_ARG( int, resultId ),
+                               Q_ARG( QVariantMap, stripUnserializable( result ) ) );
 }
 
 
 void
 JSAccount::reportNativeScriptJobError( int resultId, const QVariantMap& error )
 {
-    QString eval = QString(
-        "Tomahawk.NativeScriptJobManager.reportNativeScriptJobError("
-        "%1," // requestId
-        "%2"    // results
-        ");"
-    ).arg( resultId )
-    .arg( serializeQVariantMap( error ) );
-
-    // Remove when new scripting api turned out to work reliably
-    tDebug( LOGVERBOSE ) << Q_FUNC_INFO << eval;
-
-    evaluateJavaScript( eval );
+    QMetaObject::invokeMethod( m_channel, "reportError", Qt::AutoConnection,
+                               Q_ARG( int, resultId ),
+                               Q_ARG( QVariantMap, stripUnserializable( error ) ) );
 }
 
 
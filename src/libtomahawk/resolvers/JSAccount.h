@@ -22,6 +22,7 @@
 
 #include "ScriptAccount.h"
 
+#include <QMutex>
 #include <QVariantMap>
 #include <QObject>
 
@@ -36,6 +37,30 @@ namespace Tomahawk
 class ScriptEngine;
 class JSResolver;
 
+/**
+ * Structured channel into the script engine. tomahawk.js connects to these
+ * signals, so calling into a script hands over plain QVariants instead of
+ * building, parsing and compiling a new snippet of JavaScript for each call.
+ */
+class ScriptChannel : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ScriptChannel( QObject* parent ) : QObject( parent ) {}
+
+public slots:
+    void dispatch( const QVariantList& calls ) { emit invoke( calls ); }
+    void reportResult( int requestId, const QVariantMap& result ) { emit nativeScriptJobResult( requestId, result ); }
+    void reportError( int requestId, const QVariantMap& error ) { emit nativeScriptJobError( requestId, error ); }
+
+signals:
+    /// Each call is a map with requestId, objectId, methodName and params
+    void invoke( const QVariantList& calls );
+    void nativeScriptJobResult( int requestId, const QVariantMap& result );
+    void nativeScriptJobError( int requestId, const QVariantMap& error );
+};
+
 class DLLEXPORT JSAccount : public ScriptAccount
 {
     Q_OBJECT
@@ -76,13 +101,31 @@ public:
     void reportNativeScriptJobResult( int resultId, const QVariantMap& result ) override;
     void reportNativeScriptJobError( int resultId, const QVariantMap& error ) override;
 
+private slots:
+    void flushScriptCalls();
+
 private:
+    /// Drops values that can't be handed to JavaScript
+    static QVariantMap stripUnserializable( const QVariantMap& map );
+
     /**
         * Wrap the pure evaluateJavaScript call in here, while the threadings guards are in public methods
         */
     QVariant evaluateJavaScriptInternal( const QString& scriptSource );
 
     ScriptEngine* m_engine;
+    ScriptChannel* m_channel;
+
+    // calls started since the last flush, all of them get dispatched in one go
+    QVariantList m_pendingCalls;
+    QMutex m_pendingCallsMutex;
+    bool m_flushScheduled;
+
+    // how long dispatching calls kept the GUI thread busy
+    quint64 m_dispatchedCalls;
+    qint64 m_dispatchMsecs;
+    qint64 m_maxDispatchMsecs;
+
     // HACK: the order of initializen is flawed, tbr
     JSResolver* m_resolver;
 };
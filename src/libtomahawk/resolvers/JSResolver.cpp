@@ -45,6 +45,7 @@
 #include "ScriptInfoPlugin.h"
 #include "JSAccount.h"
 #include "ScriptJob.h"
+#include "ScriptCommandQueue.h"
 
 // lookupUrl stuff
 #include "playlist/PlaylistTemplate.h"
@@ -60,6 +61,9 @@
 #include <QMetaProperty>
 #include <QWebFrame>
 
+// queries handed to a script in a single resolveBatch call
+#define JSRESOLVER_BATCH_SIZE 50
+
 using namespace Tomahawk;
 
 JSResolver::JSResolver( const QString& accountId, const QString& scriptPath, const QStringList& additionalScriptPaths )
@@ -343,6 +347,14 @@ JSResolver::canParseUrl( const QString& url, UrlType type )
 }
 
 
+void
+JSResolver::enqueue( const QSharedPointer< ScriptCommand >& req )
+{
+    // share the account's queue, so url lookups and collection browsing don't starve each other
+    scriptAccount()->commandQueue()->enqueue( req );
+}
+
+
 void
 JSResolver::lookupUrl( const QString& url )
 {
@@ -546,46 +558,94 @@ JSResolver::resolve( const Tomahawk::query_ptr& query )
     job->start();
 }
 
+
+void
+JSResolver::resolve( const QList< Tomahawk::query_ptr >& queries )
+{
+    ScriptJob* job = scriptAccount()->resolveBatch( scriptObject(), queries, "resolver" );
+    connect( job, SIGNAL( done( QVariantMap ) ), SLOT( onResolveBatchRequestDone( QVariantMap ) ) );
+
+    job->start();
+}
+
+
+unsigned int
+JSResolver::maxBatchSize() const
+{
+    Q_D( const JSResolver );
+
+    if ( d->capabilities.testFlag( ExternalResolver::BatchResolve ) )
+        return JSRESOLVER_BATCH_SIZE;
+
+    return 1;
+}
+
+
 void
 JSResolver::onResolveRequestDone( const QVariantMap& data )
 {
     Q_ASSERT( QThread::currentThread() == thread() );
-    Q_D( JSResolver );
 
     ScriptJob* job = qobject_cast< ScriptJob* >( sender() );
 
     QID qid = job->property( "qid" ).toString();
 
     if ( job->error() )
-    {
         Tomahawk::Pipeline::instance()->reportError( qid, this );
-    }
     else
-    {
-        if ( !data.value( "artists" ).isNull() )
-        {
-            QList< artist_ptr > artists = scriptAccount()->parseArtistVariantList( data.value( "artists" ).toList() );
-            Tomahawk::Pipeline::instance()->reportArtists( qid, artists );
-        }
+        reportResolveResult( qid, data );
 
-        if ( !data.value( "albums" ).isNull() )
-        {
-            QList< album_ptr > albums = scriptAccount()->parseAlbumVariantList( data.value( "albums" ).toList() );
-            Tomahawk::Pipeline::instance()->reportAlbums( qid, albums );
-        }
+    sender()->deleteLater();
+}
 
-        QList< Tomahawk::result_ptr > results = scriptAccount()->parseResultVariantList( data.value( "tracks" ).toList() );
-        foreach( const result_ptr& result, results )
-        {
-            result->setResolvedByResolver( this );
-            result->setFriendlySource( name() );
-        }
-        Tomahawk::Pipeline::instance()->reportResults( qid, this, results );
+
+void
+JSResolver::onResolveBatchRequestDone( const QVariantMap& data )
+{
+    Q_ASSERT( QThread::currentThread() == thread() );
+
+    ScriptJob* job = qobject_cast< ScriptJob* >( sender() );
+
+    const QStringList qids = job->property( "qids" ).toStringList();
+    const QVariantMap results = data.value( "results" ).toMap();
+
+    foreach ( const QID& qid, qids )
+    {
+        // a query the script did not answer counts as failed, so the pipeline does not wait for its timeout
+        if ( job->error() || !results.contains( qid ) )
+            Tomahawk::Pipeline::instance()->reportError( qid, this );
+        else
+            reportResolveResult( qid, results.value( qid ).toMap() );
     }
 
     sender()->deleteLater();
 }
 
+
+void
+JSResolver::reportResolveResult( const QID& qid, const QVariantMap& data )
+{
+    if ( !data.value( "artists" ).isNull() )
+    {
+        QList< artist_ptr > artists = scriptAccount()->parseArtistVariantList( data.value( "artists" ).toList() );
+        Tomahawk::Pipeline::instance()->reportArtists( qid, artists );
+    }
+
+    if ( !data.value( "albums" ).isNull() )
+    {
+        QList< album_ptr > albums = scriptAccount()->parseAlbumVariantList( data.value( "albums" ).toList() );
+        Tomahawk::Pipeline::instance()->reportAlbums( qid, albums );
+    }
+
+    QList< Tomahawk::result_ptr > results = scriptAccount()->parseResultVariantList( data.value( "tracks" ).toList() );
+    foreach( const result_ptr& result, results )
+    {
+        result->setResolvedByResolver( this );
+        result->setFriendlySource( name() );
+    }
+    Tomahawk::Pipeline::instance()->reportResults( qid, this, results );
+}
+
 void
 JSResolver::stop()
 {
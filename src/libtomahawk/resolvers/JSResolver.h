@@ -70,6 +70,7 @@ public:
     void setIcon( const QPixmap& icon ) override;
 
     bool canParseUrl( const QString& url, UrlType type ) override;
+    void enqueue( const QSharedPointer< ScriptCommand >& req ) override;
 
     QVariantMap loadDataFromWidgets();
 
@@ -79,8 +80,11 @@ public:
     ScriptJob* getDownloadUrl( const result_ptr& result, const DownloadFormat &format ) override;
 
 
+    unsigned int maxBatchSize() const override;
+
 public slots:
     void resolve( const Tomahawk::query_ptr& query ) override;
+    void resolve( const QList< Tomahawk::query_ptr >& queries ) override;
     void stop() override;
     void start() override;
 
@@ -95,6 +99,7 @@ protected:
 
 private slots:
     void onResolveRequestDone(const QVariantMap& data);
+    void onResolveBatchRequestDone( const QVariantMap& data );
     void onLookupUrlRequestDone(const QVariantMap& data);
 
 private:
@@ -102,6 +107,7 @@ private:
 
     void loadUi();
     void onCapabilitiesChanged( Capabilities capabilities );
+    void reportResolveResult( const QID& qid, const QVariantMap& data );
 
     // encapsulate javascript calls
     QVariantMap resolverUserConfig();
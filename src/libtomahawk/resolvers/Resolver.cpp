@@ -37,6 +37,21 @@ Tomahawk::Resolver::icon( const QSize& ) const
 }
 
 
+unsigned int
+Tomahawk::Resolver::maxBatchSize() const
+{
+    return 1;
+}
+
+
+void
+Tomahawk::Resolver::resolve( const QList< Tomahawk::query_ptr >& queries )
+{
+    foreach ( const Tomahawk::query_ptr& query, queries )
+        resolve( query );
+}
+
+
 Tomahawk::ScriptJob*
 Tomahawk::Resolver::getStreamUrl( const result_ptr& result )
 {
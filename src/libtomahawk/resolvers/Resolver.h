@@ -52,6 +52,14 @@ public:
     virtual unsigned int timeout() const = 0;
 
     virtual void resolve( const Tomahawk::query_ptr& query ) = 0;
+
+    /**
+     * Maximum number of queries this resolver accepts in a single resolve( QList ) call.
+     * Resolvers returning 1 (the default) only ever get handed single queries.
+     */
+    virtual unsigned int maxBatchSize() const;
+    virtual void resolve( const QList< Tomahawk::query_ptr >& queries );
+
     virtual ScriptJob* getStreamUrl( const result_ptr& result );
     virtual ScriptJob* getDownloadUrl( const result_ptr& result, const DownloadFormat& format );
 };
@@ -20,6 +20,7 @@
 
 #include "ScriptAccount.h"
 
+#include "ScriptCommandQueue.h"
 #include "ScriptObject.h"
 #include "../utils/Logger.h"
 #include "../Typedefs.h"
@@ -49,6 +50,7 @@ ScriptAccount::ScriptAccount( const QString& name )
     , m_stopped( true )
     , m_collectionFactory( new ScriptCollectionFactory() )
     , m_infoPluginFactory( new ScriptInfoPluginFactory() )
+    , m_commandQueue( new ScriptCommandQueue( this ) )
 {
 }
 
@@ -122,6 +124,13 @@ ScriptAccount::filePath() const
 }
 
 
+ScriptCommandQueue*
+ScriptAccount::commandQueue() const
+{
+    return m_commandQueue;
+}
+
+
 static QString
 requestIdGenerator()
 {
@@ -440,3 +449,36 @@ ScriptAccount::resolve( const scriptobject_ptr& scriptObject, const query_ptr& q
 
     return job;
 }
+
+
+ScriptJob*
+ScriptAccount::resolveBatch( const scriptobject_ptr& scriptObject, const QList< query_ptr >& queries, const QString& resolveType )
+{
+    QVariantList list;
+    QStringList qids;
+    foreach ( const query_ptr& query, queries )
+    {
+        QVariantMap q;
+        q["qid"] = query->id();
+        if ( !query->isFullTextQuery() )
+        {
+            q["artist"] = query->queryTrack()->artist();
+            q["album"] = query->queryTrack()->album();
+            q["track"] = query->queryTrack()->track();
+        }
+        else
+            q["query"] = query->fullTextQuery();
+
+        list << q;
+        qids << query->id();
+    }
+
+    QVariantMap arguments;
+    arguments["queries"] = list;
+    arguments["type"] = resolveType;
+
+    ScriptJob* job = scriptObject->invoke( "resolveBatch", arguments );
+    job->setProperty( "qids", qids );
+
+    return job;
+}
@@ -40,6 +40,7 @@ namespace Tomahawk {
 class ScriptObject;
 class ScriptJob;
 class ScriptCollectionFactory;
+class ScriptCommandQueue;
 class ScriptInfoPluginFactory;
 
 class DLLEXPORT ScriptAccount : public QObject
@@ -63,6 +64,9 @@ public:
     void setFilePath( const QString& filePath );
     QString filePath() const;
 
+    /// Runs the browse and lookup commands for this account's collections and resolver
+    ScriptCommandQueue* commandQueue() const;
+
     ScriptJob* invoke( const scriptobject_ptr& scriptObject, const QString& methodName, const QVariantMap& arguments );
     virtual QVariant syncInvoke( const scriptobject_ptr& scriptObject, const QString& methodName, const QVariantMap& arguments ) = 0;
     virtual void startJob( ScriptJob* scriptJob ) = 0;
@@ -83,6 +87,8 @@ public:
     QList< Tomahawk::album_ptr > parseAlbumVariantList( const QVariantList& albumList );
     QList< Tomahawk::result_ptr > parseResultVariantList( const QVariantList& reslist );
     ScriptJob* resolve( const scriptobject_ptr& scriptObject, const query_ptr& query, const QString& resolveType );
+    // one job for all queries, the result maps each qid to what resolve/search would have returned for it
+    ScriptJob* resolveBatch( const scriptobject_ptr& scriptObject, const QList< query_ptr >& queries, const QString& resolveType );
 
 private slots:
     void onJobDeleted( const QString& jobId );
@@ -100,6 +106,7 @@ private: // TODO: pimple, might be renamed before tho
     // port to QScopedPointer when pimple'd
     ScriptCollectionFactory* m_collectionFactory;
     ScriptInfoPluginFactory* m_infoPluginFactory;
+    ScriptCommandQueue* m_commandQueue;
 };
 
 } // ns: Tomahawk
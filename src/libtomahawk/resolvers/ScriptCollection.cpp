@@ -28,14 +28,19 @@
 #include "resolvers/ScriptCommand_AllTracks.h"
 #include "resolvers/ScriptJob.h"
 #include "ScriptAccount.h"
+#include "ScriptCollectionMirror.h"
 #include "Result.h"
 #include "Pipeline.h"
+#include "FuncTimeout.h"
 
 #include <QImageReader>
 #include <QPainter>
 #include <QFileInfo>
 
 
+// queries handed to the collection in a single resolveBatch call
+#define SCRIPTCOLLECTION_BATCH_SIZE 100
+
 using namespace Tomahawk;
 
 
@@ -47,6 +52,8 @@ ScriptCollection::ScriptCollection( const scriptobject_ptr& scriptObject,
     , ScriptPlugin( scriptObject )
     , m_scriptAccount( scriptAccount )
     , m_trackCount( -1 ) //null value
+    , m_batchResolve( false )
+    , m_mirror( 0 )
     , m_isOnline( true )
 {
     Q_ASSERT( scriptAccount );
@@ -177,6 +184,13 @@ ScriptCollection::description() const
 Tomahawk::ArtistsRequest*
 ScriptCollection::requestArtists()
 {
+    if ( m_mirror && m_mirror->isReady() )
+    {
+        // opening the collection is a good time to pick up changes for the next time
+        m_mirror->sync();
+        return new MirrorArtistsRequest( m_mirror );
+    }
+
     Tomahawk::ArtistsRequest* cmd = new ScriptCommand_AllArtists( weakRef().toStrongRef() );
 
     return cmd;
@@ -186,6 +200,9 @@ ScriptCollection::requestArtists()
 Tomahawk::AlbumsRequest*
 ScriptCollection::requestAlbums( const Tomahawk::artist_ptr& artist )
 {
+    if ( m_mirror && m_mirror->isReady() )
+        return new MirrorAlbumsRequest( m_mirror, artist );
+
     Tomahawk::AlbumsRequest* cmd = new ScriptCommand_AllAlbums( weakRef().toStrongRef(), artist );
 
     return cmd;
@@ -195,6 +212,9 @@ ScriptCollection::requestAlbums( const Tomahawk::artist_ptr& artist )
 Tomahawk::TracksRequest*
 ScriptCollection::requestTracks( const Tomahawk::album_ptr& album )
 {
+    if ( m_mirror && m_mirror->isReady() )
+        return new MirrorTracksRequest( m_mirror, weakRef().toStrongRef(), album );
+
     Tomahawk::TracksRequest* cmd = new ScriptCommand_AllTracks( weakRef().toStrongRef(), album );
 
     return cmd;
@@ -266,6 +286,16 @@ ScriptCollection::parseMetaData( const QVariantMap& metadata )
             setTrackCount( trackCount );
     }
 
+    m_batchResolve = metadata.value( "batchresolve" ).toBool();
+
+    if ( metadata.value( "mirror" ).toBool() )
+    {
+        if ( !m_mirror )
+            m_mirror = new ScriptCollectionMirror( this, scriptAccount()->name() + "_" + metadata.value( "id" ).toString() );
+
+        m_mirror->sync( metadata.value( "revision" ).toString() );
+    }
+
     if ( metadata.contains( "iconfile" ) )
     {
         QString iconPath = QFileInfo( scriptAccount()->filePath() ).path() + "/"
@@ -368,6 +398,14 @@ ScriptCollection::weight() const
 void
 ScriptCollection::resolve( const Tomahawk::query_ptr& query )
 {
+    // the mirror can't be searched while its index is being rebuilt, the script can
+    if ( m_mirror && m_mirror->isReady() && !m_mirror->isIndexing() )
+    {
+        // report asynchronously, like any other resolver
+        new FuncTimeout( 0, std::bind( &ScriptCollection::resolveFromMirror, this, QList< Tomahawk::query_ptr >() << query ), this );
+        return;
+    }
+
     ScriptJob* job = scriptAccount()->resolve( scriptObject(), query, "collection" );
 
     connect( job, SIGNAL( done( QVariantMap ) ), SLOT( onResolveRequestDone( QVariantMap ) ) );
@@ -376,6 +414,30 @@ ScriptCollection::resolve( const Tomahawk::query_ptr& query )
 }
 
 
+unsigned int
+ScriptCollection::maxBatchSize() const
+{
+    return m_batchResolve ? SCRIPTCOLLECTION_BATCH_SIZE : 1;
+}
+
+
+void
+ScriptCollection::resolve( const QList< Tomahawk::query_ptr >& queries )
+{
+    if ( m_mirror && m_mirror->isReady() && !m_mirror->isIndexing() )
+    {
+        new FuncTimeout( 0, std::bind( &ScriptCollection::resolveFromMirror, this, queries ), this );
+        return;
+    }
+
+    ScriptJob* job = scriptAccount()->resolveBatch( scriptObject(), queries, "collection" );
+
+    connect( job, SIGNAL( done( QVariantMap ) ), SLOT( onResolveBatchRequestDone( QVariantMap ) ) );
+
+    job->start();
+}
+
+
 void
 ScriptCollection::onResolveRequestDone( const QVariantMap& data )
 {
@@ -386,21 +448,69 @@ ScriptCollection::onResolveRequestDone( const QVariantMap& data )
     QID qid = job->property( "qid" ).toString();
 
     if ( job->error() )
-    {
         Tomahawk::Pipeline::instance()->reportError( qid, this );
-    }
     else
-    {
-        QList< Tomahawk::result_ptr > results = scriptAccount()->parseResultVariantList( data.value( "tracks" ).toList() );
+        reportResolveResult( qid, data );
 
-        foreach( const result_ptr& result, results )
-        {
-            result->setResolvedByCollection( weakRef().toStrongRef() );
-            result->setFriendlySource( prettyName() );
-        }
+    sender()->deleteLater();
+}
 
-        Tomahawk::Pipeline::instance()->reportResults( qid, this, results );
+
+void
+ScriptCollection::onResolveBatchRequestDone( const QVariantMap& data )
+{
+    Q_ASSERT( QThread::currentThread() == thread() );
+
+    ScriptJob* job = qobject_cast< ScriptJob* >( sender() );
+
+    const QStringList qids = job->property( "qids" ).toStringList();
+    const QVariantMap results = data.value( "results" ).toMap();
+
+    foreach ( const QID& qid, qids )
+    {
+        if ( job->error() || !results.contains( qid ) )
+            Tomahawk::Pipeline::instance()->reportError( qid, this );
+        else
+            reportResolveResult( qid, results.value( qid ).toMap() );
     }
 
     sender()->deleteLater();
 }
+
+
+void
+ScriptCollection::reportResolveResult( const QID& qid, const QVariantMap& data )
+{
+    QList< Tomahawk::result_ptr > results = scriptAccount()->parseResultVariantList( data.value( "tracks" ).toList() );
+
+    foreach( const result_ptr& result, results )
+    {
+        result->setResolvedByCollection( weakRef().toStrongRef() );
+        result->setFriendlySource( prettyName() );
+    }
+
+    Tomahawk::Pipeline::instance()->reportResults( qid, this, results );
+}
+
+
+void
+ScriptCollection::resolveFromMirror( const QList< Tomahawk::query_ptr >& queries )
+{
+    // a sync may have started reindexing since, hand the queries to the script instead
+    if ( m_mirror->isIndexing() )
+    {
+        if ( queries.count() == 1 )
+            resolve( queries.first() );
+        else
+            resolve( queries );
+        return;
+    }
+
+    foreach ( const Tomahawk::query_ptr& query, queries )
+    {
+        QVariantMap data;
+        data[ "tracks" ] = m_mirror->resolve( query );
+
+        reportResolveResult( query->id(), data );
+    }
+}
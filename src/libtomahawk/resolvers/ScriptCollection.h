@@ -35,6 +35,7 @@
 namespace Tomahawk
 {
 class ScriptAccount;
+class ScriptCollectionMirror;
 
 class DLLEXPORT ScriptCollection : public Collection, public ScriptPlugin
 {
@@ -95,19 +96,27 @@ public:
     unsigned int weight() const override;
     unsigned int timeout() const override;
     void resolve( const Tomahawk::query_ptr& query ) override;
+    unsigned int maxBatchSize() const override;
+    void resolve( const QList< Tomahawk::query_ptr >& queries ) override;
     ScriptJob* getStreamUrl( const result_ptr& result ) override;
     ScriptJob* getDownloadUrl( const result_ptr& result, const DownloadFormat &format ) override;
 
 private slots:
     void onIconFetched();
     void onResolveRequestDone( const QVariantMap& data );
+    void onResolveBatchRequestDone( const QVariantMap& data );
 
 private:
+    void reportResolveResult( const QID& qid, const QVariantMap& data );
+    void resolveFromMirror( const QList< Tomahawk::query_ptr >& queries );
+
     ScriptAccount* m_scriptAccount;
     QString m_servicePrettyName;
     QString m_description;
     int m_trackCount;
     int m_weight;
+    bool m_batchResolve;
+    ScriptCollectionMirror* m_mirror;
     QPixmap m_icon;
     bool m_isOnline;
 };
@@ -0,0 +1,456 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Teo Mrnjavac <teo@kde.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ScriptCollectionMirror.h"
+
+#include "database/DatabaseCommand_UpdateSearchIndex.h"
+#include "database/fuzzyindex/FuzzyIndex.h"
+#include "utils/Logger.h"
+#include "utils/TomahawkUtils.h"
+
+#include "Album.h"
+#include "Artist.h"
+#include "Query.h"
+#include "Result.h"
+#include "ScriptAccount.h"
+#include "ScriptCollection.h"
+#include "ScriptJob.h"
+#include "ScriptObject.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QRegExp>
+#include <QSet>
+#include <QtConcurrentRun>
+
+#include <algorithm>
+
+// bump when the on-disk format changes, older mirrors get synced from scratch
+#define SCRIPTCOLLECTIONMIRROR_VERSION 1
+
+using namespace Tomahawk;
+
+
+ScriptCollectionMirror::ScriptCollectionMirror( ScriptCollection* collection, const QString& id )
+    : QObject( collection )
+    , m_collection( collection )
+    , m_ready( false )
+    , m_syncing( false )
+    , m_nextLocalId( 0 )
+    , m_reindexPending( false )
+{
+    QString fileName = id;
+    fileName.replace( QRegExp( "[^A-Za-z0-9_.-]" ), "_" );
+    fileName = "collectionmirror_" + fileName;
+
+    m_path = TomahawkUtils::appDataDir().absoluteFilePath( fileName + ".dat" );
+    load();
+
+    // without its listing the index is useless, start over
+    m_fuzzyIndex.reset( new FuzzyIndex( 0, fileName + ".lucene", !m_ready ) );
+
+    connect( &m_indexWatcher, SIGNAL( finished() ), SLOT( onIndexed() ) );
+}
+
+
+ScriptCollectionMirror::~ScriptCollectionMirror()
+{
+    m_indexWatcher.waitForFinished();
+}
+
+
+void
+ScriptCollectionMirror::load()
+{
+    QFile file( m_path );
+    if ( !file.open( QIODevice::ReadOnly ) )
+        return;
+
+    QDataStream stream( &file );
+    quint32 version;
+    stream >> version;
+    if ( version != SCRIPTCOLLECTIONMIRROR_VERSION )
+    {
+        tDebug() << Q_FUNC_INFO << "Ignoring outdated collection mirror" << m_path;
+        return;
+    }
+
+    qint32 nextLocalId;
+    stream >> m_revision >> nextLocalId >> m_tracks;
+    if ( stream.status() != QDataStream::Ok )
+    {
+        tLog() << Q_FUNC_INFO << "Could not read collection mirror" << m_path;
+        m_revision.clear();
+        m_tracks.clear();
+        return;
+    }
+    m_nextLocalId = nextLocalId;
+
+    QMap< int, QVariantMap >::const_iterator it = m_tracks.constBegin();
+    for ( ; it != m_tracks.constEnd(); ++it )
+    {
+        const QString id = it.value().value( "id" ).toString();
+        if ( !id.isEmpty() )
+            m_localIds.insert( id, it.key() );
+    }
+
+    m_ready = true;
+    tDebug() << Q_FUNC_INFO << "Loaded" << m_tracks.count() << "tracks at revision" << m_revision << "from" << m_path;
+}
+
+
+void
+ScriptCollectionMirror::save() const
+{
+    QFile file( m_path + ".tmp" );
+    if ( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        tLog() << Q_FUNC_INFO << "Could not write collection mirror" << file.fileName();
+        return;
+    }
+
+    QDataStream stream( &file );
+    stream << (quint32)SCRIPTCOLLECTIONMIRROR_VERSION << m_revision << (qint32)m_nextLocalId << m_tracks;
+    file.close();
+
+    QFile::remove( m_path );
+    if ( !QFile::rename( file.fileName(), m_path ) )
+        tLog() << Q_FUNC_INFO << "Could not replace collection mirror" << m_path;
+}
+
+
+void
+ScriptCollectionMirror::sync( const QString& revision )
+{
+    if ( m_syncing )
+        return;
+    if ( m_ready && !revision.isEmpty() && revision == m_revision )
+        return;
+
+    m_syncing = true;
+
+    QVariantMap arguments;
+    arguments[ "revision" ] = m_ready ? m_revision : QString();
+
+    ScriptJob* job = m_collection->scriptObject()->invoke( "changes", arguments );
+    connect( job, SIGNAL( done( QVariantMap ) ), SLOT( onChangesJobDone( QVariantMap ) ), Qt::QueuedConnection );
+    job->start();
+}
+
+
+void
+ScriptCollectionMirror::onChangesJobDone( const QVariantMap& result )
+{
+    ScriptJob* job = qobject_cast< ScriptJob* >( sender() );
+    Q_ASSERT( job );
+    job->deleteLater();
+
+    m_syncing = false;
+    if ( job->error() )
+    {
+        tLog() << Q_FUNC_INFO << "Could not sync collection mirror" << m_path;
+        return;
+    }
+
+    bool changed = result.value( "reset" ).toBool();
+    if ( changed )
+    {
+        m_tracks.clear();
+        m_localIds.clear();
+        m_nextLocalId = 0;
+    }
+
+    foreach ( const QVariant& id, result.value( "removed" ).toList() )
+    {
+        if ( !m_localIds.contains( id.toString() ) )
+            continue;
+
+        m_tracks.remove( m_localIds.take( id.toString() ) );
+        changed = true;
+    }
+
+    foreach ( const QVariant& v, result.value( "tracks" ).toList() )
+    {
+        const QVariantMap track = v.toMap();
+        const QString id = track.value( "id" ).toString();
+        if ( !id.isEmpty() && m_localIds.contains( id ) )
+            m_tracks[ m_localIds.value( id ) ] = track;
+        else
+            addTrack( track );
+
+        changed = true;
+    }
+
+    m_revision = result.value( "revision" ).toString();
+
+    // the listing is saved once the index caught up, so both stay in line on disk
+    if ( changed || !m_ready )
+        rebuildIndex();
+
+    tDebug() << Q_FUNC_INFO << "Synced" << m_tracks.count() << "tracks to revision" << m_revision << "changed:" << changed;
+
+    m_ready = true;
+    emit synced();
+}
+
+
+int
+ScriptCollectionMirror::addTrack( const QVariantMap& track )
+{
+    const int localId = m_nextLocalId++;
+    m_tracks.insert( localId, track );
+
+    const QString id = track.value( "id" ).toString();
+    if ( !id.isEmpty() )
+        m_localIds.insert( id, localId );
+
+    return localId;
+}
+
+
+void
+ScriptCollectionMirror::rebuildIndex()
+{
+    // a single job at a time, changes arriving meanwhile are picked up once it's done
+    m_reindexPending = true;
+    if ( m_indexWatcher.isRunning() )
+        return;
+
+    m_reindexPending = false;
+
+    // FuzzyIndex always starts a new index when writing, so it gets the whole listing
+    QList< IndexData > entries;
+    QMap< int, QVariantMap >::const_iterator it = m_tracks.constBegin();
+    for ( ; it != m_tracks.constEnd(); ++it )
+    {
+        IndexData data;
+        data.id = it.key();
+        data.artistId = 0;
+        data.artist = it.value().value( "artist" ).toString();
+        data.album = it.value().value( "album" ).toString();
+        data.track = it.value().value( "track" ).toString();
+        entries << data;
+    }
+
+    m_indexWatcher.setFuture( QtConcurrent::run( &ScriptCollectionMirror::writeIndex, m_fuzzyIndex.data(), entries ) );
+}
+
+
+void
+ScriptCollectionMirror::writeIndex( FuzzyIndex* index, const QList< Tomahawk::IndexData >& data )
+{
+    index->beginIndexing();
+    foreach ( const IndexData& entry, data )
+        index->appendFields( entry );
+    index->endIndexing();
+}
+
+
+void
+ScriptCollectionMirror::onIndexed()
+{
+    if ( m_reindexPending )
+    {
+        rebuildIndex();
+        return;
+    }
+
+    save();
+}
+
+
+QString
+ScriptCollectionMirror::albumArtist( const QVariantMap& track )
+{
+    const QString albumArtist = track.value( "albumArtist" ).toString();
+    if ( !albumArtist.isEmpty() )
+        return albumArtist;
+
+    return track.value( "artist" ).toString();
+}
+
+
+bool
+ScriptCollectionMirror::matches( const QVariantMap& track, const QString& filter )
+{
+    if ( filter.isEmpty() )
+        return true;
+
+    return track.value( "artist" ).toString().contains( filter, Qt::CaseInsensitive ) ||
+           track.value( "album" ).toString().contains( filter, Qt::CaseInsensitive ) ||
+           track.value( "track" ).toString().contains( filter, Qt::CaseInsensitive );
+}
+
+
+QList< Tomahawk::artist_ptr >
+ScriptCollectionMirror::artists( const QString& filter ) const
+{
+    QSet< QString > names;
+    foreach ( const QVariantMap& track, m_tracks )
+    {
+        const QString artist = track.value( "artist" ).toString().trimmed();
+        if ( !artist.isEmpty() && matches( track, filter ) )
+            names.insert( artist );
+    }
+
+    QList< Tomahawk::artist_ptr > artists;
+    foreach ( const QString& name, names )
+        artists << Tomahawk::Artist::get( name, false );
+
+    return artists;
+}
+
+
+QList< Tomahawk::album_ptr >
+ScriptCollectionMirror::albums( const Tomahawk::artist_ptr& artist, const QString& filter ) const
+{
+    QSet< QPair< QString, QString > > found;
+    foreach ( const QVariantMap& track, m_tracks )
+    {
+        const QString album = track.value( "album" ).toString().trimmed();
+        if ( album.isEmpty() || !matches( track, filter ) )
+            continue;
+
+        const QString owner = albumArtist( track );
+        if ( artist && owner != artist->name() && track.value( "artist" ).toString() != artist->name() )
+            continue;
+
+        found.insert( qMakePair( owner, album ) );
+    }
+
+    QList< Tomahawk::album_ptr > albums;
+    QPair< QString, QString > album;
+    foreach ( album, found )
+        albums << Tomahawk::Album::get( Tomahawk::Artist::get( album.first, false ), album.second, false );
+
+    return albums;
+}
+
+
+QVariantList
+ScriptCollectionMirror::tracks( const Tomahawk::album_ptr& album ) const
+{
+    QList< QVariantMap > found;
+    foreach ( const QVariantMap& track, m_tracks )
+    {
+        if ( album && ( track.value( "album" ).toString() != album->name() ||
+                        albumArtist( track ) != album->artist()->name() ) )
+            continue;
+
+        found << track;
+    }
+
+    if ( album )
+    {
+        std::stable_sort( found.begin(), found.end(), []( const QVariantMap& a, const QVariantMap& b )
+        {
+            return a.value( "albumpos" ).toUInt() < b.value( "albumpos" ).toUInt();
+        } );
+    }
+
+    QVariantList tracks;
+    foreach ( const QVariantMap& track, found )
+        tracks << track;
+
+    return tracks;
+}
+
+
+QVariantList
+ScriptCollectionMirror::resolve( const Tomahawk::query_ptr& query ) const
+{
+    const QMap< int, float > matches = m_fuzzyIndex->search( query );
+
+    QList< QPair< float, int > > scored;
+    QMap< int, float >::const_iterator it = matches.constBegin();
+    for ( ; it != matches.constEnd(); ++it )
+    {
+        if ( m_tracks.contains( it.key() ) )
+            scored << qMakePair( it.value(), it.key() );
+    }
+    std::sort( scored.begin(), scored.end(), []( const QPair< float, int >& a, const QPair< float, int >& b )
+    {
+        return a.first > b.first;
+    } );
+
+    QVariantList tracks;
+    for ( int i = 0; i < scored.count(); i++ )
+        tracks << m_tracks.value( scored.at( i ).second );
+
+    return tracks;
+}
+
+
+void
+MirrorArtistsRequest::enqueue()
+{
+    // callers connect to our signal after creating us, so answer from the event loop
+    QMetaObject::invokeMethod( this, "report", Qt::QueuedConnection );
+}
+
+
+void
+MirrorArtistsRequest::report()
+{
+    emit artists( m_mirror ? m_mirror->artists( m_filter ) : QList< Tomahawk::artist_ptr >() );
+    deleteLater();
+}
+
+
+void
+MirrorAlbumsRequest::enqueue()
+{
+    QMetaObject::invokeMethod( this, "report", Qt::QueuedConnection );
+}
+
+
+void
+MirrorAlbumsRequest::report()
+{
+    emit albums( m_mirror ? m_mirror->albums( m_artist, m_filter ) : QList< Tomahawk::album_ptr >() );
+    deleteLater();
+}
+
+
+void
+MirrorTracksRequest::enqueue()
+{
+    QMetaObject::invokeMethod( this, "report", Qt::QueuedConnection );
+}
+
+
+void
+MirrorTracksRequest::report()
+{
+    QList< Tomahawk::query_ptr > queries;
+
+    QSharedPointer< ScriptCollection > collection = m_collection.objectCast< ScriptCollection >();
+    if ( m_mirror && collection )
+    {
+        QList< Tomahawk::result_ptr > results = collection->scriptAccount()->parseResultVariantList( m_mirror->tracks( m_album ) );
+        foreach ( const Tomahawk::result_ptr& result, results )
+        {
+            result->setResolvedByCollection( m_collection );
+            queries << result->toQuery();
+        }
+    }
+
+    emit tracks( queries );
+    deleteLater();
+}
@@ -0,0 +1,183 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Teo Mrnjavac <teo@kde.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCRIPTCOLLECTIONMIRROR_H
+#define SCRIPTCOLLECTIONMIRROR_H
+
+#include "collection/AlbumsRequest.h"
+#include "collection/ArtistsRequest.h"
+#include "collection/TracksRequest.h"
+
+#include "Typedefs.h"
+#include "DllMacro.h"
+
+#include <QFutureWatcher>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+#include <QScopedPointer>
+#include <QVariantMap>
+
+class FuzzyIndex;
+
+namespace Tomahawk
+{
+
+class ScriptCollection;
+struct IndexData;
+
+/**
+ * A local copy of a script collection's track listing, so browsing and resolving
+ * don't have to go into the script (and often over the network) every time.
+ *
+ * Collections opt in by setting "mirror" in their metadata and implementing
+ * changes( { revision } ), which returns { revision, reset, tracks, removed }:
+ * the tracks added or changed since the given revision, the ids of the removed
+ * ones, and whether the listing has to be replaced as a whole. The listing is kept
+ * on disk together with its own FuzzyIndex, so only changes are transferred after
+ * a restart. The index is rebuilt on a worker thread after every change.
+ */
+class DLLEXPORT ScriptCollectionMirror : public QObject
+{
+Q_OBJECT
+
+public:
+    ScriptCollectionMirror( ScriptCollection* collection, const QString& id );
+    virtual ~ScriptCollectionMirror();
+
+    /// True once the listing was loaded from disk or synced with the script
+    bool isReady() const { return m_ready; }
+    /// True while the index doesn't match the listing yet, resolve() can't be used meanwhile
+    bool isIndexing() const { return m_reindexPending || m_indexWatcher.isRunning(); }
+    QString revision() const { return m_revision; }
+
+    /// Asks the script for the changes since our revision, unless we are at revision already
+    void sync( const QString& revision = QString() );
+
+    QList< Tomahawk::artist_ptr > artists( const QString& filter ) const;
+    QList< Tomahawk::album_ptr > albums( const Tomahawk::artist_ptr& artist, const QString& filter ) const;
+    QVariantList tracks( const Tomahawk::album_ptr& album ) const;
+    /// Tracks matching query, best matches first
+    QVariantList resolve( const Tomahawk::query_ptr& query ) const;
+
+signals:
+    void synced();
+
+private slots:
+    void onChangesJobDone( const QVariantMap& result );
+    void onIndexed();
+
+private:
+    static QString albumArtist( const QVariantMap& track );
+    static bool matches( const QVariantMap& track, const QString& filter );
+
+    void load();
+    void save() const;
+    void rebuildIndex();
+    static void writeIndex( FuzzyIndex* index, const QList< Tomahawk::IndexData >& data );
+    int addTrack( const QVariantMap& track );
+
+    ScriptCollection* m_collection;
+    QString m_path;
+    QString m_revision;
+    bool m_ready;
+    bool m_syncing;
+
+    // local ids are what the FuzzyIndex knows our tracks by
+    QMap< int, QVariantMap > m_tracks;
+    QHash< QString, int > m_localIds;
+    int m_nextLocalId;
+
+    QScopedPointer< FuzzyIndex > m_fuzzyIndex;
+    QFutureWatcher< void > m_indexWatcher;
+    bool m_reindexPending;
+};
+
+
+/// Browse requests answered from a ScriptCollectionMirror, without a trip into the script
+class MirrorArtistsRequest : public QObject, public Tomahawk::ArtistsRequest
+{
+Q_OBJECT
+
+public:
+    explicit MirrorArtistsRequest( ScriptCollectionMirror* mirror ) : m_mirror( mirror ) {}
+
+    void enqueue() override;
+    void setFilter( const QString& filter ) override { m_filter = filter; }
+
+signals:
+    void artists( const QList< Tomahawk::artist_ptr >& ) override;
+
+private slots:
+    void report();
+
+private:
+    QPointer< ScriptCollectionMirror > m_mirror;
+    QString m_filter;
+};
+
+
+class MirrorAlbumsRequest : public QObject, public Tomahawk::AlbumsRequest
+{
+Q_OBJECT
+
+public:
+    MirrorAlbumsRequest( ScriptCollectionMirror* mirror, const Tomahawk::artist_ptr& artist ) : m_mirror( mirror ), m_artist( artist ) {}
+
+    void enqueue() override;
+    void setFilter( const QString& filter ) override { m_filter = filter; }
+
+signals:
+    void albums( const QList< Tomahawk::album_ptr >& ) override;
+
+private slots:
+    void report();
+
+private:
+    QPointer< ScriptCollectionMirror > m_mirror;
+    Tomahawk::artist_ptr m_artist;
+    QString m_filter;
+};
+
+
+class MirrorTracksRequest : public QObject, public Tomahawk::TracksRequest
+{
+Q_OBJECT
+
+public:
+    MirrorTracksRequest( ScriptCollectionMirror* mirror, const Tomahawk::collection_ptr& collection, const Tomahawk::album_ptr& album )
+        : m_mirror( mirror ), m_collection( collection ), m_album( album ) {}
+
+    void enqueue() override;
+
+signals:
+    void tracks( const QList< Tomahawk::query_ptr >& ) override;
+
+private slots:
+    void report();
+
+private:
+    QPointer< ScriptCollectionMirror > m_mirror;
+    Tomahawk::collection_ptr m_collection;
+    Tomahawk::album_ptr m_album;
+};
+
+} // ns: Tomahawk
+
+#endif // SCRIPTCOLLECTIONMIRROR_H
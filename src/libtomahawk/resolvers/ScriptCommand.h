@@ -27,9 +27,20 @@ namespace Tomahawk
 class ScriptCommand : public QObject
 {
 public:
+    enum Priority
+    {
+        Interactive = 0,    // the user is waiting for it, e.g. browsing a collection
+        Background          // e.g. looking up urls
+    };
+
     explicit ScriptCommand( QObject* parent = 0 ) : QObject( parent ) {}
     virtual ~ScriptCommand() {}
 
+    virtual Priority priority() const { return Interactive; }
+
+    /// How many commands of this type may run at the same time on one script account
+    virtual int maxConcurrent() const { return 2; }
+
 signals:
     virtual void done() = 0;
 
@@ -37,6 +48,9 @@ protected:
     friend class ScriptCommandQueue;
     virtual void exec() = 0;
     virtual void reportFailure() = 0;
+
+    /// True if nobody listens for the result anymore, e.g. because the view that asked for it is gone
+    virtual bool isSuperseded() const { return false; }
 };
 
 } // ns: Tomahawk
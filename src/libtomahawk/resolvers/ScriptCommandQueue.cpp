@@ -18,90 +18,251 @@
 
 #include "ScriptCommandQueue.h"
 
+#include "utils/Logger.h"
+
 #include <QMetaType>
 #include <QMutex>
 
+// commands running at the same time on one script account
+#define SCRIPTCOMMANDQUEUE_MAX_RUNNING 4
+
+// until we know how long a command type usually takes
+#define SCRIPTCOMMANDQUEUE_DEFAULT_TIMEOUT 20000
+#define SCRIPTCOMMANDQUEUE_MIN_TIMEOUT 5000
+#define SCRIPTCOMMANDQUEUE_MAX_TIMEOUT 60000
+
+// latencies we keep per command type, and how many we need before trusting them
+#define SCRIPTCOMMANDQUEUE_LATENCY_SAMPLES 32
+#define SCRIPTCOMMANDQUEUE_MIN_LATENCY_SAMPLES 8
+
 using namespace  Tomahawk;
 
 ScriptCommandQueue::ScriptCommandQueue( QObject* parent )
     : QObject( parent )
-    , m_timer( new QTimer( this ) )
 {
-    m_timer->setSingleShot( true );
 }
 
 
 void
 ScriptCommandQueue::enqueue( const QSharedPointer< ScriptCommand >& req )
 {
+    Command command;
+    command.command = req.data();
+    command.owner = req;
+
+    enqueue( command );
+}
+
+
+void
+ScriptCommandQueue::enqueue( ScriptCommand* req )
+{
+    Command command;
+    command.command = req;
+
+    connect( req, SIGNAL( destroyed( QObject* ) ), SLOT( onCommandDestroyed( QObject* ) ) );
+
+    enqueue( command );
+}
+
+
+void
+ScriptCommandQueue::enqueue( const Command& command )
+{
+    Command c = command;
+    c.type = QString::fromLatin1( c.command->metaObject()->className() );
+    c.timer = 0;
+
     QMutexLocker locker( &m_mutex );
-    m_queue.append( req );
+
+    // keep the queue sorted by priority, first come first served within the same priority
+    int i = m_queue.count();
+    while ( i > 0 && ( m_queue.at( i - 1 ).command.isNull() || m_queue.at( i - 1 ).command->priority() > c.command->priority() ) )
+        i--;
+    m_queue.insert( i, c );
+
     locker.unlock();
 
-    if ( m_queue.count() == 1 )
-        nextCommand();
+    nextCommand();
 }
 
 
 void
 ScriptCommandQueue::nextCommand()
 {
-    if ( m_queue.isEmpty() )
-        return;
+    QList< QPointer< ScriptCommand > > start;
+
+    {
+        QMutexLocker locker( &m_mutex );
+
+        // superseded commands don't need their slot anymore
+        for ( int i = m_running.count() - 1; i >= 0; i-- )
+        {
+            const Command& c = m_running.at( i );
+            if ( !c.command.isNull() && !c.command->isSuperseded() )
+                continue;
+
+            tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Dropping running" << c.type;
+            drop( c );
+            c.timer->deleteLater();
+            m_runningPerType[ c.type ]--;
+            m_running.removeAt( i );
+        }
+
+        int i = 0;
+        while ( i < m_queue.count() && m_running.count() < SCRIPTCOMMANDQUEUE_MAX_RUNNING )
+        {
+            const Command& c = m_queue.at( i );
+            if ( c.command.isNull() || c.command->isSuperseded() )
+            {
+                tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Dropping queued" << c.type;
+                drop( c );
+                m_queue.removeAt( i );
+                continue;
+            }
+
+            if ( m_runningPerType.value( c.type ) >= c.command->maxConcurrent() )
+            {
+                i++;
+                continue;
+            }
+
+            Command command = m_queue.takeAt( i );
+            command.timer = new QTimer( this );
+            command.timer->setSingleShot( true );
+            connect( command.timer, SIGNAL( timeout() ), SLOT( onTimeout() ) );
+            command.timer->start( timeout( command.type ) );
+            command.elapsed.start();
+
+            connect( command.command.data(), SIGNAL( done() ), SLOT( onCommandDone() ) );
+
+            m_running << command;
+            m_runningPerType[ command.type ]++;
+            start << command.command;
+        }
+    }
+
+    // a command may finish right away, so don't hold the lock while starting them
+    foreach ( const QPointer< ScriptCommand >& command, start )
+    {
+        if ( !command.isNull() )
+            command->exec();
+    }
+}
 
-    QSharedPointer< ScriptCommand > req = m_queue.first();
 
-    connect( req.data(), SIGNAL( done() ),
-             this, SLOT( onCommandDone() ) );
-    connect( m_timer, SIGNAL( timeout() ),
-             this, SLOT( onTimeout() ) );
+void
+ScriptCommandQueue::drop( const Command& command )
+{
+    if ( command.command.isNull() )
+        return;
 
-    m_timer->start( 20000 );
+    disconnect( command.command.data(), 0, this, 0 );
 
-    req->exec();
+    // nobody is going to pick up a command without listeners, so it's up to us to delete it
+    if ( command.owner.isNull() )
+        command.command->deleteLater();
 }
 
 
 void
 ScriptCommandQueue::onCommandDone()
 {
-    if ( m_queue.isEmpty() || !m_timer->isActive() ) //the timeout already happened or some other weird thing
-        return;                                      //nothing to do here
+    for ( int i = 0; i < m_running.count(); i++ )
+    {
+        if ( m_running.at( i ).command.data() == sender() )
+        {
+            finish( i, false );
+            return;
+        }
+    }
+
+    // the timeout already happened or the command got dropped, nothing to do here
+}
 
-    m_timer->stop();
 
+void
+ScriptCommandQueue::onCommandDestroyed( QObject* )
+{
+    // our guards are cleared already, so we can't tell which one it was
     QMutexLocker locker( &m_mutex );
-    const QSharedPointer< ScriptCommand > req = m_queue.first();
-    m_queue.removeAll( req );
-    locker.unlock();
+    for ( int i = m_running.count() - 1; i >= 0; i-- )
+    {
+        if ( !m_running.at( i ).command.isNull() )
+            continue;
 
-    disconnect( req.data(), SIGNAL( done() ),
-                this, SLOT( onCommandDone() ) );
-    disconnect( m_timer, SIGNAL( timeout() ),
-                this, SLOT( onTimeout() ) );
+        m_running.at( i ).timer->deleteLater();
+        m_runningPerType[ m_running.at( i ).type ]--;
+        m_running.removeAt( i );
+    }
+    locker.unlock();
 
-    if ( !m_queue.isEmpty() )
-        nextCommand();
+    QMetaObject::invokeMethod( this, "nextCommand", Qt::QueuedConnection );
 }
 
 
 void
 ScriptCommandQueue::onTimeout()
 {
-    m_timer->stop();
+    for ( int i = 0; i < m_running.count(); i++ )
+    {
+        if ( m_running.at( i ).timer == sender() )
+        {
+            tLog() << Q_FUNC_INFO << m_running.at( i ).type << "timed out after" << m_running.at( i ).elapsed.elapsed() << "ms";
+            finish( i, true );
+            return;
+        }
+    }
+}
 
+
+void
+ScriptCommandQueue::finish( int running, bool timedOut )
+{
     QMutexLocker locker( &m_mutex );
-    const QSharedPointer< ScriptCommand > req = m_queue.first();
-    m_queue.removeAll( req );
+    const Command c = m_running.takeAt( running );
+    m_runningPerType[ c.type ]--;
     locker.unlock();
 
-    req->reportFailure();
+    c.timer->deleteLater();
 
-    disconnect( req.data(), SIGNAL( done() ),
-                this, SLOT( onCommandDone() ) );
-    disconnect( m_timer, SIGNAL( timeout() ),
-                this, SLOT( onTimeout() ) );
+    // a command that timed out counts with its timeout, so slow resolvers get more time next time
+    addLatency( c.type, timedOut ? timeout( c.type ) : c.elapsed.elapsed() );
+
+    if ( !c.command.isNull() )
+    {
+        disconnect( c.command.data(), SIGNAL( done() ), this, SLOT( onCommandDone() ) );
+
+        if ( timedOut )
+            c.command->reportFailure();
+    }
+
+    // we might be inside the command's done() signal, don't start the next one from here
+    QMetaObject::invokeMethod( this, "nextCommand", Qt::QueuedConnection );
+}
+
+
+int
+ScriptCommandQueue::timeout( const QString& type ) const
+{
+    QList< qint64 > latencies = m_latencies.value( type );
+    if ( latencies.count() < SCRIPTCOMMANDQUEUE_MIN_LATENCY_SAMPLES )
+        return SCRIPTCOMMANDQUEUE_DEFAULT_TIMEOUT;
+
+    // three times the 95th percentile leaves enough room for the odd slow answer
+    qSort( latencies );
+    const qint64 p95 = latencies.at( ( latencies.count() - 1 ) * 95 / 100 );
+
+    return qBound( (qint64)SCRIPTCOMMANDQUEUE_MIN_TIMEOUT, p95 * 3, (qint64)SCRIPTCOMMANDQUEUE_MAX_TIMEOUT );
+}
+
+
+void
+ScriptCommandQueue::addLatency( const QString& type, qint64 msecs )
+{
+    QList< qint64 >& latencies = m_latencies[ type ];
+    latencies << msecs;
 
-    if ( !m_queue.isEmpty() )
-        nextCommand();
+    while ( latencies.count() > SCRIPTCOMMANDQUEUE_LATENCY_SAMPLES )
+        latencies.removeFirst();
 }
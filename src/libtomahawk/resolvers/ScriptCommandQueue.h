@@ -21,7 +21,10 @@
 
 #include "ScriptCommand.h"
 
-#include <QQueue>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QPointer>
 #include <QSharedPointer>
 #include <QTimer>
 #include <QMetaType>
@@ -30,6 +33,15 @@
 namespace Tomahawk
 {
 
+/**
+ * Runs the ScriptCommands of one script account.
+ *
+ * Several commands run at the same time, limited per command type so e.g. slow
+ * url lookups can't take up all slots. Interactive commands are started before
+ * background ones. Each type's timeout follows the latencies we observed for it.
+ * Commands that got deleted or that nobody listens to anymore are dropped,
+ * whether they are still queued or running already.
+ */
 class ScriptCommandQueue : public QObject
 {
     Q_OBJECT
@@ -37,16 +49,41 @@ public:
     explicit ScriptCommandQueue( QObject* parent = 0 );
     virtual ~ScriptCommandQueue() {}
 
+    /// Takes ownership of req
     void enqueue( const QSharedPointer< ScriptCommand >& req );
+    /// Leaves req's lifetime to the caller, it may delete req at any time to cancel it.
+    /// Once nobody listens for its result anymore req gets dropped and deleted by us.
+    void enqueue( ScriptCommand* req );
 
 private slots:
     void nextCommand();
     void onCommandDone();
+    void onCommandDestroyed( QObject* object );
     void onTimeout();
 
 private:
-    QQueue< QSharedPointer< ScriptCommand > > m_queue;
-    QTimer* m_timer;
+    struct Command
+    {
+        QPointer< ScriptCommand > command;
+        QSharedPointer< ScriptCommand > owner;
+        QString type;
+        QElapsedTimer elapsed;
+        QTimer* timer;
+    };
+
+    void enqueue( const Command& command );
+    void drop( const Command& command );
+    void finish( int running, bool timedOut );
+    int timeout( const QString& type ) const;
+    void addLatency( const QString& type, qint64 msecs );
+
+    QList< Command > m_queue;
+    QList< Command > m_running;
+    QHash< QString, int > m_runningPerType;
+
+    // the last latencies we observed per command type, oldest first
+    QHash< QString, QList< qint64 > > m_latencies;
+
     QMutex m_mutex;
 };
 
@@ -25,6 +25,7 @@
 #include "ScriptAccount.h"
 #include "PlaylistEntry.h"
 #include "ScriptCollection.h"
+#include "ScriptCommandQueue.h"
 #include "ScriptJob.h"
 #include "ScriptCommand_AllArtists.h"
 
@@ -50,7 +51,7 @@ ScriptCommand_AllAlbums::enqueue()
         return;
     }
 
-    exec();
+    collection->scriptAccount()->commandQueue()->enqueue( this );
 }
 
 
@@ -90,6 +91,7 @@ ScriptCommand_AllAlbums::exec()
     }
 
     ScriptJob* job = collection->scriptObject()->invoke( methodName, arguments );
+    m_job = job;
     connect( job, SIGNAL( done( QVariantMap ) ), SLOT( onAlbumsJobDone( QVariantMap ) ), Qt::QueuedConnection );
     job->start();
 }
@@ -98,6 +100,9 @@ ScriptCommand_AllAlbums::exec()
 void
 ScriptCommand_AllAlbums::reportFailure()
 {
+    // a job that answers after this got reported already, e.g. when we timed out
+    m_job.clear();
+
     if ( m_artist )
         tDebug() << Q_FUNC_INFO << "for collection" << m_collection->name() << "and artist" << m_artist->name();
 
@@ -106,14 +111,29 @@ ScriptCommand_AllAlbums::reportFailure()
 }
 
 
+bool
+ScriptCommand_AllAlbums::isSuperseded() const
+{
+    return receivers( SIGNAL( albums( QList<Tomahawk::album_ptr> ) ) ) == 0;
+}
+
+
 void
 ScriptCommand_AllAlbums::onAlbumsJobDone( const QVariantMap& result )
 {
     ScriptJob* job = qobject_cast< ScriptJob* >( sender() );
     Q_ASSERT( job );
 
+    if ( job != m_job )
+    {
+        job->deleteLater();
+        return;
+    }
+    m_job.clear();
+
     if ( job->error() )
     {
+        job->deleteLater();
         reportFailure();
         return;
     }
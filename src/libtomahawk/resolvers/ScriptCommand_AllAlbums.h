@@ -24,9 +24,13 @@
 #include "collection/Collection.h"
 #include "resolvers/ScriptCommand.h"
 
+#include <QPointer>
+
 namespace Tomahawk
 {
 
+class ScriptJob;
+
 class ScriptCommand_AllAlbums : public ScriptCommand, public Tomahawk::AlbumsRequest
 {
     Q_OBJECT
@@ -47,6 +51,7 @@ signals:
 protected:
     virtual void exec() override;
     virtual void reportFailure() override;
+    bool isSuperseded() const override;
 
 private slots:
     void onAlbumsJobDone( const QVariantMap& result );
@@ -55,6 +60,8 @@ private:
     static QList< Tomahawk::album_ptr > parseAlbumVariantList(  const QList< Tomahawk::artist_ptr >& artists,
                                                           const QVariantList& reslist );
     Tomahawk::collection_ptr m_collection;
+    // the job we're waiting for, cleared once we reported
+    QPointer< ScriptJob > m_job;
     Tomahawk::artist_ptr m_artist;
     QString m_filter;
 };
@@ -22,6 +22,7 @@
 #include "ScriptAccount.h"
 #include "ScriptCollection.h"
 #include "ScriptObject.h"
+#include "ScriptCommandQueue.h"
 #include "ScriptJob.h"
 
 #include "utils/Logger.h"
@@ -47,7 +48,7 @@ ScriptCommand_AllArtists::enqueue()
         return;
     }
 
-    exec();
+    collection->scriptAccount()->commandQueue()->enqueue( this );
 }
 
 
@@ -71,6 +72,7 @@ ScriptCommand_AllArtists::exec()
     }
 
     ScriptJob* job = collection->scriptObject()->invoke( "artists", arguments );
+    m_job = job;
     connect( job, SIGNAL( done( QVariantMap ) ), SLOT( onArtistsJobDone( QVariantMap ) ), Qt::QueuedConnection );
     job->start();
 }
@@ -79,20 +81,38 @@ ScriptCommand_AllArtists::exec()
 void
 ScriptCommand_AllArtists::reportFailure()
 {
+    // a job that answers after this got reported already, e.g. when we timed out
+    m_job.clear();
+
     tDebug() << Q_FUNC_INFO << "for collection" << m_collection->name();
     emit artists( QList< Tomahawk::artist_ptr >() );
     emit done();
 }
 
 
+bool
+ScriptCommand_AllArtists::isSuperseded() const
+{
+    return receivers( SIGNAL( artists( QList<Tomahawk::artist_ptr> ) ) ) == 0;
+}
+
+
 void
 ScriptCommand_AllArtists::onArtistsJobDone( const QVariantMap& result )
 {
     ScriptJob* job = qobject_cast< ScriptJob* >( sender() );
     Q_ASSERT( job );
 
+    if ( job != m_job )
+    {
+        job->deleteLater();
+        return;
+    }
+    m_job.clear();
+
     if ( job->error() )
     {
+        job->deleteLater();
         reportFailure();
         return;
     }
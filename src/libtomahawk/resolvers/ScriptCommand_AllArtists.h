@@ -24,9 +24,13 @@
 #include "collection/Collection.h"
 #include "resolvers/ScriptCommand.h"
 
+#include <QPointer>
+
 namespace Tomahawk
 {
 
+class ScriptJob;
+
 class ScriptCommand_AllArtists : public ScriptCommand, public Tomahawk::ArtistsRequest
 {
 Q_OBJECT
@@ -48,6 +52,7 @@ signals:
 protected:
     void exec() override;
     void reportFailure() override;
+    bool isSuperseded() const override;
 
 private slots:
     void onArtistsJobDone( const QVariantMap& result );
@@ -56,6 +61,8 @@ private:
     static QList< Tomahawk::artist_ptr > parseArtistVariantList( const QVariantList& reslist );
 
     Tomahawk::collection_ptr m_collection;
+    // the job we're waiting for, cleared once we reported
+    QPointer< ScriptJob > m_job;
     QString m_filter;
 };
 
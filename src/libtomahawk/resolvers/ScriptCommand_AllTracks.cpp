@@ -24,6 +24,7 @@
 #include "ScriptCollection.h"
 #include "Artist.h"
 #include "Album.h"
+#include "ScriptCommandQueue.h"
 #include "ScriptJob.h"
 #include "utils/Logger.h"
 #include "../Result.h"
@@ -52,7 +53,7 @@ ScriptCommand_AllTracks::enqueue()
         return;
     }
 
-    exec();
+    collection->scriptAccount()->commandQueue()->enqueue( this );
 }
 
 
@@ -82,6 +83,7 @@ ScriptCommand_AllTracks::exec()
     }
 
 
+    m_job = job;
     connect( job, SIGNAL( done( QVariantMap ) ), SLOT( onTracksJobDone( QVariantMap ) ), Qt::QueuedConnection );
     job->start();
 }
@@ -90,6 +92,9 @@ ScriptCommand_AllTracks::exec()
 void
 ScriptCommand_AllTracks::reportFailure()
 {
+    // a job that answers after this got reported already, e.g. when we timed out
+    m_job.clear();
+
     if ( m_album && m_collection )
         tDebug() << Q_FUNC_INFO << "for collection" << m_collection->name() << "artist" << m_album->artist()->name() << "album" << m_album->name();
     else if ( m_collection )
@@ -102,16 +107,31 @@ ScriptCommand_AllTracks::reportFailure()
 }
 
 
+bool
+ScriptCommand_AllTracks::isSuperseded() const
+{
+    return receivers( SIGNAL( tracks( QList<Tomahawk::query_ptr> ) ) ) == 0;
+}
+
+
 void
 ScriptCommand_AllTracks::onTracksJobDone( const QVariantMap& result )
 {
     ScriptJob* job = qobject_cast< ScriptJob* >( sender() );
     Q_ASSERT( job );
 
+    if ( job != m_job )
+    {
+        job->deleteLater();
+        return;
+    }
+    m_job.clear();
+
     //qDebug() << "Resolver reporting album tracks:" << result;
 
     if ( job->error() )
     {
+        job->deleteLater();
         reportFailure();
         return;
     }
@@ -24,9 +24,13 @@
 #include "collection/Collection.h"
 #include "resolvers/ScriptCommand.h"
 
+#include <QPointer>
+
 namespace Tomahawk
 {
 
+class ScriptJob;
+
 class ScriptCommand_AllTracks : public ScriptCommand, public Tomahawk::TracksRequest
 {
     Q_OBJECT
@@ -45,12 +49,15 @@ signals:
 protected:
     Q_INVOKABLE void exec() override;
     void reportFailure() override;
+    bool isSuperseded() const override;
 
 private slots:
     void onTracksJobDone( const QVariantMap& result );
 
 private:
     Tomahawk::collection_ptr m_collection;
+    // the job we're waiting for, cleared once we reported
+    QPointer< ScriptJob > m_job;
     Tomahawk::album_ptr m_album;
 };
 
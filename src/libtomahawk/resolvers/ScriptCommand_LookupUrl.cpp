@@ -38,7 +38,7 @@ void
 ScriptCommand_LookupUrl::enqueue()
 {
     Q_D( ScriptCommand_LookupUrl );
-    d->resolver->enqueue( QSharedPointer< ScriptCommand >( this ) );
+    d->resolver->enqueue( QSharedPointer< ScriptCommand >( this, &QObject::deleteLater ) );
 }
 
 
@@ -57,6 +57,11 @@ void
 ScriptCommand_LookupUrl::reportFailure()
 {
     Q_D( ScriptCommand_LookupUrl );
+
+    // a late answer after we timed out must not be reported a second time
+    disconnect( d->resolver, SIGNAL( informationFound( QString, QSharedPointer<QObject> ) ),
+                this, SLOT( onResolverDone( QString, QSharedPointer<QObject> ) ) );
+
     emit information( d->url, QSharedPointer<QObject>() );
     emit done();
 }
@@ -43,6 +43,8 @@ public:
 
     void enqueue();
 
+    Priority priority() const override { return Background; }
+
 signals:
     void information( const QString& url, const QSharedPointer<QObject>& variant );
     void done() override;
@@ -32,24 +32,26 @@
 #include "Pipeline.h"
 #include "Result.h"
 #include "ScriptCollection.h"
+#include "ScriptResolverProcess.h"
 #include "SourceList.h"
 #include "Track.h"
+#include "FuncTimeout.h"
 
-#include <QtEndian>
 #include <QFileInfo>
 #include <QNetworkAccessManager>
 #include <QNetworkProxy>
 
-#ifdef Q_OS_WIN
-#include <shlwapi.h>
-#endif
+#include <functional>
+
+// upper limit for the number of processes a resolver may ask for
+#define SCRIPTRESOLVER_MAX_WORKERS 8
 
 using namespace Tomahawk;
 
 ScriptResolver::ScriptResolver( const QString& exe )
     : Tomahawk::ExternalResolverGui( exe )
     , m_num_restarts( 0 )
-    , m_msgsize( 0 )
+    , m_protocol( 1 )
     , m_ready( false )
     , m_stopped( true )
     , m_configSent( false )
@@ -57,10 +59,15 @@ ScriptResolver::ScriptResolver( const QString& exe )
     , m_error( Tomahawk::ExternalResolver::NoError )
 {
     tLog() << Q_FUNC_INFO << "Created script resolver:" << exe;
-    connect( &m_proc, SIGNAL( readyReadStandardError() ), SLOT( readStderr() ) );
-    connect( &m_proc, SIGNAL( readyReadStandardOutput() ), SLOT( readStdout() ) );
-    connect( &m_proc, SIGNAL( finished( int, QProcess::ExitStatus ) ), SLOT( cmdExited( int, QProcess::ExitStatus ) ) );
 
+    m_decoder = new ScriptResolverDecoder( this );
+    m_decoder->moveToThread( &m_decoderThread );
+    connect( m_decoder, SIGNAL( message( int, QVariantMap ) ), SLOT( handleMsg( int, QVariantMap ) ) );
+    connect( m_decoder, SIGNAL( results( int, QString, QList< Tomahawk::result_ptr > ) ),
+                          SLOT( handleResults( int, QString, QList< Tomahawk::result_ptr > ) ) );
+    m_decoderThread.start();
+
+    setWorkerCount( 1 );
     startProcess();
 
     if ( !Tomahawk::Utils::nam() )
@@ -76,27 +83,37 @@ ScriptResolver::ScriptResolver( const QString& exe )
 
 ScriptResolver::~ScriptResolver()
 {
-    disconnect( &m_proc, SIGNAL( finished( int, QProcess::ExitStatus ) ), this, SLOT( cmdExited( int, QProcess::ExitStatus ) ) );
     m_deleting = true;
 
     QVariantMap msg;
     msg[ "_msgtype" ] = "quit";
-    sendMessage( msg );
-
-    bool finished = m_proc.state() != QProcess::Running || m_proc.waitForFinished( 2500 ); // might call handleMsg
-
-    Tomahawk::Pipeline::instance()->removeResolver( this );
+    foreach ( ScriptResolverProcess* worker, m_workers )
+    {
+        disconnect( worker, SIGNAL( finished( int, int, QProcess::ExitStatus ) ), this, SLOT( cmdExited( int, int, QProcess::ExitStatus ) ) );
+        sendMsg( worker, msg );
+    }
 
-    if ( !finished || m_proc.state() == QProcess::Running )
+    foreach ( ScriptResolverProcess* worker, m_workers )
     {
-        qDebug() << "External resolver didn't exit after waiting 2s for it to die, killing forcefully";
+        QProcess* proc = worker->process();
+        bool finished = proc->state() != QProcess::Running || proc->waitForFinished( 2500 );
+        if ( !finished || proc->state() == QProcess::Running )
+        {
+            qDebug() << "External resolver didn't exit after waiting 2s for it to die, killing forcefully";
 #ifdef Q_OS_WIN
-        m_proc.kill();
+            proc->kill();
 #else
-        m_proc.terminate();
+            proc->terminate();
 #endif
+        }
     }
 
+    Tomahawk::Pipeline::instance()->removeResolver( this );
+
+    m_decoderThread.quit();
+    m_decoderThread.wait();
+    delete m_decoder;
+
     if ( !m_configWidget.isNull() )
         delete m_configWidget.data();
 }
@@ -128,20 +145,25 @@ ScriptResolver::start()
     if ( m_ready )
         Tomahawk::Pipeline::instance()->addResolver( this );
     else if ( !m_configSent )
-        sendConfig();
+        sendConfig( primary() );
     // else, we've sent our config msg so are waiting for the resolver to react
 }
 
 
 void
-ScriptResolver::sendConfig()
+ScriptResolver::sendConfig( ScriptResolverProcess* worker )
 {
     // Send a configutaion message with any information the resolver might need
     // For now, only the proxy information is sent
     QVariantMap m;
     m.insert( "_msgtype", "config" );
 
-    m_configSent = true;
+    // protocol versions and encodings we speak, the resolver picks in its settings reply
+    m.insert( "protocols", QVariantList() << 1 << 2 );
+    m.insert( "encodings", QVariantList() << "json" << "qdatastream" );
+
+    if ( worker == primary() )
+        m_configSent = true;
 
     tDebug() << "Nam is:" << Tomahawk::Utils::nam();
     tDebug() << "Nam proxy is:" << Tomahawk::Utils::nam()->proxyFactory();
@@ -161,10 +183,7 @@ ScriptResolver::sendConfig()
         hosts << host;
     m.insert( "noproxyhosts", hosts );
 
-    bool ok;
-    QByteArray data = TomahawkUtils::toJson( m, &ok );
-    Q_ASSERT( ok );
-    sendMsg( data );
+    sendMsg( worker, m );
 }
 
 
@@ -185,17 +204,7 @@ ScriptResolver::running() const
 void
 ScriptResolver::sendMessage( const QVariantMap& map )
 {
-    bool ok;
-    QByteArray data = TomahawkUtils::toJson( map, &ok );
-    Q_ASSERT( ok );
-    sendMsg( data );
-}
-
-
-void
-ScriptResolver::readStderr()
-{
-    tLog() << "SCRIPT_STDERR" << filePath() << m_proc.readAllStandardError();
+    sendMsg( primary(), map );
 }
 
 
@@ -207,145 +216,192 @@ ScriptResolver::error() const
 
 
 void
-ScriptResolver::readStdout()
+ScriptResolver::sendMsg( ScriptResolverProcess* worker, const QVariantMap& m )
 {
-    if ( m_msgsize == 0 )
-    {
-        if ( m_proc.bytesAvailable() < 4 )
-            return;
-
-        quint32 len_nbo;
-        m_proc.read( (char*) &len_nbo, 4 );
-        m_msgsize = qFromBigEndian( len_nbo );
-    }
-
-    if ( m_msgsize > 0 )
-    {
-        m_msg.append( m_proc.read( m_msgsize - m_msg.length() ) );
-    }
-
-    if ( m_msgsize == (quint32) m_msg.length() )
-    {
-        handleMsg( m_msg );
-        m_msgsize = 0;
-        m_msg.clear();
+    if ( !worker )
+        return;
 
-        if ( m_proc.bytesAvailable() )
-            QTimer::singleShot( 0, this, SLOT( readStdout() ) );
-    }
+    worker->sendFrame( ScriptResolverDecoder::encode( m, worker->isBinary() ) );
 }
 
 
 void
-ScriptResolver::sendMsg( const QByteArray& msg )
+ScriptResolver::onFrame( int index, const QByteArray& payload )
 {
-//     qDebug() << Q_FUNC_INFO << m_ready << msg << msg.length();
-    if ( !m_proc.isOpen() )
+    // Might be called from waitForFinished() in ~ScriptResolver, no database in that case, abort.
+    if ( m_deleting )
         return;
 
-    quint32 len;
-    qToBigEndian( msg.length(), (uchar*) &len );
-    m_proc.write( (const char*) &len, 4 );
-    m_proc.write( msg );
+    QMetaObject::invokeMethod( m_decoder, "decodeFrame", Qt::QueuedConnection,
+                               Q_ARG( int, index ),
+                               Q_ARG( QByteArray, payload ),
+                               Q_ARG( QString, m_name ) );
 }
 
 
 void
-ScriptResolver::handleMsg( const QByteArray& msg )
+ScriptResolver::handleMsg( int index, const QVariantMap& m )
 {
-//    qDebug() << Q_FUNC_INFO << msg.size() << QString::fromAscii( msg );
-
-    // Might be called from waitForFinished() in ~ScriptResolver, no database in that case, abort.
     if ( m_deleting )
         return;
 
-    bool ok;
-    QVariant v = TomahawkUtils::parseJson( msg, &ok );
-    if ( !ok || v.type() != QVariant::Map )
-    {
-        Q_ASSERT( false );
+    ScriptResolverProcess* worker = m_workers.value( index );
+    if ( !worker )
         return;
-    }
-    QVariantMap m = v.toMap();
+
     QString msgtype = m.value( "_msgtype" ).toString();
 
     if ( msgtype == "settings" )
     {
-        doSetup( m );
+        if ( worker == primary() )
+            doSetup( m );
+        else
+            setupWorker( worker, m );
         return;
     }
     else if ( msgtype == "confwidget" )
     {
-        setupConfWidget( m );
+        if ( worker == primary() )
+            setupConfWidget( m );
         return;
     }
-    else if ( msgtype == "results" )
+    else
+    {
+        // Unknown message, give up for custom implementations
+        emit customMessage( msgtype, m );
+    }
+}
+
+
+void
+ScriptResolver::handleResults( int index, const QString& qid, const QList< Tomahawk::result_ptr >& results )
+{
+    Q_UNUSED( index );
+
+    if ( m_deleting )
+        return;
+
+    ScriptResolverProcess* worker = m_pendingRequests.take( qid );
+    if ( worker )
+        worker->removePendingRequest();
+
+    Tomahawk::Pipeline::instance()->reportResults( qid, this, results );
+}
+
+
+void
+ScriptResolver::expireRequest( const QString& qid )
+{
+    // the pipeline gave up on this one already, stop counting it against its worker
+    ScriptResolverProcess* worker = m_pendingRequests.take( qid );
+    if ( worker )
+        worker->removePendingRequest();
+}
+
+
+ScriptResolverProcess*
+ScriptResolver::primary() const
+{
+    return m_workers.value( 0 );
+}
+
+
+ScriptResolverProcess*
+ScriptResolver::nextWorker() const
+{
+    ScriptResolverProcess* next = primary();
+    foreach ( ScriptResolverProcess* worker, m_workers )
+    {
+        if ( worker->isReady() && worker->pendingRequests() < next->pendingRequests() )
+            next = worker;
+    }
+
+    return next;
+}
+
+
+void
+ScriptResolver::setWorkerCount( int count )
+{
+    count = qBound( 1, count, SCRIPTRESOLVER_MAX_WORKERS );
+
+    while ( m_workers.count() > count )
     {
-        const QString qid = m.value( "qid" ).toString();
-        QList< Tomahawk::result_ptr > results;
-        const QVariantList reslist = m.value( "results" ).toList();
+        ScriptResolverProcess* worker = m_workers.takeLast();
+        disconnect( worker, 0, this, 0 );
 
-        foreach( const QVariant& rv, reslist )
+        foreach ( const QString& qid, m_pendingRequests.keys( worker ) )
+            m_pendingRequests.remove( qid );
+
+        if ( worker->process()->state() == QProcess::NotRunning )
         {
-            QVariantMap m = rv.toMap();
-            tDebug( LOGVERBOSE ) << "Found result:" << m;
-
-            Tomahawk::track_ptr track = Tomahawk::Track::get( m.value( "artist" ).toString(),
-                                                              m.value( "track" ).toString(),
-                                                              m.value( "album" ).toString(),
-                                                              m.value( "albumartist" ).toString(),
-                                                              m.value( "duration" ).toUInt(),
-                                                              QString(),
-                                                              m.value( "albumpos" ).toUInt(),
-                                                              m.value( "discnumber" ).toUInt() );
-            if ( !track )
-                continue;
-
-            Tomahawk::result_ptr rp = Tomahawk::Result::get( m.value( "url" ).toString(), track );
-            if ( !rp )
-                continue;
-
-            rp->setBitrate( m.value( "bitrate" ).toUInt() );
-            rp->setSize( m.value( "size" ).toUInt() );
-            rp->setRID( uuid() );
-            rp->setFriendlySource( m_name );
-            rp->setPurchaseUrl( m.value( "purchaseUrl" ).toString() );
-            rp->setLinkUrl( m.value( "linkUrl" ).toString() );
-
-            //FIXME
-            if ( m.contains( "year" ) )
-            {
-                QVariantMap attr;
-                attr[ "releaseyear" ] = m.value( "year" );
-//                rp->track()->setAttributes( attr );
-            }
-
-            rp->setMimetype( m.value( "mimetype" ).toString() );
-            if ( rp->mimetype().isEmpty() )
-            {
-                rp->setMimetype( TomahawkUtils::extensionToMimetype( m.value( "extension" ).toString() ) );
-                Q_ASSERT( !rp->mimetype().isEmpty() );
-            }
-
-            rp->setResolvedByResolver( this );
-            results << rp;
+            worker->deleteLater();
+            continue;
         }
 
-        Tomahawk::Pipeline::instance()->reportResults( qid, this, results );
+        connect( worker->process(), SIGNAL( finished( int, QProcess::ExitStatus ) ), worker, SLOT( deleteLater() ) );
+
+        QVariantMap msg;
+        msg[ "_msgtype" ] = "quit";
+        sendMsg( worker, msg );
     }
-    else
+
+    while ( m_workers.count() < count )
     {
-        // Unknown message, give up for custom implementations
-        emit customMessage( msgtype, m );
+        ScriptResolverProcess* worker = new ScriptResolverProcess( filePath(), m_workers.count(), this );
+        connect( worker, SIGNAL( frame( int, QByteArray ) ), SLOT( onFrame( int, QByteArray ) ) );
+        connect( worker, SIGNAL( finished( int, int, QProcess::ExitStatus ) ), SLOT( cmdExited( int, int, QProcess::ExitStatus ) ) );
+        m_workers << worker;
+
+        // the primary gets started by startProcess()
+        if ( worker != primary() )
+            startWorker( worker );
     }
 }
 
 
 void
-ScriptResolver::cmdExited( int code, QProcess::ExitStatus status )
+ScriptResolver::startWorker( ScriptResolverProcess* worker )
+{
+    worker->start();
+    sendConfig( worker );
+}
+
+
+void
+ScriptResolver::setupWorker( ScriptResolverProcess* worker, const QVariantMap& m )
+{
+    const int protocol = m.value( "protocol", 1 ).toInt();
+    worker->setBinary( protocol >= 2 && m.value( "encoding" ).toString() == "qdatastream" );
+    worker->setReady( true );
+
+    if ( worker == primary() )
+        m_protocol = protocol;
+}
+
+
+void
+ScriptResolver::cmdExited( int index, int code, QProcess::ExitStatus status )
 {
+    tLog() << Q_FUNC_INFO << "SCRIPT EXITED, code" << code << "status" << status << filePath() << "worker" << index;
+
+    ScriptResolverProcess* worker = m_workers.value( index );
+    foreach ( const QString& qid, m_pendingRequests.keys( worker ) )
+        m_pendingRequests.remove( qid );
+
+    if ( worker && worker != primary() )
+    {
+        // a pool worker died, the primary keeps serving requests while we bring it back
+        if ( !m_stopped && m_num_restarts < 10 )
+        {
+            m_num_restarts++;
+            tLog() << "*** Restarting worker" << index << "restart num" << m_num_restarts;
+            startWorker( worker );
+        }
+        return;
+    }
+
     m_ready = false;
-    tLog() << Q_FUNC_INFO << "SCRIPT EXITED, code" << code << "status" << status << filePath();
     Tomahawk::Pipeline::instance()->removeResolver( this );
 
     m_error = ExternalResolver::FailedToLoad;
@@ -364,7 +420,6 @@ ScriptResolver::cmdExited( int code, QProcess::ExitStatus status )
         m_num_restarts++;
         tLog() << "*** Restart num" << m_num_restarts;
         startProcess();
-        sendConfig();
     }
     else
     {
@@ -395,8 +450,16 @@ ScriptResolver::resolve( const Tomahawk::query_ptr& query )
             m.insert( "resultHint", query->resultHint() );
     }
 
-    const QByteArray msg = TomahawkUtils::toJson( QVariant( m ) );
-    sendMsg( msg );
+    ScriptResolverProcess* worker = nextWorker();
+    if ( !worker )
+        return;
+
+    m_pendingRequests.insert( query->id(), worker );
+    worker->addPendingRequest();
+    if ( m_timeout > 0 )
+        new FuncTimeout( m_timeout, std::bind( &ScriptResolver::expireRequest, this, query->id() ), this );
+
+    sendMsg( worker, m );
 }
 
 
@@ -443,12 +506,21 @@ ScriptResolver::doSetup( const QVariantMap& m )
             m_icon = icon;
     }
 
-    qDebug() << "SCRIPT" << filePath() << "READY," << "name" << m_name << "weight" << m_weight << "timeout" << m_timeout << "icon received" << success;
+    setupWorker( primary(), m );
+
+    qDebug() << "SCRIPT" << filePath() << "READY," << "name" << m_name << "weight" << m_weight << "timeout" << m_timeout << "icon received" << success
+             << "protocol" << m_protocol << "binary" << primary()->isBinary();
 
     m_ready = true;
     m_configSent = false;
     m_num_restarts = 0;
 
+    // only v2 resolvers answer requests out of order, so only they get a pool
+    if ( m_protocol >= 2 )
+        setWorkerCount( m.value( "workers", 1 ).toInt() );
+    else
+        setWorkerCount( 1 );
+
     if ( !m_stopped )
         Tomahawk::Pipeline::instance()->addResolver( this );
 
@@ -486,52 +558,11 @@ ScriptResolver::startProcess()
         m_error = Tomahawk::ExternalResolver::NoError;
     }
 
-    const QFileInfo fi( filePath() );
-
-    QString interpreter;
-    // have to enclose in quotes if path contains spaces...
-    const QString runPath = QString( "\"%1\"" ).arg( filePath() );
+    // extra workers get started again once the primary told us how many it wants
+    setWorkerCount( 1 );
+    m_pendingRequests.clear();
 
-    QFile file( filePath() );
-    file.setPermissions( file.permissions() | QFile::ExeOwner | QFile::ExeGroup | QFile::ExeOther );
-
-#ifdef Q_OS_WIN
-    if ( fi.suffix().toLower() != "exe" )
-    {
-        DWORD dwSize = MAX_PATH;
-
-        wchar_t path[MAX_PATH] = { 0 };
-        wchar_t *ext = (wchar_t *) ("." + fi.suffix()).utf16();
-
-        HRESULT hr = AssocQueryStringW(
-                (ASSOCF) 0,
-                ASSOCSTR_EXECUTABLE,
-                ext,
-                L"open",
-                path,
-                &dwSize
-        );
-
-        if ( ! FAILED( hr ) )
-        {
-            interpreter = QString( "\"%1\"" ).arg(QString::fromUtf16((const ushort *) path));
-        }
-    }
-#endif // Q_OS_WIN
-
-    if ( interpreter.isEmpty() )
-    {
-#ifndef Q_OS_WIN
-        const QFileInfo info( filePath() );
-        m_proc.setWorkingDirectory( info.absolutePath() );
-        tLog() << "Setting working dir:" << info.absolutePath();
-#endif
-        m_proc.start( runPath );
-    }
-    else
-        m_proc.start( interpreter, QStringList() << filePath() );
-
-    sendConfig();
+    startWorker( primary() );
 }
 
 
@@ -544,11 +575,7 @@ ScriptResolver::saveConfig()
     m.insert( "_msgtype", "setpref" );
     QVariant widgets = configMsgFromWidget( m_configWidget.data() );
     m.insert( "widgets", widgets );
-    bool ok;
-    QByteArray data = TomahawkUtils::toJson( m, &ok );
-    Q_ASSERT( ok );
-
-    sendMsg( data );
+    sendMsg( primary(), m );
 }
 
 
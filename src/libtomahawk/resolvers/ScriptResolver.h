@@ -29,12 +29,27 @@
 #include "DllMacro.h"
 
 #include <QProcess>
+#include <QThread>
 
 class QWidget;
 
 namespace Tomahawk
 {
 
+class ScriptResolverDecoder;
+class ScriptResolverProcess;
+
+/**
+ * A resolver running as an external process, talking to us through
+ * length-prefixed frames on stdin and stdout.
+ *
+ * Protocol v1 sends JSON frames and answers one request at a time. Resolvers
+ * that answer our config message with "protocol": 2 may pick a binary encoding,
+ * answer requests in any order (matched up by their qid) and ask for a pool of
+ * "workers" processes that requests get spread over. The first process is the
+ * primary one, it alone handles settings, the config widget and custom messages.
+ */
+
 class DLLEXPORT ScriptResolver : public Tomahawk::ExternalResolverGui
 {
 Q_OBJECT
@@ -65,6 +80,8 @@ public:
 
     bool canParseUrl( const QString&, UrlType ) Q_DECL_OVERRIDE { return false; }
 
+    using Resolver::resolve;
+
 signals:
     void terminated();
     void customMessage( const QString& msgType, const QVariantMap& msg );
@@ -78,30 +95,39 @@ public slots:
 
 
 private slots:
-    void readStderr();
-    void readStdout();
-    void cmdExited( int code, QProcess::ExitStatus status );
+    void onFrame( int index, const QByteArray& payload );
+    void handleMsg( int index, const QVariantMap& m );
+    void handleResults( int index, const QString& qid, const QList< Tomahawk::result_ptr >& results );
+    void cmdExited( int index, int code, QProcess::ExitStatus status );
 
 private:
-    void sendConfig();
-
-    void handleMsg( const QByteArray& msg );
-    void sendMsg( const QByteArray& msg );
+    void sendConfig( ScriptResolverProcess* worker );
+    void sendMsg( ScriptResolverProcess* worker, const QVariantMap& m );
     void doSetup( const QVariantMap& m );
     void setupConfWidget( const QVariantMap& m );
+    void setupWorker( ScriptResolverProcess* worker, const QVariantMap& m );
+    void setWorkerCount( int count );
+    void expireRequest( const QString& qid );
+
+    ScriptResolverProcess* primary() const;
+    ScriptResolverProcess* nextWorker() const;
 
     void startProcess();
+    void startWorker( ScriptResolverProcess* worker );
+
+    QList< ScriptResolverProcess* > m_workers;
+    QHash< QString, ScriptResolverProcess* > m_pendingRequests;
+    int m_protocol;
+
+    QThread m_decoderThread;
+    ScriptResolverDecoder* m_decoder;
 
-    QProcess m_proc;
     QString m_name;
     QPixmap m_icon;
     unsigned int m_weight, m_preference, m_timeout, m_num_restarts;
     Capabilities m_capabilities;
     QPointer< AccountConfigWidget > m_configWidget;
 
-    quint32 m_msgsize;
-    QByteArray m_msg;
-
     bool m_ready, m_stopped, m_configSent, m_deleting;
     ExternalResolver::ErrorState m_error;
 };
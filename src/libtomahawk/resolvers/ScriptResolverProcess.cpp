@@ -0,0 +1,321 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Teo Mrnjavac <teo@kde.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ScriptResolverProcess.h"
+
+#include "utils/Json.h"
+#include "utils/Logger.h"
+#include "utils/TomahawkUtils.h"
+
+#include "Resolver.h"
+#include "Result.h"
+#include "Track.h"
+
+#include <QtEndian>
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+
+#ifdef Q_OS_WIN
+#include <shlwapi.h>
+#endif
+
+// frames bigger than this are garbage, not a resolver talking to us
+#define SCRIPTRESOLVER_MAX_FRAME 64 * 1024 * 1024
+
+using namespace Tomahawk;
+
+
+ScriptResolverProcess::ScriptResolverProcess( const QString& exe, int index, QObject* parent )
+    : QObject( parent )
+    , m_exe( exe )
+    , m_index( index )
+    , m_msgsize( 0 )
+    , m_binary( false )
+    , m_ready( false )
+    , m_pending( 0 )
+{
+    connect( &m_proc, SIGNAL( readyReadStandardError() ), SLOT( readStderr() ) );
+    connect( &m_proc, SIGNAL( readyReadStandardOutput() ), SLOT( readStdout() ) );
+    connect( &m_proc, SIGNAL( finished( int, QProcess::ExitStatus ) ), SLOT( onFinished( int, QProcess::ExitStatus ) ) );
+}
+
+
+ScriptResolverProcess::~ScriptResolverProcess()
+{
+    disconnect( &m_proc, SIGNAL( finished( int, QProcess::ExitStatus ) ), this, SLOT( onFinished( int, QProcess::ExitStatus ) ) );
+}
+
+
+void
+ScriptResolverProcess::start()
+{
+    m_msgsize = 0;
+    m_msg.clear();
+    m_binary = false;
+    m_ready = false;
+    m_pending = 0;
+
+    const QFileInfo fi( m_exe );
+
+    QString interpreter;
+    // have to enclose in quotes if path contains spaces...
+    const QString runPath = QString( "\"%1\"" ).arg( m_exe );
+
+    QFile file( m_exe );
+    file.setPermissions( file.permissions() | QFile::ExeOwner | QFile::ExeGroup | QFile::ExeOther );
+
+#ifdef Q_OS_WIN
+    if ( fi.suffix().toLower() != "exe" )
+    {
+        DWORD dwSize = MAX_PATH;
+
+        wchar_t path[MAX_PATH] = { 0 };
+        wchar_t *ext = (wchar_t *) ("." + fi.suffix()).utf16();
+
+        HRESULT hr = AssocQueryStringW(
+                (ASSOCF) 0,
+                ASSOCSTR_EXECUTABLE,
+                ext,
+                L"open",
+                path,
+                &dwSize
+        );
+
+        if ( ! FAILED( hr ) )
+        {
+            interpreter = QString( "\"%1\"" ).arg(QString::fromUtf16((const ushort *) path));
+        }
+    }
+#endif // Q_OS_WIN
+
+    if ( interpreter.isEmpty() )
+    {
+#ifndef Q_OS_WIN
+        m_proc.setWorkingDirectory( fi.absolutePath() );
+        tLog() << "Setting working dir:" << fi.absolutePath();
+#endif
+        m_proc.start( runPath );
+    }
+    else
+        m_proc.start( interpreter, QStringList() << m_exe );
+}
+
+
+void
+ScriptResolverProcess::sendFrame( const QByteArray& payload )
+{
+    if ( !m_proc.isOpen() )
+        return;
+
+    quint32 len;
+    qToBigEndian( payload.length(), (uchar*) &len );
+    m_proc.write( (const char*) &len, 4 );
+    m_proc.write( payload );
+}
+
+
+void
+ScriptResolverProcess::readStdout()
+{
+    // hand out every complete frame we have, the rest waits for the next readyRead
+    forever
+    {
+        if ( m_msgsize == 0 )
+        {
+            if ( m_proc.bytesAvailable() < 4 )
+                return;
+
+            quint32 len_nbo;
+            m_proc.read( (char*) &len_nbo, 4 );
+            m_msgsize = qFromBigEndian( len_nbo );
+
+            if ( m_msgsize > SCRIPTRESOLVER_MAX_FRAME )
+            {
+                tLog() << Q_FUNC_INFO << "Resolver sent a frame of" << m_msgsize << "bytes, killing it:" << m_exe;
+                m_msgsize = 0;
+                m_proc.kill();
+                return;
+            }
+
+            m_msg.reserve( m_msgsize );
+        }
+
+        if ( m_msgsize > 0 )
+            m_msg.append( m_proc.read( m_msgsize - m_msg.length() ) );
+
+        if ( m_msgsize != (quint32) m_msg.length() )
+            return;
+
+        const QByteArray msg = m_msg;
+        m_msgsize = 0;
+        m_msg.clear();
+
+        emit frame( m_index, msg );
+    }
+}
+
+
+void
+ScriptResolverProcess::readStderr()
+{
+    tLog() << "SCRIPT_STDERR" << m_exe << m_index << m_proc.readAllStandardError();
+}
+
+
+void
+ScriptResolverProcess::onFinished( int code, QProcess::ExitStatus status )
+{
+    m_ready = false;
+    m_pending = 0;
+
+    emit finished( m_index, code, status );
+}
+
+
+ScriptResolverDecoder::ScriptResolverDecoder( Tomahawk::Resolver* resolver )
+    : QObject( 0 )
+    , m_resolver( resolver )
+{
+}
+
+
+QByteArray
+ScriptResolverDecoder::encode( const QVariantMap& map, bool binary )
+{
+    if ( !binary )
+    {
+        bool ok;
+        QByteArray data = TomahawkUtils::toJson( map, &ok );
+        Q_ASSERT( ok );
+        return data;
+    }
+
+    QByteArray data;
+    QDataStream stream( &data, QIODevice::WriteOnly );
+    stream.setVersion( QDataStream::Qt_4_8 );
+    stream << QVariant( map );
+
+    return data;
+}
+
+
+bool
+ScriptResolverDecoder::isJson( const QByteArray& payload )
+{
+    // binary frames start with the QVariant type id, JSON ones maybe with whitespace before the '{'
+    for ( int i = 0; i < payload.size(); i++ )
+    {
+        const char c = payload.at( i );
+        if ( c != ' ' && c != '\t' && c != '\r' && c != '\n' )
+            return c == '{';
+    }
+
+    return false;
+}
+
+
+QVariantMap
+ScriptResolverDecoder::decode( const QByteArray& payload, bool* ok )
+{
+    QVariant v;
+    if ( isJson( payload ) )
+    {
+        v = TomahawkUtils::parseJson( payload, ok );
+    }
+    else
+    {
+        QDataStream stream( payload );
+        stream.setVersion( QDataStream::Qt_4_8 );
+        stream >> v;
+        *ok = stream.status() == QDataStream::Ok;
+    }
+
+    if ( *ok && v.type() != QVariant::Map )
+        *ok = false;
+
+    return v.toMap();
+}
+
+
+void
+ScriptResolverDecoder::decodeFrame( int index, const QByteArray& payload, const QString& friendlySource )
+{
+    bool ok;
+    const QVariantMap m = decode( payload, &ok );
+    if ( !ok )
+    {
+        tLog() << Q_FUNC_INFO << "Could not decode frame of" << payload.size() << "bytes from" << friendlySource;
+        return;
+    }
+
+    if ( m.value( "_msgtype" ).toString() != "results" )
+    {
+        emit message( index, m );
+        return;
+    }
+
+    QList< Tomahawk::result_ptr > results;
+    foreach( const QVariant& rv, m.value( "results" ).toList() )
+    {
+        const QVariantMap m = rv.toMap();
+        tDebug( LOGVERBOSE ) << "Found result:" << m;
+
+        Tomahawk::track_ptr track = Tomahawk::Track::get( m.value( "artist" ).toString(),
+                                                          m.value( "track" ).toString(),
+                                                          m.value( "album" ).toString(),
+                                                          m.value( "albumartist" ).toString(),
+                                                          m.value( "duration" ).toUInt(),
+                                                          QString(),
+                                                          m.value( "albumpos" ).toUInt(),
+                                                          m.value( "discnumber" ).toUInt() );
+        if ( !track )
+            continue;
+
+        Tomahawk::result_ptr rp = Tomahawk::Result::get( m.value( "url" ).toString(), track );
+        if ( !rp )
+            continue;
+
+        rp->setBitrate( m.value( "bitrate" ).toUInt() );
+        rp->setSize( m.value( "size" ).toUInt() );
+        rp->setRID( uuid() );
+        rp->setFriendlySource( friendlySource );
+        rp->setPurchaseUrl( m.value( "purchaseUrl" ).toString() );
+        rp->setLinkUrl( m.value( "linkUrl" ).toString() );
+
+        //FIXME
+        if ( m.contains( "year" ) )
+        {
+            QVariantMap attr;
+            attr[ "releaseyear" ] = m.value( "year" );
+//            rp->track()->setAttributes( attr );
+        }
+
+        rp->setMimetype( m.value( "mimetype" ).toString() );
+        if ( rp->mimetype().isEmpty() )
+        {
+            rp->setMimetype( TomahawkUtils::extensionToMimetype( m.value( "extension" ).toString() ) );
+            Q_ASSERT( !rp->mimetype().isEmpty() );
+        }
+
+        rp->setResolvedByResolver( m_resolver );
+        results << rp;
+    }
+
+    emit results( index, m.value( "qid" ).toString(), results );
+}
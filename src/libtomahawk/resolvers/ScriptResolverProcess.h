@@ -0,0 +1,123 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2013, Teo Mrnjavac <teo@kde.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCRIPTRESOLVERPROCESS_H
+#define SCRIPTRESOLVERPROCESS_H
+
+#include "Typedefs.h"
+
+#include <QHash>
+#include <QObject>
+#include <QProcess>
+#include <QVariantMap>
+
+namespace Tomahawk
+{
+
+class Resolver;
+
+/**
+ * One process of an out-of-process resolver. Cuts the process' output into the
+ * length-prefixed frames of the resolver protocol and sends frames to it.
+ */
+class ScriptResolverProcess : public QObject
+{
+Q_OBJECT
+
+public:
+    ScriptResolverProcess( const QString& exe, int index, QObject* parent = 0 );
+    virtual ~ScriptResolverProcess();
+
+    int index() const { return m_index; }
+    QProcess* process() { return &m_proc; }
+
+    void start();
+    void sendFrame( const QByteArray& payload );
+
+    /// Encoding of the frames we send, switched once the process agreed to protocol v2
+    bool isBinary() const { return m_binary; }
+    void setBinary( bool binary ) { m_binary = binary; }
+
+    /// True once the process answered our config message
+    bool isReady() const { return m_ready; }
+    void setReady( bool ready ) { m_ready = ready; }
+
+    /// Requests sent to this process that weren't answered yet
+    int pendingRequests() const { return m_pending; }
+    void addPendingRequest() { m_pending++; }
+    void removePendingRequest() { m_pending = qMax( 0, m_pending - 1 ); }
+
+signals:
+    void frame( int index, const QByteArray& payload );
+    void finished( int index, int code, QProcess::ExitStatus status );
+
+private slots:
+    void readStdout();
+    void readStderr();
+    void onFinished( int code, QProcess::ExitStatus status );
+
+private:
+    QProcess m_proc;
+    QString m_exe;
+    int m_index;
+
+    quint32 m_msgsize;
+    QByteArray m_msg;
+
+    bool m_binary;
+    bool m_ready;
+    int m_pending;
+};
+
+
+/**
+ * Decodes the frames of all processes of a resolver on a worker thread, so
+ * parsing large result lists doesn't block the GUI. Frames are handled in the
+ * order they arrived in.
+ *
+ * Protocol v2 frames are either JSON or QDataStream-serialized QVariantMaps. A
+ * JSON frame starts with '{' after optional whitespace while a binary one
+ * starts with the QVariant type id, so the encoding of each frame is sniffed
+ * and both sides can switch encodings without further coordination.
+ */
+class ScriptResolverDecoder : public QObject
+{
+Q_OBJECT
+
+public:
+    explicit ScriptResolverDecoder( Tomahawk::Resolver* resolver );
+
+    static QByteArray encode( const QVariantMap& map, bool binary );
+    static QVariantMap decode( const QByteArray& payload, bool* ok );
+
+public slots:
+    void decodeFrame( int index, const QByteArray& payload, const QString& friendlySource );
+
+signals:
+    void message( int index, const QVariantMap& msg );
+    void results( int index, const QString& qid, const QList< Tomahawk::result_ptr >& results );
+
+private:
+    static bool isJson( const QByteArray& payload );
+
+    Tomahawk::Resolver* m_resolver;
+};
+
+} // ns: Tomahawk
+
+#endif // SCRIPTRESOLVERPROCESS_H
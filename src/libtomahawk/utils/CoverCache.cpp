@@ -0,0 +1,353 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CoverCache.h"
+
+#include "utils/Logger.h"
+#include "TomahawkSettings.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QMap>
+#include <QPixmapCache>
+#include <QRunnable>
+#include <QThread>
+
+// default memory limit for decoded thumbnails, in kilobytes
+#define COVERCACHE_DEFAULT_COST 64 * 1024
+// size limit of the thumbnails on disk, in bytes
+#define COVERCACHE_DISK_LIMIT Q_INT64_C( 256 * 1024 * 1024 )
+
+static const int s_buckets[] = { 64, 128, 256, 512, 1024 };
+
+CoverCache* CoverCache::s_instance = 0;
+
+namespace
+{
+
+class CoverDecodeJob : public QRunnable
+{
+public:
+    CoverDecodeJob( CoverCache* cache, const QString& key, quint64 job, const QByteArray& data, int bucket, const QString& diskCachePath )
+        : m_cache( cache )
+        , m_key( key )
+        , m_job( job )
+        , m_data( data )
+        , m_bucket( bucket )
+        , m_diskCachePath( diskCachePath )
+    {
+    }
+
+    void run()
+    {
+        QString path;
+        if ( !m_diskCachePath.isEmpty() )
+        {
+            const QByteArray hash = QCryptographicHash::hash( m_data, QCryptographicHash::Md5 ).toHex();
+            path = QString( "%1/%2_%3.png" ).arg( m_diskCachePath ).arg( QString::fromLatin1( hash ) ).arg( m_bucket );
+        }
+
+        QImage image;
+        if ( path.isEmpty() || !image.load( path, "PNG" ) )
+        {
+            image = thumbnail();
+            if ( !image.isNull() && !path.isEmpty() && !image.save( path, "PNG" ) )
+                tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Could not write cover thumbnail:" << path;
+        }
+
+        QMetaObject::invokeMethod( m_cache, "onDecoded", Qt::QueuedConnection,
+                                   Q_ARG( QString, m_key ),
+                                   Q_ARG( quint64, m_job ),
+                                   Q_ARG( QImage, image ) );
+    }
+
+private:
+    QImage thumbnail() const
+    {
+        QImage image;
+        if ( !image.loadFromData( m_data ) )
+            return QImage();
+
+        // covers are always shown square, crop to the center
+        if ( image.width() != image.height() )
+        {
+            const int edge = qMin( image.width(), image.height() );
+            image = image.copy( ( image.width() - edge ) / 2, ( image.height() - edge ) / 2, edge, edge );
+        }
+
+        if ( image.width() > m_bucket )
+            image = image.scaled( m_bucket, m_bucket, Qt::KeepAspectRatio, Qt::SmoothTransformation );
+
+        return image;
+    }
+
+    CoverCache* m_cache;
+    QString m_key;
+    quint64 m_job;
+    QByteArray m_data;
+    int m_bucket;
+    QString m_diskCachePath;
+};
+
+
+class CoverPruneJob : public QRunnable
+{
+public:
+    CoverPruneJob( const QString& diskCachePath )
+        : m_diskCachePath( diskCachePath )
+    {
+    }
+
+    void run()
+    {
+        QDir dir( m_diskCachePath );
+        dir.setFilter( QDir::Files | QDir::NoDotAndDotDot );
+        const QFileInfoList files = dir.entryInfoList();
+
+        qint64 total = 0;
+        QMultiMap< QDateTime, QFileInfo > byAge;
+        foreach ( const QFileInfo& fi, files )
+        {
+            total += fi.size();
+            byAge.insert( qMax( fi.lastRead(), fi.lastModified() ), fi );
+        }
+
+        if ( total <= COVERCACHE_DISK_LIMIT )
+            return;
+
+        // prune to three quarters of the limit, so we don't have to do this again right away
+        int removed = 0;
+        QMultiMap< QDateTime, QFileInfo >::const_iterator it = byAge.constBegin();
+        for ( ; it != byAge.constEnd() && total > COVERCACHE_DISK_LIMIT / 4 * 3; ++it )
+        {
+            if ( QFile::remove( it.value().absoluteFilePath() ) )
+            {
+                total -= it.value().size();
+                removed++;
+            }
+        }
+
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Removed" << removed << "cover thumbnails from disk cache";
+    }
+
+private:
+    QString m_diskCachePath;
+};
+
+}
+
+
+CoverCache*
+CoverCache::instance()
+{
+    if ( !s_instance )
+        s_instance = new CoverCache();
+
+    return s_instance;
+}
+
+
+CoverCache::CoverCache( QObject* parent )
+    : QObject( parent )
+    , m_nextJob( 0 )
+{
+    m_pool.setMaxThreadCount( qMax( 1, QThread::idealThreadCount() / 2 ) );
+    m_cache.setMaxCost( COVERCACHE_DEFAULT_COST );
+
+    m_diskCachePath = TomahawkSettings::instance()->storageCacheLocation() + "/covers";
+    if ( !QDir().mkpath( m_diskCachePath ) )
+    {
+        tLog() << Q_FUNC_INFO << "Could not create cover thumbnail cache:" << m_diskCachePath;
+        m_diskCachePath.clear();
+    }
+    else
+    {
+        CoverPruneJob* job = new CoverPruneJob( m_diskCachePath );
+        job->setAutoDelete( true );
+        m_pool.start( job );
+    }
+}
+
+
+CoverCache::~CoverCache()
+{
+    m_pool.waitForDone();
+
+    if ( s_instance == this )
+        s_instance = 0;
+}
+
+
+int
+CoverCache::bucketSize( const QSize& size )
+{
+    const int edge = qMax( size.width(), size.height() );
+    for ( unsigned int i = 0; i < sizeof( s_buckets ) / sizeof( s_buckets[ 0 ] ); i++ )
+    {
+        if ( edge <= s_buckets[ i ] )
+            return s_buckets[ i ];
+    }
+
+    return edge;
+}
+
+
+QString
+CoverCache::cacheKey( const QString& id, int bucket )
+{
+    return QString( "%1_%2" ).arg( id ).arg( bucket );
+}
+
+
+QString
+CoverCache::scaledKey( const QString& id, const QSize& size ) const
+{
+    return QString( "%1_%2_%3_%4" ).arg( id ).arg( m_generations.value( id ) ).arg( size.width() ).arg( size.height() );
+}
+
+
+QPixmap
+CoverCache::cover( const QString& id, const QByteArray& data, const QSize& size, QObject* notify )
+{
+    if ( data.isEmpty() || size.isEmpty() || m_undecodable.contains( id ) )
+        return QPixmap();
+
+    const int bucket = bucketSize( size );
+    const QString key = cacheKey( id, bucket );
+
+    QPixmap* thumbnail = m_cache.object( key );
+    if ( thumbnail )
+    {
+        if ( thumbnail->size() == size )
+            return *thumbnail;
+
+        // scaling a thumbnail down to the exact size is cheap enough to do right here
+        const QString key = scaledKey( id, size );
+        QPixmap scaled;
+        if ( !QPixmapCache::find( key, &scaled ) )
+        {
+            scaled = thumbnail->scaled( size, Qt::KeepAspectRatio, Qt::SmoothTransformation );
+            QPixmapCache::insert( key, scaled );
+        }
+
+        return scaled;
+    }
+
+    const bool queued = m_pending.contains( key );
+    PendingCover& pending = m_pending[ key ];
+    if ( notify && !pending.waiting.contains( notify ) )
+        pending.waiting << notify;
+
+    if ( !queued )
+    {
+        pending.job = ++m_nextJob;
+
+        CoverDecodeJob* job = new CoverDecodeJob( this, key, pending.job, data, bucket, m_diskCachePath );
+        job->setAutoDelete( true );
+        m_pool.start( job );
+    }
+
+    return QPixmap();
+}
+
+
+void
+CoverCache::remove( const QString& id )
+{
+    const QString prefix = id + '_';
+
+    // exact size pixmaps of the old cover can't be found under the new generation
+    m_generations[ id ]++;
+    m_undecodable.remove( id );
+
+    foreach ( const QString& key, m_cache.keys() )
+    {
+        if ( key.startsWith( prefix ) )
+            m_cache.remove( key );
+    }
+
+    // results of jobs that are still running are outdated now
+    foreach ( const QString& key, m_pending.keys() )
+    {
+        if ( key.startsWith( prefix ) )
+            m_pending[ key ].job = 0;
+    }
+}
+
+
+bool
+CoverCache::isUndecodable( const QString& id ) const
+{
+    return m_undecodable.contains( id );
+}
+
+
+void
+CoverCache::setMaxCost( int kb )
+{
+    m_cache.setMaxCost( kb );
+}
+
+
+int
+CoverCache::maxCost() const
+{
+    return m_cache.maxCost();
+}
+
+
+void
+CoverCache::onDecoded( const QString& key, quint64 job, const QImage& image )
+{
+    if ( !m_pending.contains( key ) )
+        return;
+
+    const PendingCover pending = m_pending.take( key );
+    if ( pending.job != job )
+    {
+        // the cover changed while we were decoding it, waiters will ask again
+        foreach ( const QPointer< QObject >& object, pending.waiting )
+        {
+            if ( !object.isNull() )
+                QMetaObject::invokeMethod( object.data(), "coverChanged", Qt::QueuedConnection );
+        }
+        return;
+    }
+
+    if ( image.isNull() )
+    {
+        // don't try again on every paint, but let the owner fall back to another cover
+        const QString id = key.left( key.lastIndexOf( '_' ) );
+        tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Could not decode cover:" << id;
+        m_undecodable.insert( id );
+    }
+    else
+    {
+        const int cost = qMax( 1, image.byteCount() / 1024 );
+        m_cache.insert( key, new QPixmap( QPixmap::fromImage( image ) ), cost );
+    }
+
+    foreach ( const QPointer< QObject >& object, pending.waiting )
+    {
+        if ( !object.isNull() )
+            QMetaObject::invokeMethod( object.data(), "coverChanged" );
+    }
+}
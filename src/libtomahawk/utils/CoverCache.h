@@ -0,0 +1,107 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COVERCACHE_H
+#define COVERCACHE_H
+
+#include "DllMacro.h"
+
+#include <QCache>
+#include <QHash>
+#include <QObject>
+#include <QPixmap>
+#include <QPointer>
+#include <QSet>
+#include <QThreadPool>
+
+/**
+ * Decodes and scales album and artist covers on a worker pool, so painting a
+ * grid full of covers never has to decode images on the GUI thread.
+ *
+ * Covers are scaled to a few fixed bucket sizes. Those thumbnails are kept in
+ * a memory bounded LRU cache and written to disk, keyed by a hash of the image
+ * data, so later runs skip decoding altogether. The disk cache is pruned to a
+ * fixed size, least recently used thumbnails first.
+ *
+ * While a cover is being decoded a null pixmap is returned and the requesting
+ * object's coverChanged() signal gets emitted once it is ready.
+ */
+class DLLEXPORT CoverCache : public QObject
+{
+Q_OBJECT
+
+public:
+    static CoverCache* instance();
+
+    explicit CoverCache( QObject* parent = 0 );
+    virtual ~CoverCache();
+
+    /**
+     * Returns the cover encoded in data, cropped to a square and scaled to size.
+     *
+     * id identifies the owner of the cover, e.g. an album's infoid(). If the cover
+     * isn't decoded yet a null pixmap is returned and notify's coverChanged() is
+     * emitted later on.
+     */
+    QPixmap cover( const QString& id, const QByteArray& data, const QSize& size, QObject* notify );
+
+    /// Drops all cached thumbnails of id from memory, e.g. because its cover changed
+    void remove( const QString& id );
+
+    /// True if the cover data of id turned out not to be an image we can decode
+    bool isUndecodable( const QString& id ) const;
+
+    /// Memory limit for decoded thumbnails in kilobytes
+    void setMaxCost( int kb );
+    int maxCost() const;
+
+private slots:
+    void onDecoded( const QString& key, quint64 job, const QImage& image );
+
+private:
+    static int bucketSize( const QSize& size );
+    static QString cacheKey( const QString& id, int bucket );
+    QString scaledKey( const QString& id, const QSize& size ) const;
+
+    QThreadPool m_pool;
+    QString m_diskCachePath;
+
+    // thumbnail pixmaps, cost is their size in kilobytes
+    QCache< QString, QPixmap > m_cache;
+
+    // thumbnails being decoded and the objects waiting for them
+    struct PendingCover
+    {
+        PendingCover() : job( 0 ) {}
+
+        quint64 job;
+        QList< QPointer< QObject > > waiting;
+    };
+    QHash< QString, PendingCover > m_pending;
+    quint64 m_nextJob;
+
+    // bumped whenever an id's cover changes, so exact size pixmaps in QPixmapCache go stale
+    QHash< QString, quint32 > m_generations;
+
+    // ids whose cover data could not be decoded, their owners fall back to other covers
+    QSet< QString > m_undecodable;
+
+    static CoverCache* s_instance;
+};
+
+#endif // COVERCACHE_H
@@ -23,20 +23,30 @@
 
 #include "utils/Logger.h"
 
-static QHash< QString, QHash< int, QHash< qint64, QPixmap > > > s_cache;
+// default memory limit for cached pixmaps, in kilobytes
+#define IMAGEREGISTRY_DEFAULT_COST 32 * 1024
+
 ImageRegistry* ImageRegistry::s_instance = 0;
 
 
 ImageRegistry*
 ImageRegistry::instance()
 {
+    if ( !s_instance )
+        new ImageRegistry();
+
     return s_instance;
 }
 
 
 ImageRegistry::ImageRegistry()
+    : m_hits( 0 )
+    , m_misses( 0 )
+    , m_evictions( 0 )
 {
     s_instance = this;
+
+    m_cache.setMaxCost( IMAGEREGISTRY_DEFAULT_COST );
 }
 
 
@@ -47,10 +57,34 @@ ImageRegistry::icon( const QString& image, TomahawkUtils::ImageMode mode )
 }
 
 
-qint64
-ImageRegistry::cacheKey( const QSize& size, float opacity, QColor tint )
+void
+ImageRegistry::setMaxCost( int kb )
+{
+    const int before = m_cache.count();
+    m_cache.setMaxCost( kb );
+    m_evictions += before - m_cache.count();
+}
+
+
+int
+ImageRegistry::maxCost() const
 {
-    return size.width() * 100 + size.height() * 10 + ( opacity * 100.0 ) + tint.value();
+    return m_cache.maxCost();
+}
+
+
+quint64
+ImageRegistry::cacheKey( const QString& image, const QSize& size, TomahawkUtils::ImageMode mode, float opacity, QColor tint )
+{
+    // the image's hash in the upper half, everything else mixed into the lower half.
+    // Collisions are caught by comparing the entry's parameters on lookup.
+    uint params = qHash( ( quint64( quint16( size.width() ) ) << 48 ) |
+                         ( quint64( quint16( size.height() ) ) << 32 ) |
+                         ( quint64( mode & 0xff ) << 24 ) |
+                         quint64( qRound( opacity * 255.0 ) & 0xff ) );
+    params ^= qHash( tint.rgba() ) + 0x9e3779b9 + ( params << 6 ) + ( params >> 2 );
+
+    return ( quint64( qHash( image ) ) << 32 ) | params;
 }
 
 
@@ -63,25 +97,16 @@ ImageRegistry::pixmap( const QString& image, const QSize& size, TomahawkUtils::I
         return QPixmap();
     }
 
-    QHash< qint64, QPixmap > subsubcache;
-    QHash< int, QHash< qint64, QPixmap > > subcache;
-
-    if ( s_cache.contains( image ) )
+    const CacheEntry* entry = m_cache.object( cacheKey( image, size, mode, opacity, tint ) );
+    if ( entry && entry->image == image && entry->size == size && entry->mode == mode &&
+         entry->opacity == opacity && entry->tint == tint.rgba() )
     {
-        subcache = s_cache.value( image );
-
-        if ( subcache.contains( mode ) )
-        {
-            subsubcache = subcache.value( mode );
-
-            const qint64 ck = cacheKey( size, opacity, tint );
-            if ( subsubcache.contains( ck ) )
-            {
-                return subsubcache.value( ck );
-            }
-        }
+        m_hits++;
+        return entry->pixmap;
     }
 
+    m_misses++;
+
     // Image not found in cache. Let's load it.
     QPixmap pixmap;
     if ( image.toLower().endsWith( ".svg" ) )
@@ -141,25 +166,18 @@ ImageRegistry::putInCache( const QString& image, const QSize& size, TomahawkUtil
 {
     tDebug( LOGVERBOSE ) << Q_FUNC_INFO << "Adding to image cache:" << image << size << mode;
 
-    QHash< qint64, QPixmap > subsubcache;
-    QHash< int, QHash< qint64, QPixmap > > subcache;
+    CacheEntry* entry = new CacheEntry;
+    entry->image = image;
+    entry->size = size;
+    entry->mode = mode;
+    entry->opacity = opacity;
+    entry->tint = tint.rgba();
+    entry->pixmap = pixmap;
 
-    if ( s_cache.contains( image ) )
-    {
-        subcache = s_cache.value( image );
-
-        if ( subcache.contains( mode ) )
-        {
-            subsubcache = subcache.value( mode );
-
-/*            if ( subsubcache.contains( size.width() * size.height() ) )
-            {
-                Q_ASSERT( false );
-            }*/
-        }
-    }
+    const quint64 key = cacheKey( image, size, mode, opacity, tint );
+    const int cost = qMax( 1, pixmap.width() * pixmap.height() * pixmap.depth() / 8 / 1024 );
+    const int before = m_cache.count() - ( m_cache.contains( key ) ? 1 : 0 );
 
-    subsubcache.insert( cacheKey( size, opacity, tint ), pixmap );
-    subcache.insert( mode, subsubcache );
-    s_cache.insert( image, subcache );
+    m_cache.insert( key, entry, cost );
+    m_evictions += qMax( 0, before + 1 - m_cache.count() );
 }
@@ -18,11 +18,19 @@
 #ifndef IMAGE_REGISTRY_H
 #define IMAGE_REGISTRY_H
 
+#include <QCache>
 #include <QPixmap>
 
 #include "utils/TomahawkUtilsGui.h"
 #include "DllMacro.h"
 
+/**
+ * Renders and caches the pixmaps of our (mostly SVG) artwork.
+ *
+ * The cache is a least-recently-used cache bounded by the memory the pixmaps
+ * take up, so all the size, mode and opacity variations requested over a long
+ * session don't pile up forever.
+ */
 class DLLEXPORT ImageRegistry
 {
 public:
@@ -33,10 +41,35 @@ public:
     QIcon icon( const QString& image, TomahawkUtils::ImageMode mode = TomahawkUtils::Original );
     QPixmap pixmap( const QString& image, const QSize& size, TomahawkUtils::ImageMode mode = TomahawkUtils::Original, float opacity = 1.0, QColor tint = QColor( 0, 0, 0, 0 ) );
 
+    /// Memory limit for cached pixmaps in kilobytes
+    void setMaxCost( int kb );
+    int maxCost() const;
+
+    int totalCost() const { return m_cache.totalCost(); }
+    int count() const { return m_cache.count(); }
+    quint64 hits() const { return m_hits; }
+    quint64 misses() const { return m_misses; }
+    quint64 evictions() const { return m_evictions; }
+
 private:
-    qint64 cacheKey( const QSize& size, float opacity, QColor tint );
+    struct CacheEntry
+    {
+        QString image;
+        QSize size;
+        TomahawkUtils::ImageMode mode;
+        float opacity;
+        QRgb tint;
+        QPixmap pixmap;
+    };
+
+    static quint64 cacheKey( const QString& image, const QSize& size, TomahawkUtils::ImageMode mode, float opacity, QColor tint );
     void putInCache( const QString& image, const QSize& size, TomahawkUtils::ImageMode mode, float opacity, const QPixmap& pixmap, QColor tint );
 
+    QCache< quint64, CacheEntry > m_cache;
+    quint64 m_hits;
+    quint64 m_misses;
+    quint64 m_evictions;
+
     static ImageRegistry* s_instance;
 };
 
@@ -0,0 +1,127 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTMSG_H
+#define TOMAHAWK_TESTMSG_H
+
+#include "libtomahawk/network/BufferIoDevice.h"
+#include "libtomahawk/network/Msg.h"
+#include "libtomahawk/network/MsgProcessor.h"
+
+#include <QtEndian>
+
+/*
+ * Every payload copy we got rid of is checked by comparing data pointers: a
+ * slice or block that points into the buffer the msg was read into was not
+ * allocated and copied again.
+ */
+class TestMsg : public QObject
+{
+    Q_OBJECT
+
+private:
+    msg_ptr readMsg( const QByteArray& payload, char flags )
+    {
+        quint32 size = qToBigEndian( (quint32)payload.length() );
+        QByteArray header( (const char*) &size, sizeof( quint32 ) );
+        header.append( flags );
+
+        msg_ptr msg = Msg::begin( header.data() );
+        msg->fill( payload );
+        return msg;
+    }
+
+private slots:
+    void testFillSharesPayload()
+    {
+        const QByteArray payload( "data0123456789" );
+        msg_ptr msg = readMsg( payload, Msg::RAW );
+
+        QCOMPARE( msg->payload().constData(), payload.constData() );
+        QCOMPARE( msg->buffer().constData(), payload.constData() );
+    }
+
+    void testSliceDoesNotCopy()
+    {
+        const QByteArray payload( "data0123456789" );
+        msg_ptr msg = readMsg( payload, Msg::RAW );
+
+        const MsgBuffer buffer = msg->buffer();
+        QVERIFY( buffer.startsWith( "data" ) );
+        QVERIFY( !buffer.startsWith( "datablock" ) );
+
+        const MsgBuffer data = buffer.mid( 4 );
+        QCOMPARE( data.constData(), payload.constData() + 4 );
+        QCOMPARE( data.length(), payload.length() - 4 );
+        QCOMPARE( data.toByteArray(), QByteArray( "0123456789" ) );
+
+        const MsgBuffer inner = data.mid( 2, 3 );
+        QCOMPARE( inner.constData(), payload.constData() + 6 );
+        QCOMPARE( inner.toByteArray(), QByteArray( "234" ) );
+
+        QVERIFY( data.mid( 100 ).isEmpty() );
+        QCOMPARE( data.mid( 8, 100 ).toByteArray(), QByteArray( "89" ) );
+
+        // a slice spanning everything hands out the shared array itself
+        QCOMPARE( buffer.toByteArray().constData(), payload.constData() );
+    }
+
+    void testBlocksFromSlices()
+    {
+        const int blockSize = BufferIODevice::blockSize();
+        QByteArray audio;
+        for ( int i = 0; i < blockSize * 2 + 100; i++ )
+            audio.append( char( i % 251 ) );
+
+        BufferIODevice device( audio.length() );
+        device.open( QIODevice::ReadOnly );
+
+        for ( int block = 0; block * blockSize < audio.length(); block++ )
+        {
+            // the msg goes away, its payload lives on in the device's block
+            msg_ptr msg = readMsg( "data" + audio.mid( block * blockSize, blockSize ), Msg::RAW );
+            device.addData( block, msg->buffer().mid( 4 ) );
+            QVERIFY( !device.isBlockEmpty( block ) );
+        }
+        QCOMPARE( device.nextEmptyBlock(), -1 );
+
+        // reads crossing block boundaries come out in one piece
+        QCOMPARE( device.read( blockSize - 10 ), audio.left( blockSize - 10 ) );
+        QCOMPARE( device.read( 20 ), audio.mid( blockSize - 10, 20 ) );
+        QCOMPARE( device.readAll(), audio.mid( blockSize + 10 ) );
+        QVERIFY( device.atEnd() );
+    }
+
+    void testCompressionRoundtrip()
+    {
+        QByteArray json( "{\"command\":\"addfiles\",\"files\":[" );
+        for ( int i = 0; i < 200; i++ )
+            json.append( QString( "{\"url\":\"/music/%1.mp3\",\"size\":%2}," ).arg( i ).arg( i * 1024 ).toUtf8() );
+        json.append( "{}]}" );
+
+        msg_ptr msg = MsgProcessor::process( Msg::factory( json, Msg::JSON | Msg::DBOP ), MsgProcessor::COMPRESS_IF_LARGE, 512 );
+        QVERIFY( msg->is( Msg::COMPRESSED ) );
+        QVERIFY( msg->length() < (quint32)json.length() );
+
+        msg = MsgProcessor::process( readMsg( msg->payload(), msg->flags() ), MsgProcessor::UNCOMPRESS_ALL, 512 );
+        QVERIFY( !msg->is( Msg::COMPRESSED ) );
+        QCOMPARE( msg->payload(), json );
+    }
+};
+
+#endif
@@ -0,0 +1,169 @@
+/* === This file is part of Tomahawk Player - <http://tomahawk-player.org> ===
+ *
+ *   Copyright 2010-2015, Christian Muehlhaeuser <muesli@tomahawk-player.org>
+ *
+ *   Tomahawk is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+ *
+ *   Tomahawk is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with Tomahawk. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TOMAHAWK_TESTPLAYABLEPROXYMODEL_H
+#define TOMAHAWK_TESTPLAYABLEPROXYMODEL_H
+
+#include <QtTest>
+
+#include "libtomahawk/playlist/PlayableModel.h"
+#include "libtomahawk/playlist/PlayableProxyModel.h"
+#include "libtomahawk/Query.h"
+
+#define TEST_ROWS 100000
+
+class TestPlayableProxyModel : public QObject
+{
+    Q_OBJECT
+
+private:
+    PlayableModel* model;
+    PlayableProxyModel* proxy;
+
+private slots:
+    void initTestCase()
+    {
+        // every track shows up twice, every 100th one is by Radiohead
+        QList< Tomahawk::query_ptr > queries;
+        for ( int i = 0; i < TEST_ROWS; i++ )
+        {
+            const int n = i % ( TEST_ROWS / 2 );
+            const QString artist = n % 100 ? QString( "Artist %1" ).arg( n % 1000 ) : QString( "Radiohead" );
+
+            queries << Tomahawk::Query::get( artist, QString( "Track %1" ).arg( n ), QString( "Album %1" ).arg( n % 5000 ) );
+        }
+
+        model = new PlayableModel( 0, false );
+        model->appendQueries( queries );
+
+        proxy = new PlayableProxyModel();
+        proxy->setSourcePlayableModel( model );
+    }
+
+    void cleanupTestCase()
+    {
+        delete proxy;
+        delete model;
+    }
+
+    void testFilter()
+    {
+        QCOMPARE( proxy->rowCount( QModelIndex() ), TEST_ROWS );
+
+        proxy->setFilter( "radio" );
+        QCOMPARE( proxy->rowCount( QModelIndex() ), TEST_ROWS / 100 );
+
+        proxy->setFilter( "radioh" );
+        QCOMPARE( proxy->rowCount( QModelIndex() ), TEST_ROWS / 100 );
+
+        proxy->setFilter( "radiohx" );
+        QCOMPARE( proxy->rowCount( QModelIndex() ), 0 );
+
+        // getting less specific has to bring back rows that were filtered out before
+        proxy->setFilter( "track 1" );
+        QVERIFY( proxy->rowCount( QModelIndex() ) > 0 );
+
+        proxy->setFilter( "" );
+        QCOMPARE( proxy->rowCount( QModelIndex() ), TEST_ROWS );
+    }
+
+    void testHideDupeItems()
+    {
+        proxy->setHideDupeItems( true );
+        QCOMPARE( proxy->rowCount( QModelIndex() ), TEST_ROWS / 2 );
+
+        proxy->setHideDupeItems( false );
+        QCOMPARE( proxy->rowCount( QModelIndex() ), TEST_ROWS );
+    }
+
+    void testSort()
+    {
+        proxy->sort( 0 );
+
+        // rows are ordered by artist, then album
+        QCOMPARE( proxy->rowCount( QModelIndex() ), TEST_ROWS );
+        Tomahawk::track_ptr previous;
+        for ( int i = 0; i < TEST_ROWS; i++ )
+        {
+            const QModelIndex index = proxy->index( i, 0, QModelIndex() );
+            const Tomahawk::track_ptr track = proxy->itemFromIndex( proxy->mapToSource( index ) )->query()->track();
+            if ( previous )
+            {
+                const int artist = QString::localeAwareCompare( previous->artistSortname(), track->artistSortname() );
+                QVERIFY( artist <= 0 );
+                if ( artist == 0 )
+                    QVERIFY( QString::localeAwareCompare( previous->albumSortname(), track->albumSortname() ) <= 0 );
+            }
+            previous = track;
+        }
+
+        proxy->sort( -1 );
+    }
+
+    void testHideDupeItemsIsCaseSensitive()
+    {
+        QList< Tomahawk::query_ptr > queries;
+        queries << Tomahawk::Query::get( "Radiohead", "Airbag", "OK Computer" );
+        queries << Tomahawk::Query::get( "Radiohead", "Airbag", "OK Computer" );
+        queries << Tomahawk::Query::get( "radiohead", "airbag", "ok computer" );
+
+        PlayableModel dupes( 0, false );
+        dupes.appendQueries( queries );
+
+        PlayableProxyModel dupesProxy;
+        dupesProxy.setSourcePlayableModel( &dupes );
+        dupesProxy.setHideDupeItems( true );
+
+        // like Query::equals, tracks only differing in case are not dupes
+        QCOMPARE( dupesProxy.rowCount( QModelIndex() ), 2 );
+    }
+
+    void benchmarkSort()
+    {
+        QBENCHMARK
+        {
+            proxy->sort( 0 );
+            proxy->sort( -1 );
+        }
+    }
+
+    void benchmarkIncrementalFilter()
+    {
+        QBENCHMARK
+        {
+            proxy->setFilter( "r" );
+            proxy->setFilter( "ra" );
+            proxy->setFilter( "rad" );
+            proxy->setFilter( "radi" );
+            proxy->setFilter( "radio" );
+            proxy->setFilter( "radioh" );
+            proxy->setFilter( "" );
+        }
+    }
+
+    void benchmarkHideDupeItems()
+    {
+        QBENCHMARK
+        {
+            proxy->setHideDupeItems( true );
+            proxy->setHideDupeItems( false );
+        }
+    }
+};
+
+#endif // TOMAHAWK_TESTPLAYABLEPROXYMODEL_H
@@ -35,6 +35,7 @@
 #include "sip/PeerInfo.h"
 #include "sip/SipInfo.h"
 #include "sip/SipPlugin.h"
+#include "utils/ImageRegistry.h"
 #include "utils/TomahawkUtilsGui.h"
 #include "utils/Logger.h"
 #include "Pipeline.h"
@@ -94,6 +95,17 @@ DiagnosticsDialog::updateLogView()
         log.append( "      not listening to any interface, outgoing connections only\n" );
     }
 
+    ImageRegistry* imageRegistry = ImageRegistry::instance();
+    log.append( "\n\nIMAGE CACHE:\n" );
+    log.append( QString( "      %1 images, %2 of %3 KB\n" )
+                .arg( imageRegistry->count() )
+                .arg( imageRegistry->totalCost() )
+                .arg( imageRegistry->maxCost() ) );
+    log.append( QString( "      %1 hits, %2 misses, %3 evictions\n" )
+                .arg( imageRegistry->hits() )
+                .arg( imageRegistry->misses() )
+                .arg( imageRegistry->evictions() ) );
+
     log.append( "\n\nINFOPLUGINS:\n" );
     QThread* infoSystemWorkerThreadSuperClass = Tomahawk::InfoSystem::InfoSystem::instance()->workerThread();
     Tomahawk::InfoSystem::InfoSystemWorkerThread* infoSystemWorkerThread = qobject_cast< Tomahawk::InfoSystem::InfoSystemWorkerThread* >(infoSystemWorkerThreadSuperClass);
@@ -193,6 +193,8 @@ SettingsDialog::SettingsDialog(QObject *parent )
     m_advancedWidgetUi->proxyButton->setVisible( true );
 
     m_collectionWidgetUi->checkBoxWatchForChanges->setChecked( s->watchForChanges() );
+    m_collectionWidgetUi->checkBoxAnalyzeLoudness->setChecked( s->analyzeLoudness() );
+    m_collectionWidgetUi->volumeNormalizationComboBox->setCurrentIndex( s->volumeNormalization() );
     m_collectionWidgetUi->scannerTimeSpinBox->setValue( s->scannerTime() );
     m_collectionWidgetUi->enableEchonestCatalog->setChecked( s->enableEchonestCatalogs() );
 
@@ -327,6 +329,8 @@ SettingsDialog::saveSettings()
     s->setScannerPaths( libraryPaths );
 //    s->setScannerPaths( m_collectionWidgetUi->dirTree->getCheckedPaths() );
     s->setWatchForChanges( m_collectionWidgetUi->checkBoxWatchForChanges->isChecked() );
+    s->setAnalyzeLoudness( m_collectionWidgetUi->checkBoxAnalyzeLoudness->isChecked() );
+    s->setVolumeNormalization( (TomahawkSettings::VolumeNormalization) m_collectionWidgetUi->volumeNormalizationComboBox->currentIndex() );
     s->setScannerTime( m_collectionWidgetUi->scannerTimeSpinBox->value() );
     s->setEnableEchonestCatalogs( m_collectionWidgetUi->enableEchonestCatalog->isChecked() );
     s->setDownloadsPath( m_downloadsWidgetUi->downloadsFolder->text() );
@@ -0,0 +1,133 @@
+#include "database/DatabaseImpl.h"
+#include "utils/TomahawkUtils.h"
+#include "TomahawkVersion.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStringList>
+
+#include <iostream>
+
+/*
+ * Runs the id and metadata lookups that resolving and scanning hammer the
+ * database with, once without and once with the prepared statement cache, and
+ * reports how many statements sqlite had to compile per second.
+ *
+ * Point it at a copy of your tomahawk.db, the lookups don't create anything
+ * but opening the database may migrate its schema.
+ */
+
+struct Sample
+{
+    int artistId;
+    int trackId;
+    int albumId;
+    QString artist;
+    QString track;
+    QString album;
+};
+
+
+void
+usage()
+{
+    std::cout << "Usage:" << std::endl;
+    std::cout << "\ttomahawk-db-benchmark <database> [iterations]" << std::endl;
+}
+
+
+QList< Sample >
+loadSamples( Tomahawk::DatabaseImpl* dbi )
+{
+    QList< Sample > samples;
+
+    TomahawkSqlQuery query = dbi->newquery();
+    query.exec( "SELECT artist.id, track.id, album.id, artist.name, track.name, album.name "
+                "FROM file_join, artist, track, album "
+                "WHERE artist.id = file_join.artist AND track.id = file_join.track AND album.id = file_join.album "
+                "LIMIT 1000" );
+    while ( query.next() )
+    {
+        Sample sample;
+        sample.artistId = query.value( 0 ).toInt();
+        sample.trackId = query.value( 1 ).toInt();
+        sample.albumId = query.value( 2 ).toInt();
+        sample.artist = query.value( 3 ).toString();
+        sample.track = query.value( 4 ).toString();
+        sample.album = query.value( 5 ).toString();
+        samples << sample;
+    }
+
+    return samples;
+}
+
+
+void
+run( Tomahawk::DatabaseImpl* dbi, const QList< Sample >& samples, int iterations, int cacheSize )
+{
+    TomahawkSqlStatementCache* cache = dbi->statementCache();
+    cache->clear();
+    cache->setCapacity( cacheSize );
+
+    const quint64 prepared = cache->prepared();
+    const quint64 reused = cache->reused();
+    quint64 lookups = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for ( int i = 0; i < iterations; i++ )
+    {
+        foreach ( const Sample& sample, samples )
+        {
+            dbi->artistId( sample.artist, false );
+            dbi->trackId( sample.artistId, sample.track, false );
+            dbi->albumId( sample.artistId, sample.album, false );
+            dbi->artist( sample.artistId );
+            dbi->track( sample.trackId );
+            dbi->album( sample.albumId );
+            dbi->getTrackFids( sample.trackId );
+            lookups += 7;
+        }
+    }
+
+    const qint64 elapsed = qMax( Q_INT64_C( 1 ), timer.elapsed() );
+    const quint64 compiled = cache->prepared() - prepared;
+
+    std::cout << "Statement cache size " << cacheSize << ":" << std::endl;
+    std::cout << "\t" << lookups << " lookups in " << elapsed << " ms, " << lookups * 1000 / elapsed << " lookups/s" << std::endl;
+    std::cout << "\t" << compiled << " statements compiled, " << compiled * 1000 / elapsed << " statements/s" << std::endl;
+    std::cout << "\t" << cache->reused() - reused << " statements reused" << std::endl;
+}
+
+
+int
+main( int argc, char* argv[] )
+{
+    QCoreApplication app( argc, argv );
+    app.setOrganizationName( TOMAHAWK_ORGANIZATION_NAME );
+
+    const QStringList args = app.arguments();
+    if ( args.count() < 2 || !QFile::exists( args.at( 1 ) ) )
+    {
+        usage();
+        return 1;
+    }
+
+    const int iterations = args.count() > 2 ? qMax( 1, args.at( 2 ).toInt() ) : 10;
+
+    Tomahawk::DatabaseImpl dbi( args.at( 1 ) );
+    const QList< Sample > samples = loadSamples( &dbi );
+    if ( samples.isEmpty() )
+    {
+        std::cout << "The database doesn't contain any tracks." << std::endl;
+        return 1;
+    }
+
+    const int cacheSize = dbi.statementCache()->capacity();
+    run( &dbi, samples, iterations, 0 );
+    run( &dbi, samples, iterations, cacheSize );
+
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include "network/Msg.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QHostAddress>
+#include <QStringList>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QtEndian>
+
+#include <iostream>
+
+/*
+ * Pushes msgs through a loopback TCP connection, the way Connection frames
+ * them, and reports how many msgs per second made it to the other side.
+ *
+ * The legacy mode writes header and payload of each msg separately and reads
+ * a single msg per wakeup, the coalesced mode frames a burst of msgs into one
+ * buffer and drains all complete msgs per wakeup.
+ */
+
+// msgs the sender hands over per event loop iteration, like a MsgProcessor burst
+#define BENCHMARK_BURST 64
+// max msgs read per wakeup in coalesced mode, matches Connection
+#define BENCHMARK_READ_BUDGET 512
+
+
+class Receiver : public QObject
+{
+Q_OBJECT
+public:
+    Receiver( QTcpSocket* sock, bool drain, int expected )
+        : sock( sock )
+        , drain( drain )
+        , expected( expected )
+        , received( 0 )
+    {
+        connect( sock, SIGNAL( readyRead() ), SLOT( readyRead() ), Qt::QueuedConnection );
+    }
+
+    QTcpSocket* sock;
+    bool drain;
+    int expected;
+    int received;
+    msg_ptr msg;
+
+signals:
+    void finished();
+
+public slots:
+    void readyRead()
+    {
+        const int budget = drain ? BENCHMARK_READ_BUDGET : 1;
+        for ( int i = 0; i < budget; i++ )
+        {
+            if ( !readMsg() )
+                return;
+
+            if ( ++received == expected )
+            {
+                emit finished();
+                return;
+            }
+        }
+
+        if ( sock->bytesAvailable() )
+            QTimer::singleShot( 0, this, SLOT( readyRead() ) );
+    }
+
+private:
+    bool readMsg()
+    {
+        if ( msg.isNull() )
+        {
+            if ( sock->bytesAvailable() < Msg::headerSize() )
+                return false;
+
+            char header[ Msg::headerSize() ];
+            sock->read( header, Msg::headerSize() );
+            msg = Msg::begin( header );
+        }
+
+        if ( sock->bytesAvailable() < msg->length() )
+            return false;
+
+        msg->fill( sock->read( msg->length() ) );
+        msg.clear();
+        return true;
+    }
+};
+
+
+class Sender : public QObject
+{
+Q_OBJECT
+public:
+    Sender( QTcpSocket* sock, bool coalesce, const QList< msg_ptr >& msgs )
+        : sock( sock )
+        , coalesce( coalesce )
+        , msgs( msgs )
+        , sent( 0 )
+    {
+    }
+
+    QTcpSocket* sock;
+    bool coalesce;
+    QList< msg_ptr > msgs;
+    int sent;
+
+public slots:
+    void sendBurst()
+    {
+        const int end = qMin( sent + BENCHMARK_BURST, msgs.count() );
+
+        if ( coalesce )
+        {
+            QByteArray buffer;
+            for ( ; sent < end; sent++ )
+                msgs.at( sent )->appendTo( buffer );
+
+            sock->write( buffer );
+        }
+        else
+        {
+            for ( ; sent < end; sent++ )
+            {
+                const msg_ptr& msg = msgs.at( sent );
+                quint32 size = qToBigEndian( msg->length() );
+                quint8 flags = msg->flags();
+                sock->write( (const char*) &size, sizeof( quint32 ) );
+                sock->write( (const char*) &flags, sizeof( quint8 ) );
+                sock->write( msg->payload() );
+            }
+        }
+
+        if ( sent < msgs.count() )
+            QTimer::singleShot( 0, this, SLOT( sendBurst() ) );
+    }
+};
+
+
+void
+usage()
+{
+    std::cout << "Usage:" << std::endl;
+    std::cout << "\ttomahawk-msg-benchmark [msgs] [payload bytes]" << std::endl;
+}
+
+
+bool
+run( const QList< msg_ptr >& msgs, bool coalesced )
+{
+    QTcpServer server;
+    if ( !server.listen( QHostAddress::LocalHost ) )
+    {
+        std::cout << "Could not listen on the loopback interface." << std::endl;
+        return false;
+    }
+
+    QTcpSocket client;
+    client.connectToHost( QHostAddress::LocalHost, server.serverPort() );
+    if ( !client.waitForConnected( 5000 ) || !server.waitForNewConnection( 5000 ) )
+    {
+        std::cout << "Could not connect to the loopback server." << std::endl;
+        return false;
+    }
+    QTcpSocket* peer = server.nextPendingConnection();
+
+    Sender sender( &client, coalesced, msgs );
+    Receiver receiver( peer, coalesced, msgs.count() );
+
+    QEventLoop loop;
+    QObject::connect( &receiver, SIGNAL( finished() ), &loop, SLOT( quit() ) );
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QTimer::singleShot( 0, &sender, SLOT( sendBurst() ) );
+    loop.exec();
+
+    const qint64 elapsed = qMax( Q_INT64_C( 1 ), timer.elapsed() );
+
+    std::cout << ( coalesced ? "Coalesced writes, draining reads:" : "Write per header field, one msg per read:" ) << std::endl;
+    std::cout << "\t" << receiver.received << " msgs in " << elapsed << " ms, " << receiver.received * 1000 / elapsed << " msgs/s" << std::endl;
+
+    delete peer;
+    return true;
+}
+
+
+int
+main( int argc, char* argv[] )
+{
+    QCoreApplication app( argc, argv );
+
+    const QStringList args = app.arguments();
+    if ( args.contains( "--help" ) || args.contains( "-h" ) )
+    {
+        usage();
+        return 0;
+    }
+
+    const int count = args.count() > 1 ? qMax( 1, args.at( 1 ).toInt() ) : 200000;
+    const int payloadSize = args.count() > 2 ? qMax( 0, args.at( 2 ).toInt() ) : 200;
+
+    // small JSON msgs, like the dbsync ops and pings that make up most of the traffic
+    QList< msg_ptr > msgs;
+    const QByteArray payload( payloadSize, 'x' );
+    for ( int i = 0; i < count; i++ )
+        msgs << Msg::factory( payload, Msg::JSON | Msg::DBOP );
+
+    if ( !run( msgs, false ) || !run( msgs, true ) )
+        return 1;
+
+    return 0;
+}
+
+#include "main.moc"
@@ -0,0 +1,244 @@
+#include "utils/Json.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QStringList>
+#include <QThread>
+#include <QtEndian>
+
+#include <cstdio>
+#include <iostream>
+
+/*
+ * A resolver that answers every request with made up results right away, so
+ * the script resolver protocol and its worker pool can be benchmarked without
+ * any network or disk access getting in the way.
+ */
+
+struct Options
+{
+    Options() : protocol( 2 ), results( 5 ), delay( 0 ), workers( 1 ), binary( true ) {}
+
+    int protocol;
+    int results;
+    int delay;
+    int workers;
+    bool binary;
+};
+
+
+void
+usage()
+{
+    std::cout << "Usage:" << std::endl;
+    std::cout << "\ttomahawk-stub-resolver [--protocol 1|2] [--encoding json|qdatastream] [--workers N] [--results N] [--delay ms]" << std::endl;
+    std::cout << std::endl;
+    std::cout << "\tSpeaks the script resolver protocol on stdin and stdout. Add it as a resolver and" << std::endl;
+    std::cout << "\tresolve some queries to measure the host's framing and decoding overhead." << std::endl;
+    std::cout << std::endl;
+    std::cout << "\tTomahawk starts resolvers without arguments, so every option can also be set in the" << std::endl;
+    std::cout << "\tenvironment Tomahawk is started from, e.g. STUB_RESOLVER_WORKERS=4 for --workers 4." << std::endl;
+}
+
+
+bool
+parseOption( const QString& option, const QString& value, Options& options )
+{
+    if ( option == "--protocol" )
+        options.protocol = value.toInt();
+    else if ( option == "--encoding" )
+        options.binary = value == "qdatastream";
+    else if ( option == "--workers" )
+        options.workers = qMax( 1, value.toInt() );
+    else if ( option == "--results" )
+        options.results = qMax( 0, value.toInt() );
+    else if ( option == "--delay" )
+        options.delay = qMax( 0, value.toInt() );
+    else
+        return false;
+
+    return true;
+}
+
+
+bool
+readFrame( QByteArray& payload )
+{
+    quint32 len_nbo;
+    if ( fread( &len_nbo, 4, 1, stdin ) != 1 )
+        return false;
+
+    payload.resize( qFromBigEndian( len_nbo ) );
+    return payload.isEmpty() || fread( payload.data(), payload.size(), 1, stdin ) == 1;
+}
+
+
+void
+writeFrame( const QVariantMap& map, bool binary )
+{
+    QByteArray payload;
+    if ( binary )
+    {
+        QDataStream stream( &payload, QIODevice::WriteOnly );
+        stream.setVersion( QDataStream::Qt_4_8 );
+        stream << QVariant( map );
+    }
+    else
+        payload = TomahawkUtils::toJson( map );
+
+    quint32 len;
+    qToBigEndian( (quint32) payload.size(), (uchar*) &len );
+    fwrite( &len, 4, 1, stdout );
+    fwrite( payload.constData(), payload.size(), 1, stdout );
+    fflush( stdout );
+}
+
+
+bool
+isJson( const QByteArray& payload )
+{
+    for ( int i = 0; i < payload.size(); i++ )
+    {
+        const char c = payload.at( i );
+        if ( c != ' ' && c != '\t' && c != '\r' && c != '\n' )
+            return c == '{';
+    }
+
+    return false;
+}
+
+
+QVariantMap
+decodeFrame( const QByteArray& payload )
+{
+    if ( isJson( payload ) )
+        return TomahawkUtils::parseJson( payload ).toMap();
+
+    QVariant v;
+    QDataStream stream( payload );
+    stream.setVersion( QDataStream::Qt_4_8 );
+    stream >> v;
+
+    return v.toMap();
+}
+
+
+QVariantMap
+settings( const QVariantMap& config, const Options& options, bool* binary )
+{
+    QVariantMap m;
+    m[ "_msgtype" ] = "settings";
+    m[ "name" ] = "Stub Resolver";
+    m[ "weight" ] = 1;
+    m[ "timeout" ] = 5;
+
+    // only switch to protocol v2 if the host offers it, old hosts keep talking JSON
+    const bool v2 = options.protocol >= 2 && config.value( "protocols" ).toList().contains( 2 );
+    *binary = v2 && options.binary && config.value( "encodings" ).toList().contains( "qdatastream" );
+    if ( v2 )
+    {
+        m[ "protocol" ] = 2;
+        m[ "encoding" ] = *binary ? "qdatastream" : "json";
+        m[ "workers" ] = options.workers;
+    }
+
+    return m;
+}
+
+
+QVariantMap
+results( const QVariantMap& rq, const Options& options )
+{
+    QString artist = rq.value( "artist" ).toString();
+    QString track = rq.value( "track" ).toString();
+    if ( artist.isEmpty() )
+        artist = "Stub Artist";
+
+    QVariantList results;
+    for ( int i = 0; i < options.results; i++ )
+    {
+        QVariantMap r;
+        r[ "artist" ] = artist;
+        r[ "track" ] = track;
+        r[ "album" ] = "Stub Album";
+        r[ "albumpos" ] = i + 1;
+        r[ "duration" ] = 180 + i;
+        r[ "bitrate" ] = 320;
+        r[ "size" ] = 7200000;
+        r[ "url" ] = QString( "http://localhost/stub/%1/%2" ).arg( rq.value( "qid" ).toString() ).arg( i );
+        r[ "mimetype" ] = "audio/mpeg";
+        results << r;
+    }
+
+    QVariantMap m;
+    m[ "_msgtype" ] = "results";
+    m[ "qid" ] = rq.value( "qid" );
+    m[ "results" ] = results;
+
+    return m;
+}
+
+
+int
+main( int argc, char* argv[] )
+{
+    QCoreApplication a( argc, argv );
+
+    Options options;
+
+    // the environment comes first, arguments given on the command line override it
+    foreach ( const QString& option, QStringList() << "protocol" << "encoding" << "workers" << "results" << "delay" )
+    {
+        const QByteArray value = qgetenv( "STUB_RESOLVER_" + option.toUpper().toLatin1() );
+        if ( !value.isEmpty() )
+            parseOption( "--" + option, QString::fromLatin1( value ), options );
+    }
+
+    QStringList args = a.arguments();
+    args.removeFirst();
+    while ( args.count() >= 2 )
+    {
+        const QString option = args.takeFirst();
+        const QString value = args.takeFirst();
+
+        if ( !parseOption( option, value, options ) )
+        {
+            usage();
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    if ( !args.isEmpty() )
+    {
+        usage();
+        exit(EXIT_FAILURE);
+    }
+
+    bool binary = false;
+    QByteArray payload;
+    while ( readFrame( payload ) )
+    {
+        const QVariantMap m = decodeFrame( payload );
+        const QString msgtype = m.value( "_msgtype" ).toString();
+
+        if ( msgtype == "quit" )
+            break;
+
+        if ( msgtype == "config" )
+        {
+            // the settings reply still goes out as JSON, the host switches once it read it
+            bool useBinary;
+            writeFrame( settings( m, options, &useBinary ), false );
+            binary = useBinary;
+        }
+        else if ( msgtype == "rq" )
+        {
+            if ( options.delay > 0 )
+                QThread::msleep( options.delay );
+
+            writeFrame( results( m, options ), binary );
+        }
+    }
+
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include"filemetadata/MusicScanner.h"
 
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QFileInfo>
 
 #include <iostream>
@@ -9,17 +10,62 @@ void
 usage()
 {
     std::cout << "Usage:" << std::endl;
-    std::cout << "\ttomahawk-test-musicscan <path>" << std::endl;
+    std::cout << "\ttomahawk-test-musicscan <path> [threads...]" << std::endl;
     std::cout << std::endl;
     std::cout << "\tpath\tEither an audio file or a directory" << std::endl;
+    std::cout << "\tthreads\tTag reader pool sizes to benchmark a directory scan with, e.g. 1 4 16" << std::endl;
 }
 
+
+void
+scanDirectory( const QFileInfo& pathInfo, int threads, bool verbose )
+{
+    // Create the MusicScanner instance
+    QStringList paths;
+    paths << pathInfo.canonicalFilePath();
+    MusicScanner scanner( MusicScanner::DirScan, paths, 0 );
+
+    // We want a dry-run of the scanner and not update any internal data.
+    scanner.setDryRun( true );
+    scanner.setVerbose( verbose );
+    if ( threads > 0 )
+        scanner.setTagReaderThreads( threads );
+
+    // Start the MusicScanner in its own thread
+    QThread scannerThread( 0 );
+    scannerThread.start();
+    // We need to do this or the finished() signal/quit() SLOT is not called.
+    scannerThread.moveToThread( &scannerThread );
+    scanner.moveToThread( &scannerThread );
+    QObject::connect( &scanner, SIGNAL( finished() ), &scannerThread, SLOT( quit() ) );
+
+    QElapsedTimer timer;
+    timer.start();
+    QMetaObject::invokeMethod( &scanner, "scan", Qt::QueuedConnection );
+
+    // Wait until the scanner has done its work.
+    scannerThread.wait();
+
+    if ( threads > 0 )
+    {
+        const qint64 elapsed = qMax( (qint64)1, timer.elapsed() );
+        const unsigned int files = scanner.scannedFiles() + scanner.skippedFiles();
+        std::cout << "threads: " << scanner.tagReaderThreads()
+                  << "\tI/O depth: " << scanner.maxPendingReads()
+                  << "\tfiles: " << files
+                  << "\ttime: " << elapsed << " ms"
+                  << "\tfiles/sec: " << ( files * 1000.0 / elapsed ) << std::endl;
+    }
+}
+
+
 int
 main( int argc, char* argv[] )
 {
-    if ( argc != 2 )
+    if ( argc < 2 )
     {
         usage();
+        exit(EXIT_FAILURE);
     }
 
     QCoreApplication a( argc, argv );
@@ -41,26 +87,26 @@ main( int argc, char* argv[] )
         qRegisterMetaType< QDir >( "QDir" );
         qRegisterMetaType< QFileInfo >( "QFileInfo" );
 
-        // Create the MusicScanner instance
-        QStringList paths;
-        paths << pathInfo.canonicalFilePath();
-        MusicScanner scanner( MusicScanner::DirScan, paths, 0 );
-
-        // We want a dry-run of the scanner and not update any internal data.
-        scanner.setDryRun( true );
-        scanner.setVerbose( true );
-
-        // Start the MusicScanner in its own thread
-        QThread scannerThread( 0 );
-        scannerThread.start();
-        // We need to do this or the finished() signal/quit() SLOT is not called.
-        scannerThread.moveToThread( &scannerThread );
-        scanner.moveToThread( &scannerThread );
-        QObject::connect( &scanner, SIGNAL( finished() ), &scannerThread, SLOT( quit() ) );
-        QMetaObject::invokeMethod( &scanner, "scan", Qt::QueuedConnection );
-
-        // Wait until the scanner has done its work.
-        scannerThread.wait();
+        if ( argc == 2 )
+        {
+            scanDirectory( pathInfo, 0, true );
+        }
+        else
+        {
+            // Note: later runs profit from the OS' file cache, drop caches between runs
+            // (or pass the pool sizes in varying order) when measuring cold scans.
+            for ( int i = 2; i < argc; i++ )
+            {
+                const int threads = QString( argv[i] ).toInt();
+                if ( threads < 1 )
+                {
+                    usage();
+                    exit(EXIT_FAILURE);
+                }
+
+                scanDirectory( pathInfo, threads, false );
+            }
+        }
     }
     else
     {